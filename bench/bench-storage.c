@@ -0,0 +1,581 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+/*
+	bench-storage measures SqStorage CRUD functions against SQLite.
+
+	Usage: bench-storage [options]
+	  --rows N        number of rows (default 1000)
+	  --width N       length of each string value (default 32)
+	  --columns N     number of extra string columns, 0 - 16 (default 4)
+	  --repeat N      number of calls for get_all and query (default 10)
+	  --db TYPE       "memory", "file", or "both" (default both)
+	  --folder PATH   folder of database file (default .)
+	  --transaction   run insert, update, and remove in a transaction
+	  --json PATH     write results in JSON to PATH, "-" means stdout
+	  --stats         print statistics of SQL statements (SqdbStats)
+	  --verbose       don't discard debug messages of library
+
+	Debug messages of library are written to stderr if it was built with DEBUG.
+	They are discarded by default, but they still take time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <SqConfig.h>
+#ifdef SQ_CONFIG_HAVE_SQLITE
+
+#include <SqError.h>
+#include <SqPtrArray.h>
+#include <SqQuery.h>
+#include <SqSchema.h>
+#include <SqStorage.h>
+#include <SqdbSqlite.h>
+#include <SqdbStats.h>
+
+#define BENCH_COLUMNS_MAX    16
+#define BENCH_CITIES         16
+#define BENCH_RESULTS_MAX    16
+
+typedef struct BenchCity      BenchCity;
+typedef struct BenchUser      BenchUser;
+typedef struct BenchOptions   BenchOptions;
+typedef struct BenchResult    BenchResult;
+
+struct BenchCity
+{
+	int    id;
+	char  *name;
+};
+
+struct BenchUser
+{
+	int    id;
+	int    city_id;
+	double score;
+	char  *name;
+	char  *extra[BENCH_COLUMNS_MAX];
+};
+
+struct BenchOptions
+{
+	int          rows;
+	int          width;
+	int          columns;
+	int          repeat;
+	bool         memory;
+	bool         file;
+	bool         transaction;
+	bool         stats;
+	bool         verbose;
+	const char  *folder;
+	const char  *json;
+};
+
+struct BenchResult
+{
+	const char  *db;
+	const char  *op;
+	int          count;      // number of calls
+	int          rows;       // number of rows processed
+	double       seconds;
+	double       p50;        // latency in microseconds
+	double       p99;
+};
+
+static BenchResult  results[BENCH_RESULTS_MAX];
+static int          n_results;
+
+// ----------------------------------------------------------------------------
+// timer
+
+static double  bench_now(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER  counter, frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec  ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static int  double_compare(const void *a, const void *b)
+{
+	double  da = *(const double*)a;
+	double  db = *(const double*)b;
+
+	return (da > db) - (da < db);
+}
+
+// 'latency' is sorted by this function
+static void  bench_record(const char *db, const char *op, double *latency, int count, int rows, double seconds)
+{
+	BenchResult *result;
+
+	if (n_results == BENCH_RESULTS_MAX || count == 0)
+		return;
+	qsort(latency, count, sizeof(double), double_compare);
+
+	result = results + n_results++;
+	result->db = db;
+	result->op = op;
+	result->count = count;
+	result->rows = rows;
+	result->seconds = seconds;
+	result->p50 = latency[(count - 1) * 50 / 100] * 1e6;
+	result->p99 = latency[(count - 1) * 99 / 100] * 1e6;
+}
+
+// ----------------------------------------------------------------------------
+// data
+
+static void  bench_city_free(BenchCity *city)
+{
+	free(city->name);
+	free(city);
+}
+
+static void  bench_user_free(BenchUser *user)
+{
+	free(user->name);
+	for (int index = 0;  index < BENCH_COLUMNS_MAX;  index++)
+		free(user->extra[index]);
+	free(user);
+}
+
+static char *bench_string(int width, int seed)
+{
+	char  *string = malloc(width + 1);
+
+	for (int index = 0;  index < width;  index++)
+		string[index] = 'a' + (seed + index) % 26;
+	string[width] = 0;
+	return string;
+}
+
+static void  bench_user_fill(BenchUser *user, BenchOptions *options, int seed)
+{
+	user->city_id = seed % BENCH_CITIES + 1;
+	user->score = seed * 0.5;
+	free(user->name);
+	user->name = bench_string(options->width, seed);
+	for (int index = 0;  index < options->columns;  index++) {
+		free(user->extra[index]);
+		user->extra[index] = bench_string(options->width, seed + index);
+	}
+}
+
+static void  bench_make_schema(SqStorage *storage, BenchOptions *options)
+{
+	SqSchema *schema;
+	SqTable  *table;
+	SqColumn *column;
+	char      name[16];
+
+	schema = sq_schema_new("bench");
+	schema->version = 1;
+
+	table = sq_schema_create(schema, "cities", BenchCity);
+	column = sq_table_add_int(table, "id", offsetof(BenchCity, id));
+	column->bit_field |= SQB_PRIMARY | SQB_AUTOINCREMENT;
+	sq_table_add_string(table, "name", offsetof(BenchCity, name), -1);
+
+	table = sq_schema_create(schema, "users", BenchUser);
+	column = sq_table_add_int(table, "id", offsetof(BenchUser, id));
+	column->bit_field |= SQB_PRIMARY | SQB_AUTOINCREMENT;
+	sq_table_add_int(table, "city_id", offsetof(BenchUser, city_id));
+	sq_table_add_double(table, "score", offsetof(BenchUser, score));
+	sq_table_add_string(table, "name", offsetof(BenchUser, name), -1);
+	for (int index = 0;  index < options->columns;  index++) {
+		snprintf(name, sizeof(name), "extra%d", index);
+		sq_table_add_string(table, name, offsetof(BenchUser, extra) + sizeof(char*) * index, -1);
+	}
+
+	sq_storage_migrate(storage, schema);
+	// synchronize schema to database and free 'schema'
+	sq_storage_migrate(storage, NULL);
+}
+
+static void  bench_print_stats(const char *db_name, SqdbStats *stats)
+{
+	SqPtrArray     *array;
+	SqdbStatsEntry *entry;
+
+	array = sqdb_stats_snapshot(stats, false);
+	fprintf(stdout, "SQL statements of %s database:\n", db_name);
+	fprintf(stdout, "%10s %10s %10s %10s %10s  %s\n",
+	        "count", "rows", "total(ms)", "p50(us)", "p99(us)", "fingerprint");
+	for (int index = 0;  index < array->length;  index++) {
+		entry = array->data[index];
+		fprintf(stdout, "%10llu %10llu %10.1f %10.1f %10.1f  %s\n",
+		        (unsigned long long)entry->count, (unsigned long long)entry->rows,
+		        entry->total_ns / 1e6,
+		        sqdb_stats_entry_percentile(entry, 50),
+		        sqdb_stats_entry_percentile(entry, 99),
+		        entry->fingerprint);
+	}
+	fprintf(stdout, "\n");
+	sq_ptr_array_free(array);
+}
+
+// ----------------------------------------------------------------------------
+// benchmark
+
+static void  bench_run(const char *db_name, BenchOptions *options)
+{
+	SqdbConfigSqlite  config = {0};
+	Sqdb       *db;
+	SqStorage  *storage;
+	SqQuery    *query;
+	SqCompiledQuery *compiled;
+	SqPtrArray *array;
+	BenchUser  *user;
+	BenchCity  *city;
+	double     *latency;
+	double      start, time_begin, time_end;
+	int        *ids;
+	int         n_rows = 0;
+	int         count;
+
+	if (strcmp(db_name, "file") == 0) {
+		char *path = malloc(strlen(options->folder) + sizeof("/bench-storage.db"));
+		strcpy(path, options->folder);
+		strcat(path, "/bench-storage.db");
+		remove(path);
+		free(path);
+	}
+
+	config.folder = options->folder;
+	db = sqdb_new(SQDB_INFO_SQLITE, (SqdbConfig*)&config);
+	storage = sq_storage_new(db);
+	if (sq_storage_open(storage, (strcmp(db_name, "file") == 0) ? "bench-storage" : ":memory:") != SQCODE_OK) {
+		fprintf(stdout, "Can't open database - %s\n", db_name);
+		sq_storage_free(storage);
+		sqdb_free(db);
+		return;
+	}
+	bench_make_schema(storage, options);
+	if (options->stats)
+		db->stats = sqdb_stats_new();
+
+	count = (options->rows > options->repeat) ? options->rows : options->repeat;
+	latency = malloc(sizeof(double) * count);
+	ids = malloc(sizeof(int) * options->rows);
+
+	city = calloc(1, sizeof(BenchCity));
+	for (int index = 0;  index < BENCH_CITIES;  index++) {
+		free(city->name);
+		city->name = bench_string(options->width, index);
+		sq_storage_insert(storage, "cities", NULL, city);
+	}
+	bench_city_free(city);
+
+	// --- insert ---
+	user = calloc(1, sizeof(BenchUser));
+	start = bench_now();
+	if (options->transaction)
+		sq_storage_begin(storage);
+	for (int index = 0;  index < options->rows;  index++) {
+		bench_user_fill(user, options, index);
+		time_begin = bench_now();
+		ids[index] = sq_storage_insert(storage, "users", NULL, user);
+		time_end = bench_now();
+		latency[index] = time_end - time_begin;
+	}
+	if (options->transaction)
+		sq_storage_commit(storage);
+	bench_record(db_name, "insert", latency, options->rows, options->rows, bench_now() - start);
+
+	// --- get ---
+	srand(1);
+	start = bench_now();
+	for (int index = 0;  index < options->rows;  index++) {
+		int  id = ids[rand() % options->rows];
+		time_begin = bench_now();
+		bench_user_free(sq_storage_get(storage, "users", NULL, id));
+		time_end = bench_now();
+		latency[index] = time_end - time_begin;
+	}
+	bench_record(db_name, "get", latency, options->rows, options->rows, bench_now() - start);
+
+	// --- get_all ---
+	start = bench_now();
+	for (int index = 0;  index < options->repeat;  index++) {
+		time_begin = bench_now();
+		array = sq_storage_get_all(storage, "users", NULL, NULL);
+		time_end = bench_now();
+		latency[index] = time_end - time_begin;
+		if (array) {
+			n_rows = array->length;
+			sq_ptr_array_foreach(array, element) {
+				bench_user_free(element);
+			}
+			sq_ptr_array_free(array);
+		}
+	}
+	bench_record(db_name, "get_all", latency, options->repeat, n_rows * options->repeat, bench_now() - start);
+
+	// --- query with join ---
+	// sq_storage_query() adds 'SELECT' columns to query that has multiple tables, so query is built every time.
+	start = bench_now();
+	for (int index = 0;  index < options->repeat;  index++) {
+		time_begin = bench_now();
+		query = sq_query_new(NULL);
+		sq_query_from(query, "cities");
+		sq_query_join(query, "users", "cities.id", "users.city_id");
+		array = sq_storage_query(storage, query, NULL, NULL);
+		sq_query_free(query);
+		time_end = bench_now();
+		latency[index] = time_end - time_begin;
+		if (array) {
+			n_rows = array->length;
+			sq_ptr_array_foreach(array, element) {
+				bench_city_free(((void**)element)[0]);
+				bench_user_free(((void**)element)[1]);
+				free(element);
+			}
+			sq_ptr_array_free(array);
+		}
+	}
+	bench_record(db_name, "query_join", latency, options->repeat, n_rows * options->repeat, bench_now() - start);
+
+	// --- compiled query with join ---
+	query = sq_query_new(NULL);
+	sq_query_from(query, "cities");
+	sq_query_join(query, "users", "cities.id", "users.city_id");
+	sq_query_where(query, "users.id", ">", ":min_id");
+	compiled = sq_storage_compile(storage, query, NULL, NULL);
+	sq_query_free(query);
+	start = bench_now();
+	for (int index = 0;  compiled && index < options->repeat;  index++) {
+		time_begin = bench_now();
+		sq_compiled_query_bind_int(compiled, 1, 0);
+		array = sq_compiled_query_exec(compiled);
+		time_end = bench_now();
+		latency[index] = time_end - time_begin;
+		if (array) {
+			n_rows = array->length;
+			sq_ptr_array_foreach(array, element) {
+				bench_city_free(((void**)element)[0]);
+				bench_user_free(((void**)element)[1]);
+				free(element);
+			}
+			sq_ptr_array_free(array);
+		}
+	}
+	if (compiled) {
+		sq_compiled_query_free(compiled);
+		bench_record(db_name, "query_compiled", latency, options->repeat, n_rows * options->repeat, bench_now() - start);
+	}
+
+	// --- update ---
+	start = bench_now();
+	if (options->transaction)
+		sq_storage_begin(storage);
+	for (int index = 0;  index < options->rows;  index++) {
+		bench_user_fill(user, options, index + 1);
+		user->id = ids[index];
+		time_begin = bench_now();
+		sq_storage_update(storage, "users", NULL, user);
+		time_end = bench_now();
+		latency[index] = time_end - time_begin;
+	}
+	if (options->transaction)
+		sq_storage_commit(storage);
+	bench_record(db_name, "update", latency, options->rows, options->rows, bench_now() - start);
+	bench_user_free(user);
+
+	// --- remove ---
+	start = bench_now();
+	if (options->transaction)
+		sq_storage_begin(storage);
+	for (int index = 0;  index < options->rows;  index++) {
+		time_begin = bench_now();
+		sq_storage_remove(storage, "users", NULL, ids[index]);
+		time_end = bench_now();
+		latency[index] = time_end - time_begin;
+	}
+	if (options->transaction)
+		sq_storage_commit(storage);
+	bench_record(db_name, "remove", latency, options->rows, options->rows, bench_now() - start);
+
+	free(ids);
+	free(latency);
+	if (db->stats) {
+		bench_print_stats(db_name, db->stats);
+		sqdb_stats_free(db->stats);
+		db->stats = NULL;
+	}
+	sq_storage_close(storage);
+	sq_storage_free(storage);
+	sqdb_free(db);
+}
+
+// ----------------------------------------------------------------------------
+// output
+
+static void  bench_print(FILE *file)
+{
+	BenchResult *result;
+
+	fprintf(file, "%-8s %-14s %8s %10s %12s %12s %10s %10s\n",
+	        "db", "op", "calls", "rows", "ops/sec", "rows/sec", "p50(us)", "p99(us)");
+	for (int index = 0;  index < n_results;  index++) {
+		result = results + index;
+		fprintf(file, "%-8s %-14s %8d %10d %12.0f %12.0f %10.1f %10.1f\n",
+		        result->db, result->op, result->count, result->rows,
+		        result->count / result->seconds, result->rows / result->seconds,
+		        result->p50, result->p99);
+	}
+}
+
+static void  bench_print_json(FILE *file, BenchOptions *options)
+{
+	BenchResult *result;
+
+	fprintf(file, "{\n"
+	              "  \"benchmark\": \"bench-storage\",\n"
+	              "  \"rows\": %d,\n"
+	              "  \"width\": %d,\n"
+	              "  \"columns\": %d,\n"
+	              "  \"repeat\": %d,\n"
+	              "  \"transaction\": %s,\n"
+	              "  \"debug\": %s,\n"
+	              "  \"results\": [",
+	        options->rows, options->width, options->columns, options->repeat,
+	        (options->transaction) ? "true" : "false",
+#ifdef DEBUG
+	        "true");
+#else
+	        "false");
+#endif
+
+	for (int index = 0;  index < n_results;  index++) {
+		result = results + index;
+		fprintf(file, "%s\n    {\"db\": \"%s\", \"op\": \"%s\", \"calls\": %d, \"rows\": %d, "
+		              "\"seconds\": %.6f, \"ops_per_sec\": %.1f, \"rows_per_sec\": %.1f, "
+		              "\"p50_us\": %.3f, \"p99_us\": %.3f}",
+		        (index) ? "," : "",
+		        result->db, result->op, result->count, result->rows, result->seconds,
+		        result->count / result->seconds, result->rows / result->seconds,
+		        result->p50, result->p99);
+	}
+	fprintf(file, "\n  ]\n}\n");
+}
+
+static int  bench_usage(const char *program)
+{
+	fprintf(stdout, "Usage: %s [--rows N] [--width N] [--columns N] [--repeat N]\n"
+	                "       [--db memory|file|both] [--folder PATH] [--transaction]\n"
+	                "       [--json PATH] [--stats] [--verbose]\n",
+	        program);
+	return EXIT_FAILURE;
+}
+
+int  main(int argc, char *argv[])
+{
+	BenchOptions  options = {1000, 32, 4, 10, true, true, false, false, false, ".", NULL};
+	FILE         *file;
+	const char   *arg;
+
+	for (int index = 1;  index < argc;  index++) {
+		arg = argv[index];
+		if (strcmp(arg, "--transaction") == 0)
+			options.transaction = true;
+		else if (strcmp(arg, "--stats") == 0)
+			options.stats = true;
+		else if (strcmp(arg, "--verbose") == 0)
+			options.verbose = true;
+		else if (index + 1 == argc)
+			return bench_usage(argv[0]);
+		else if (strcmp(arg, "--rows") == 0)
+			options.rows = atoi(argv[++index]);
+		else if (strcmp(arg, "--width") == 0)
+			options.width = atoi(argv[++index]);
+		else if (strcmp(arg, "--columns") == 0)
+			options.columns = atoi(argv[++index]);
+		else if (strcmp(arg, "--repeat") == 0)
+			options.repeat = atoi(argv[++index]);
+		else if (strcmp(arg, "--folder") == 0)
+			options.folder = argv[++index];
+		else if (strcmp(arg, "--json") == 0)
+			options.json = argv[++index];
+		else if (strcmp(arg, "--db") == 0) {
+			arg = argv[++index];
+			options.memory = (strcmp(arg, "memory") == 0 || strcmp(arg, "both") == 0);
+			options.file   = (strcmp(arg, "file")   == 0 || strcmp(arg, "both") == 0);
+			if (options.memory == false && options.file == false)
+				return bench_usage(argv[0]);
+		}
+		else
+			return bench_usage(argv[0]);
+	}
+	if (options.rows < 1 || options.width < 0 || options.repeat < 1 ||
+	    options.columns < 0 || options.columns > BENCH_COLUMNS_MAX)
+	{
+		return bench_usage(argv[0]);
+	}
+
+	if (options.verbose == false) {
+#if defined(_WIN32)
+		freopen("NUL", "w", stderr);
+#else
+		freopen("/dev/null", "w", stderr);
+#endif
+	}
+
+	if (options.memory)
+		bench_run("memory", &options);
+	if (options.file)
+		bench_run("file", &options);
+
+	if (options.json == NULL || strcmp(options.json, "-") != 0)
+		bench_print(stdout);
+	if (options.json) {
+		if (strcmp(options.json, "-") == 0)
+			file = stdout;
+		else if ((file = fopen(options.json, "w")) == NULL) {
+			fprintf(stdout, "Can't write file - %s\n", options.json);
+			return EXIT_FAILURE;
+		}
+		bench_print_json(file, &options);
+		if (file != stdout)
+			fclose(file);
+	}
+	return EXIT_SUCCESS;
+}
+
+#else   // SQ_CONFIG_HAVE_SQLITE
+
+int  main(void)
+{
+	fprintf(stdout, "bench-storage requires SQLite.\n");
+	return EXIT_SUCCESS;
+}
+
+#endif  // SQ_CONFIG_HAVE_SQLITE
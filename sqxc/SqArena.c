@@ -0,0 +1,137 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#include <stdlib.h>     // malloc, free
+#include <string.h>     // memset, memcpy, strlen
+
+#include <SqConfig.h>
+#include <SqArena.h>
+
+// alignment of memory that returned by sq_arena_alloc()
+#define SQ_ARENA_ALIGN    (sizeof(void*) > sizeof(double) ? sizeof(void*) * 2 : sizeof(double) * 2)
+
+struct SqArenaChunk
+{
+	SqArenaChunk  *prev;
+	size_t         size;     // size of data
+	// data follow this header
+};
+
+// size of chunk header that keeps data aligned
+#define CHUNK_HEADER_SIZE    ((sizeof(SqArenaChunk) + SQ_ARENA_ALIGN - 1) & ~(SQ_ARENA_ALIGN - 1))
+
+SqArena *sq_arena_new(size_t chunk_size)
+{
+	SqArena *arena;
+
+	arena = malloc(sizeof(SqArena));
+	sq_arena_init(arena, chunk_size);
+	return arena;
+}
+
+void  sq_arena_free(SqArena *arena)
+{
+	sq_arena_final(arena);
+	free(arena);
+}
+
+void  sq_arena_init(SqArena *arena, size_t chunk_size)
+{
+	if (chunk_size == 0)
+		chunk_size = SQ_CONFIG_ARENA_CHUNK_SIZE_DEFAULT;
+	arena->chunk_size = chunk_size;
+	arena->chunk = NULL;
+	arena->cur = NULL;
+	arena->end = NULL;
+}
+
+void  sq_arena_final(SqArena *arena)
+{
+	SqArenaChunk *chunk, *prev;
+
+	for (chunk = arena->chunk;  chunk;  chunk = prev) {
+		prev = chunk->prev;
+		free(chunk);
+	}
+	arena->chunk = NULL;
+	arena->cur = NULL;
+	arena->end = NULL;
+}
+
+void  sq_arena_reset(SqArena *arena)
+{
+	SqArenaChunk *chunk, *prev, *keep = NULL;
+
+	// keep one chunk that has default size, free others.
+	for (chunk = arena->chunk;  chunk;  chunk = prev) {
+		prev = chunk->prev;
+		if (keep == NULL && chunk->size == arena->chunk_size)
+			keep = chunk;
+		else
+			free(chunk);
+	}
+	arena->chunk = keep;
+	if (keep) {
+		keep->prev = NULL;
+		arena->cur = (char*)keep + CHUNK_HEADER_SIZE;
+		arena->end = arena->cur + keep->size;
+	}
+	else {
+		arena->cur = NULL;
+		arena->end = NULL;
+	}
+}
+
+void *sq_arena_alloc(SqArena *arena, size_t size)
+{
+	SqArenaChunk *chunk;
+	char         *mem;
+
+	size = (size + SQ_ARENA_ALIGN - 1) & ~(SQ_ARENA_ALIGN - 1);
+	if ((size_t)(arena->end - arena->cur) >= size) {
+		mem = arena->cur;
+		arena->cur += size;
+		return mem;
+	}
+
+	// large memory has its own chunk, it doesn't waste free space in current chunk.
+	if (size > arena->chunk_size / 4 && arena->chunk) {
+		chunk = malloc(CHUNK_HEADER_SIZE + size);
+		chunk->size = size;
+		chunk->prev = arena->chunk->prev;
+		arena->chunk->prev = chunk;
+		return (char*)chunk + CHUNK_HEADER_SIZE;
+	}
+
+	chunk = malloc(CHUNK_HEADER_SIZE + ((size > arena->chunk_size) ? size : arena->chunk_size));
+	chunk->size = (size > arena->chunk_size) ? size : arena->chunk_size;
+	chunk->prev = arena->chunk;
+	arena->chunk = chunk;
+	mem = (char*)chunk + CHUNK_HEADER_SIZE;
+	arena->cur = mem + size;
+	arena->end = mem + chunk->size;
+	return mem;
+}
+
+void *sq_arena_calloc(SqArena *arena, size_t size)
+{
+	return memset(sq_arena_alloc(arena, size), 0, size);
+}
+
+char *sq_arena_strdup(SqArena *arena, const char *string)
+{
+	size_t  length = strlen(string) + 1;
+
+	return memcpy(sq_arena_alloc(arena, length), string, length);
+}
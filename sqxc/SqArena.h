@@ -0,0 +1,104 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQ_ARENA_H
+#define SQ_ARENA_H
+
+#include <stddef.h>    // size_t
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+typedef struct SqArena         SqArena;
+typedef struct SqArenaChunk    SqArenaChunk;    // define in SqArena.c
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 'chunk_size' is size of memory chunk. 0 = default.
+SqArena *sq_arena_new(size_t chunk_size);
+// free arena and all memory that allocated by arena
+void     sq_arena_free(SqArena *arena);
+
+void     sq_arena_init(SqArena *arena, size_t chunk_size);
+void     sq_arena_final(SqArena *arena);
+
+// release all memory that allocated by arena. arena keeps one chunk and can be reused.
+void     sq_arena_reset(SqArena *arena);
+
+// Memory is aligned for any basic type. It is released by sq_arena_free() or sq_arena_reset().
+void    *sq_arena_alloc(SqArena *arena, size_t size);
+void    *sq_arena_calloc(SqArena *arena, size_t size);
+char    *sq_arena_strdup(SqArena *arena, const char *string);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+// ----------------------------------------------------------------------------
+// C/C++ common definitions: define structue
+
+/*
+    SqArena - allocate memory from large chunks, all memory are released at once.
+ */
+struct SqArena
+{
+	SqArenaChunk  *chunk;        // current chunk. Chunks are linked from newest to oldest.
+	char          *cur;          // free space in current chunk
+	char          *end;
+	size_t         chunk_size;
+};
+
+// ----------------------------------------------------------------------------
+// C++ definitions: define C++ data, function, method, and others.
+
+#ifdef __cplusplus
+
+namespace Sq {
+
+// conforming C++11 standard-layout
+// These are for directly use only. You can NOT derived it.
+struct Arena : SqArena
+{
+	Arena(size_t chunk_size = 0) {
+		sq_arena_init((SqArena*)this, chunk_size);
+	}
+	~Arena() {
+		sq_arena_final((SqArena*)this);
+	}
+
+	void *alloc(size_t size) {
+		return sq_arena_alloc((SqArena*)this, size);
+	}
+	void *calloc(size_t size) {
+		return sq_arena_calloc((SqArena*)this, size);
+	}
+	char *strdup(const char *string) {
+		return sq_arena_strdup((SqArena*)this, string);
+	}
+	void  reset() {
+		sq_arena_reset((SqArena*)this);
+	}
+};
+
+};  // namespace Sq
+
+#endif  // __cplusplus
+
+
+#endif  // SQ_ARENA_H
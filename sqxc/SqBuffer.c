@@ -14,6 +14,7 @@
 
 #include <SqConfig.h>
 #include <SqBuffer.h>
+#include <SqUtil.h>
 
 #define SQ_BUFFER_SIZE_DEFAULT    SQ_CONFIG_BUFFER_SIZE_DEAULT
 
@@ -53,6 +54,30 @@ char *sq_buffer_alloc_at(SqBuffer *buf, int position, int count)
 	return buf->buf + position;
 }
 
+// ------------------------------------
+// number to text. Allocate enough space, then give back unused part.
+
+void  sq_buffer_write_int64(SqBuffer *buffer, int64_t value)
+{
+	char *dest = sq_buffer_alloc(buffer, SQ_INT64_STR_SIZE);
+
+	buffer->writed -= SQ_INT64_STR_SIZE - sq_int64_to_str(dest, value);
+}
+
+void  sq_buffer_write_uint64(SqBuffer *buffer, uint64_t value)
+{
+	char *dest = sq_buffer_alloc(buffer, SQ_INT64_STR_SIZE);
+
+	buffer->writed -= SQ_INT64_STR_SIZE - sq_uint64_to_str(dest, value);
+}
+
+void  sq_buffer_write_double(SqBuffer *buffer, double value)
+{
+	char *dest = sq_buffer_alloc(buffer, SQ_DOUBLE_STR_SIZE);
+
+	buffer->writed -= SQ_DOUBLE_STR_SIZE - sq_double_to_str(dest, value);
+}
+
 // ----------------------------------------------------------------------------
 // If C compiler doesn't support C99 inline function.
 
@@ -17,6 +17,7 @@
 
 #include <stdlib.h>    // calloc(), realloc()
 #include <string.h>    // memcpy(), strcpy(), strlen()
+#include <stdint.h>    // int64_t, uint64_t
 
 // ----------------------------------------------------------------------------
 // C/C++ common declarations: declare type, structue, macro, enumeration.
@@ -100,6 +101,11 @@ void *sq_buffer_resize(SqBuffer *buf, int size);
 // It reserve space in tail of buffer for NULL-terminated
 char *sq_buffer_alloc_at(SqBuffer *buf, int position, int count);
 
+// write number as text to tail of buffer without calling printf(). (SqUtil-number.c)
+void  sq_buffer_write_int64(SqBuffer *buffer, int64_t value);
+void  sq_buffer_write_uint64(SqBuffer *buffer, uint64_t value);
+void  sq_buffer_write_double(SqBuffer *buffer, double value);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
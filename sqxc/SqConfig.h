@@ -49,6 +49,21 @@
 /* Sqxc can process (skip) unknown array & object */
 // #define SQ_CONFIG_SQXC_UNKNOWN_SKIP
 
+/* Sqxc.c - sqxc_send() use frozen chain (dispatch table) to find element that support SqxcType.
+   It is disabled if SQ_CONFIG_SQXC_UNKNOWN_SKIP is defined because chain changes while sending. */
+#define SQ_CONFIG_SQXC_DISPATCH
+
+/* SqxcSql.h - SqxcSql output '?' placeholders and bind values to prepared statement
+   if Sqdb caches prepared statements (SqdbInfo.stmt_cache is 1). */
+#define SQ_CONFIG_SQXC_SQL_USE_PARAM
+
+/* SqUtil-escape.c - use SSE2/AVX2 to find characters that need escaping in SQL and JSON string */
+#define SQ_CONFIG_ESCAPE_SIMD
+
+/* SqUtil.c - time string without time zone is UTC time instead of local time.
+   Enable it if time is generated by SQL, e.g. CURRENT_TIMESTAMP of SQLite is UTC time. */
+// #define SQ_CONFIG_TIME_UTC
+
 /* Enable "SQL_table_name" <-> "C struct type_name" converting. (SqSchema.h, SqUtil.h)
    When calling sq_schema_create_xxx():
      user only specify "SQL_table_name", program generate "C struct type_name".
@@ -65,12 +80,46 @@
 /* SqEntry.c, SqType.c, SqSchema.c - SQ_TYPE_N_ENTRY_DEFAULT */
 #define SQ_CONFIG_TYPE_N_ENTRY_DEFAULT            16
 
+/* SqArena.c - size of memory chunk if chunk_size is 0 */
+#define SQ_CONFIG_ARENA_CHUNK_SIZE_DEFAULT    16384
+
+/* SqQuery.c - size of memory chunk for strings in SqQuery */
+#define SQ_CONFIG_QUERY_ARENA_CHUNK_SIZE      1024
+
+/* SqIntern.c - initial number of hash buckets (power of 2) */
+#define SQ_CONFIG_INTERN_BUCKETS_DEFAULT          64
+
 /* SqBuffer.c - SQ_BUFFER_SIZE_DEFAULT */
 #define SQ_CONFIG_BUFFER_SIZE_DEAULT             128
 
 /* SqxcSql.c */
 #define SQ_CONFIG_SQXC_SQL_BUFFER_SIZE_DEAULT    256
 
+/* SqxcJsonWriter.c - buffer is flushed to sink when it reaches this size */
+#define SQ_CONFIG_JSON_WRITER_FLUSH_SIZE        4096
+
+/* SqxcJsonWriter.c - initial number of cached keys (power of 2) */
+#define SQ_CONFIG_JSON_WRITER_KEYS_DEFAULT        32
+
+/* SqdbSqlite.c - capacity of prepared statement cache */
+#define SQ_CONFIG_SQLITE_STMT_CACHE_SIZE_DEFAULT      32
+
+/* SqdbSqlite.c - milliseconds of busy_timeout in performance presets */
+#define SQ_CONFIG_SQLITE_BUSY_TIMEOUT_DEFAULT   5000
+
+/* SqdbPool.c - max number of connections if SqdbConfigPool.max_connections is 0 */
+#define SQ_CONFIG_SQDB_POOL_MAX_DEFAULT            8
+
+/* SqdbStats.c - default threshold of slow query log in microseconds */
+#define SQ_CONFIG_SQDB_STATS_SLOW_THRESHOLD   100000
+
+/* SqStorage.c - max number of values in an INSERT statement of sq_storage_insert_all().
+   999 is default SQLITE_MAX_VARIABLE_NUMBER before SQLite 3.32.0 */
+#define SQ_CONFIG_STORAGE_INSERT_ALL_PARAMS      999
+
+/* SqStorage-async.c - number of worker threads if n_threads is 0 */
+#define SQ_CONFIG_STORAGE_ASYNC_THREADS_DEFAULT    4
+
 /* SqType-PtrArray.c - SQ_TYPE_PTR_ARRAY_SIZE_DEFAULT */
 #define SQ_CONFIG_TYPE_PTR_ARRAY_SIZE_DEFAULT     16
 
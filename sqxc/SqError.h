@@ -46,9 +46,14 @@ extern "C" {
 // SQL - error
 #define SQCODE_OPEN_FAIL             51
 #define SQCODE_EXEC_ERROR            52
+// SQL - prepared statement
+#define SQCODE_ROW                   55    // sqdb_stmt_step() has another row ready
+#define SQCODE_DONE                  56    // sqdb_stmt_step() has finished executing
 
 // JSON error
 #define SQCODE_UNCOMPLETED_JSON      61
+#define SQCODE_WRITE_ERROR           62    // SqxcJsonWriter can't write to sink
+#define SQCODE_INVALID_JSON          63    // SqxcJsonParser found syntax error
 
 
 #ifdef __cplusplus
@@ -0,0 +1,208 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#include <stddef.h>     // offsetof
+#include <stdlib.h>     // malloc, calloc, free
+#include <string.h>     // memcpy, strlen, strcmp
+
+#include <SqConfig.h>
+#include <SqIntern.h>
+
+struct SqInternTable
+{
+	SqInternStr  **buckets;
+	unsigned int   n_buckets;    // power of 2
+	unsigned int   length;       // number of strings
+	SqArena       *arena;
+
+	SqMutex        mutex;
+	bool           finalized;    // SqIntern was finalized while strings are in use
+};
+
+struct SqInternStr
+{
+	SqInternStr   *next;         // next string in the same bucket
+	SqInternTable *table;        // NULL if string is not shared. It doesn't change after creation.
+	unsigned int   hash;
+	unsigned int   ref_count;    // protected by table->mutex if string is shared
+	bool           in_arena;     // string was allocated from arena. It doesn't change after creation.
+	char           string[1];
+};
+
+#define SQ_INTERN_STR(string)    ((SqInternStr*)((char*)(string) - offsetof(SqInternStr, string)))
+
+static SqInternStr *intern_str_new(SqInternTable *table, const char *string, unsigned int hash)
+{
+	SqInternStr *istr;
+	size_t       length = strlen(string) + 1;
+
+	if (table && table->arena) {
+		istr = sq_arena_alloc(table->arena, offsetof(SqInternStr, string) + length);
+		istr->in_arena = true;
+	}
+	else {
+		istr = malloc(offsetof(SqInternStr, string) + length);
+		istr->in_arena = false;
+	}
+	istr->next = NULL;
+	istr->table = table;
+	istr->hash = hash;
+	istr->ref_count = 1;
+	memcpy(istr->string, string, length);
+	return istr;
+}
+
+static void intern_resize(SqInternTable *table)
+{
+	SqInternStr **buckets, *istr, *next;
+	unsigned int  n_buckets = table->n_buckets * 2;
+
+	buckets = calloc(n_buckets, sizeof(SqInternStr*));
+	for (unsigned int index = 0;  index < table->n_buckets;  index++) {
+		for (istr = table->buckets[index];  istr;  istr = next) {
+			next = istr->next;
+			istr->next = buckets[istr->hash & (n_buckets - 1)];
+			buckets[istr->hash & (n_buckets - 1)] = istr;
+		}
+	}
+	free(table->buckets);
+	table->buckets = buckets;
+	table->n_buckets = n_buckets;
+}
+
+static void intern_table_free(SqInternTable *table)
+{
+	free(table->buckets);
+	sq_mutex_final(&table->mutex);
+	free(table);
+}
+
+SqIntern *sq_intern_new(SqArena *arena)
+{
+	SqIntern *intern;
+
+	intern = malloc(sizeof(SqIntern));
+	sq_intern_init(intern, arena);
+	return intern;
+}
+
+void  sq_intern_free(SqIntern *intern)
+{
+	sq_intern_final(intern);
+	free(intern);
+}
+
+void  sq_intern_init(SqIntern *intern, SqArena *arena)
+{
+	SqInternTable *table;
+
+	table = malloc(sizeof(SqInternTable));
+	table->n_buckets = SQ_CONFIG_INTERN_BUCKETS_DEFAULT;
+	table->buckets = calloc(table->n_buckets, sizeof(SqInternStr*));
+	table->length = 0;
+	table->arena = arena;
+	table->finalized = false;
+	sq_mutex_init(&table->mutex, false);
+	intern->table = table;
+}
+
+void  sq_intern_final(SqIntern *intern)
+{
+	SqInternTable *table = intern->table;
+
+	sq_mutex_lock(&table->mutex);
+	if (table->length > 0 && table->arena == NULL) {
+		// the last sq_intern_unref() will free table
+		table->finalized = true;
+		sq_mutex_unlock(&table->mutex);
+		return;
+	}
+	sq_mutex_unlock(&table->mutex);
+
+	intern_table_free(table);
+}
+
+char *sq_intern_ref(SqIntern *intern, const char *string)
+{
+	SqInternTable *table;
+	SqInternStr   *istr, **bucket;
+	unsigned int   hash = 2166136261u;    // FNV-1a
+
+	if (intern == NULL)
+		return intern_str_new(NULL, string, 0)->string;
+
+	for (const char *cur = string;  *cur;  cur++)
+		hash = (hash ^ (unsigned char)*cur) * 16777619u;
+
+	table = intern->table;
+	sq_mutex_lock(&table->mutex);
+	bucket = table->buckets + (hash & (table->n_buckets - 1));
+	for (istr = *bucket;  istr;  istr = istr->next) {
+		if (istr->hash == hash && strcmp(istr->string, string) == 0) {
+			if (istr->in_arena == false)
+				istr->ref_count++;
+			sq_mutex_unlock(&table->mutex);
+			return istr->string;
+		}
+	}
+
+	istr = intern_str_new(table, string, hash);
+	istr->next = *bucket;
+	*bucket = istr;
+	if (++table->length > table->n_buckets)
+		intern_resize(table);
+	sq_mutex_unlock(&table->mutex);
+	return istr->string;
+}
+
+void  sq_intern_unref(const char *string)
+{
+	SqInternTable *table;
+	SqInternStr   *istr, **addr;
+
+	if (string == NULL)
+		return;
+	istr = SQ_INTERN_STR(string);
+	if (istr->in_arena)
+		return;
+
+	table = istr->table;
+	if (table == NULL) {
+		if (sq_atomic_add_fetch(&istr->ref_count, -1) == 0)
+			free(istr);
+		return;
+	}
+
+	sq_mutex_lock(&table->mutex);
+	if (--istr->ref_count > 0) {
+		sq_mutex_unlock(&table->mutex);
+		return;
+	}
+	// remove string from bucket
+	for (addr = table->buckets + (istr->hash & (table->n_buckets - 1));  *addr;  addr = &(*addr)->next) {
+		if (*addr == istr) {
+			*addr = istr->next;
+			break;
+		}
+	}
+	free(istr);
+	table->length--;
+
+	if (table->finalized && table->length == 0) {
+		sq_mutex_unlock(&table->mutex);
+		intern_table_free(table);
+		return;
+	}
+	sq_mutex_unlock(&table->mutex);
+}
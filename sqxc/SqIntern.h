@@ -0,0 +1,104 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQ_INTERN_H
+#define SQ_INTERN_H
+
+#include <stdbool.h>     // bool
+
+#include <SqArena.h>
+#include <SqThread.h>
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+typedef struct SqIntern        SqIntern;
+typedef struct SqInternStr     SqInternStr;    // define in SqIntern.c
+typedef struct SqInternTable   SqInternTable;  // define in SqIntern.c
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// If 'arena' is not NULL, strings are allocated from 'arena' and they are not reference counted.
+SqIntern *sq_intern_new(SqArena *arena);
+// If interned strings are still in use, they are valid until they are released.
+void      sq_intern_free(SqIntern *intern);
+
+void      sq_intern_init(SqIntern *intern, SqArena *arena);
+void      sq_intern_final(SqIntern *intern);
+
+// return shared copy of 'string' and increase its reference count. Returned string is read-only.
+// If 'intern' is NULL, it returns unshared copy that can be released by sq_intern_unref().
+char     *sq_intern_ref(SqIntern *intern, const char *string);
+
+// decrease reference count of string that returned by sq_intern_ref(). 'string' can be NULL.
+// It does nothing if string was allocated from arena.
+void      sq_intern_unref(const char *string);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+// ----------------------------------------------------------------------------
+// C/C++ common definitions: define structue
+
+/*
+    SqIntern - table of shared strings. Each distinct value is stored only once.
+
+    It is thread-safe. It is used by SQ_TYPE_INTERN_STRING to deduplicate values of
+    low-cardinality columns.
+ */
+struct SqIntern
+{
+	// Interned strings point to this table. If strings are still in use when SqIntern is
+	// finalized, the table is freed after the last one is released.
+	SqInternTable *table;
+};
+
+// ----------------------------------------------------------------------------
+// C++ definitions: define C++ data, function, method, and others.
+
+#ifdef __cplusplus
+
+namespace Sq {
+
+// conforming C++11 standard-layout
+// These are for directly use only. You can NOT derived it.
+struct Intern : SqIntern
+{
+	Intern(SqArena *arena = NULL) {
+		sq_intern_init((SqIntern*)this, arena);
+	}
+	~Intern() {
+		sq_intern_final((SqIntern*)this);
+	}
+
+	char *ref(const char *string) {
+		return sq_intern_ref((SqIntern*)this, string);
+	}
+	static void unref(const char *string) {
+		sq_intern_unref(string);
+	}
+};
+
+};  // namespace Sq
+
+#endif  // __cplusplus
+
+
+#endif  // SQ_INTERN_H
@@ -132,9 +132,10 @@ extern "C" {
 #define sq_ptr_array_foreach(array, element)                    \
 		for (void **element##_end  = sq_ptr_array_end(array),   \
 		          **element##_addr = sq_ptr_array_begin(array), \
-		           *element = *element##_addr;                  \
-		     element##_addr < element##_end;                    \
-		     element##_addr++, element = *element##_addr)
+		           *element;                                    \
+		     element##_addr < element##_end &&                  \
+		     ((element = *element##_addr), 1);                  \
+		     element##_addr++)
 
 // void sq_ptr_array_foreach_addr(void *array, void **element_addr)
 #define sq_ptr_array_foreach_addr(array, element_addr)              \
@@ -147,25 +148,28 @@ extern "C" {
 #define sq_string_array_foreach(array, element)                 \
 		for (char **element##_end  = (char**)sq_ptr_array_end(array),   \
 		          **element##_addr = (char**)sq_ptr_array_begin(array), \
-		           *element = *element##_addr;                  \
-		     element##_addr < element##_end;                    \
-		     element##_addr++, element = *element##_addr)
+		           *element;                                    \
+		     element##_addr < element##_end &&                  \
+		     ((element = *element##_addr), 1);                  \
+		     element##_addr++)
 
 // void sq_intptr_array_foreach(void *array, intptr_t *element_addr)
 #define sq_intptr_array_foreach(array, element)                \
 		for (intptr_t *element##_end  = (intptr_t*)sq_ptr_array_end(array),   \
 		              *element##_addr = (intptr_t*)sq_ptr_array_begin(array), \
-		               element        = *element##_addr;       \
-		     element##_addr < element##_end;                   \
-		     element##_addr++, element = *element##_addr)
+		               element;                                \
+		     element##_addr < element##_end &&                 \
+		     ((element = *element##_addr), 1);                 \
+		     element##_addr++)
 
 // void sq_uintptr_array_foreach(void *array, uintptr_t *element_addr)
 #define sq_uintptr_array_foreach(array, element)                \
 		for (uintptr_t *element##_end  = (uintptr_t*)sq_ptr_array_end(array),   \
 		               *element##_addr = (uintptr_t*)sq_ptr_array_begin(array), \
-		                element        = *element##_addr;       \
-		     element##_addr < element##_end;                    \
-		     element##_addr++, element = *element##_addr)
+		                element;                                \
+		     element##_addr < element##_end &&                  \
+		     ((element = *element##_addr), 1);                  \
+		     element##_addr++)
 
 // ----------------------------------------------------------------------------
 // macro for maintaining C/C++ inline functions easily
@@ -18,11 +18,14 @@
 #include <string.h>
 #include <stdio.h>      // vsnprintf
 
+#include <SqConfig.h>
+#include <SqBuffer.h>
 #include <SqQuery.h>
 
 static SqQueryNode *sq_query_condition(SqQuery *query, const char *first, va_list arg_list);
 static void         sq_query_column(SqQuery *query, SqQueryNode *parent, const char *first, va_list arg_list);
 static void         sq_query_free_all_node(SqQuery *query);
+static char        *sq_query_name(SqQuery *query, const char *name);
 
 static SqQueryNode *sq_query_node_new(SqQuery *query);
 static void         sq_query_node_free(SqQueryNode *node, SqQuery *query);
@@ -132,6 +135,7 @@ const uintptr_t SQ_QUERYSORT_DESC = SQN_DESC;
 SqQuery *sq_query_init(SqQuery *query, const char *table_name)
 {
 	memset(query, 0, sizeof(SqQuery));
+	sq_arena_init(&query->arena, SQ_CONFIG_QUERY_ARENA_CHUNK_SIZE);
 
 	if (table_name)
 		sq_query_from(query, table_name);
@@ -147,22 +151,30 @@ SqQuery *sq_query_final(SqQuery *query)
 		sq_query_pop_nested(query);
 	// free SqQueryNode
 	sq_query_free_all_node(query);
+	// free strings
+	sq_arena_final(&query->arena);
 	return query;
 }
 
 void  sq_query_clear(SqQuery *query)
 {
-	// clear query->root 
+	SqQueryNested *nested;
+
+	// keep top level SqQueryNested
+	while (query->nested_count > 1)
+		sq_query_pop_nested(query);
+	nested = query->nested_cur;
+	nested->inner = NULL;
+	nested->command = NULL;
+	nested->name = NULL;
+	nested->aliasable = NULL;
+	nested->where = NULL;
+	nested->joinon = NULL;
+	// move all SqQueryNode to freed list, chunks of SqQueryNode are kept.
+	sq_query_node_free(query->root.children, query);
 	query->root.children = NULL;
-	// run finalize function
-	sq_query_final(query);
-	// sq_query_free_all_node() doesn't reset these
-	query->node = NULL;
-	query->node_chunk = NULL;
-	query->node_count = 0;
-	query->freed = NULL;
-	// sq_query_init() also do this
-	sq_query_push_nested(query, &query->root);
+	// release strings, one chunk of arena is kept.
+	sq_arena_reset(&query->arena);
 }
 
 bool sq_query_from(SqQuery *query, const char *table)
@@ -189,7 +201,7 @@ bool sq_query_from(SqQuery *query, const char *table)
 	}
 	else {
 		node->type = SQN_VALUE;
-		node->value = strdup(table);
+		node->value = sq_query_name(query, table);
 	}
 	return true;
 }
@@ -210,7 +222,7 @@ void sq_query_as(SqQuery *query, const char *name)
 	// insert alias name
 	sub_node = sq_query_node_new(query);
 	sub_node->type = SQN_VALUE;
-	sub_node->value = strdup(name);
+	sub_node->value = sq_query_name(query, name);
 	sub_node->next = node->next;
 	node->next = sub_node;
 	node = sub_node;
@@ -378,7 +390,7 @@ void sq_query_join_va(SqQuery *query, const char *table, const char *first, va_l
 	}
 	else {
 		node->type = SQN_VALUE;
-		node->value = strdup(table);
+		node->value = sq_query_name(query, table);
 	}
 
 	sq_query_node_append(joinon, sq_query_condition(query, first, arg_list));
@@ -561,7 +573,7 @@ static void sq_query_column(SqQuery *query, SqQueryNode *node, const char *first
 		// replace '*', "ASC", or "DESC" if user specify column
 		if (node->type != SQN_VALUE) {
 			node->type  = SQN_VALUE;
-			node->value = strdup(name);
+			node->value = sq_query_name(query, name);
 			continue;
 		}
 		// if node->type == SQN_VALUE, add ',' if user specify multiple column
@@ -574,7 +586,7 @@ static void sq_query_column(SqQuery *query, SqQueryNode *node, const char *first
 		// append column name
 		sub_node = sq_query_node_new(query);
 		sub_node->type = SQN_VALUE;
-		sub_node->value = strdup(name);
+		sub_node->value = sq_query_name(query, name);
 		node->next = sub_node;
 		node = sub_node;
 		// for sq_query_as()
@@ -593,6 +605,7 @@ static SqQueryNode *sq_query_condition(SqQuery *query, const char *first, va_lis
 {
 	SqQueryNode *node;
 	const char  *argv[3];
+	char         format_buf[256];
 	union {
 		int       length;
 		int       index;
@@ -613,14 +626,14 @@ static SqQueryNode *sq_query_condition(SqQuery *query, const char *first, va_lis
 		// printf format
 		va_list  arg_copy;
 		va_copy(arg_copy, arg_list);
-#ifdef _MSC_VER		// for MS C only
-		temp.length = _vscprintf (argv[0], arg_list) + 1;
-#else				// for C99 standard
-		temp.length = vsnprintf (NULL, 0, argv[0], arg_list) + 1;
-#endif
+		// format to stack buffer first, most conditions are short.
+		temp.length = vsnprintf(format_buf, sizeof(format_buf), argv[0], arg_list) + 1;
 		node->type = SQN_VALUE;
-		node->value = malloc(temp.length);
-		vsprintf(node->value, argv[0], arg_copy);
+		node->value = sq_arena_alloc(&query->arena, temp.length);
+		if (temp.length <= (int)sizeof(format_buf))
+			memcpy(node->value, format_buf, temp.length);
+		else
+			vsnprintf(node->value, temp.length, argv[0], arg_copy);
 		va_end(arg_copy);
 		return node;
 	}
@@ -630,7 +643,7 @@ static SqQueryNode *sq_query_condition(SqQuery *query, const char *first, va_lis
 	// if argv[1] == NULL, argv[0] is raw condition
 	if (argv[1] == NULL) {
 		node->type = SQN_VALUE;
-		node->value = strdup(argv[0]);
+		node->value = sq_arena_strdup(&query->arena, argv[0]);
 		return node;
 	}
 	temp.length += strlen(argv[1]) +1;
@@ -646,7 +659,7 @@ static SqQueryNode *sq_query_condition(SqQuery *query, const char *first, va_lis
 	}
 
 	node->type = SQN_VALUE;
-	node->value = malloc(temp.length);
+	node->value = sq_arena_alloc(&query->arena, temp.length);
 	node->value[0] = 0;
 	for (temp.index = 0;  temp.index < 2;  temp.index++) {
 		strcat(node->value, argv[temp.index]);
@@ -665,66 +678,53 @@ static SqQueryNode *sq_query_condition(SqQuery *query, const char *first, va_lis
 // ------------------------------------
 // sq_query_to_sql()
 
-struct Sqbuf
-{
-	char *beg;
-	char *cur;
-	char *end;
-	int   length;
-};
-
-static void node_to_buf(SqQueryNode *node, struct Sqbuf *buf)
+static void node_to_buf(SqQueryNode *node, SqBuffer *buf)
 {
-	char *cur;
-	int   temp;
+	char *mem;
+	int   len;
 
 	for (;  node;  node = node->next) {
 		if (node->type < SQN_N_CODE) {
 			node->value = (char*) sqnword[node->type];
 			if (node->type == SQN_COMMA)
-				buf->cur--;
+				buf->writed--;
 		}
-		cur = node->value;
-		if (*cur) {
-			temp = strlen(cur) + 1;    // + " "
-			if (buf->cur +temp >= buf->end) {
-				temp = buf->cur - buf->beg;
-				buf->length *= 2;
-				buf->beg = realloc(buf->beg, buf->length);
-				buf->end = buf->beg + buf->length;
-				buf->cur = buf->beg + temp;
-			}
-			while (*cur)
-				*buf->cur++ = *cur++;
-			*buf->cur++ = ' ';
+		len = (int)strlen(node->value);
+		if (len) {
+			mem = sq_buffer_alloc(buf, len + 1);    // + " "
+			memcpy(mem, node->value, len);
+			mem[len] = ' ';
 		}
 		node_to_buf(node->children, buf);
 	}
 }
 
-char *sq_query_to_sql(SqQuery *query)
+char *sq_query_write_sql(SqQuery *query, SqBuffer *buffer)
 {
 	SqQueryNested *nested = query->nested_cur;
-	struct Sqbuf   buf;
+	int            start = buffer->writed;
 
 	if (nested->name) {
 		if (nested->command == NULL)
 			sq_query_select(query, NULL);
 	}
 
-	buf.length = 1024;
-	buf.beg = malloc(buf.length);
-	buf.end = buf.beg + buf.length;
-	buf.cur = buf.beg;
-	node_to_buf(query->root.children, &buf);
+	node_to_buf(query->root.children, buffer);
+	// remove last " "
+	if (buffer->writed > start)
+		buffer->writed--;
+	sq_buffer_alloc(buffer, 0)[0] = 0;    // NULL-termainated is not counted in length
+	return buffer->buf + start;
+}
 
-	if (buf.cur > buf.beg)
-		*(buf.cur-1) = 0;
-	else
-		*buf.cur = 0;
-	buf.beg = realloc(buf.beg, buf.cur - buf.beg);
+char *sq_query_to_sql(SqQuery *query)
+{
+	SqBuffer  buf;
 
-	return buf.beg;
+	sq_buffer_init(&buf);
+	sq_buffer_resize(&buf, 1024);
+	sq_query_write_sql(query, &buf);
+	return buf.buf;
 }
 
 static const char *get_table(SqQueryNode *parent)
@@ -873,24 +873,25 @@ static SqQueryNode *sq_query_node_new(SqQuery *query)
 	SqQueryNode *node;
 	struct NodeChunk  *chunk;
 
-	// reuse freed SqQueryNode
+	// reuse freed SqQueryNode. 'node' and 'node_count' only track nodes in chunks.
 	if (query->freed) {
 		node = query->freed;
 		query->freed = node->next;
-		query->node = node;
 	}
-	// alloc multiple SqQueryNode each time
-	else if ((query->node_count & NODE_CHUNK_MASK) == 0) {
-		chunk = malloc(sizeof(struct NodeChunk));
-		chunk->prev = query->node_chunk;
-		query->node_chunk = chunk;
-		query->node = chunk->nodes;
+	else {
+		// alloc multiple SqQueryNode each time
+		if ((query->node_count & NODE_CHUNK_MASK) == 0) {
+			chunk = malloc(sizeof(struct NodeChunk));
+			chunk->prev = query->node_chunk;
+			query->node_chunk = chunk;
+			query->node = chunk->nodes;
+		}
+		else
+			query->node++;
+		query->node_count++;
+		node = query->node;
 	}
-	else
-		query->node++;
-	query->node_count++;
 
-	node = query->node;
 	node->next = NULL;
 	node->children = NULL;
 
@@ -902,8 +903,7 @@ static void sq_query_node_free(SqQueryNode *node, SqQuery *query)
 	SqQueryNode  *next;
 
 	for (;  node;  node = next) {
-		if (node->type == SQN_VALUE)
-			free(node->value);
+		// node->value is allocated from SqQuery.arena or it is static string
 		if (node->children)
 			sq_query_node_free(node->children, query);
 		// add SqQueryNode to freed list
@@ -913,6 +913,14 @@ static void sq_query_node_free(SqQueryNode *node, SqQuery *query)
 	}
 }
 
+// copy name of table or column to arena if SqQuery doesn't reference static names
+static char *sq_query_name(SqQuery *query, const char *name)
+{
+	if (query->static_names)
+		return (char*)name;
+	return sq_arena_strdup(&query->arena, name);
+}
+
 static SqQueryNode *sq_query_node_last(SqQueryNode *node)
 {
 	SqQueryNode *prev;
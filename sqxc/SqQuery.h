@@ -24,6 +24,8 @@
 #include <stdbool.h>
 
 #include <SqPtrArray.h>
+#include <SqArena.h>
+#include <SqBuffer.h>
 
 // ----------------------------------------------------------------------------
 // C/C++ common declarations: declare type, structue, macro, enumeration.
@@ -108,8 +110,14 @@ SqQuery *sq_query_final(SqQuery *query);
 #define sq_query_free(query)    free(sq_query_final(query))
 
 // It reset SqQuery and remove all statements.
+// Memory of nodes and strings is kept and reused by next statements.
 void    sq_query_clear(SqQuery *query);
 
+// void sq_query_static_names(SqQuery *query, bool reference);
+// If 'reference' is true, names of table and column are referenced instead of copied.
+// They must be valid until query is cleared or freed (e.g. string literal).
+#define sq_query_static_names(query, reference)    (query)->static_names = (reference)
+
 /*
 	sq_query_push_nested() was called by sq_query_where_exists(), sq_query_from(),
 	                       sq_query_join(), sq_query_on(), sq_query_where() ...etc
@@ -183,9 +191,12 @@ void    sq_query_delete(SqQuery *query);
 // SQL: TRUNCATE TABLE
 void    sq_query_truncate(SqQuery *query);
 
-// SQL statements
+// SQL statements. It must call free() to release returned string.
 char   *sq_query_to_sql(SqQuery *query);
 
+// write SQL statements to tail of 'buffer'. return SQL statements in 'buffer' (null-terminated).
+char   *sq_query_write_sql(SqQuery *query, SqBuffer *buffer);
+
 // va_list
 void    sq_query_join_va(SqQuery *query, const char *table,
                          const char *condition, va_list arg_list);
@@ -278,6 +289,9 @@ struct SqQuery
 	SqQueryNested *nested_cur;
 	int            nested_count;
 
+	SqArena        arena;          // strings of SqQueryNode.value
+	bool           static_names;   // reference names of table and column instead of copying them
+
 #ifdef __cplusplus
 	// C++11 standard-layout
 
@@ -593,6 +607,9 @@ struct SqQuery
 	char *toSql() {
 		return sq_query_to_sql(this);
 	}
+	char *toSql(SqBuffer *buffer) {
+		return sq_query_write_sql(this, buffer);
+	}
 #endif  // __cplusplus
 };
 
@@ -0,0 +1,490 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#if defined(_MSC_VER)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <errno.h>      // errno, EINTR
+#include <stdint.h>     // uint64_t
+#include <stdlib.h>     // malloc, free
+#include <string.h>     // strdup
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>     // read, write, close
+#elif !defined(_WIN32) && !defined(_WIN64)
+#include <fcntl.h>      // fcntl
+#include <unistd.h>     // pipe, read, write, close
+#endif
+
+#include <SqConfig.h>
+#include <SqStorage-async.h>
+
+static void  sq_storage_async_worker(SqStorageAsync *async);
+
+// ----------------------------------------------------------------------------
+// SqStorageAsync
+
+SqStorageAsync *sq_storage_async_new(SqStorage *storage, int n_threads, unsigned int flags)
+{
+	SqStorageAsync *async;
+
+	async = malloc(sizeof(SqStorageAsync));
+	sq_storage_async_init(async, storage, n_threads, flags);
+	return async;
+}
+
+void  sq_storage_async_free(SqStorageAsync *async)
+{
+	sq_storage_async_final(async);
+	free(async);
+}
+
+void  sq_storage_async_init(SqStorageAsync *async, SqStorage *storage, int n_threads, unsigned int flags)
+{
+	async->storage = storage;
+	async->flags = flags;
+	async->serial = 0;
+	async->quit = false;
+	sq_ptr_array_init(&async->queue, 16, NULL);
+	sq_ptr_array_init(&async->done, 16, NULL);
+	sq_mutex_init(&async->mutex, false);
+	sq_cond_init(&async->cond);
+	sq_cond_init(&async->cond_done);
+
+	async->fd[0] = -1;
+	async->fd[1] = -1;
+	if (flags & SQ_STORAGE_ASYNC_DISPATCH) {
+#if defined(__linux__)
+		async->fd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif !defined(_WIN32) && !defined(_WIN64)
+		if (pipe(async->fd) == 0)
+			fcntl(async->fd[0], F_SETFL, fcntl(async->fd[0], F_GETFL) | O_NONBLOCK);
+#endif
+	}
+
+	if (n_threads <= 0)
+		n_threads = SQ_CONFIG_STORAGE_ASYNC_THREADS_DEFAULT;
+	async->threads = malloc(sizeof(SqThread) * n_threads);
+	for (async->n_threads = 0;  async->n_threads < n_threads;  async->n_threads++) {
+		if (sq_thread_create(async->threads + async->n_threads,
+		                     (SqThreadFunc)sq_storage_async_worker, async) == false)
+			break;
+	}
+}
+
+void  sq_storage_async_final(SqStorageAsync *async)
+{
+	// worker threads exit after queue is empty
+	sq_mutex_lock(&async->mutex);
+	async->quit = true;
+	sq_cond_broadcast(&async->cond);
+	sq_mutex_unlock(&async->mutex);
+	for (int index = 0;  index < async->n_threads;  index++)
+		sq_thread_join(async->threads[index]);
+	free(async->threads);
+
+	// call callbacks of remaining done jobs
+	sq_storage_async_dispatch(async);
+
+	sq_ptr_array_final(&async->queue);
+	sq_ptr_array_final(&async->done);
+	sq_mutex_final(&async->mutex);
+	sq_cond_final(&async->cond);
+	sq_cond_final(&async->cond_done);
+#if !defined(_WIN32) && !defined(_WIN64)
+	if (async->fd[0] != -1)
+		close(async->fd[0]);
+	if (async->fd[1] != -1)
+		close(async->fd[1]);
+#endif
+}
+
+int   sq_storage_async_fd(SqStorageAsync *async)
+{
+	return async->fd[0];
+}
+
+int   sq_storage_async_dispatch(SqStorageAsync *async)
+{
+	SqStorageJob  *job;
+	SqPtrArray     done;
+	int            n;
+#if !defined(_WIN32) && !defined(_WIN64)
+	uint64_t       value;
+
+	// clear readable state of fd
+	if (async->fd[0] != -1) {
+		while (read(async->fd[0], &value, sizeof(value)) > 0)
+			;
+	}
+#endif
+
+	// take all done jobs and call callbacks without lock
+	sq_mutex_lock(&async->mutex);
+	done = async->done;
+	sq_ptr_array_init(&async->done, 16, NULL);
+	sq_mutex_unlock(&async->mutex);
+
+	n = done.length;
+	for (int index = 0;  index < n;  index++) {
+		job = done.data[index];
+		job->callback(job, job->data);
+		sq_storage_job_unref(job);
+	}
+	sq_ptr_array_final(&done);
+	return n;
+}
+
+// ----------------------------------------------------------------------------
+// priority queue (binary heap)
+
+// return true if 'job1' should run before 'job2'
+static bool job_before(SqStorageJob *job1, SqStorageJob *job2)
+{
+	if (job1->priority != job2->priority)
+		return job1->priority > job2->priority;
+	// serial number may wrap around
+	return (int)(job1->serial - job2->serial) < 0;
+}
+
+static void queue_push(SqPtrArray *queue, SqStorageJob *job)
+{
+	void **data;
+	int    index, parent;
+
+	sq_ptr_array_append(queue, job);
+	data = queue->data;
+	for (index = queue->length - 1;  index > 0;  index = parent) {
+		parent = (index - 1) / 2;
+		if (job_before(data[parent], job))
+			break;
+		data[index] = data[parent];
+	}
+	data[index] = job;
+}
+
+static SqStorageJob *queue_pop(SqPtrArray *queue)
+{
+	SqStorageJob *top, *last;
+	void **data = queue->data;
+	int    index, child;
+	int    length;
+
+	if (queue->length == 0)
+		return NULL;
+	top = data[0];
+	last = data[queue->length - 1];
+	sq_ptr_array_steal(queue, queue->length - 1, 1);
+	data = queue->data;
+	length = queue->length;
+	for (index = 0;  (child = index * 2 + 1) < length;  index = child) {
+		if (child + 1 < length && job_before(data[child + 1], data[child]))
+			child++;
+		if (job_before(last, data[child]))
+			break;
+		data[index] = data[child];
+	}
+	if (length > 0)
+		data[index] = last;
+	return top;
+}
+
+// ----------------------------------------------------------------------------
+// worker thread
+
+static void  sq_storage_job_run(SqStorageJob *job)
+{
+	SqStorage *storage = job->async->storage;
+
+	switch (job->kind) {
+	case SQ_STORAGE_JOB_GET:
+		job->result = sq_storage_get_full(storage, job->table_name, job->type_name,
+		                                  job->type, job->id);
+		break;
+
+	case SQ_STORAGE_JOB_GET_ALL:
+		job->result = sq_storage_get_all_full(storage, job->table_name, job->type_name,
+		                                      job->type, job->container, job->sql_where_having);
+		break;
+
+	case SQ_STORAGE_JOB_QUERY:
+		job->result = sq_storage_query(storage, job->query, job->container, job->type);
+		break;
+
+	case SQ_STORAGE_JOB_INSERT:
+		job->code = sq_storage_insert(storage, job->table_name, job->type_name, job->instance);
+		break;
+
+	case SQ_STORAGE_JOB_UPDATE:
+		sq_storage_update(storage, job->table_name, job->type_name, job->instance);
+		break;
+
+	case SQ_STORAGE_JOB_REMOVE:
+		sq_storage_remove(storage, job->table_name, job->type_name, job->id);
+		break;
+	}
+}
+
+// make fd readable. write() is retried if it is interrupted by signal.
+// Other errors are ignored: eventfd counter (or pipe) is not empty and fd is readable already.
+static void  sq_storage_async_notify(SqStorageAsync *async)
+{
+#if defined(__linux__)
+	uint64_t  value = 1;
+
+	if (async->fd[0] != -1) {
+		while (write(async->fd[0], &value, sizeof(value)) == -1 && errno == EINTR)
+			;
+	}
+#elif !defined(_WIN32) && !defined(_WIN64)
+	char      value = 1;
+
+	if (async->fd[1] != -1 && async->done.length == 1) {
+		while (write(async->fd[1], &value, 1) == -1 && errno == EINTR)
+			;
+	}
+#endif
+}
+
+// run 'job' and call (or queue) its callback. async->mutex must be locked. It is locked when returning.
+static void  sq_storage_async_run(SqStorageAsync *async, SqStorageJob *job)
+{
+	job->state = SQ_STORAGE_JOB_RUNNING;
+	sq_mutex_unlock(&async->mutex);
+
+	sq_storage_job_run(job);
+
+	sq_mutex_lock(&async->mutex);
+	job->state = SQ_STORAGE_JOB_DONE;
+	sq_cond_broadcast(&async->cond_done);
+	if (job->callback && async->flags & SQ_STORAGE_ASYNC_DISPATCH) {
+		// async->done keeps reference of job until it is dispatched
+		sq_ptr_array_append(&async->done, job);
+		sq_storage_async_notify(async);
+		return;
+	}
+	sq_mutex_unlock(&async->mutex);
+
+	if (job->callback)
+		job->callback(job, job->data);
+	sq_storage_job_unref(job);
+	sq_mutex_lock(&async->mutex);
+}
+
+static void  sq_storage_async_worker(SqStorageAsync *async)
+{
+	SqStorageJob *job;
+
+	sq_mutex_lock(&async->mutex);
+	for (;;) {
+		job = queue_pop(&async->queue);
+		if (job == NULL) {
+			if (async->quit)
+				break;
+			sq_cond_wait(&async->cond, &async->mutex);
+			continue;
+		}
+		// job is canceled
+		if (job->state != SQ_STORAGE_JOB_QUEUED) {
+			sq_mutex_unlock(&async->mutex);
+			sq_storage_job_unref(job);
+			sq_mutex_lock(&async->mutex);
+			continue;
+		}
+		sq_storage_async_run(async, job);
+	}
+	sq_mutex_unlock(&async->mutex);
+}
+
+// ----------------------------------------------------------------------------
+// SqStorageJob
+
+static SqStorageJob *sq_storage_job_new(SqStorageAsync *async, int kind,
+                                        const char *table_name, const char *type_name,
+                                        int priority, SqStorageJobFunc callback, void *data)
+{
+	SqStorageJob *job;
+
+	job = calloc(1, sizeof(SqStorageJob));
+	job->async = async;
+	job->kind = kind;
+	job->state = SQ_STORAGE_JOB_QUEUED;
+	job->priority = priority;
+	// one for caller, another for SqStorageAsync
+	job->ref_count = 2;
+	job->table_name = (table_name) ? strdup(table_name) : NULL;
+	job->type_name = (type_name) ? strdup(type_name) : NULL;
+	job->callback = callback;
+	job->data = data;
+	return job;
+}
+
+static SqStorageJob *sq_storage_job_submit(SqStorageJob *job)
+{
+	SqStorageAsync *async = job->async;
+
+	sq_mutex_lock(&async->mutex);
+	job->serial = async->serial++;
+	// no worker thread can be created. run job in calling thread.
+	if (async->n_threads == 0)
+		sq_storage_async_run(async, job);
+	else {
+		queue_push(&async->queue, job);
+		sq_cond_signal(&async->cond);
+	}
+	sq_mutex_unlock(&async->mutex);
+	return job;
+}
+
+SqStorageJob *sq_storage_async_get(SqStorageAsync *async,
+                                   const char *table_name,
+                                   const char *type_name,
+                                   int   id,
+                                   int   priority, SqStorageJobFunc callback, void *data)
+{
+	SqStorageJob *job;
+
+	job = sq_storage_job_new(async, SQ_STORAGE_JOB_GET, table_name, type_name,
+	                         priority, callback, data);
+	job->id = id;
+	return sq_storage_job_submit(job);
+}
+
+SqStorageJob *sq_storage_async_get_all(SqStorageAsync *async,
+                                       const char *table_name,
+                                       const char *type_name,
+                                       const SqType *container,
+                                       const char *sql_where_having,
+                                       int   priority, SqStorageJobFunc callback, void *data)
+{
+	SqStorageJob *job;
+
+	job = sq_storage_job_new(async, SQ_STORAGE_JOB_GET_ALL, table_name, type_name,
+	                         priority, callback, data);
+	job->container = container;
+	job->sql_where_having = (sql_where_having) ? strdup(sql_where_having) : NULL;
+	return sq_storage_job_submit(job);
+}
+
+SqStorageJob *sq_storage_async_query(SqStorageAsync *async,
+                                     SqQuery *query,
+                                     const SqType *container,
+                                     const SqType *type,
+                                     int   priority, SqStorageJobFunc callback, void *data)
+{
+	SqStorageJob *job;
+
+	job = sq_storage_job_new(async, SQ_STORAGE_JOB_QUERY, NULL, NULL,
+	                         priority, callback, data);
+	job->query = query;
+	job->container = container;
+	job->type = type;
+	return sq_storage_job_submit(job);
+}
+
+SqStorageJob *sq_storage_async_insert(SqStorageAsync *async,
+                                      const char *table_name,
+                                      const char *type_name,
+                                      void *instance,
+                                      int   priority, SqStorageJobFunc callback, void *data)
+{
+	SqStorageJob *job;
+
+	job = sq_storage_job_new(async, SQ_STORAGE_JOB_INSERT, table_name, type_name,
+	                         priority, callback, data);
+	job->instance = instance;
+	return sq_storage_job_submit(job);
+}
+
+SqStorageJob *sq_storage_async_update(SqStorageAsync *async,
+                                      const char *table_name,
+                                      const char *type_name,
+                                      void *instance,
+                                      int   priority, SqStorageJobFunc callback, void *data)
+{
+	SqStorageJob *job;
+
+	job = sq_storage_job_new(async, SQ_STORAGE_JOB_UPDATE, table_name, type_name,
+	                         priority, callback, data);
+	job->instance = instance;
+	return sq_storage_job_submit(job);
+}
+
+SqStorageJob *sq_storage_async_remove(SqStorageAsync *async,
+                                      const char *table_name,
+                                      const char *type_name,
+                                      int   id,
+                                      int   priority, SqStorageJobFunc callback, void *data)
+{
+	SqStorageJob *job;
+
+	job = sq_storage_job_new(async, SQ_STORAGE_JOB_REMOVE, table_name, type_name,
+	                         priority, callback, data);
+	job->id = id;
+	return sq_storage_job_submit(job);
+}
+
+void  sq_storage_job_ref(SqStorageJob *job)
+{
+	sq_mutex_lock(&job->async->mutex);
+	job->ref_count++;
+	sq_mutex_unlock(&job->async->mutex);
+}
+
+void  sq_storage_job_unref(SqStorageJob *job)
+{
+	int  ref_count;
+
+	sq_mutex_lock(&job->async->mutex);
+	ref_count = --job->ref_count;
+	sq_mutex_unlock(&job->async->mutex);
+
+	if (ref_count == 0) {
+		free(job->table_name);
+		free(job->type_name);
+		free(job->sql_where_having);
+		free(job);
+	}
+}
+
+int   sq_storage_job_wait(SqStorageJob *job)
+{
+	SqStorageAsync *async = job->async;
+	int  state;
+
+	sq_mutex_lock(&async->mutex);
+	while (job->state == SQ_STORAGE_JOB_QUEUED || job->state == SQ_STORAGE_JOB_RUNNING)
+		sq_cond_wait(&async->cond_done, &async->mutex);
+	state = job->state;
+	sq_mutex_unlock(&async->mutex);
+	return state;
+}
+
+bool  sq_storage_job_cancel(SqStorageJob *job)
+{
+	SqStorageAsync *async = job->async;
+	bool  canceled = false;
+
+	sq_mutex_lock(&async->mutex);
+	// worker thread removes canceled job from queue and releases it.
+	if (job->state == SQ_STORAGE_JOB_QUEUED) {
+		job->state = SQ_STORAGE_JOB_CANCELED;
+		sq_cond_broadcast(&async->cond_done);
+		canceled = true;
+	}
+	sq_mutex_unlock(&async->mutex);
+	return canceled;
+}
@@ -0,0 +1,278 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQ_STORAGE_ASYNC_H
+#define SQ_STORAGE_ASYNC_H
+
+#include <SqPtrArray.h>
+#include <SqThread.h>
+#include <SqStorage.h>
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+typedef struct SqStorageAsync    SqStorageAsync;
+typedef struct SqStorageJob      SqStorageJob;
+
+// callback of SqStorageJob. It is called when job is done.
+typedef void (*SqStorageJobFunc)(SqStorageJob *job, void *data);
+
+// SqStorageJob.kind
+typedef enum SqStorageJobKind {
+	SQ_STORAGE_JOB_GET,
+	SQ_STORAGE_JOB_GET_ALL,
+	SQ_STORAGE_JOB_QUERY,
+	SQ_STORAGE_JOB_INSERT,
+	SQ_STORAGE_JOB_UPDATE,
+	SQ_STORAGE_JOB_REMOVE,
+} SqStorageJobKind;
+
+// SqStorageJob.state
+typedef enum SqStorageJobState {
+	SQ_STORAGE_JOB_QUEUED,
+	SQ_STORAGE_JOB_RUNNING,
+	SQ_STORAGE_JOB_DONE,
+	SQ_STORAGE_JOB_CANCELED,
+} SqStorageJobState;
+
+// flags of sq_storage_async_new()
+// Callbacks are not called by worker threads. They are called by sq_storage_async_dispatch().
+#define SQ_STORAGE_ASYNC_DISPATCH    (1 << 0)
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --- SqStorageAsync C Functions --- */
+
+// 'n_threads' is number of worker threads. 0 = default.
+// If no worker thread can be created, jobs run in the thread that submits them.
+SqStorageAsync *sq_storage_async_new(SqStorage *storage, int n_threads, unsigned int flags);
+void            sq_storage_async_free(SqStorageAsync *async);
+
+// sq_storage_async_final() runs all queued jobs and waits for worker threads.
+void  sq_storage_async_init(SqStorageAsync *async, SqStorage *storage, int n_threads, unsigned int flags);
+void  sq_storage_async_final(SqStorageAsync *async);
+
+// return file descriptor that is readable when done jobs are waiting for sq_storage_async_dispatch().
+// return -1 if SQ_STORAGE_ASYNC_DISPATCH is not set or platform doesn't support it.
+int   sq_storage_async_fd(SqStorageAsync *async);
+
+// call callbacks of done jobs in calling thread. return number of called jobs.
+// It is used with SQ_STORAGE_ASYNC_DISPATCH.
+int   sq_storage_async_dispatch(SqStorageAsync *async);
+
+// ------------------------------------
+// Job functions. Arguments are the same as sq_storage_xxx() functions.
+// Jobs that have higher 'priority' run first. Jobs that have the same 'priority' run in order.
+// 'callback' can be NULL.
+// Returned job must be released by sq_storage_job_unref() before SqStorageAsync is finalized.
+// 'instance', 'container', and 'query' must be available until job is done.
+
+SqStorageJob *sq_storage_async_get(SqStorageAsync *async,
+                                   const char *table_name,
+                                   const char *type_name,
+                                   int   id,
+                                   int   priority, SqStorageJobFunc callback, void *data);
+
+SqStorageJob *sq_storage_async_get_all(SqStorageAsync *async,
+                                       const char *table_name,
+                                       const char *type_name,
+                                       const SqType *container,
+                                       const char *sql_where_having,
+                                       int   priority, SqStorageJobFunc callback, void *data);
+
+SqStorageJob *sq_storage_async_query(SqStorageAsync *async,
+                                     SqQuery *query,
+                                     const SqType *container,
+                                     const SqType *type,
+                                     int   priority, SqStorageJobFunc callback, void *data);
+
+SqStorageJob *sq_storage_async_insert(SqStorageAsync *async,
+                                      const char *table_name,
+                                      const char *type_name,
+                                      void *instance,
+                                      int   priority, SqStorageJobFunc callback, void *data);
+
+SqStorageJob *sq_storage_async_update(SqStorageAsync *async,
+                                      const char *table_name,
+                                      const char *type_name,
+                                      void *instance,
+                                      int   priority, SqStorageJobFunc callback, void *data);
+
+SqStorageJob *sq_storage_async_remove(SqStorageAsync *async,
+                                      const char *table_name,
+                                      const char *type_name,
+                                      int   id,
+                                      int   priority, SqStorageJobFunc callback, void *data);
+
+/* --- SqStorageJob C Functions --- */
+
+void  sq_storage_job_ref(SqStorageJob *job);
+void  sq_storage_job_unref(SqStorageJob *job);
+
+// wait until job is done (or canceled). return SqStorageJob.state
+int   sq_storage_job_wait(SqStorageJob *job);
+
+// remove queued job. Callback of canceled job will not be called.
+// return false if job is running or done.
+bool  sq_storage_job_cancel(SqStorageJob *job);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+// ----------------------------------------------------------------------------
+// C/C++ common definitions: define structue
+
+/*
+    SqStorageAsync - run SqStorage functions in worker threads.
+
+    Worker threads share SqStorage. Use thread-safe Sqdb (e.g. SqdbPool) to run jobs in parallel,
+    otherwise access to database is serialized by SqStorage.
+ */
+struct SqStorageAsync
+{
+	SqStorage     *storage;
+	unsigned int   flags;
+
+	SqThread      *threads;
+	int            n_threads;
+
+	SqPtrArray     queue;        // binary heap of queued jobs
+	SqPtrArray     done;         // done jobs that wait for sq_storage_async_dispatch()
+	unsigned int   serial;       // order of jobs that have the same priority
+	bool           quit;
+
+	SqMutex        mutex;
+	SqCond         cond;         // signaled when job is queued
+	SqCond         cond_done;    // signaled when job is done
+
+	int            fd[2];        // fd[0] is returned by sq_storage_async_fd(). eventfd use fd[0] only.
+};
+
+/*
+    SqStorageJob - handle of job that is submitted to SqStorageAsync.
+ */
+struct SqStorageJob
+{
+	SqStorageAsync  *async;
+	int              kind;       // SqStorageJobKind
+	int              state;      // SqStorageJobState
+	int              priority;
+	unsigned int     serial;
+	int              ref_count;
+
+	// arguments
+	char            *table_name;
+	char            *type_name;
+	char            *sql_where_having;
+	const SqType    *type;
+	const SqType    *container;
+	SqQuery         *query;
+	void            *instance;
+	int              id;
+
+	// result
+	void            *result;     // returned by get, get_all, and query. Caller must free it.
+	int              code;       // id returned by insert
+
+	SqStorageJobFunc callback;
+	void            *data;
+};
+
+// ----------------------------------------------------------------------------
+// C++ definitions: define C++ data, function, method, and others.
+
+#ifdef __cplusplus
+
+namespace Sq {
+
+typedef struct SqStorageJob    StorageJob;
+
+// conforming C++11 standard-layout
+// These are for directly use only. You can NOT derived it.
+struct StorageAsync : SqStorageAsync
+{
+	StorageAsync(SqStorage *storage, int n_threads = 0, unsigned int flags = 0) {
+		sq_storage_async_init(this, storage, n_threads, flags);
+	}
+	~StorageAsync() {
+		sq_storage_async_final(this);
+	}
+
+	int   fd() {
+		return sq_storage_async_fd(this);
+	}
+	int   dispatch() {
+		return sq_storage_async_dispatch(this);
+	}
+
+	template <class StructType>
+	SqStorageJob *get(int id, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_get(this, NULL, typeid(StructType).name(), id, priority, callback, data);
+	}
+	SqStorageJob *get(const char *table_name, int id, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_get(this, table_name, NULL, id, priority, callback, data);
+	}
+
+	template <class StructType>
+	SqStorageJob *getAll(const SqType *container = NULL, const char *sql_where_having = NULL,
+	                     int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_get_all(this, NULL, typeid(StructType).name(), container, sql_where_having, priority, callback, data);
+	}
+	SqStorageJob *getAll(const char *table_name, const SqType *container = NULL, const char *sql_where_having = NULL,
+	                     int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_get_all(this, table_name, NULL, container, sql_where_having, priority, callback, data);
+	}
+
+	SqStorageJob *query(SqQuery *query, const SqType *container = NULL, const SqType *type = NULL,
+	                    int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_query(this, query, container, type, priority, callback, data);
+	}
+
+	template <class StructType>
+	SqStorageJob *insert(StructType *instance, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_insert(this, NULL, typeid(StructType).name(), instance, priority, callback, data);
+	}
+	SqStorageJob *insert(const char *table_name, void *instance, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_insert(this, table_name, NULL, instance, priority, callback, data);
+	}
+
+	template <class StructType>
+	SqStorageJob *update(StructType *instance, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_update(this, NULL, typeid(StructType).name(), instance, priority, callback, data);
+	}
+	SqStorageJob *update(const char *table_name, void *instance, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_update(this, table_name, NULL, instance, priority, callback, data);
+	}
+
+	template <class StructType>
+	SqStorageJob *remove(int id, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_remove(this, NULL, typeid(StructType).name(), id, priority, callback, data);
+	}
+	SqStorageJob *remove(const char *table_name, int id, int priority = 0, SqStorageJobFunc callback = NULL, void *data = NULL) {
+		return sq_storage_async_remove(this, table_name, NULL, id, priority, callback, data);
+	}
+};
+
+};  // namespace Sq
+
+#endif  // __cplusplus
+
+
+#endif  // SQ_STORAGE_ASYNC_H
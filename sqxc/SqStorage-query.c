@@ -18,10 +18,16 @@
 #endif  // _MSC_VER
 
 #include <stdio.h>      // snprintf
+#include <stdarg.h>     // va_list
+#include <string.h>     // strcmp, strncmp, strlen, memcpy
+#include <ctype.h>      // isalpha, isalnum
 
 #include <SqxcValue.h>
 #include <SqStorage.h>
 #include <SqQuery.h>
+#include <SqBuffer.h>
+#include <SqUtil.h>     // sq_time_to_str, sq_str_span_sql
+#include <SqError.h>
 
 static void query_add_column_as_names(SqQuery *query, SqTable *table)
 {
@@ -29,7 +35,10 @@ static void query_add_column_as_names(SqQuery *query, SqTable *table)
 	SqColumn *column;
 	char     *buffer = NULL;
 	int       buf_len;
+	bool      static_names = query->static_names;
 
+	// 'buffer' is reused for every column, query must copy it.
+	sq_query_static_names(query, false);
 	for (int index = 0;  index < type->n_entry;  index++) {
 		column = (SqColumn*)type->entry[index];
 		if (SQ_TYPE_IS_FAKE(column->type))
@@ -40,6 +49,7 @@ static void query_add_column_as_names(SqQuery *query, SqTable *table)
 		sq_query_select(query, buffer, NULL);
 	}
 	free(buffer);
+	sq_query_static_names(query, static_names);
 }
 
 SqType  *sq_storage_type_from_query(SqStorage *storage, SqQuery *query, int *n_tables_in_query)
@@ -101,14 +111,17 @@ void *sq_storage_query(SqStorage *storage, SqQuery *query, const SqType *contain
 	// get SQL statement string
 	sql = sq_query_to_sql(query);
 	// destination of input
-	xcvalue = (Sqxc*) storage->xc_input;
+	xcvalue = sq_storage_get_xc_input(storage);
 	sqxc_value_type(xcvalue) = type_cur;
 	sqxc_value_container(xcvalue) = (container) ? container : (SqType*)storage->container_default;
 	// get input from SQL
 	sqxc_ready(xcvalue, NULL);
+	sq_storage_lock_db(storage);
 	sqdb_exec(storage->db, sql, xcvalue, NULL);
+	sq_storage_unlock_db(storage);
 	sqxc_finish(xcvalue, NULL);
 	instance = sqxc_value_instance(xcvalue);
+	sq_storage_put_xc_input(storage, xcvalue);
 	// free SQL statement string
 	free(sql);
 
@@ -116,3 +129,337 @@ void *sq_storage_query(SqStorage *storage, SqQuery *query, const SqType *contain
 		sq_type_unref(type_cur);
 	return instance;
 }
+
+// ----------------------------------------------------------------------------
+// SqCompiledQuery
+
+// replace named placeholders by '?' in 'compiled->sql' and record parameters.
+// characters in quoted string or identifier are skipped.
+static void sq_compiled_query_parse(SqCompiledQuery *compiled)
+{
+	char *src, *dest, *name;
+	char  quote;
+	int   len, index;
+
+	compiled->n_params = 0;
+	compiled->n_places = 0;
+	// count placeholders to allocate arrays
+	for (src = compiled->sql, len = 0;  *src;  src++) {
+		if (*src == '?' || *src == ':')
+			len++;
+	}
+	compiled->params = calloc(len + 1, sizeof(SqCompiledParam));
+	compiled->places = malloc((len + 1) * sizeof(SqCompiledPlace));
+
+	for (src = compiled->sql, dest = src;  *src;  ) {
+		switch (*src) {
+		case '\'':
+		case '"':
+		case '`':
+			quote = *src;
+			do {
+				*dest++ = *src++;
+			} while (*src && *src != quote);
+			if (*src)
+				*dest++ = *src++;
+			continue;
+
+		case '?':
+			src++;
+			index = compiled->n_params++;
+			compiled->params[index].type = SQXC_TYPE_STRING;
+			break;
+
+		case ':':
+			// ignore '::' and ':' that doesn't follow by identifier
+			if (src[1] == ':' || (src[1] != '_' && isalpha((unsigned char)src[1]) == 0)) {
+				*dest++ = *src++;
+				if (*src == ':')
+					*dest++ = *src++;
+				continue;
+			}
+			name = ++src;
+			while (*src == '_' || isalnum((unsigned char)*src))
+				src++;
+			len = (int)(src - name);
+			// the same name is the same parameter
+			for (index = 0;  index < compiled->n_params;  index++) {
+				if (compiled->params[index].name && strncmp(compiled->params[index].name, name, len) == 0 &&
+				    compiled->params[index].name[len] == 0)
+					break;
+			}
+			if (index == compiled->n_params) {
+				compiled->n_params++;
+				compiled->params[index].type = SQXC_TYPE_STRING;
+				compiled->params[index].name = malloc(len + 1);
+				memcpy(compiled->params[index].name, name, len);
+				compiled->params[index].name[len] = 0;
+			}
+			break;
+
+		default:
+			*dest++ = *src++;
+			continue;
+		}
+		compiled->places[compiled->n_places].param = index;
+		compiled->places[compiled->n_places].pos = (int)(dest - compiled->sql);
+		compiled->n_places++;
+		*dest++ = '?';
+	}
+	*dest = 0;
+}
+
+SqCompiledQuery *sq_storage_compile(SqStorage *storage, SqQuery *query, const SqType *container, const SqType *type)
+{
+	SqCompiledQuery *compiled;
+	SqType          *type_cur;
+	SqdbStmt        *stmt;
+	int              code;
+
+	compiled = calloc(1, sizeof(SqCompiledQuery));
+	compiled->storage = storage;
+	compiled->container = (container) ? container : storage->container_default;
+	if (type)
+		compiled->type = type;
+	else {
+		// It adds column names to 'query' if there are multiple tables in query.
+		type_cur = sq_storage_type_from_query(storage, query, NULL);
+		if (type_cur == NULL) {
+			free(compiled);
+			return NULL;
+		}
+		// special case for SqPtrArray: if there is only 1 table in query
+		if (compiled->container == SQ_TYPE_PTR_ARRAY && type_cur->n_entry == 1) {
+			compiled->type = type_cur->entry[0]->type;
+			sq_type_unref(type_cur);
+		}
+		else {
+			compiled->type = type_cur;
+			compiled->type_owned = true;
+		}
+	}
+
+	compiled->sql = sq_query_to_sql(query);
+	sq_compiled_query_parse(compiled);
+
+	// check SQL statement. SQLite keeps prepared statement in its cache.
+	if (storage->db->info->prepare) {
+		sq_storage_lock_db(storage);
+		code = sqdb_prepare(storage->db, compiled->sql, &stmt);
+		if (code == SQCODE_OK)
+			sqdb_stmt_finalize(storage->db, stmt);
+		sq_storage_unlock_db(storage);
+		if (code != SQCODE_OK) {
+			sq_compiled_query_free(compiled);
+			return NULL;
+		}
+	}
+	return compiled;
+}
+
+void  sq_compiled_query_free(SqCompiledQuery *compiled)
+{
+	for (int index = 0;  index < compiled->n_params;  index++)
+		free(compiled->params[index].name);
+	free(compiled->params);
+	free(compiled->places);
+	free(compiled->sql);
+	if (compiled->type_owned)
+		sq_type_unref((SqType*)compiled->type);
+	free(compiled);
+}
+
+int   sq_compiled_query_index(SqCompiledQuery *compiled, const char *name)
+{
+	if (name[0] == ':')
+		name++;
+	for (int index = 0;  index < compiled->n_params;  index++) {
+		if (compiled->params[index].name && strcmp(compiled->params[index].name, name) == 0)
+			return index + 1;
+	}
+	return 0;
+}
+
+int   sq_compiled_query_bind(SqCompiledQuery *compiled, int index, int type, ...)
+{
+	SqCompiledParam *param;
+	va_list  arg_list;
+
+	if (index < 1 || index > compiled->n_params)
+		return SQCODE_ERROR;
+	param = compiled->params + index - 1;
+	param->type = type;
+
+	va_start(arg_list, type);
+	switch (type) {
+	case SQXC_TYPE_BOOL:
+		// bool is promoted to int when it is passed through '...'
+		param->value.boolean = (va_arg(arg_list, int) != 0);
+		break;
+
+	case SQXC_TYPE_INT:
+		param->value.integer = va_arg(arg_list, int);
+		break;
+
+	case SQXC_TYPE_INT64:
+		param->value.int64 = va_arg(arg_list, int64_t);
+		break;
+
+	case SQXC_TYPE_TIME:
+		param->value.rawtime = va_arg(arg_list, time_t);
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		param->value.fraction = va_arg(arg_list, double);
+		break;
+
+	case SQXC_TYPE_STRING:
+		param->value.string = va_arg(arg_list, const char*);
+		break;
+
+	default:
+		param->type = SQXC_TYPE_STRING;
+		param->value.string = NULL;
+		va_end(arg_list);
+		return SQCODE_TYPE_NOT_SUPPORT;
+	}
+	va_end(arg_list);
+	return SQCODE_OK;
+}
+
+// write value of parameter to SQL statement if Sqdb can't prepare statement.
+static void sq_compiled_query_write_param(SqBuffer *buffer, SqCompiledParam *param)
+{
+	const char *str;
+	char        timestr[SQ_TIME_STR_SIZE];
+	int         len;
+
+	switch (param->type) {
+	case SQXC_TYPE_BOOL:
+		sq_buffer_write_c(buffer, param->value.boolean ? '1' : '0');
+		return;
+
+	case SQXC_TYPE_INT:
+		sq_buffer_write_int64(buffer, param->value.integer);
+		return;
+
+	case SQXC_TYPE_INT64:
+		sq_buffer_write_int64(buffer, param->value.int64);
+		return;
+
+	case SQXC_TYPE_DOUBLE:
+		sq_buffer_write_double(buffer, param->value.fraction);
+		return;
+
+	case SQXC_TYPE_TIME:
+		sq_time_to_str(timestr, param->value.rawtime, SQ_TIME_USE_UTC);
+		str = timestr;
+		break;
+
+	default:
+		str = param->value.string;
+		if (str == NULL) {
+			sq_buffer_write(buffer, "NULL");
+			return;
+		}
+		break;
+	}
+
+	// handle SQL string apostrophe (single quotes)
+	sq_buffer_write_c(buffer, '\'');
+	for (;  ;  str++) {
+		// copy characters before single quote
+		len = sq_str_span_sql(str);
+		sq_buffer_write_n(buffer, str, len);
+		str += len;
+		if (*str == 0)
+			break;
+		// double up on the single quotes
+		memcpy(sq_buffer_alloc(buffer, 2), "\'\'", 2);
+	}
+	sq_buffer_write_c(buffer, '\'');
+}
+
+static int  sq_compiled_query_run(SqCompiledQuery *compiled, Sqxc *xc)
+{
+	Sqdb            *db = compiled->storage->db;
+	SqdbStmt        *stmt = NULL;
+	SqCompiledParam *param;
+	SqCompiledPlace *place;
+	SqBuffer         buffer;
+	int   index, pos, code;
+
+	if (db->info->prepare)
+		code = sqdb_prepare(db, compiled->sql, &stmt);
+	else
+		code = SQCODE_NOT_SUPPORT;
+
+	// Sqdb can't prepare statement. write values to SQL statement and run it.
+	if (code != SQCODE_OK) {
+		sq_buffer_init(&buffer);
+		for (pos = 0, index = 0;  index < compiled->n_places;  index++) {
+			place = compiled->places + index;
+			sq_buffer_write_n(&buffer, compiled->sql + pos, place->pos - pos);
+			pos = place->pos + 1;
+			sq_compiled_query_write_param(&buffer, compiled->params + place->param);
+		}
+		// remaining part of SQL statement (including null-terminated)
+		sq_buffer_write_n(&buffer, compiled->sql + pos, (int)strlen(compiled->sql + pos) + 1);
+		code = sqdb_exec(db, buffer.buf, xc, NULL);
+		sq_buffer_final(&buffer);
+		return code;
+	}
+
+	for (index = 0;  index < compiled->n_places;  index++) {
+		param = compiled->params + compiled->places[index].param;
+		xc->type = param->type;
+		xc->name = NULL;
+		memcpy(&xc->value, &param->value, sizeof(param->value));
+		code = sqdb_stmt_bind(db, stmt, index + 1, xc);
+		if (code != SQCODE_OK)
+			break;
+	}
+
+	if (code == SQCODE_OK) {
+		// if Sqxc element prepare for multiple row
+		if (sqxc_value_current(xc) == sqxc_value_container(xc)) {
+			xc->type = SQXC_TYPE_ARRAY;
+			xc->name = NULL;
+			xc->value.pointer = NULL;
+			xc = sqxc_send(xc);
+		}
+		while ((code = sqdb_stmt_step(db, stmt, xc)) == SQCODE_ROW)
+			;
+		if (code == SQCODE_DONE)
+			code = SQCODE_OK;
+		// if Sqxc element prepare for multiple row
+		if (sqxc_value_current(xc) == sqxc_value_container(xc)) {
+			xc->type = SQXC_TYPE_ARRAY_END;
+			xc->name = NULL;
+			xc = sqxc_send(xc);
+		}
+	}
+	sqdb_stmt_finalize(db, stmt);
+	return code;
+}
+
+void *sq_compiled_query_exec(SqCompiledQuery *compiled)
+{
+	SqStorage  *storage = compiled->storage;
+	Sqxc       *xcvalue;
+	void       *instance;
+
+	// destination of input
+	xcvalue = sq_storage_get_xc_input(storage);
+	sqxc_value_type(xcvalue) = compiled->type;
+	sqxc_value_container(xcvalue) = compiled->container;
+	// get input from SQL
+	sqxc_ready(xcvalue, NULL);
+	sq_storage_lock_db(storage);
+	sq_compiled_query_run(compiled, xcvalue);
+	sq_storage_unlock_db(storage);
+	sqxc_finish(xcvalue, NULL);
+	instance = sqxc_value_instance(xcvalue);
+	sq_storage_put_xc_input(storage, xcvalue);
+	return instance;
+}
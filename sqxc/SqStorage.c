@@ -13,30 +13,33 @@
  */
 
 #if defined(_MSC_VER)
-#ifdef _WIN64
-#define __WORDSIZE 64
-#else
-#define __WORDSIZE 32
-#endif
-
 #define _CRT_SECURE_NO_WARNINGS
-#define snprintf    _snprintf
+#define strncasecmp strnicmp
 #endif  // _MSC_VER
 
-#include <limits.h>     // __WORDSIZE
-#include <stdio.h>      // snprintf
+#include <stdio.h>      // fprintf
+#include <string.h>     // memcpy, strlen
 
 #include <SqError.h>
+#include <SqUtil.h>     // sq_int64_to_str()
 #include <SqStorage.h>
 #include <SqxcSql.h>
 #include <SqxcValue.h>
 #ifdef SQ_CONFIG_HAVE_JSONC
 #include <SqxcJsonc.h>
+#else
+#include <SqxcJsonParser.h>
+#include <SqxcJsonWriter.h>
 #endif
 
 #define STORAGE_SCHEMA_INITIAL_VERSION       0
+#define STORAGE_TABLES_SIZE_MIN              16    // power of 2
 
 static char    *get_primary_key_string(void *instance, SqTable *type, const char quote[2]);
+static void     index_tables(SqStorage *storage);
+
+// every index of tables has unique serial number
+static unsigned int  tables_serial = 0;
 
 void  sq_storage_init(SqStorage *storage, Sqdb *db)
 {
@@ -44,7 +47,9 @@ void  sq_storage_init(SqStorage *storage, Sqdb *db)
 	storage->schema = sq_schema_new("current");
 	storage->schema->version = STORAGE_SCHEMA_INITIAL_VERSION;
 	storage->tables_version  = STORAGE_SCHEMA_INITIAL_VERSION;
-	sq_ptr_array_init(&storage->tables, 16, NULL);
+	storage->tables_serial   = sq_atomic_add_fetch(&tables_serial, 1);
+	storage->tables = NULL;
+	storage->tables_size = 0;
 
 	storage->container_default = SQ_TYPE_PTR_ARRAY;
 
@@ -55,17 +60,40 @@ void  sq_storage_init(SqStorage *storage, Sqdb *db)
 	// append JSON parser/writer to tail of list
 	sqxc_insert(storage->xc_input,  sqxc_new(SQXC_INFO_JSONC_PARSER), -1);
 	sqxc_insert(storage->xc_output, sqxc_new(SQXC_INFO_JSONC_WRITER), -1);
+#else
+	// use built-in JSON parser/writer if json-c is not available
+	sqxc_insert(storage->xc_input,  sqxc_new(SQXC_INFO_JSON_PARSER), -1);
+	sqxc_insert(storage->xc_output, sqxc_new(SQXC_INFO_JSON_WRITER), -1);
 #endif
+
+	// pools of Sqxc chain. xc_input and xc_output are the first chains in pools.
+	sq_ptr_array_init(&storage->xc_input_pool,  4, (SqDestroyFunc)sqxc_free_chain);
+	sq_ptr_array_init(&storage->xc_output_pool, 4, (SqDestroyFunc)sqxc_free_chain);
+	sq_ptr_array_append(&storage->xc_input_pool,  storage->xc_input);
+	sq_ptr_array_append(&storage->xc_output_pool, storage->xc_output);
+
+	sq_mutex_init(&storage->mutex, false);
+	sq_mutex_init(&storage->db_mutex, true);
+	storage->in_transaction = false;
+
+	storage->intern = sq_intern_new(NULL);
 }
 
 void  sq_storage_final(SqStorage *storage)
 {
 //	sq_type_unref(storage->container_default);
 	sq_schema_free(storage->schema);
-	sq_ptr_array_final(&storage->tables);
+	free(storage->tables);
+
+	// free all Sqxc chains (include xc_input and xc_output)
+	sq_ptr_array_final(&storage->xc_input_pool);
+	sq_ptr_array_final(&storage->xc_output_pool);
 
-	sqxc_free_chain(storage->xc_input);
-	sqxc_free_chain(storage->xc_output);
+	sq_mutex_final(&storage->mutex);
+	sq_mutex_final(&storage->db_mutex);
+
+	// it is freed after all interned strings are released
+	sq_intern_free(storage->intern);
 }
 
 SqStorage *sq_storage_new(Sqdb *db)
@@ -86,17 +114,103 @@ void  sq_storage_free(SqStorage *storage)
 
 int   sq_storage_open(SqStorage *storage, const char *database_name)
 {
-	return sqdb_open(storage->db, database_name);
+	int   code;
+
+	sq_storage_lock_db(storage);
+	code = sqdb_open(storage->db, database_name);
+	sq_storage_unlock_db(storage);
+	return code;
 }
 
 int   sq_storage_close(SqStorage *storage)
 {
-	return sqdb_close(storage->db);
+	int   code;
+
+	sq_storage_lock_db(storage);
+	code = sqdb_close(storage->db);
+	sq_storage_unlock_db(storage);
+	return code;
 }
 
 int   sq_storage_migrate(SqStorage *storage, SqSchema *schema)
 {
-	return sqdb_migrate(storage->db, storage->schema, schema);
+	int   code;
+
+	sq_storage_lock_db(storage);
+	code = sqdb_migrate(storage->db, storage->schema, schema);
+	sq_storage_unlock_db(storage);
+	return code;
+}
+
+// ------------------------------------
+// serialize access to Sqdb that is not thread safe
+
+void  sq_storage_lock_db(SqStorage *storage)
+{
+	if (storage->db->info->thread_safe == 0)
+		sq_mutex_lock(&storage->db_mutex);
+}
+
+void  sq_storage_unlock_db(SqStorage *storage)
+{
+	if (storage->db->info->thread_safe == 0)
+		sq_mutex_unlock(&storage->db_mutex);
+}
+
+// ------------------------------------
+// transaction. db_mutex is held from BEGIN to COMMIT or ROLLBACK.
+// If Sqdb is thread safe (e.g. SqdbPool), Sqdb binds connection to thread by itself.
+
+int   sq_storage_begin(SqStorage *storage)
+{
+	int   code;
+
+	sq_storage_lock_db(storage);
+	code = sqdb_exec(storage->db, "BEGIN", NULL, NULL);
+	if (code != SQCODE_OK)
+		sq_storage_unlock_db(storage);
+	else if (storage->db->info->thread_safe == 0) {
+		storage->transaction_owner = sq_thread_self();
+		storage->in_transaction = true;
+	}
+	return code;
+}
+
+// run COMMIT or ROLLBACK and release db_mutex that was locked by sq_storage_begin()
+static int  sq_storage_end_transaction(SqStorage *storage, const char *sql)
+{
+	int   code;
+
+	if (storage->db->info->thread_safe)
+		return sqdb_exec(storage->db, sql, NULL, NULL);
+
+	// If calling thread owns transaction, it locks recursive mutex again.
+	// Otherwise it waits until transaction ends and finds no transaction.
+	sq_mutex_lock(&storage->db_mutex);
+	if (storage->in_transaction == false ||
+	    sq_thread_equal(storage->transaction_owner, sq_thread_self()) == 0)
+	{
+		sq_mutex_unlock(&storage->db_mutex);
+#ifdef DEBUG
+		fprintf(stderr, "SqStorage: %s without sq_storage_begin() in calling thread.\n", sql);
+#endif
+		return SQCODE_ERROR;
+	}
+	code = sqdb_exec(storage->db, sql, NULL, NULL);
+	storage->in_transaction = false;
+	sq_mutex_unlock(&storage->db_mutex);
+	sq_mutex_unlock(&storage->db_mutex);
+	return code;
+}
+
+int   sq_storage_commit(SqStorage *storage)
+{
+	return sq_storage_end_transaction(storage, "COMMIT");
+}
+
+int   sq_storage_rollback(SqStorage *storage)
+{
+	return sq_storage_end_transaction(storage, "ROLLBACK");
 }
 
 void *sq_storage_get_full(SqStorage  *storage,
@@ -111,7 +225,6 @@ void *sq_storage_get_full(SqStorage  *storage,
 		SqColumn *column;
 		SqTable  *table;
 		void     *instance;
-		int       len;
 	} temp;
 
 	if (type == NULL) {
@@ -134,7 +247,7 @@ void *sq_storage_get_full(SqStorage  *storage,
 	}
 
 	// destination of input
-	xcvalue = storage->xc_input;
+	xcvalue = sq_storage_get_xc_input(storage);
 	sqxc_value_type(xcvalue) = type;
 	sqxc_value_container(xcvalue) = NULL;
 
@@ -153,13 +266,15 @@ void *sq_storage_get_full(SqStorage  *storage,
 	sq_buffer_r_at(buf, 1) = storage->db->info->quote.identifier[1];
 	sq_buffer_r_at(buf, 0) = '=';
 
-	temp.len = snprintf(NULL, 0, "%d", id);
-	sprintf(sq_buffer_alloc(buf, temp.len), "%d", id);
+	sq_buffer_write_int64(buf, id);
 
 	sqxc_ready(xcvalue, NULL);
+	sq_storage_lock_db(storage);
 	sqdb_exec(storage->db, buf->buf, xcvalue, NULL);
+	sq_storage_unlock_db(storage);
 	sqxc_finish(xcvalue, NULL);
 	temp.instance = sqxc_value_instance(xcvalue);
+	sq_storage_put_xc_input(storage, xcvalue);
 	return temp.instance;
 }
 
@@ -169,8 +284,21 @@ void *sq_storage_get_all_full(SqStorage  *storage,
                               const SqType *type,
                               const SqType *container,
                               const char *sql_where_having)
+{
+	return sq_storage_get_all_arena(storage, table_name, type_name, type,
+	                                container, sql_where_having, NULL);
+}
+
+void *sq_storage_get_all_arena(SqStorage  *storage,
+                               const char *table_name,
+                               const char *type_name,
+                               const SqType *type,
+                               const SqType *container,
+                               const char *sql_where_having,
+                               SqArena    *arena)
 {
 	Sqxc     *xcvalue;
+	SqIntern  intern;
 	union {
 		SqBuffer *buf;
 		SqTable  *table;
@@ -199,9 +327,15 @@ void *sq_storage_get_all_full(SqStorage  *storage,
 		container = (SqType*)storage->container_default;
 
 	// destination of input
-	xcvalue = (Sqxc*) storage->xc_input;
+	xcvalue = sq_storage_get_xc_input(storage);
 	sqxc_value_type(xcvalue) = type;
 	sqxc_value_container(xcvalue) = container;
+	sqxc_value_arena(xcvalue) = arena;
+	if (arena) {
+		// deduplicate strings in this result only. They are allocated from 'arena'.
+		sq_intern_init(&intern, arena);
+		sqxc_value_intern(xcvalue) = &intern;
+	}
 
 	// SQL statement
 	temp.buf = sqxc_get_buffer(xcvalue);
@@ -213,12 +347,150 @@ void *sq_storage_get_all_full(SqStorage  *storage,
 		sq_buffer_write(temp.buf, sql_where_having);
 
 	sqxc_ready(xcvalue, NULL);
+	sq_storage_lock_db(storage);
 	sqdb_exec(storage->db, temp.buf->buf, xcvalue, NULL);
+	sq_storage_unlock_db(storage);
 	sqxc_finish(xcvalue, NULL);
+	if (arena) {
+		sqxc_value_arena(xcvalue) = NULL;
+		sqxc_value_intern(xcvalue) = storage->intern;
+		sq_intern_final(&intern);
+	}
 	temp.instance = sqxc_value_instance(xcvalue);
+	sq_storage_put_xc_input(storage, xcvalue);
 	return temp.instance;
 }
 
+// ------------------------------------
+// SqStorageCursor
+
+SqStorageCursor *sq_storage_cursor_open(SqStorage  *storage,
+                                        const char *table_name,
+                                        const char *type_name,
+                                        const SqType *type,
+                                        const char *sql_where_having)
+{
+	SqStorageCursor *cursor;
+	SqTable         *table;
+	SqdbStmt        *stmt;
+	SqBuffer         buf;
+	int              code;
+
+	if (type == NULL) {
+		// find SqTable by table_name or type_name
+		if (table_name)
+			table = sq_schema_find(storage->schema, table_name);
+		else    // if (type_name)
+			table = sq_storage_find_by_type(storage, type_name);
+
+		if (table == NULL)
+			return NULL;
+		type = table->type;
+		table_name = table->name;
+	}
+	else if (table_name == NULL) {
+		table = sq_storage_find_by_type(storage, type->name);
+		if (table == NULL)
+			return NULL;
+		table_name = table->name;
+	}
+	if (storage->db->info->prepare == NULL)
+		return NULL;
+
+	// SQL statement
+	sq_buffer_init(&buf);
+	sqdb_sql_from(storage->db, &buf, table_name, false);
+	// SQL WHERE ... HAVING ...
+	if (sql_where_having)
+		sq_buffer_write(&buf, sql_where_having);
+	sq_storage_lock_db(storage);
+	code = sqdb_prepare(storage->db, buf.buf, &stmt);
+	sq_storage_unlock_db(storage);
+	sq_buffer_final(&buf);
+	if (code != SQCODE_OK)
+		return NULL;
+
+	cursor = malloc(sizeof(SqStorageCursor));
+	cursor->storage = storage;
+	cursor->stmt = stmt;
+	cursor->type = type;
+	cursor->instance = NULL;
+	cursor->reuse = false;
+	cursor->code = SQCODE_OK;
+	// cursor checks out its own Sqxc chain, storage can be used while cursor is opened.
+	cursor->xc = sq_storage_get_xc_input(storage);
+	sqxc_value_reset_columns(cursor->xc);
+	sqxc_value_type(cursor->xc) = type;
+	sqxc_value_container(cursor->xc) = NULL;
+	return cursor;
+}
+
+void *sq_storage_cursor_next(SqStorageCursor *cursor)
+{
+	Sqxc  *xcvalue = cursor->xc;
+	void  *instance;
+	int    code;
+
+	if (cursor->stmt == NULL)
+		return NULL;
+
+	if (cursor->reuse) {
+		// release data of previous row and parse next row to the same instance
+		instance = cursor->instance;
+		if (instance) {
+			sq_type_final_instance(cursor->type, instance, false);
+			memset(instance, 0, cursor->type->size);
+		}
+		else
+			instance = calloc(1, cursor->type->size);
+		cursor->instance = sq_type_init_instance(cursor->type, instance, false);
+	}
+	else {
+		// create new instance for every row
+		instance = sq_type_init_instance(cursor->type, &instance, true);
+	}
+	// don't call sqxc_ready() here, it will reset column cache of SqxcValue.
+	sqxc_value_current(xcvalue) = cursor->type;
+	sqxc_value_instance(xcvalue) = instance;
+
+	sq_storage_lock_db(cursor->storage);
+	code = sqdb_stmt_step(cursor->storage->db, cursor->stmt, xcvalue);
+	// no more row (or error). release statement now.
+	if (code != SQCODE_ROW) {
+		sqdb_stmt_finalize(cursor->storage->db, cursor->stmt);
+		cursor->stmt = NULL;
+		if (code != SQCODE_DONE)
+			cursor->code = code;
+	}
+	sq_storage_unlock_db(cursor->storage);
+	sqxc_finish(xcvalue, NULL);
+	instance = sqxc_value_instance(xcvalue);
+
+	if (code == SQCODE_ROW)
+		return instance;
+
+	if (cursor->reuse == false)
+		sq_type_final_instance(cursor->type, &instance, true);
+	return NULL;
+}
+
+void  sq_storage_cursor_close(SqStorageCursor *cursor)
+{
+	SqStorage *storage = cursor->storage;
+
+	if (cursor->stmt) {
+		sq_storage_lock_db(storage);
+		sqdb_stmt_finalize(storage->db, cursor->stmt);
+		sq_storage_unlock_db(storage);
+	}
+	if (cursor->instance)
+		sq_type_final_instance(cursor->type, &cursor->instance, true);
+	sq_storage_put_xc_input(storage, cursor->xc);
+	free(cursor);
+}
+
+// ------------------------------------
+
 int   sq_storage_insert(SqStorage *storage,
                         const char *table_name,
                         const char *type_name,
@@ -237,15 +509,239 @@ int   sq_storage_insert(SqStorage *storage,
 		return -1;
 
 	// destination of output
-	xcsql = storage->xc_output;
+	xcsql = sq_storage_get_xc_output(storage);
 	sqxc_sql_set_db(xcsql, storage->db);
 	xcsql->info->ctrl(xcsql, SQXC_SQL_USE_INSERT, table);
 
 	sqxc_ready(xcsql, NULL);
 	table->type->write(instance, table->type, xcsql);
+	// SqxcSql run SQL statement when it finish
+	sq_storage_lock_db(storage);
 	sqxc_finish(xcsql, NULL);
+	id = (int)sqxc_sql_id(xcsql);
+	sq_storage_unlock_db(storage);
+
+	sq_storage_put_xc_output(storage, xcsql);
+	return id;
+}
+
+// ------------------------------------
+// sq_storage_insert_all()
 
-	return (id = sqxc_sql_id(xcsql));
+// element type of container in sq_storage_insert_all().
+// It splits rows into multiple INSERT statements and collects instances of rows to set inserted id.
+typedef struct InsertAllType
+{
+	SqType      type;         // copy of table->type. SqType.write is replaced.
+
+	SqStorage  *storage;
+	SqTable    *table;
+	SqColumn   *primary;      // integer primary key (AUTOINCREMENT)
+	unsigned int  primary_bit;    // bit of 'primary' in 'skipped'
+	Sqxc       *xcsql;        // SqxcSql that checked out from storage
+
+	void      **rows;         // instances in current INSERT statement
+	int         n_rows;
+	int         max_rows;
+	int         n_inserted;
+	unsigned int  skipped;    // columns that SqxcSql doesn't output in current INSERT statement
+} InsertAllType;
+
+// return bit field of columns that SqxcSql will not output. All rows in an INSERT statement must have the same columns.
+// This must match sqxc_sql_send_insert_command().
+static unsigned int insert_all_skipped_columns(InsertAllType *iatype, void *instance)
+{
+	const SqType *type = iatype->table->type;
+	SqColumn   *column;
+	void       *field;
+	unsigned int  bit, skipped = 0;
+	int           index;
+
+	for (index = 0, bit = 1;  index < type->n_entry;  index++) {
+		column = (SqColumn*)type->entry[index];
+		if (column->bit_field & SQB_POINTER)
+			continue;
+		field = (char*)instance + column->offset;
+		// column has AUTO INCREMENT and value is 0
+		if (column->bit_field & SQB_INCREMENT) {
+			if (column == iatype->primary)
+				iatype->primary_bit = bit;
+			if (column->type == SQ_TYPE_INT64 || column->type == SQ_TYPE_UINT64) {
+				if (*(int64_t*)field == 0)
+					skipped |= bit;
+			}
+			else if (*(int*)field == 0)
+				skipped |= bit;
+			bit <<= 1;
+		}
+		// column has DEFAULT CURRENT_XXXX and value is 0
+		else if (column->type == SQ_TYPE_TIME && column->default_value &&
+		         strncasecmp("CURRENT_", column->default_value, 8) == 0)
+		{
+			if (*(time_t*)field == 0)
+				skipped |= bit;
+			bit <<= 1;
+		}
+	}
+	return skipped;
+}
+
+// write inserted id to instances of current INSERT statement.
+// Rows of a statement get consecutive ids only if database generates id for all of them.
+static void insert_all_set_id(InsertAllType *iatype, int64_t id)
+{
+	SqColumn *primary = iatype->primary;
+	void     *field;
+
+	if (primary == NULL || (primary->bit_field & SQB_POINTER))
+		return;
+	// rows in current statement have preset id. SqxcSql output primary key.
+	if ((iatype->skipped & iatype->primary_bit) == 0)
+		return;
+	// MySQL returns id of the first row, SQLite returns id of the last row.
+	if (iatype->storage->db->info->product != SQDB_PRODUCT_MYSQL)
+		id = id - iatype->n_rows + 1;
+
+	for (int index = 0;  index < iatype->n_rows;  index++, id++) {
+		field = (char*)iatype->rows[index] + primary->offset;
+		if (primary->type == SQ_TYPE_INT64 || primary->type == SQ_TYPE_UINT64)
+			*(int64_t*)field = id;
+		else
+			*(int*)field = (int)id;
+	}
+}
+
+// run INSERT statement that has current rows
+static int  insert_all_flush(InsertAllType *iatype)
+{
+	Sqxc *xcsql = iatype->xcsql;
+
+	if (sqxc_broadcast(xcsql, SQXC_CTRL_FINISH, NULL) != SQCODE_OK)
+		return SQCODE_EXEC_ERROR;
+	insert_all_set_id(iatype, sqxc_sql_id(xcsql));
+	iatype->n_inserted += iatype->n_rows;
+	iatype->n_rows = 0;
+	return SQCODE_OK;
+}
+
+static Sqxc *insert_all_write(void *instance, const SqType *type, Sqxc *dest)
+{
+	InsertAllType *iatype = (InsertAllType*)type;
+	Sqxc          *xcsql  = iatype->xcsql;
+	unsigned int   skipped;
+
+	skipped = insert_all_skipped_columns(iatype, instance);
+	// start new INSERT statement if it reaches limit or columns are changed
+	if (iatype->n_rows == iatype->max_rows || (iatype->n_rows > 0 && iatype->skipped != skipped)) {
+		// End of current statement
+		dest->type = SQXC_TYPE_ARRAY_END;
+		dest->name = NULL;
+		dest = sqxc_send(dest);
+		if (dest->code != SQCODE_OK)
+			return dest;
+		dest->code = insert_all_flush(iatype);
+		if (dest->code != SQCODE_OK)
+			return dest;
+		// Begin of next statement
+		xcsql->info->ctrl(xcsql, SQXC_SQL_USE_INSERT, iatype->table);
+		sqxc_ready(xcsql, NULL);
+		xcsql->type = SQXC_TYPE_ARRAY;
+		xcsql->name = NULL;
+		dest = sqxc_send(xcsql);
+		if (dest->code != SQCODE_OK)
+			return dest;
+	}
+	iatype->skipped = skipped;
+	iatype->rows[iatype->n_rows++] = instance;
+
+	type = iatype->table->type;
+	return type->write(instance, type, dest);
+}
+
+int   sq_storage_insert_all(SqStorage *storage,
+                            const char *table_name,
+                            const char *type_name,
+                            void *container,
+                            const SqType *container_type)
+{
+	InsertAllType  iatype;
+	SqType         ctype;
+	SqTable       *table;
+	Sqxc          *xcsql;
+	bool           in_transaction;
+	int            code;
+
+	// find SqTable by table_name or type_name
+	if (table_name)
+		table = sq_schema_find(storage->schema, table_name);
+	else
+		table = sq_storage_find_by_type(storage, type_name);
+	if (table == NULL)
+		return -1;
+	if (container_type == NULL)
+		container_type = storage->container_default;
+
+	// replace element type of container
+	iatype.type = *table->type;
+	iatype.type.write = insert_all_write;
+	iatype.storage = storage;
+	iatype.table = table;
+	iatype.primary = sq_table_get_primary(table, NULL);
+	if (iatype.primary && (iatype.primary->bit_field & SQB_INCREMENT) == 0)
+		iatype.primary = NULL;
+	iatype.primary_bit = 0;
+	iatype.n_rows = 0;
+	iatype.n_inserted = 0;
+	iatype.skipped = 0;
+	// split rows by limit of bound parameters
+	iatype.max_rows = SQ_CONFIG_STORAGE_INSERT_ALL_PARAMS / ((table->type->n_entry > 0) ? table->type->n_entry : 1);
+	// ids of multi-row INSERT are consecutive in SQLite and MySQL. Insert rows one by one for other products.
+	if (iatype.max_rows < 1 || (iatype.primary &&
+	    storage->db->info->product != SQDB_PRODUCT_SQLITE && storage->db->info->product != SQDB_PRODUCT_MYSQL))
+		iatype.max_rows = 1;
+	iatype.rows = malloc(sizeof(void*) * iatype.max_rows);
+	// container get element type from SqType.entry if SqType.n_entry == -1 (SQ_TYPE_PTR_ARRAY, Sq::TypeStl)
+	ctype = *container_type;
+	ctype.entry = (SqEntry**)&iatype.type;
+	ctype.n_entry = -1;
+
+	// destination of output
+	xcsql = sq_storage_get_xc_output(storage);
+	iatype.xcsql = xcsql;
+
+	// run all INSERT statements in a transaction. BEGIN fails if user has started a transaction.
+	// db_mutex is recursive, keep it locked even if BEGIN fails.
+	// SqdbPool run all statements in the connection that is bound to this thread by BEGIN.
+	sq_storage_lock_db(storage);
+	in_transaction = (sq_storage_begin(storage) == SQCODE_OK);
+
+	sqxc_sql_set_db(xcsql, storage->db);
+	xcsql->info->ctrl(xcsql, SQXC_SQL_USE_INSERT, table);
+
+	sqxc_ready(xcsql, NULL);
+	xcsql->name = NULL;
+	code = ctype.write(container, &ctype, xcsql)->code;
+	if (code == SQCODE_OK)
+		code = insert_all_flush(&iatype);
+	else {
+		// clear Sqxc chain. SqxcSql doesn't run INSERT statement if it has no row.
+		((SqxcSql*)xcsql)->row_count = 0;
+		sqxc_finish(xcsql, NULL);
+	}
+	free(iatype.rows);
+
+	if (in_transaction) {
+		if (code == SQCODE_OK)
+			sq_storage_commit(storage);
+		else
+			sq_storage_rollback(storage);
+	}
+	sq_storage_unlock_db(storage);
+	sq_storage_put_xc_output(storage, xcsql);
+
+	if (code != SQCODE_OK)
+		return -1;
+	return iatype.n_inserted;
 }
 
 void  sq_storage_update(SqStorage *storage,
@@ -270,7 +766,7 @@ void  sq_storage_update(SqStorage *storage,
 		return;
 
 	// destination of output
-	xcsql = storage->xc_output;
+	xcsql = sq_storage_get_xc_output(storage);
 	xcsql->info->ctrl(xcsql, SQXC_SQL_USE_UPDATE, table);
 	xcsql->info->ctrl(xcsql, SQXC_SQL_USE_WHERE, where);
 	sqxc_sql_set_db(xcsql, storage->db);
@@ -278,7 +774,12 @@ void  sq_storage_update(SqStorage *storage,
 
 	sqxc_ready(xcsql, NULL);
 	table->type->write(instance, table->type, xcsql);
+	// SqxcSql run SQL statement when it finish
+	sq_storage_lock_db(storage);
 	sqxc_finish(xcsql, NULL);
+	sq_storage_unlock_db(storage);
+
+	sq_storage_put_xc_output(storage, xcsql);
 }
 
 void  sq_storage_remove(SqStorage *storage,
@@ -289,7 +790,7 @@ void  sq_storage_remove(SqStorage *storage,
 	SqBuffer  *buf;
 	SqTable   *table;
 	SqColumn  *column;
-	int        len;
+	Sqxc      *xcsql;
 //	int        code;
 
 	// find SqTable by table_name or type_name
@@ -302,150 +803,200 @@ void  sq_storage_remove(SqStorage *storage,
 
 	column = sq_table_get_primary(table, NULL);
 
-	buf = sqxc_get_buffer(storage->xc_output);
+	xcsql = sq_storage_get_xc_output(storage);
+	buf = sqxc_get_buffer(xcsql);
 	buf->writed = 0;
 	sqdb_sql_from(storage->db, buf, table->name, true);
 	sq_buffer_write(buf, "WHERE");
-	len = snprintf(NULL, 0, " %c%s%c=%d",
-	               storage->db->info->quote.identifier[0],
-	               column->name,
-	               storage->db->info->quote.identifier[1],
-	               id);
-	sprintf(sq_buffer_alloc(buf, len), " %c%s%c=%d",
-	        storage->db->info->quote.identifier[0],
-	        column->name,
-	        storage->db->info->quote.identifier[1],
-	        id);
+	sq_buffer_alloc(buf, 2);
+	sq_buffer_r_at(buf, 1) = ' ';
+	sq_buffer_r_at(buf, 0) = storage->db->info->quote.identifier[0];
+	sq_buffer_write(buf, column->name);
+	sq_buffer_alloc(buf, 2);
+	sq_buffer_r_at(buf, 1) = storage->db->info->quote.identifier[1];
+	sq_buffer_r_at(buf, 0) = '=';
+	sq_buffer_write_int64(buf, id);
+	sq_storage_lock_db(storage);
 	sqdb_exec(storage->db, buf->buf, NULL, NULL);
+	sq_storage_unlock_db(storage);
+
+	sq_storage_put_xc_output(storage, xcsql);
+}
+
+// ------------------------------------
+// pools of Sqxc chain
+
+// check out Sqxc chain from 'pool'. Create new chain that has the same SqxcInfo elements as 'xc_template' if pool is empty.
+static Sqxc  *get_xc(SqStorage *storage, SqPtrArray *pool, Sqxc *xc_template)
+{
+	Sqxc *xc = NULL;
+
+	sq_mutex_lock(&storage->mutex);
+	if (pool->length > 0)
+		xc = pool->data[--pool->length];
+	sq_mutex_unlock(&storage->mutex);
+
+	if (xc == NULL) {
+		xc = sqxc_new(xc_template->info);
+		for (xc_template = xc_template->peer;  xc_template;  xc_template = xc_template->peer)
+			sqxc_insert(xc, sqxc_new(xc_template->info), -1);
+	}
+	return xc;
+}
+
+// return Sqxc chain to 'pool'
+static void   put_xc(SqStorage *storage, SqPtrArray *pool, Sqxc *xc)
+{
+	sq_mutex_lock(&storage->mutex);
+	sq_ptr_array_append(pool, xc);
+	sq_mutex_unlock(&storage->mutex);
+}
+
+Sqxc *sq_storage_get_xc_input(SqStorage *storage)
+{
+	Sqxc *xc;
+
+	xc = get_xc(storage, (SqPtrArray*)&storage->xc_input_pool, storage->xc_input);
+	sqxc_value_intern(xc) = storage->intern;
+	return xc;
+}
+
+Sqxc *sq_storage_get_xc_output(SqStorage *storage)
+{
+	return get_xc(storage, (SqPtrArray*)&storage->xc_output_pool, storage->xc_output);
+}
+
+void  sq_storage_put_xc_input(SqStorage *storage, Sqxc *xc)
+{
+	put_xc(storage, (SqPtrArray*)&storage->xc_input_pool, xc);
+}
+
+void  sq_storage_put_xc_output(SqStorage *storage, Sqxc *xc)
+{
+	put_xc(storage, (SqPtrArray*)&storage->xc_output_pool, xc);
 }
 
 // ------------------------------------
 
 SqTable  *sq_storage_find_by_type(SqStorage *storage, const char *type_name)
 {
-	SqPtrArray *type_tables;      // sorted by SqType.name
-	SqPtrArray *schema_tables;    // sorted by SqTable.name
-	SqTable   **table_addr;
-	int         count;
+	SqTable      *table;
+	const char   *name;
+	const char   *cur;
+	unsigned int  hash = 2166136261u;    // FNV-1a
+	unsigned int  mask;
+
+	for (cur = type_name;  *cur;  cur++)
+		hash = (hash ^ (unsigned char)*cur) * 16777619u;
 
-	type_tables = &storage->tables;
-	schema_tables = sq_type_get_ptr_array(storage->schema->type);
+	// storage->tables is shared by threads. lock it while indexing and searching.
+	sq_mutex_lock(&storage->mutex);
 	// if version is not the same
 	if (storage->tables_version != storage->schema->version) {
 		storage->tables_version  = storage->schema->version;
-		count = schema_tables->length - type_tables->length;
-		if (count > 0)
-			sq_ptr_array_alloc(type_tables, count);
-		memcpy(type_tables->data, schema_tables->data, sizeof(void*) * schema_tables->length);
-		// sort storage->tables by SqTable.type.name
-		sq_ptr_array_sort(type_tables, sq_entry_cmp_type_name);
+		index_tables(storage);
 	}
 	// search storage->tables by SqTable.type.name
-	table_addr = sq_ptr_array_search(type_tables, type_name,
-	             (SqCompareFunc)sq_entry_cmp_str__type_name);
-	if (table_addr)
-		return *table_addr;
-	return NULL;
+	table = NULL;
+	if (storage->tables) {
+		mask = storage->tables_size - 1;
+		for (;  (table = storage->tables[hash & mask]) != NULL;  hash++) {
+			name = table->type->name;
+			// typeid(Type).name() returns the same address in the same module
+			if (name == type_name || strcmp(name, type_name) == 0)
+				break;
+		}
+	}
+	sq_mutex_unlock(&storage->mutex);
+	return table;
 }
 
 // ----------------------------------------------------------------------------
 // static function
 
+// hash index of tables by SqTable.type.name (open addressing)
+static void  index_tables(SqStorage *storage)
+{
+	SqPtrArray   *schema_tables = sq_type_get_ptr_array(storage->schema->type);
+	SqTable      *table;
+	SqTable     **slot;
+	const char   *cur;
+	unsigned int  hash, mask;
+	unsigned int  size;
+	int           index;
+
+	// load factor <= 0.5
+	for (size = STORAGE_TABLES_SIZE_MIN;  size < (unsigned int)schema_tables->length * 2;  size <<= 1)
+		;
+	if (storage->tables_size != size) {
+		free(storage->tables);
+		storage->tables = malloc(sizeof(SqTable*) * size);
+		storage->tables_size = size;
+	}
+	memset(storage->tables, 0, sizeof(SqTable*) * size);
+	mask = size - 1;
+
+	for (index = 0;  index < schema_tables->length;  index++) {
+		table = schema_tables->data[index];
+		if (table == NULL || table->type->name == NULL)
+			continue;
+		hash = 2166136261u;    // FNV-1a
+		for (cur = table->type->name;  *cur;  cur++)
+			hash = (hash ^ (unsigned char)*cur) * 16777619u;
+		slot = storage->tables + (hash & mask);
+		while (*slot && strcmp((*slot)->type->name, table->type->name) != 0)
+			slot = storage->tables + (++hash & mask);
+		// keep the first table if tables have the same type
+		if (*slot == NULL)
+			*slot = table;
+	}
+
+	// C++ cache of SqTable use serial number to check if index was changed.
+	// release store: thread that loads new serial (acquire) also sees new index.
+	sq_atomic_store(&storage->tables_serial, sq_atomic_add_fetch(&tables_serial, 1));
+}
+
 static char  *get_primary_key_string(void *instance, SqTable *table, const char quote[2])
 {
 	SqColumn   *column;
-	char       *condition = NULL;
+	char       *condition;
 	int         len;
 
 	column = sq_table_get_primary(table, NULL);
+	if (SQ_TYPE_NOT_INT(column->type))
+		return NULL;
+
+	// "column name"=id
+	len = (int)strlen(column->name);
+	condition = malloc(len + 3 + SQ_INT64_STR_SIZE);
+	condition[0] = quote[0];
+	memcpy(condition + 1, column->name, len);
+	condition[len + 1] = quote[1];
+	condition[len + 2] = '=';
 
 	// integer
 	instance = (char*)instance + column->offset;
 	switch(SQ_TYPE_BUILTIN_INDEX(column->type)) {
 	case SQ_TYPE_INT_INDEX:
-		len = snprintf(NULL, 0, "%c%s%c=%d",
-				quote[0], column->name, quote[1], *(int*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%d",
-				quote[0], column->name, quote[1], *(int*)instance);
+		sq_int64_to_str(condition + len + 3, *(int*)instance);
 		break;
 
 	case SQ_TYPE_UINT_INDEX:
-		len = snprintf(NULL, 0, "%c%s%c=%u",
-				quote[0], column->name, quote[1], *(unsigned int*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%u",
-				quote[0], column->name, quote[1], *(unsigned int*)instance);
+		sq_uint64_to_str(condition + len + 3, *(unsigned int*)instance);
 		break;
 
 	case SQ_TYPE_INT64_INDEX:
-#if defined (_MSC_VER)  // || defined (__MINGW32__) || defined (__MINGW64__)
-		len = snprintf(NULL, 0, "%c%s%c=%I64d",
-				quote[0], column->name, quote[1], *(int64_t*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%I64d",
-				quote[0], column->name, quote[1], *(int64_t*)instance);
-#elif defined(__WORDSIZE) && (__WORDSIZE == 64)
-		len = snprintf(NULL, 0, "%c%s%c=%ld",
-				quote[0], column->name, quote[1], *(int64_t*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%ld",
-				quote[0], column->name, quote[1], *(int64_t*)instance);
-#else
-		len = snprintf(NULL, 0, "%c%s%c=%lld",
-				quote[0], column->name, quote[1], (long long int) *(int64_t*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%lld",
-				quote[0], column->name, quote[1], (long long int) *(int64_t*)instance);
-#endif
+		sq_int64_to_str(condition + len + 3, *(int64_t*)instance);
 		break;
 
 	case SQ_TYPE_UINT64_INDEX:
-#if defined (_MSC_VER)  // || defined (__MINGW32__) || defined (__MINGW64__)
-		len = snprintf(NULL, 0, "%c%s%c=%I64u",
-				quote[0], column->name, quote[1], *(uint64_t*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%I64u",
-				quote[0], column->name, quote[1], *(uint64_t*)instance);
-#elif defined(__WORDSIZE) && (__WORDSIZE == 64)
-		len = snprintf(NULL, 0, "%c%s%c=%lu",
-				quote[0], column->name, quote[1], *(uint64_t*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%lu",
-				quote[0], column->name, quote[1], *(uint64_t*)instance);
-#else
-		len = snprintf(NULL, 0, "%c%s%c=%llu",
-				quote[0], column->name, quote[1], (long long unsigned int) *(int64_t*)instance) +1;
-		condition = malloc(len);
-		snprintf(condition, len, "%c%s%c=%llu",
-				quote[0], column->name, quote[1], (long long unsigned int) *(int64_t*)instance);
-#endif
+		sq_uint64_to_str(condition + len + 3, *(uint64_t*)instance);
 		break;
 
 	default:
+		free(condition);
 		return NULL;
 	}
 
 	return condition;
 }
-
-// ----------------------------------------------------------------------------
-// If compiler doesn't support C99 inline functions
-
-#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L)
-// C99 or C++ inline functions in SqArray.h
-#else
-
-int  sq_storage_begin(SqStorage *storage) {
-	return SQ_STORAGE_BEGIN(storage);
-}
-
-int  sq_storage_commit(SqStorage *storage) {
-	return SQ_STORAGE_COMMIT(storage);
-}
-
-int  sq_storage_rollback(SqStorage *storage) {
-	return SQ_STORAGE_ROLLBACK(storage);
-}
-
-#endif  // __STDC_VERSION
@@ -18,6 +18,9 @@
 
 #include <Sqdb.h>
 #include <SqSchema.h>
+#include <SqThread.h>
+#include <SqArena.h>
+#include <SqIntern.h>
 #include <SqJoint.h>
 #ifdef __cplusplus
 #include <SqType-stl-cpp.h>
@@ -27,20 +30,13 @@
 // C/C++ common declarations: declare type, structue, macro, enumeration.
 
 typedef struct SqStorage         SqStorage;
+typedef struct SqStorageCursor   SqStorageCursor;
+typedef struct SqCompiledQuery   SqCompiledQuery;
+typedef struct SqCompiledParam   SqCompiledParam;
+typedef struct SqCompiledPlace   SqCompiledPlace;
 
 typedef struct SqQuery           SqQuery;    // define in SqQuery.h
 
-/* macro for maintaining C/C++ inline functions easily */
-
-// int   sq_storage_begin(SqStorage *storage);
-#define  SQ_STORAGE_BEGIN(storage)     (storage)->db->info->exec((storage)->db, "BEGIN", NULL, NULL);
-
-// int   sq_storage_commit(SqStorage *storage);
-#define  SQ_STORAGE_COMMIT(storage)    (storage)->db->info->exec((storage)->db, "COMMIT", NULL, NULL);
-
-// int   sq_storage_rollback(SqStorage *storage);
-#define  SQ_STORAGE_ROLLBACK(storage)  (storage)->db->info->exec((storage)->db, "ROLLBACK", NULL, NULL);
-
 // ----------------------------------------------------------------------------
 // C declarations: declare C data, function, and others.
 
@@ -60,8 +56,22 @@ int   sq_storage_open(SqStorage *storage, const char *database_name);
 int   sq_storage_close(SqStorage *storage);
 
 // synchronize storage->schema to database if 'schema' == NULL (Mainly used by SQLite)
+// storage->schema is changed by migration. Don't call it while other threads are accessing storage.
 int   sq_storage_migrate(SqStorage *storage, SqSchema *schema);
 
+// Transaction is bound to calling thread. sq_storage_begin() lock database of storage if it succeeds,
+// other threads wait until this thread call sq_storage_commit() or sq_storage_rollback().
+// If database is thread safe (e.g. SqdbPool), other threads use other connections and don't wait.
+// sq_storage_commit() and sq_storage_rollback() return SQCODE_ERROR if calling thread didn't begin transaction.
+int   sq_storage_begin(SqStorage *storage);
+int   sq_storage_commit(SqStorage *storage);
+int   sq_storage_rollback(SqStorage *storage);
+
+// lock/unlock database of storage if it is not thread safe (SqdbInfo.thread_safe == 0).
+// call them if you use storage->db directly while other threads are accessing storage.
+void  sq_storage_lock_db(SqStorage *storage);
+void  sq_storage_unlock_db(SqStorage *storage);
+
 // ------------------------------------
 // CRUD functions can work if user only specify one of 'table_name', 'type_name', or 'type'.
 
@@ -80,6 +90,18 @@ void *sq_storage_get_all_full(SqStorage  *storage,
                               const SqType *container,
                               const char *sql_where_having);
 
+// All memory of result (container, instances, and strings) is allocated from 'arena'.
+// Don't free result, release it by sq_arena_free(arena) or sq_arena_reset(arena).
+// Values of SQ_TYPE_INTERN_STRING are deduplicated in result and allocated from 'arena' too.
+// It works with C types only, e.g. SQ_TYPE_PTR_ARRAY container and structure that defined by SqColumn.
+void *sq_storage_get_all_arena(SqStorage  *storage,
+                               const char *table_name,
+                               const char *type_name,
+                               const SqType *type,
+                               const SqType *container,
+                               const char *sql_where_having,
+                               SqArena    *arena);
+
 // void *sq_storage_get(SqStorage  *storage,
 //                      const char *table_name,
 //                      const char *type_name,
@@ -111,6 +133,17 @@ int   sq_storage_insert(SqStorage *storage,
                         const char *type_name,
                         void *instance);
 
+// insert all elements of 'container' in a transaction. 'container_type' must get element type from SqType.entry
+// like SQ_TYPE_PTR_ARRAY or Sq::TypeStl. Rows are split into multiple INSERT statements.
+// Inserted id will be written to instances that have AUTOINCREMENT primary key.
+// return number of inserted rows if no error
+// return -1 if error occurred
+int   sq_storage_insert_all(SqStorage *storage,
+                            const char *table_name,
+                            const char *type_name,
+                            void *container,
+                            const SqType *container_type);
+
 void  sq_storage_update(SqStorage *storage,
                         const char *table_name,
                         const char *type_name,
@@ -121,6 +154,29 @@ void  sq_storage_remove(SqStorage *storage,
                         const char *type_name,
                         int   id);
 
+// ------------------------------------
+// cursor - get rows one by one. It doesn't load all rows into container.
+
+// This function will generate below SQL statement to get rows
+// SELECT * FROM table_name + 'sql_where_having'
+// return NULL if error occurred or Sqdb doesn't support prepared statement.
+SqStorageCursor *sq_storage_cursor_open(SqStorage  *storage,
+                                        const char *table_name,
+                                        const char *type_name,
+                                        const SqType *type,
+                                        const char *sql_where_having);
+
+// return instance of next row, or NULL if no more row or error occurred. Error code is in cursor->code.
+// If cursor reuse instance, returned instance is freed by next call or sq_storage_cursor_close().
+// Otherwise caller must free returned instance.
+void    *sq_storage_cursor_next(SqStorageCursor *cursor);
+
+void     sq_storage_cursor_close(SqStorageCursor *cursor);
+
+// void sq_storage_cursor_reuse(SqStorageCursor *cursor, bool reuse_instance);
+// use the same instance for all rows. call it before sq_storage_cursor_next()
+#define sq_storage_cursor_reuse(cursor, boolean)    (cursor)->reuse = (boolean)
+
 // ------------------------------------
 
 // find SqTable by SqTable.name
@@ -129,6 +185,13 @@ void  sq_storage_remove(SqStorage *storage,
 // find SqTable by SqType.name
 SqTable *sq_storage_find_by_type(SqStorage *storage, const char *type_name);
 
+// check out Sqxc chain from pool of storage. Every thread must use its own Sqxc chain.
+// Sqxc chain must be returned by sq_storage_put_xc_input() or sq_storage_put_xc_output() after use.
+Sqxc *sq_storage_get_xc_input(SqStorage *storage);
+Sqxc *sq_storage_get_xc_output(SqStorage *storage);
+void  sq_storage_put_xc_input(SqStorage *storage, Sqxc *xc);
+void  sq_storage_put_xc_output(SqStorage *storage, Sqxc *xc);
+
 // ------------------------------------
 // SqStorage-query.c
 
@@ -145,6 +208,44 @@ SqType  *sq_storage_type_from_query(SqStorage *storage, SqQuery *query, int *n_t
 // ...etc
 void *sq_storage_query(SqStorage *storage, SqQuery *query, const SqType *container, const SqType *type);
 
+// ------------------------------------
+// compiled query - build SQL statement and result type once, run it many times with bound parameters.
+
+// 'query' can use positional placeholder '?' or named placeholder ':name'. e.g.
+// sq_query_where(query, "id", "<", "?");
+// sq_query_where(query, "name", ":name");
+// 'query' can be freed after compiling. Arguments 'container' and 'type' are the same as sq_storage_query().
+// return NULL if error occurred.
+SqCompiledQuery *sq_storage_compile(SqStorage *storage, SqQuery *query, const SqType *container, const SqType *type);
+
+void  sq_compiled_query_free(SqCompiledQuery *compiled);
+
+// return index of named parameter (start from 1), or 0 if not found. 'name' can omit prefix ':'.
+int   sq_compiled_query_index(SqCompiledQuery *compiled, const char *name);
+
+// bind value to parameter 'index' (start from 1). 'type' is SQXC_TYPE_INT, SQXC_TYPE_INT64, SQXC_TYPE_DOUBLE,
+// SQXC_TYPE_TIME, SQXC_TYPE_BOOL, or SQXC_TYPE_STRING. String isn't copied, it must be valid until execution.
+// Bound values are kept for next execution. Parameters that are not bound are NULL.
+int   sq_compiled_query_bind(SqCompiledQuery *compiled, int index, int type, ...);
+
+#define sq_compiled_query_bind_bool(compiled, index, value)      \
+		sq_compiled_query_bind(compiled, index, SQXC_TYPE_BOOL, (int)(value))
+#define sq_compiled_query_bind_int(compiled, index, value)       \
+		sq_compiled_query_bind(compiled, index, SQXC_TYPE_INT, (int)(value))
+#define sq_compiled_query_bind_int64(compiled, index, value)     \
+		sq_compiled_query_bind(compiled, index, SQXC_TYPE_INT64, (int64_t)(value))
+#define sq_compiled_query_bind_double(compiled, index, value)    \
+		sq_compiled_query_bind(compiled, index, SQXC_TYPE_DOUBLE, (double)(value))
+#define sq_compiled_query_bind_time(compiled, index, value)      \
+		sq_compiled_query_bind(compiled, index, SQXC_TYPE_TIME, (time_t)(value))
+#define sq_compiled_query_bind_string(compiled, index, value)    \
+		sq_compiled_query_bind(compiled, index, SQXC_TYPE_STRING, (const char*)(value))
+#define sq_compiled_query_bind_null(compiled, index)             \
+		sq_compiled_query_bind(compiled, index, SQXC_TYPE_STRING, (const char*)NULL)
+
+// run compiled query with bound parameters. return instance of container like sq_storage_query().
+void *sq_compiled_query_exec(SqCompiledQuery *compiled);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -157,6 +258,9 @@ void *sq_storage_query(SqStorage *storage, SqQuery *query, const SqType *contain
 namespace Sq
 {
 
+template <class StructType>
+class CursorRange;
+
 /* StorageMethod : C++ struct is used by SqStorage and it's children. */
 
 struct StorageMethod
@@ -172,6 +276,10 @@ struct StorageMethod
 
 	int   migrate(SqSchema *schema);
 
+	// find SqTable by StructType. Result is cached in each thread until schema is changed.
+	template <class StructType>
+	SqTable    *findByType();
+
 	template <class StructType>
 	StructType *get(int id);
 	void       *get(const char *table_name, int id);
@@ -199,6 +307,8 @@ struct StorageMethod
 	StlContainer *query(SqQuery *query);
 	void *query(SqQuery *query, const SqType *container = NULL, const SqType *type = NULL);
 
+	SqCompiledQuery *compile(SqQuery *query, const SqType *container = NULL, const SqType *type = NULL);
+
 	template <class StructType>
 	int   insert(StructType& instance);
 	template <class StructType>
@@ -207,6 +317,14 @@ struct StorageMethod
 	int   insert(void *instance);
 	int   insert(const char *table_name, void *instance);
 
+	template <class StlContainer>
+	int   insertAll(StlContainer& container);
+	template <class StlContainer>
+	int   insertAll(StlContainer *container);
+	template <class StructType>
+	int   insertAll(void *container, const SqType *container_type = NULL);
+	int   insertAll(const char *table_name, void *container, const SqType *container_type = NULL);
+
 	template <class StructType>
 	void  update(StructType& instance);
 	template <class StructType>
@@ -219,6 +337,9 @@ struct StorageMethod
 	void  remove(int id);
 	void  remove(const char *table_name, int id);
 
+	template <class StructType>
+	CursorRange<StructType> cursor(const char *sql_where_having = NULL, bool reuse_instance = true);
+
 	int   begin();
 	int   commit();
 	int   rollback();
@@ -243,58 +364,114 @@ struct SqStorage
 
 	SqSchema  *schema;      // current schema
 
-	// tables is sorted by SqTable.type.name
-	SqPtrArray tables;
+	// hash index of tables by SqTable.type.name. It is rebuilt if schema version is changed.
+	SqTable  **tables;
+	unsigned int tables_size;       // power of 2
+	unsigned int tables_serial;     // it is changed after rebuilding index
 	int        tables_version;
 
-	// 1 thread use 1 Sqxc chain
+	// 1 thread use 1 Sqxc chain at a time.
+	// Thread check out Sqxc chain from pool while accessing storage. If pool is empty,
+	// new chain that has the same SqxcInfo elements as xc_input (or xc_output) will be created.
 	Sqxc      *xc_input;    // SqxcValue
 	Sqxc      *xc_output;   // SqxcSql
+	// pools are SqPtrArray. They don't use type SqPtrArray because it has constructor/destructor in C++,
+	// sq_storage_init() and sq_storage_final() manage them.
+	struct { SQ_PTR_ARRAY_MEMBERS(void*, data, length); }  xc_input_pool;
+	struct { SQ_PTR_ARRAY_MEMBERS(void*, data, length); }  xc_output_pool;
+
+	SqMutex    mutex;       // protect 'tables' and pools of Sqxc chain
+	SqMutex    db_mutex;    // recursive mutex. serialize access to 'db' if it is not thread safe
+
+	// thread that holds db_mutex from sq_storage_begin() to sq_storage_commit() or sq_storage_rollback()
+	SqThreadId transaction_owner;
+	bool       in_transaction;
 
 	const SqType   *container_default;
+
+	// shared strings of SQ_TYPE_INTERN_STRING columns. They are released by sq_type_final_instance().
+	SqIntern  *intern;
 };
 
-// ----------------------------------------------------------------------------
-// C/C++ common definitions: define global inline function
+/* --- SqStorageCursor --- */
 
-#if (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L)) || defined(__cplusplus)
-// C99 or C++ inline functions
+struct SqStorageCursor
+{
+	SqStorage     *storage;
+	SqdbStmt      *stmt;
+	Sqxc          *xc;          // SqxcValue. cursor checks out its own Sqxc chain from storage.
+	const SqType  *type;
+
+	void          *instance;    // current instance if 'reuse' is true
+	bool           reuse;       // use the same instance for all rows
+	int            code;        // SQCODE_OK, or error code if sq_storage_cursor_next() failed to get row
+};
 
-#ifdef __cplusplus  // C++
-inline
-#else               // C99
-static inline
-#endif
-int      sq_storage_begin(SqStorage *storage) {
-	return SQ_STORAGE_BEGIN(storage);
-}
+/* --- SqCompiledQuery --- */
 
-#ifdef __cplusplus  // C++
-inline
-#else               // C99
-static inline
-#endif
-int      sq_storage_commit(SqStorage *storage) {
-	return SQ_STORAGE_COMMIT(storage);
-}
+struct SqCompiledParam
+{
+	char          *name;        // name of parameter, NULL if it is positional '?'
+	uint16_t       type;        // SqxcType of bound value
+	union {
+		bool        boolean;
+		int         integer;
+		int64_t     int64;
+		time_t      rawtime;
+		double      fraction;
+		const char *string;
+	} value;
+};
 
-#ifdef __cplusplus  // C++
-inline
-#else               // C99
-static inline
-#endif
-int      sq_storage_rollback(SqStorage *storage) {
-	return SQ_STORAGE_ROLLBACK(storage);
-}
+// placeholder in SQL statement
+struct SqCompiledPlace
+{
+	int            param;       // index of SqCompiledQuery.params
+	int            pos;         // position of '?' in SqCompiledQuery.sql
+};
 
-#else   // __STDC_VERSION__ || __cplusplus
+struct SqCompiledQuery
+{
+	SqStorage     *storage;
+	char          *sql;         // named placeholders have been replaced by '?'
+	const SqType  *container;
+	const SqType  *type;        // type of row
+	bool           type_owned;  // 'type' is created by sq_storage_type_from_query()
 
-// C functions
-int      sq_storage_begin(SqStorage *storage);
-int      sq_storage_commit(SqStorage *storage);
-int      sq_storage_rollback(SqStorage *storage);
+	int              n_params;
+	SqCompiledParam *params;    // parameters in order of first appearance
+	int              n_places;
+	SqCompiledPlace *places;    // placeholders in order of SQL statement
 
-#endif  // __STDC_VERSION__ || __cplusplus
+#ifdef __cplusplus
+	// C++11 standard-layout
+	int   index(const char *name) {
+		return sq_compiled_query_index((SqCompiledQuery*)this, name);
+	}
+	int   bind(int index, bool value) {
+		return sq_compiled_query_bind_bool((SqCompiledQuery*)this, index, value);
+	}
+	int   bind(int index, int value) {
+		return sq_compiled_query_bind_int((SqCompiledQuery*)this, index, value);
+	}
+	int   bind(int index, int64_t value) {
+		return sq_compiled_query_bind_int64((SqCompiledQuery*)this, index, value);
+	}
+	int   bind(int index, double value) {
+		return sq_compiled_query_bind_double((SqCompiledQuery*)this, index, value);
+	}
+	int   bind(int index, const char *value) {
+		return sq_compiled_query_bind_string((SqCompiledQuery*)this, index, value);
+	}
+	template <typename Value>
+	int   bind(const char *name, Value value) {
+		return bind(sq_compiled_query_index((SqCompiledQuery*)this, name), value);
+	}
+	void *exec() {
+		return sq_compiled_query_exec((SqCompiledQuery*)this);
+	}
+#endif  // __cplusplus
+};
 
 // ----------------------------------------------------------------------------
 // C++ definitions: define C++ data, function, method, and others.
@@ -304,19 +481,41 @@ int      sq_storage_rollback(SqStorage *storage);
 namespace Sq {
 
 inline int   StorageMethod::open(const char *database_name) {
-	return sqdb_open(((SqStorage*)this)->db, database_name);
+	return sq_storage_open((SqStorage*)this, database_name);
 }
 inline int   StorageMethod::close(void) {
-	return sqdb_close(((SqStorage*)this)->db);
+	return sq_storage_close((SqStorage*)this);
 }
 
 inline int   StorageMethod::migrate(SqSchema *schema) {
-	return sqdb_migrate(((SqStorage*)this)->db, ((SqStorage*)this)->schema, schema);
+	return sq_storage_migrate((SqStorage*)this, schema);
+}
+
+template <class StructType>
+inline SqTable    *StorageMethod::findByType() {
+	static thread_local SqStorage    *cache_storage = NULL;
+	static thread_local unsigned int  cache_serial;
+	static thread_local SqTable      *cache_table;
+	SqStorage *storage = (SqStorage*)this;
+	// load serial before searching. If index is rebuilt while searching, next call search again.
+	unsigned int  serial = sq_atomic_load(&storage->tables_serial);
+
+	if (cache_storage != storage || cache_serial != serial ||
+	    storage->tables_version != storage->schema->version)
+	{
+		cache_table   = sq_storage_find_by_type(storage, typeid(StructType).name());
+		cache_serial  = serial;
+		cache_storage = storage;
+	}
+	return cache_table;
 }
 
 template <class StructType>
 inline StructType *StorageMethod::get(int id) {
-	return (StructType*)sq_storage_get((SqStorage*)this, NULL, typeid(StructType).name(), id);
+	SqTable *table = findByType<StructType>();
+	if (table == NULL)
+		return NULL;
+	return (StructType*)sq_storage_get_full((SqStorage*)this, table->name, NULL, table->type, id);
 }
 inline void       *StorageMethod::get(const char *table_name, int id) {
 	return (void*)sq_storage_get((SqStorage*)this, table_name, NULL, id);
@@ -327,28 +526,31 @@ inline void       *StorageMethod::get(const char *table_name, const SqType *type
 
 template <class StlContainer>
 inline StlContainer *StorageMethod::getBySql(const char *sql_where_having) {
-	SqTable *table = sq_storage_find_by_type((SqStorage*)this, typeid(typename std::remove_pointer<typename StlContainer::value_type>::type).name());
+	SqTable *table = findByType<typename std::remove_pointer<typename StlContainer::value_type>::type>();
 	if (table == NULL)
 		return NULL;
 	SqType  *containerType = new Sq::TypeStl<StlContainer>(table->type);
-	StlContainer *instance = (StlContainer*) sq_storage_get_by_sql((SqStorage*)this, table->name, NULL, containerType, sql_where_having);
+	StlContainer *instance = (StlContainer*) sq_storage_get_all_full((SqStorage*)this, table->name, NULL, table->type, containerType, sql_where_having);
 	delete (Sq::TypeStl<StlContainer>*)containerType;
 	return instance;
 }
 template <class ElementType, class StlContainer>
 inline StlContainer *StorageMethod::getBySql(const char *sql_where_having) {
-	SqTable *table = sq_storage_find_by_type((SqStorage*)this, typeid(typename std::remove_pointer<ElementType>::type).name());
+	SqTable *table = findByType<typename std::remove_pointer<ElementType>::type>();
 	if (table == NULL)
 		return NULL;
 	SqType  *containerType = new Sq::TypeStl<StlContainer>(table->type);
-	StlContainer *instance = (StlContainer*) sq_storage_get_by_sql((SqStorage*)this, table->name, NULL, containerType, sql_where_having);
+	StlContainer *instance = (StlContainer*) sq_storage_get_all_full((SqStorage*)this, table->name, NULL, table->type, containerType, sql_where_having);
 	delete (Sq::TypeStl<StlContainer>*)containerType;
 	return instance;
 }
 
 template <class StructType>
 inline void *StorageMethod::getBySql(const SqType *container, const char *sql_where_having) {
-	return (StructType*)sq_storage_get_by_sql((SqStorage*)this, NULL, typeid(StructType).name(), container, sql_where_having);
+	SqTable *table = findByType<StructType>();
+	if (table == NULL)
+		return NULL;
+	return sq_storage_get_all_full((SqStorage*)this, table->name, NULL, table->type, container, sql_where_having);
 }
 inline void *StorageMethod::getBySql(const char *table_name, const SqType *container, const char *sql_where_having) {
 	return (void*)sq_storage_get_by_sql((SqStorage*)this, table_name, NULL, container, sql_where_having);
@@ -359,28 +561,31 @@ inline void *StorageMethod::getBySql(const char *table_name, const SqType *type,
 
 template <class StlContainer>
 inline StlContainer *StorageMethod::getAll() {
-	SqTable *table = sq_storage_find_by_type((SqStorage*)this, typeid(typename std::remove_pointer<typename StlContainer::value_type>::type).name());
+	SqTable *table = findByType<typename std::remove_pointer<typename StlContainer::value_type>::type>();
 	if (table == NULL)
 		return NULL;
 	SqType  *containerType = new Sq::TypeStl<StlContainer>(table->type);
-	StlContainer *instance = (StlContainer*) sq_storage_get_all((SqStorage*)this, table->name, NULL, containerType);
+	StlContainer *instance = (StlContainer*) sq_storage_get_all_full((SqStorage*)this, table->name, NULL, table->type, containerType, NULL);
 	delete (Sq::TypeStl<StlContainer>*)containerType;
 	return instance;
 }
 template <class ElementType, class StlContainer>
 inline StlContainer *StorageMethod::getAll() {
-	SqTable *table = sq_storage_find_by_type((SqStorage*)this, typeid(typename std::remove_pointer<ElementType>::type).name());
+	SqTable *table = findByType<typename std::remove_pointer<ElementType>::type>();
 	if (table == NULL)
 		return NULL;
 	SqType  *containerType = new Sq::TypeStl<StlContainer>(table->type);
-	StlContainer *instance = (StlContainer*) sq_storage_get_all((SqStorage*)this, table->name, NULL, containerType);
+	StlContainer *instance = (StlContainer*) sq_storage_get_all_full((SqStorage*)this, table->name, NULL, table->type, containerType, NULL);
 	delete (Sq::TypeStl<StlContainer>*)containerType;
 	return instance;
 }
 
 template <class StructType>
 inline void *StorageMethod::getAll(const SqType *container) {
-	return (StructType*)sq_storage_get_all((SqStorage*)this, NULL, typeid(StructType).name(), container);
+	SqTable *table = findByType<StructType>();
+	if (table == NULL)
+		return NULL;
+	return sq_storage_get_all_full((SqStorage*)this, table->name, NULL, table->type, container, NULL);
 }
 inline void *StorageMethod::getAll(const char *table_name, const SqType *container) {
 	return (void*)sq_storage_get_all((SqStorage*)this, table_name, NULL, container);
@@ -405,33 +610,66 @@ inline void *StorageMethod::query(SqQuery *query, const SqType *container, const
 	return sq_storage_query((SqStorage*)this, query, container, type);
 }
 
+inline SqCompiledQuery *StorageMethod::compile(SqQuery *query, const SqType *container, const SqType *type) {
+	return sq_storage_compile((SqStorage*)this, query, container, type);
+}
+
 template <class StructType>
 inline int   StorageMethod::insert(StructType& instance) {
-	return sq_storage_insert((SqStorage*)this, NULL, typeid(StructType).name(), &instance);
+	return insert<StructType>((void*)&instance);
 }
 template <class StructType>
 inline int   StorageMethod::insert(StructType *instance) {
-	return sq_storage_insert((SqStorage*)this, NULL, typeid(StructType).name(), instance);
+	return insert<StructType>((void*)instance);
 }
 template <class StructType>
 inline int   StorageMethod::insert(void *instance) {
-	return sq_storage_insert((SqStorage*)this, NULL, typeid(StructType).name(), instance);
+	SqTable *table = findByType<StructType>();
+	if (table == NULL)
+		return -1;
+	return sq_storage_insert((SqStorage*)this, table->name, NULL, instance);
 }
 inline int   StorageMethod::insert(const char *table_name, void *instance) {
 	return sq_storage_insert((SqStorage*)this, table_name, NULL, instance);
 }
 
+template <class StlContainer>
+inline int   StorageMethod::insertAll(StlContainer& container) {
+	return insertAll(&container);
+}
+template <class StlContainer>
+inline int   StorageMethod::insertAll(StlContainer *container) {
+	SqTable *table = findByType<typename std::remove_pointer<typename StlContainer::value_type>::type>();
+	if (table == NULL)
+		return -1;
+	// sq_storage_insert_all() replaces element type of container, so one instance serves all tables.
+	static const Sq::TypeStl<StlContainer>  containerType(NULL);
+	return sq_storage_insert_all((SqStorage*)this, table->name, NULL, container, &containerType);
+}
+template <class StructType>
+inline int   StorageMethod::insertAll(void *container, const SqType *container_type) {
+	SqTable *table = findByType<StructType>();
+	if (table == NULL)
+		return -1;
+	return sq_storage_insert_all((SqStorage*)this, table->name, NULL, container, container_type);
+}
+inline int   StorageMethod::insertAll(const char *table_name, void *container, const SqType *container_type) {
+	return sq_storage_insert_all((SqStorage*)this, table_name, NULL, container, container_type);
+}
+
 template <class StructType>
 inline void  StorageMethod::update(StructType& instance) {
-	sq_storage_update((SqStorage*)this, NULL, typeid(StructType).name(), &instance);
+	update<StructType>((void*)&instance);
 }
 template <class StructType>
 inline void  StorageMethod::update(StructType *instance) {
-	sq_storage_update((SqStorage*)this, NULL, typeid(StructType).name(), instance);
+	update<StructType>((void*)instance);
 }
 template <class StructType>
 inline void  StorageMethod::update(void *instance) {
-	sq_storage_update((SqStorage*)this, NULL, typeid(StructType).name(), instance);
+	SqTable *table = findByType<StructType>();
+	if (table)
+		sq_storage_update((SqStorage*)this, table->name, NULL, instance);
 }
 inline void  StorageMethod::update(const char *table_name, void *instance) {
 	sq_storage_update((SqStorage*)this, table_name, NULL, instance);
@@ -439,22 +677,87 @@ inline void  StorageMethod::update(const char *table_name, void *instance) {
 
 template <class StructType>
 inline void StorageMethod::remove(int id) {
-	sq_storage_remove((SqStorage*)this, NULL, typeid(StructType).name(), id);
+	SqTable *table = findByType<StructType>();
+	if (table)
+		sq_storage_remove((SqStorage*)this, table->name, NULL, id);
 }
 inline void StorageMethod::remove(const char *table_name, int id) {
 	sq_storage_remove((SqStorage*)this, table_name, NULL, id);
 }
 
 inline int  StorageMethod::begin() {
-	return SQ_STORAGE_BEGIN((SqStorage*)this);
+	return sq_storage_begin((SqStorage*)this);
 }
 inline int  StorageMethod::commit() {
-	return SQ_STORAGE_COMMIT((SqStorage*)this);
+	return sq_storage_commit((SqStorage*)this);
 }
 inline int  StorageMethod::rollback() {
-	return SQ_STORAGE_ROLLBACK((SqStorage*)this);
+	return sq_storage_rollback((SqStorage*)this);
+}
+
+/*	CursorRange : C++ range-for adaptor for SqStorageCursor
+
+	for (User *user : storage->cursor<User>("WHERE id > 10"))
+		puts(user->name);
+
+	If 'reuse_instance' is false, caller owns every yielded instance and must free it.
+	Use code() to check if loop stopped because of error.
+ */
+template <class StructType>
+class CursorRange
+{
+	SqStorageCursor  *cursor;
+
+public:
+	class iterator {
+		SqStorageCursor  *cursor;
+		StructType       *current;
+	public:
+		iterator(SqStorageCursor *cur, StructType *instance) : cursor(cur), current(instance) {}
+		StructType *operator*() const { return current; }
+		iterator   &operator++() {
+			current = (StructType*)sq_storage_cursor_next(cursor);
+			return *this;
+		}
+		bool        operator!=(const iterator &other) const { return current != other.current; }
+	};
+
+	CursorRange(SqStorageCursor *cur) : cursor(cur) {}
+	CursorRange(CursorRange &&other) : cursor(other.cursor) { other.cursor = NULL; }
+	CursorRange(const CursorRange &other) = delete;
+	~CursorRange() {
+		if (cursor)
+			sq_storage_cursor_close(cursor);
+	}
+
+	iterator begin() {
+		if (cursor == NULL)
+			return end();
+		return iterator(cursor, (StructType*)sq_storage_cursor_next(cursor));
+	}
+	iterator end() {
+		return iterator(cursor, NULL);
+	}
+
+	// SQCODE_OK, or error code if getting row failed
+	int  code() const {
+		return (cursor) ? cursor->code : SQCODE_ERROR;
+	}
+};
+
+template <class StructType>
+inline CursorRange<StructType> StorageMethod::cursor(const char *sql_where_having, bool reuse_instance) {
+	SqTable         *table  = findByType<StructType>();
+	SqStorageCursor *cursor = NULL;
+	if (table)
+		cursor = sq_storage_cursor_open((SqStorage*)this, table->name, NULL, table->type, sql_where_having);
+	if (cursor)
+		sq_storage_cursor_reuse(cursor, reuse_instance);
+	return CursorRange<StructType>(cursor);
 }
 
+typedef struct SqCompiledQuery    CompiledQuery;
+
 // This is for directly use only. You can NOT derived it.
 struct Storage : SqStorage
 {
@@ -0,0 +1,192 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE    // PTHREAD_MUTEX_RECURSIVE
+#endif
+
+#include <stdlib.h>      // malloc, free
+
+#include <SqThread.h>
+
+// argument of thread_main()
+typedef struct ThreadData
+{
+	SqThreadFunc  func;
+	void         *data;
+} ThreadData;
+
+#if defined(_WIN32) || defined(_WIN64)
+
+// ----------------------------------------------------------------------------
+// Windows
+
+void  sq_mutex_init(SqMutex *mutex, bool recursive)
+{
+	InitializeCriticalSection(mutex);
+}
+
+void  sq_mutex_final(SqMutex *mutex)
+{
+	DeleteCriticalSection(mutex);
+}
+
+void  sq_mutex_lock(SqMutex *mutex)
+{
+	EnterCriticalSection(mutex);
+}
+
+void  sq_mutex_unlock(SqMutex *mutex)
+{
+	LeaveCriticalSection(mutex);
+}
+
+void  sq_cond_init(SqCond *cond)
+{
+	InitializeConditionVariable(cond);
+}
+
+void  sq_cond_final(SqCond *cond)
+{
+	// Windows doesn't need to delete CONDITION_VARIABLE
+}
+
+void  sq_cond_wait(SqCond *cond, SqMutex *mutex)
+{
+	SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+void  sq_cond_signal(SqCond *cond)
+{
+	WakeConditionVariable(cond);
+}
+
+void  sq_cond_broadcast(SqCond *cond)
+{
+	WakeAllConditionVariable(cond);
+}
+
+static DWORD WINAPI thread_main(LPVOID param)
+{
+	ThreadData  td = *(ThreadData*)param;
+
+	free(param);
+	td.func(td.data);
+	return 0;
+}
+
+bool  sq_thread_create(SqThread *thread, SqThreadFunc func, void *data)
+{
+	ThreadData *td = malloc(sizeof(ThreadData));
+
+	td->func = func;
+	td->data = data;
+	*thread = CreateThread(NULL, 0, thread_main, td, 0, NULL);
+	if (*thread == NULL) {
+		free(td);
+		return false;
+	}
+	return true;
+}
+
+void  sq_thread_join(SqThread thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+#else
+
+// ----------------------------------------------------------------------------
+// POSIX threads
+
+void  sq_mutex_init(SqMutex *mutex, bool recursive)
+{
+	pthread_mutexattr_t  attr;
+
+	pthread_mutexattr_init(&attr);
+	if (recursive)
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+void  sq_mutex_final(SqMutex *mutex)
+{
+	pthread_mutex_destroy(mutex);
+}
+
+void  sq_mutex_lock(SqMutex *mutex)
+{
+	pthread_mutex_lock(mutex);
+}
+
+void  sq_mutex_unlock(SqMutex *mutex)
+{
+	pthread_mutex_unlock(mutex);
+}
+
+void  sq_cond_init(SqCond *cond)
+{
+	pthread_cond_init(cond, NULL);
+}
+
+void  sq_cond_final(SqCond *cond)
+{
+	pthread_cond_destroy(cond);
+}
+
+void  sq_cond_wait(SqCond *cond, SqMutex *mutex)
+{
+	pthread_cond_wait(cond, mutex);
+}
+
+void  sq_cond_signal(SqCond *cond)
+{
+	pthread_cond_signal(cond);
+}
+
+void  sq_cond_broadcast(SqCond *cond)
+{
+	pthread_cond_broadcast(cond);
+}
+
+static void *thread_main(void *param)
+{
+	ThreadData  td = *(ThreadData*)param;
+
+	free(param);
+	td.func(td.data);
+	return NULL;
+}
+
+bool  sq_thread_create(SqThread *thread, SqThreadFunc func, void *data)
+{
+	ThreadData *td = malloc(sizeof(ThreadData));
+
+	td->func = func;
+	td->data = data;
+	if (pthread_create(thread, NULL, thread_main, td) != 0) {
+		free(td);
+		return false;
+	}
+	return true;
+}
+
+void  sq_thread_join(SqThread thread)
+{
+	pthread_join(thread, NULL);
+}
+
+#endif  // _WIN32 || _WIN64
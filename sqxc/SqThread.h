@@ -0,0 +1,118 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQ_THREAD_H
+#define SQ_THREAD_H
+
+#include <stdbool.h>     // bool
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+/*	SqMutex    - wrapper of platform mutex (pthread_mutex_t or CRITICAL_SECTION)
+	SqCond     - wrapper of platform condition variable (pthread_cond_t or CONDITION_VARIABLE)
+	SqThreadId - identifier of thread
+	SqThread   - handle of thread that is created by sq_thread_create()
+ */
+#if defined(_WIN32) || defined(_WIN64)
+typedef CRITICAL_SECTION     SqMutex;
+typedef CONDITION_VARIABLE   SqCond;
+typedef DWORD                SqThreadId;
+typedef HANDLE               SqThread;
+
+#define sq_thread_self()               GetCurrentThreadId()
+#define sq_thread_equal(id1, id2)      ((id1) == (id2))
+#else
+typedef pthread_mutex_t      SqMutex;
+typedef pthread_cond_t       SqCond;
+typedef pthread_t            SqThreadId;
+typedef pthread_t            SqThread;
+
+#define sq_thread_self()               pthread_self()
+#define sq_thread_equal(id1, id2)      pthread_equal(id1, id2)
+#endif
+
+typedef void (*SqThreadFunc)(void *data);
+
+// storage-class of thread-local variable
+#if defined(_MSC_VER)
+#define SQ_THREAD_LOCAL    __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define SQ_THREAD_LOCAL    __thread
+#else
+#define SQ_THREAD_LOCAL    _Thread_local
+#endif
+
+/*	atomic access to 'unsigned int'
+	sq_atomic_load()      - load with acquire ordering
+	sq_atomic_store()     - store with release ordering
+	sq_atomic_add_fetch() - add 'value' and return the new value
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define sq_atomic_load(ptr)                __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define sq_atomic_store(ptr, value)        __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#define sq_atomic_add_fetch(ptr, value)    __atomic_add_fetch(ptr, value, __ATOMIC_SEQ_CST)
+#elif defined(_MSC_VER)
+// volatile access has acquire/release semantics in MSVC (/volatile:ms)
+#define sq_atomic_load(ptr)                (*(volatile unsigned int*)(ptr))
+#define sq_atomic_store(ptr, value)        (*(volatile unsigned int*)(ptr) = (value))
+#define sq_atomic_add_fetch(ptr, value)    \
+		((unsigned int)InterlockedExchangeAdd((volatile LONG*)(ptr), (LONG)(value)) + (value))
+#else
+// fallback: not atomic
+#define sq_atomic_load(ptr)                (*(volatile unsigned int*)(ptr))
+#define sq_atomic_store(ptr, value)        (*(volatile unsigned int*)(ptr) = (value))
+#define sq_atomic_add_fetch(ptr, value)    (*(ptr) += (value))
+#endif
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// If 'recursive' is true, thread can lock 'mutex' many times and it must unlock the same number of times.
+// Note: CRITICAL_SECTION is always recursive.
+void  sq_mutex_init(SqMutex *mutex, bool recursive);
+void  sq_mutex_final(SqMutex *mutex);
+
+void  sq_mutex_lock(SqMutex *mutex);
+void  sq_mutex_unlock(SqMutex *mutex);
+
+void  sq_cond_init(SqCond *cond);
+void  sq_cond_final(SqCond *cond);
+
+// 'mutex' must be locked by calling thread.
+void  sq_cond_wait(SqCond *cond, SqMutex *mutex);
+void  sq_cond_signal(SqCond *cond);
+void  sq_cond_broadcast(SqCond *cond);
+
+// run 'func' in new thread. return false if thread can't be created.
+bool  sq_thread_create(SqThread *thread, SqThreadFunc func, void *data);
+// wait until 'thread' terminates
+void  sq_thread_join(SqThread thread);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+
+#endif  // SQ_THREAD_H
@@ -15,6 +15,7 @@
 #include <stdbool.h>
 
 #include <SqConfig.h>
+#include <SqArena.h>
 #include <SqError.h>
 #include <SqPtrArray.h>
 #include <SqType.h>
@@ -23,6 +24,42 @@
 
 #define SQ_TYPE_PTR_ARRAY_SIZE_DEFAULT    SQ_CONFIG_TYPE_PTR_ARRAY_SIZE_DEFAULT
 
+/* ----------------------------------------------------------------------------
+	arena mode of SqxcValue: memory of array is allocated from SqxcValue.arena.
+	Old memory is left in arena when array grows, it is released by sq_arena_free().
+ */
+
+// move memory of empty array (allocated by SqType.init) to arena
+static void  ptr_array_move_to_arena(void *array, SqArena *arena)
+{
+	void **header = sq_ptr_array_header(array);
+	int    header_length = sq_ptr_array_header_length(array);
+	int    size = (header_length + sq_ptr_array_allocated(array)) * sizeof(void*);
+
+	((SqPtrArray*)array)->data = (void**)memcpy(sq_arena_alloc(arena, size), header, size) + header_length;
+	free(header);
+}
+
+static void **ptr_array_alloc_arena(void *array, SqArena *arena)
+{
+	void **header;
+	int    header_length;
+	int    allocated = sq_ptr_array_allocated(array);
+	int    length = ((SqPtrArray*)array)->length;
+
+	if (length == allocated) {
+		header = sq_ptr_array_header(array);
+		header_length = sq_ptr_array_header_length(array);
+		allocated *= 2;
+		((SqPtrArray*)array)->data = (void**)memcpy(
+				sq_arena_alloc(arena, (header_length + allocated) * sizeof(void*)),
+				header, (header_length + length) * sizeof(void*)) + header_length;
+		sq_ptr_array_allocated(array) = allocated;
+	}
+	((SqPtrArray*)array)->length++;
+	return ((SqPtrArray*)array)->data + length;
+}
+
 /* ----------------------------------------------------------------------------
 	SQ_TYPE_PTR_ARRAY
 	User must assign element type in SqType.entry and set SqType.n_entry to -1.
@@ -80,6 +117,8 @@ static int  sq_type_ptr_array_parse(void *array, const SqType *type, Sqxc *src)
 		}
 		// ready to parse array
 		nested->data3 = array;
+		if (xc_value->arena)
+			ptr_array_move_to_arena(array, xc_value->arena);
 		return (src->code = SQCODE_OK);
 	}
 	/*
@@ -90,8 +129,14 @@ static int  sq_type_ptr_array_parse(void *array, const SqType *type, Sqxc *src)
 	}
 	 */
 
-	element = sq_ptr_array_alloc(array, 1);
-	element = sq_type_init_instance(element_type, element, true);
+	if (xc_value->arena) {
+		element = ptr_array_alloc_arena(array, xc_value->arena);
+		element = sq_type_init_instance_arena(element_type, element, true, xc_value->arena);
+	}
+	else {
+		element = sq_ptr_array_alloc(array, 1);
+		element = sq_type_init_instance(element_type, element, true);
+	}
 	src->name = NULL;    // set "name" before calling parse()
 	src->code = element_type->parse(element, element_type, src);
 	return src->code;
@@ -175,6 +220,8 @@ static int  sq_type_notptr_array_parse(void *array, const SqType *type, Sqxc *sr
 		}
 		// ready to parse array
 		nested->data3 = array;
+		if (xc_value->arena)
+			ptr_array_move_to_arena(array, xc_value->arena);
 		return (src->code = SQCODE_OK);
 	}
 	/*
@@ -186,7 +233,10 @@ static int  sq_type_notptr_array_parse(void *array, const SqType *type, Sqxc *sr
 	 */
 
 	// different from sq_type_ptr_array_parse()
-	element = sq_ptr_array_alloc(array, 1);
+	if (xc_value->arena)
+		element = ptr_array_alloc_arena(array, xc_value->arena);
+	else
+		element = sq_ptr_array_alloc(array, 1);
 	src->name = NULL;    // set "name" before calling parse()
 	src->code = element_type->parse(element, element_type, src);
 	return src->code;
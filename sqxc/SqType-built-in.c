@@ -12,13 +12,15 @@
  * See the Mulan PSL v2 for more details.
  */
 
+#include <limits.h>   // INT_MIN, INT_MAX, UINT_MAX
 #include <time.h>     // time_t
-#include <stdio.h>    // sprintf()
 #include <stdlib.h>   // realloc(), strtol()
 #include <string.h>   // strdup()
 
-#include <SqUtil.h>   // sq_time_to_string(), sq_time_from_string()
+#include <SqUtil.h>   // sq_time_to_string(), sq_time_from_string(), sq_int64_to_str()
 #include <SqError.h>
+#include <SqArena.h>
+#include <SqIntern.h>
 #include <SqPtrArray.h>
 #include <SqType.h>
 #include <SqEntry.h>
@@ -27,7 +29,6 @@
 #if defined(_MSC_VER)
 #define _CRT_SECURE_NO_WARNINGS
 #define strtoll		_strtoi64
-#define snprintf	_snprintf
 #endif
 
 // ------------------------------------
@@ -46,6 +47,10 @@ int  sq_type_bool_parse(void *instance, const SqType *entrytype, Sqxc *src)
 		*(bool*)instance = (src->value.integer) ? true : false;
 		break;
 
+	case SQXC_TYPE_INT64:
+		*(bool*)instance = (src->value.int64) ? true : false;
+		break;
+
 	case SQXC_TYPE_STRING:
 		if (src->value.string) {
 			ch = src->value.string[0]; 
@@ -84,6 +89,17 @@ int  sq_type_int_parse(void *instance, const SqType *entrytype, Sqxc *src)
 		*(int*)instance = src->value.integer;
 		break;
 
+	case SQXC_TYPE_INT64:
+		*(int*)instance = (int)src->value.int64;
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		// converting out of range value is undefined behavior. NaN is rejected here too.
+		if ((src->value.double_ > INT_MIN - 1.0 && src->value.double_ < INT_MAX + 1.0) == false)
+			return (src->code = SQCODE_TYPE_NOT_MATCH);
+		*(int*)instance = (int)src->value.double_;
+		break;
+
 	case SQXC_TYPE_BOOL:
 		*(int*)instance = src->value.boolean;
 		break;
@@ -118,9 +134,21 @@ int  sq_type_uint_parse(void *instance, const SqType *entrytype, Sqxc *src)
 {
 	switch (src->type) {
 	case SQXC_TYPE_UINT:
+	case SQXC_TYPE_INT:
 		*(unsigned int*)instance = src->value.uinteger;
 		break;
 
+	case SQXC_TYPE_INT64:
+	case SQXC_TYPE_UINT64:
+		*(unsigned int*)instance = (unsigned int)src->value.uint64;
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		if ((src->value.double_ > -1.0 && src->value.double_ < UINT_MAX + 1.0) == false)
+			return (src->code = SQCODE_TYPE_NOT_MATCH);
+		*(unsigned int*)instance = (unsigned int)src->value.double_;
+		break;
+
 	case SQXC_TYPE_BOOL:
 		*(unsigned int*)instance = src->value.boolean;
 		break;
@@ -158,6 +186,10 @@ int  sq_type_intptr_parse(void *instance, const SqType *entrytype, Sqxc *src)
 		*(intptr_t*)instance = src->value.integer;
 		break;
 
+	case SQXC_TYPE_INT64:
+		*(intptr_t*)instance = (intptr_t)src->value.int64;
+		break;
+
 	case SQXC_TYPE_BOOL:
 		*(intptr_t*)instance = src->value.boolean;
 		break;
@@ -196,9 +228,17 @@ int  sq_type_int64_parse(void *instance, const SqType *entrytype, Sqxc *src)
 		break;
 
 	case SQXC_TYPE_INT64:
+	case SQXC_TYPE_UINT64:
 		*(int64_t*)instance = src->value.int64;
 		break;
 
+	case SQXC_TYPE_DOUBLE:
+		// -2^63 <= value < 2^63
+		if ((src->value.double_ >= -9223372036854775808.0 && src->value.double_ < 9223372036854775808.0) == false)
+			return (src->code = SQCODE_TYPE_NOT_MATCH);
+		*(int64_t*)instance = (int64_t)src->value.double_;
+		break;
+
 	case SQXC_TYPE_STRING:
 		if (src->value.string)
 			*(int64_t*)instance = strtoll(src->value.string, NULL, 10);
@@ -233,7 +273,15 @@ int  sq_type_uint64_parse(void *instance, const SqType *entrytype, Sqxc *src)
 		break;
 
 	case SQXC_TYPE_UINT64:
-		*(uint64_t*)instance = src->value.int64;
+	case SQXC_TYPE_INT64:
+		*(uint64_t*)instance = src->value.uint64;
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		// -1 < value < 2^64
+		if ((src->value.double_ > -1.0 && src->value.double_ < 18446744073709551616.0) == false)
+			return (src->code = SQCODE_TYPE_NOT_MATCH);
+		*(uint64_t*)instance = (uint64_t)src->value.double_;
 		break;
 
 	case SQXC_TYPE_STRING:
@@ -269,6 +317,10 @@ int  sq_type_double_parse(void *instance, const SqType *entrytype, Sqxc *src)
 		*(double*)instance = src->value.integer;
 		break;
 
+	case SQXC_TYPE_INT64:
+		*(double*)instance = (double)src->value.int64;
+		break;
+
 	case SQXC_TYPE_DOUBLE:
 		*(double*)instance = src->value.double_;
 		break;
@@ -351,18 +403,28 @@ void sq_type_string_final(void *instance, const SqType *entrytype)
 
 int  sq_type_string_parse(void *instance, const SqType *entrytype, Sqxc *src)
 {
+	SqArena *arena = ((SqxcValue*)src->dest)->arena;
+	char     buf[SQ_DOUBLE_STR_SIZE];
+	int      len;
+
 	switch (src->type) {
-	/* TODO: convert to string
-	case SQXC_TYPE_INT:
 	case SQXC_TYPE_INT64:
+		len = sq_int64_to_str(buf, src->value.int64) + 1;
+		*(char**)instance = memcpy((arena) ? sq_arena_alloc(arena, len) : malloc(len), buf, len);
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		len = sq_double_to_str(buf, src->value.double_) + 1;
+		*(char**)instance = memcpy((arena) ? sq_arena_alloc(arena, len) : malloc(len), buf, len);
 		break;
-	 */
 
 	case SQXC_TYPE_STRING:
-		if (src->value.string)
-			*(char**)instance = strdup(src->value.string);
-		else
+		if (src->value.string == NULL)
 			*(char**)instance = NULL;
+		else if (arena)
+			*(char**)instance = sq_arena_strdup(arena, src->value.string);
+		else
+			*(char**)instance = strdup(src->value.string);
 		break;
 
 	default:
@@ -381,6 +443,45 @@ Sqxc *sq_type_string_write(void *instance, const SqType *entrytype, Sqxc *dest)
 	return sqxc_send(dest);
 }
 
+// ------------------------------------
+// SqType *SQ_TYPE_INTERN_STRING functions
+
+void sq_type_intern_string_final(void *instance, const SqType *entrytype)
+{
+	sq_intern_unref(*(char**)instance);
+}
+
+int  sq_type_intern_string_parse(void *instance, const SqType *entrytype, Sqxc *src)
+{
+	SqxcValue *xc_value = (SqxcValue*)src->dest;
+	char       buf[SQ_DOUBLE_STR_SIZE];
+
+	switch (src->type) {
+	case SQXC_TYPE_INT64:
+		sq_int64_to_str(buf, src->value.int64);
+		*(char**)instance = sq_intern_ref(xc_value->intern, buf);
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		sq_double_to_str(buf, src->value.double_);
+		*(char**)instance = sq_intern_ref(xc_value->intern, buf);
+		break;
+
+	case SQXC_TYPE_STRING:
+		if (src->value.string == NULL)
+			*(char**)instance = NULL;
+		else
+			*(char**)instance = sq_intern_ref(xc_value->intern, src->value.string);
+		break;
+
+	default:
+//		src->required_type = SQXC_TYPE_STRING;    // set required type if return SQCODE_TYPE_NOT_MATCH
+		return (src->code = SQCODE_TYPE_NOT_MATCH);
+	}
+
+	return (src->code = SQCODE_OK);
+}
+
 // ------------------------------------
 // SqType *SQ_ENTRY_OBJECT functions
 
@@ -419,6 +520,8 @@ int  sq_type_object_parse(void *instance, const SqType *entrytype, Sqxc *src)
 		}
 		// ready to parse object
 		nested->data3 = instance;
+		if (entrytype == xc_value->element)
+			xc_value->columns.index = 0;
 		return (src->code = SQCODE_OK);
 	}
 	/*
@@ -430,9 +533,16 @@ int  sq_type_object_parse(void *instance, const SqType *entrytype, Sqxc *src)
 	 */
 
 	// parse entries in type
-	entry = (SqEntry*)sq_type_find_entry(entrytype, src->name, NULL);
+	if (src == (Sqxc*)xc_value && entrytype == xc_value->element) {
+		// columns sent by data source directly. Find entry by column index.
+		entry = sqxc_value_find_column(xc_value, src->name);
+	}
+	else {
+		entry = (SqEntry*)sq_type_find_entry(entrytype, src->name, NULL);
+		if (entry)
+			entry = *(SqEntry**)entry;
+	}
 	if (entry) {
-		entry = *(SqEntry**)entry;
 		entrytype = entry->type;
 		if (entrytype->parse == NULL)  // don't parse anything if function pointer is NULL
 			return (src->code = SQCODE_OK);
@@ -442,7 +552,7 @@ int  sq_type_object_parse(void *instance, const SqType *entrytype, Sqxc *src)
 				*(void**)instance = NULL;
 				return (src->code = SQCODE_OK);
 			}
-			instance = sq_type_init_instance(entrytype, instance, true);
+			instance = sq_type_init_instance_arena(entrytype, instance, true, xc_value->arena);
 		}
 		return entrytype->parse(instance, entrytype, src);
 	}
@@ -571,3 +681,12 @@ const SqType SqType_BuiltIn_[] = {
 		sq_type_string_write,
 	},
 };
+
+const SqType SqType_InternString_ =
+{
+	sizeof(char*),
+	NULL,
+	sq_type_intern_string_final,
+	sq_type_intern_string_parse,
+	sq_type_string_write,
+};
@@ -0,0 +1,423 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQ_TYPE_STATIC_CPP_H
+#define SQ_TYPE_STATIC_CPP_H
+
+// This header requires C++17
+#if defined(__cplusplus) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+
+#include <stddef.h>       // size_t, ptrdiff_t
+#include <string.h>       // strlen
+#include <array>
+#include <string>
+#include <tuple>
+#include <utility>        // std::index_sequence
+#include <type_traits>
+
+#include <SqError.h>
+#include <SqType.h>
+#include <SqTable.h>      // SqColumn, Sq::offsetOf()
+#include <SqxcValue.h>
+
+/*
+	Sq::StaticType - SqType that is generated at compile time.
+
+	Entries are sorted by name at compile time, so SqType doesn't need to sort them at runtime.
+	parse() and write() are generated for each structure. They don't call sq_type_find_entry()
+	and values of built-in types are sent without calling SqType.write().
+
+	// sample
+	struct User {
+		int          id;
+		std::string  name;
+		time_t       created_at;
+	};
+
+	static constexpr auto userFields = Sq::fields(
+		Sq::field("id",         &User::id,   SQB_PRIMARY),
+		Sq::field("name",       &User::name),
+		Sq::field("created_at", &User::created_at, SQ_TYPE_TIME)    // specify SqType
+	);
+
+	const SqType *type = Sq::StaticType<User, userFields>::type();
+
+	table = schema->create("users", type);
+
+	Member's SqType is decided by C++ type: bool, int, unsigned int, 64-bit integer, double,
+	char*, and std::string. Other types must be specified in Sq::field().
+	Note: time_t is 64-bit integer, use SQ_TYPE_TIME to store it as time.
+ */
+
+namespace Sq {
+
+// index of member's built-in SqType in SqType_BuiltIn_[]. It returns -1 if C++ type isn't built-in type.
+// Built-in types are dispatched by this index at compile time, because addresses of SqType_BuiltIn_[]
+// can't be compared in constant expressions.
+template<typename Member>
+constexpr int  builtInIndexOf() {
+	if constexpr (std::is_same<Member, bool>::value)
+		return SQ_TYPE_BOOL_INDEX;
+	else if constexpr (std::is_same<Member, int>::value)
+		return SQ_TYPE_INT_INDEX;
+	else if constexpr (std::is_same<Member, unsigned int>::value)
+		return SQ_TYPE_UINT_INDEX;
+	else if constexpr (std::is_integral<Member>::value && sizeof(Member) == 8)
+		return (std::is_signed<Member>::value) ? SQ_TYPE_INT64_INDEX : SQ_TYPE_UINT64_INDEX;
+	else if constexpr (std::is_same<Member, double>::value)
+		return SQ_TYPE_DOUBLE_INDEX;
+	else if constexpr (std::is_same<Member, char*>::value || std::is_same<Member, const char*>::value)
+		return SQ_TYPE_STRING_INDEX;
+	else
+		return -1;
+}
+
+// return true if C++ type has SqType
+template<typename Member>
+constexpr bool  hasTypeOf() {
+	return builtInIndexOf<Member>() >= 0 || std::is_same<Member, std::string>::value;
+}
+
+// SqType of member. It returns NULL if C++ type doesn't have SqType.
+template<typename Member>
+constexpr const SqType *typeOf() {
+	if constexpr (builtInIndexOf<Member>() >= 0)
+		return &SqType_BuiltIn_[builtInIndexOf<Member>()];
+	else if constexpr (std::is_same<Member, std::string>::value)
+		return SQ_TYPE_STD_STRING;
+	else
+		return NULL;
+}
+
+// compare name like sq_entry_cmp_name()
+constexpr int  compareName(const char *name1, const char *name2) {
+	int  c1 = 0, c2 = 0;
+
+	for (;;  name1++, name2++) {
+		c1 = (unsigned char)*name1;
+		c2 = (unsigned char)*name2;
+#ifndef SQ_CONFIG_SQL_CASE_SENSITIVE
+		if (c1 >= 'A' && c1 <= 'Z')
+			c1 += 'a' - 'A';
+		if (c2 >= 'A' && c2 <= 'Z')
+			c2 += 'a' - 'A';
+#endif
+		if (c1 != c2 || c1 == 0)
+			return c1 - c2;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Sq::Field - description of member
+
+template<class Store, class Member>
+struct Field {
+	const char     *name;
+	Member Store::*member;
+	const SqType   *type;
+	unsigned int    bit_field;
+	int             built_in;    // index in SqType_BuiltIn_[], -1 if it is unknown at compile time
+};
+
+template<class Store, class Member>
+constexpr Field<Store, Member>  field(const char *name, Member Store::*member, unsigned int bit_field = 0) {
+	static_assert(hasTypeOf<Member>(), "SqType of this member must be specified");
+	return {name, member, typeOf<Member>(), bit_field, builtInIndexOf<Member>()};
+}
+
+template<class Store, class Member>
+constexpr Field<Store, Member>  field(const char *name, Member Store::*member, const SqType *type, unsigned int bit_field = 0) {
+	return {name, member, type, bit_field, -1};
+}
+
+template<class Store, class... Members>
+constexpr std::tuple<Field<Store, Members>...>  fields(const Field<Store, Members>&... args) {
+	return std::tuple<Field<Store, Members>...>(args...);
+}
+
+// ----------------------------------------------------------------------------
+// Sq::StaticType - 'Fields' must be constexpr variable that returned by Sq::fields()
+
+template<class Store, const auto &Fields>
+struct StaticType
+{
+	static constexpr size_t  n_fields = std::tuple_size<std::remove_cv_t<std::remove_reference_t<decltype(Fields)>>>::value;
+	static_assert(n_fields > 0, "Sq::StaticType must have fields");
+
+	// --- compile time ---
+
+	template<size_t... Index>
+	static constexpr std::array<const char*, n_fields>  getNames(std::index_sequence<Index...>) {
+		return {{ std::get<Index>(Fields).name... }};
+	}
+
+	// sorted[position] = index of field
+	static constexpr std::array<size_t, n_fields>  sortFields() {
+		std::array<const char*, n_fields> names = getNames(std::make_index_sequence<n_fields>());
+		std::array<size_t, n_fields>      sorted = {};
+		size_t  cur = 0, index = 0;
+
+		// insertion sort
+		for (index = 0;  index < n_fields;  index++) {
+			for (cur = index;  cur > 0 && compareName(names[sorted[cur-1]], names[index]) > 0;  cur--)
+				sorted[cur] = sorted[cur-1];
+			sorted[cur] = index;
+		}
+		return sorted;
+	}
+
+	// position[index of field] = position in sorted SqType.entry
+	static constexpr std::array<size_t, n_fields>  positionFields() {
+		std::array<size_t, n_fields>  position = {};
+		for (size_t index = 0;  index < n_fields;  index++)
+			position[sorted[index]] = index;
+		return position;
+	}
+
+	static constexpr std::array<size_t, n_fields>  sorted   = sortFields();
+	static constexpr std::array<size_t, n_fields>  position = positionFields();
+
+	// --- startup ---
+
+	template<size_t Position>
+	static SqColumn  makeColumn() {
+		const auto &field = std::get<sorted[Position]>(Fields);
+		return SqColumn{field.type, field.name, Sq::offsetOf(field.member), field.bit_field};
+	}
+
+	template<size_t... Position>
+	static std::array<SqColumn, n_fields>  makeColumns(std::index_sequence<Position...>) {
+		return {{ makeColumn<Position>()... }};
+	}
+
+	template<size_t... Position>
+	static std::array<const SqColumn*, n_fields>  makePointers(std::index_sequence<Position...>) {
+		return {{ &columns()[Position]... }};
+	}
+
+	// columns are sorted by name at compile time. They are filled when they are used first time,
+	// so type() can be called during static initialization of other translation units.
+	static const std::array<SqColumn, n_fields>  &columns() {
+		static const std::array<SqColumn, n_fields>  columns = makeColumns(std::make_index_sequence<n_fields>());
+		return columns;
+	}
+
+	static const std::array<const SqColumn*, n_fields>  &pointers() {
+		static const std::array<const SqColumn*, n_fields>  pointers = makePointers(std::make_index_sequence<n_fields>());
+		return pointers;
+	}
+
+	// --- parse ---
+
+	template<size_t Position>
+	static bool  matchName(const char *name, size_t length) {
+		constexpr const char *field_name = std::get<sorted[Position]>(Fields).name;
+		// compare length before comparing characters
+		if (length != std::char_traits<char>::length(field_name))
+			return false;
+		return compareName(name, field_name) == 0;
+	}
+
+	template<size_t... Position>
+	static const SqEntry *findEntry(const char *name, std::index_sequence<Position...>) {
+		size_t  length = strlen(name);
+		size_t  found  = n_fields;
+
+		(void)( (matchName<Position>(name, length) && (found = Position, true)) || ... );
+		return (found < n_fields) ? (const SqEntry*)&columns()[found] : NULL;
+	}
+
+	static int   cxxParse(void *instance, const SqType *type, Sqxc *src) {
+		SqxcValue  *xc_value = (SqxcValue*)src->dest;
+		SqxcNested *nested;
+		const SqEntry *entry;
+
+		// Start of Object
+		nested = xc_value->nested;
+		if (nested->data3 != instance) {
+			if (nested->data != instance) {
+				// Frist time to call this function to parse object
+				nested = sqxc_push_nested((Sqxc*)xc_value);
+				nested->data  = instance;
+				nested->data2 = (SqType*)type;
+				nested->data3 = NULL;
+			}
+			if (src->type != SQXC_TYPE_OBJECT) {
+//				src->required_type = SQXC_TYPE_OBJECT;    // set required type if return SQCODE_TYPE_NOT_MATCH
+				return (src->code = SQCODE_TYPE_NOT_MATCH);
+			}
+			// ready to parse object
+			nested->data3 = instance;
+			if (type == xc_value->element)
+				xc_value->columns.index = 0;
+			return (src->code = SQCODE_OK);
+		}
+
+		// parse entries in type
+		if (src == (Sqxc*)xc_value && type == xc_value->element) {
+			// columns sent by data source directly. Find entry by column index.
+			entry = sqxc_value_find_column(xc_value, src->name);
+		}
+		else if (src->name)
+			entry = findEntry(src->name, std::make_index_sequence<n_fields>());
+		else
+			entry = NULL;
+
+		if (entry) {
+			type = entry->type;
+			if (type->parse == NULL)  // don't parse anything if function pointer is NULL
+				return (src->code = SQCODE_OK);
+			instance = (char*)instance + entry->offset;
+			if (entry->bit_field & SQB_POINTER) {
+				if (src->type == SQXC_TYPE_STRING && src->value.string == NULL) {
+					*(void**)instance = NULL;
+					return (src->code = SQCODE_OK);
+				}
+				instance = sq_type_init_instance_arena(type, instance, true, xc_value->arena);
+			}
+			return type->parse(instance, type, src);
+		}
+		return (src->code = SQCODE_ENTRY_NOT_FOUND);
+	}
+
+	// --- write ---
+
+	// write field in declaration order
+	template<size_t Index>
+	static Sqxc *writeField(Store *instance, Sqxc *dest) {
+		constexpr const auto   &field  = std::get<Index>(Fields);
+		constexpr const SqType *type   = field.type;
+		const SqColumn         *column = &columns()[position[Index]];
+		void                   *member = (void*) &(instance->*(field.member));
+
+		dest->name  = field.name;                 // set "name" before calling write()
+		dest->entry = (SqEntry*)column;           // SqxcSql and SqxcJsonc will use this
+
+		if constexpr ((field.bit_field & SQB_POINTER) != 0) {
+			if (type->write == NULL)  // don't write anything if function pointer is NULL
+				return dest;
+			member = *(void**)member;
+			if (member == NULL) {
+				dest->type = SQXC_TYPE_STRING;
+				dest->value.string = NULL;
+				return sqxc_send(dest);
+			}
+		}
+
+		// built-in types. 'member' points to value even if field has SQB_POINTER.
+		// If type was specified in Sq::field(), it is checked at runtime.
+		int  built_in = field.built_in;
+		if constexpr (field.built_in < 0)
+			built_in = SQ_TYPE_IS_BUILTIN(type) ? (int)SQ_TYPE_BUILTIN_INDEX(type) : -1;
+
+		switch (built_in) {
+		case SQ_TYPE_BOOL_INDEX:
+			dest->type = SQXC_TYPE_BOOL;
+			dest->value.boolean = *(bool*)member;
+			break;
+
+		case SQ_TYPE_INT_INDEX:
+			dest->type = SQXC_TYPE_INT;
+			dest->value.integer = *(int*)member;
+			break;
+
+		case SQ_TYPE_UINT_INDEX:
+			dest->type = SQXC_TYPE_UINT;
+			dest->value.uinteger = *(unsigned int*)member;
+			break;
+
+		case SQ_TYPE_INT64_INDEX:
+			dest->type = SQXC_TYPE_INT64;
+			dest->value.int64 = *(int64_t*)member;
+			break;
+
+		case SQ_TYPE_UINT64_INDEX:
+			dest->type = SQXC_TYPE_UINT64;
+			dest->value.uint64 = *(uint64_t*)member;
+			break;
+
+		case SQ_TYPE_TIME_INDEX:
+			dest->type = SQXC_TYPE_TIME;
+			dest->value.rawtime = *(time_t*)member;
+			break;
+
+		case SQ_TYPE_DOUBLE_INDEX:
+			dest->type = SQXC_TYPE_DOUBLE;
+			dest->value.double_ = *(double*)member;
+			break;
+
+		case SQ_TYPE_STRING_INDEX:
+			dest->type = SQXC_TYPE_STRING;
+			dest->value.string = *(char**)member;
+			break;
+
+		default:
+			if (type->write == NULL)  // don't write anything if function pointer is NULL
+				return dest;
+			return type->write(member, type, dest);
+		}
+		return sqxc_send(dest);
+	}
+
+	template<size_t... Index>
+	static Sqxc *writeFields(Store *instance, Sqxc *dest, std::index_sequence<Index...>) {
+		(void)( (((dest = writeField<Index>(instance, dest))->code == SQCODE_OK) && ...) );
+		return dest;
+	}
+
+	static Sqxc *cxxWrite(void *instance, const SqType *type, Sqxc *dest) {
+		const char *object_name = dest->name;
+
+		dest->type = SQXC_TYPE_OBJECT;
+//		dest->name = object_name;     // "name" was set by caller of this function
+		dest->entry = NULL;           // SqxcSql and SqxcJsonc will use this
+		dest = sqxc_send(dest);
+		if (dest->code != SQCODE_OK)
+			return dest;
+
+		dest = writeFields((Store*)instance, dest, std::make_index_sequence<n_fields>());
+		if (dest->code != SQCODE_OK)
+			return dest;
+
+		dest->type = SQXC_TYPE_OBJECT_END;
+		dest->name = object_name;
+		dest->entry = NULL;
+		return sqxc_send(dest);
+	}
+
+	// --- SqType ---
+
+	static const SqType *type() {
+		static const SqType  instance = {
+			sizeof(Store),                    // size
+			NULL,                             // init
+			NULL,                             // final
+			cxxParse,                         // parse
+			cxxWrite,                         // write
+			SQ_GET_TYPE_NAME(Store),          // name
+			(SqEntry**)pointers().data(),     // entry
+			(int)n_fields,                    // n_entry
+			SQB_TYPE_SORTED,                  // bit_field
+			0,                                // ref_count
+		};
+		return &instance;
+	}
+};
+
+};  // namespace Sq
+
+#endif  // C++17
+
+
+#endif  // SQ_TYPE_STATIC_CPP_H
@@ -14,6 +14,7 @@
 
 #include <string>
 #include <SqError.h>
+#include <SqUtil.h>   // sq_int64_to_str(), sq_double_to_str()
 #include <SqType.h>
 
 /* ----------------------------------------------------------------------------
@@ -48,8 +49,16 @@ static int  sq_type_std_string_parse(void *instance, const SqType *type, Sqxc *s
 		else
             ((std::string*)instance)->resize(0);
 	}
+	// format numbers the same way as SQ_TYPE_STRING
+	else if (src->type == SQXC_TYPE_INT64) {
+		char  buf[SQ_INT64_STR_SIZE];
+		((std::string*)instance)->assign(buf, sq_int64_to_str(buf, src->value.int64));
+	}
+	else if (src->type == SQXC_TYPE_DOUBLE) {
+		char  buf[SQ_DOUBLE_STR_SIZE];
+		((std::string*)instance)->assign(buf, sq_double_to_str(buf, src->value.double_));
+	}
 	else {
-		// TODO: convert to string
 //		src->required_type = SQXC_TYPE_STRING;    // set required type if return SQCODE_TYPE_NOT_MATCH
 		return (src->code = SQCODE_TYPE_NOT_MATCH);
 	}
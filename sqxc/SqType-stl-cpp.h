@@ -118,7 +118,8 @@ struct TypeStl : SqType {
 		this->ref_count = 1;
 		this->n_entry = -1;                       // SqType.entry can't be freed if SqType.n_entry == -1
 		this->entry = (SqEntry**)element_type;    // TypeStl use SqType.entry to store element type
-		sq_type_ref((SqType*)element_type);
+		if (element_type)
+			sq_type_ref((SqType*)element_type);
 		// reset SqType.bit_field if it has not been set by operator new()
 		// cast to SqType to avoid compiling warning
 		if ( ((SqType*)this)->bit_field != SQB_TYPE_DYNAMIC )
@@ -126,7 +127,8 @@ struct TypeStl : SqType {
 	}
 	~TypeStl() {
 //		if (this->bit_field & SQB_TYPE_DYNAMIC)
-		sq_type_unref((SqType*)this->entry);      // TypeStl use SqType.entry to store element type
+		if (this->entry)
+			sq_type_unref((SqType*)this->entry);  // TypeStl use SqType.entry to store element type
 	}
 
 	// for dynamic allocated Sq::TypeStl
@@ -15,6 +15,7 @@
 #include <string.h>
 
 #include <SqConfig.h>
+#include <SqArena.h>
 #include <SqPtrArray.h>
 #include <SqType.h>
 #include <SqEntry.h>
@@ -63,6 +64,7 @@ SqType  *sq_type_copy_static(const SqType *type_src, SqDestroyFunc entry_free_fu
 	type = malloc(sizeof(SqType));
 	memcpy(type, type_src, sizeof(SqType));
 	type->bit_field |= SQB_TYPE_DYNAMIC;
+	type->ref_count = 1;
 	// alloc & copy SqEntry pointer array
 	sq_ptr_array_init(sq_type_get_ptr_array(type), type_src->n_entry, entry_free_func);
 	type->n_entry = type_src->n_entry;
@@ -106,14 +108,23 @@ void  sq_type_final_self(SqType *type)
 }
 
 void *sq_type_init_instance(const SqType *type, void *instance, int is_pointer)
+{
+	return sq_type_init_instance_arena(type, instance, is_pointer, NULL);
+}
+
+void *sq_type_init_instance_arena(const SqType *type, void *instance, int is_pointer, SqArena *arena)
 {
 	SqTypeFunc  init = type->init;
 	SqPtrArray *array;
 
 	// This instance pointer to pointer
 	if (is_pointer) {
-		if (type->size > 0)
-			*(void**)instance = calloc(1, type->size);
+		if (type->size > 0) {
+			if (arena)
+				*(void**)instance = sq_arena_calloc(arena, type->size);
+			else
+				*(void**)instance = calloc(1, type->size);
+		}
 		instance = *(void**)instance;
 	}
 
@@ -127,9 +138,9 @@ void *sq_type_init_instance(const SqType *type, void *instance, int is_pointer)
 			SqEntry *entry = *element_addr;
 			type = entry->type;
 			if (SQ_TYPE_NOT_BUILTIN(type)) {
-				sq_type_init_instance(type, 
+				sq_type_init_instance_arena(type,
 						instance + entry->offset,
-						entry->bit_field & SQB_POINTER);
+						entry->bit_field & SQB_POINTER, arena);
 			}
 		}
 	}
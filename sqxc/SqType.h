@@ -36,6 +36,7 @@
 
 typedef struct SqType        SqType;
 typedef struct SqEntry       SqEntry;
+typedef struct SqArena       SqArena;    // define in SqArena.h
 
 typedef void  (*SqTypeFunc)(void *instance, const SqType *type);
 typedef int   (*SqTypeParseFunc)(void *instance, const SqType *type, Sqxc *xc_src);
@@ -132,6 +133,10 @@ void     sq_type_final_self(SqType *type);
 void    *sq_type_init_instance(const SqType *type, void *instance, int is_pointer);
 void     sq_type_final_instance(const SqType *type, void *instance, int is_pointer);
 
+// initialize instance, memory of pointer instance is allocated from 'arena' (if 'arena' is not NULL).
+// Don't call sq_type_final_instance() to finalize it, all memory is released by sq_arena_free().
+void    *sq_type_init_instance_arena(const SqType *type, void *instance, int is_pointer, SqArena *arena);
+
 // add entry from SqEntry array (NOT pointer array) to dynamic SqType.
 // if 'sizeof_entry' == 0, 'sizeof_entry' will equal sizeof(SqEntry)
 void     sq_type_add_entry(SqType *type, const SqEntry *entry, int n_entry, size_t sizeof_entry);
@@ -175,6 +180,9 @@ void  sq_type_string_final(void *instance, const SqType *type);
 int   sq_type_string_parse(void *instance, const SqType *type, Sqxc *xc_src);
 Sqxc *sq_type_string_write(void *instance, const SqType *type, Sqxc *xc_dest);
 
+void  sq_type_intern_string_final(void *instance, const SqType *type);
+int   sq_type_intern_string_parse(void *instance, const SqType *type, Sqxc *xc_src);
+
 int   sq_type_object_parse(void *instance, const SqType *type, Sqxc *xc_src);
 Sqxc *sq_type_object_write(void *instance, const SqType *type, Sqxc *xc_dest);
 
@@ -312,12 +320,6 @@ struct SqType
 extern "C" {
 #endif
 
-/* SqType-built-in.c - built-in types */
-extern  const  SqType      SqType_BuiltIn_[];
-extern  const  SqType      SqType_PtrArray_;
-extern  const  SqType      SqType_StringArray_;
-extern  const  SqType      SqType_IntptrArray_;
-
 enum {
 	SQ_TYPE_BOOL_INDEX,
 	SQ_TYPE_INT_INDEX,
@@ -328,8 +330,16 @@ enum {
 	SQ_TYPE_TIME_INDEX,
 	SQ_TYPE_DOUBLE_INDEX,
 	SQ_TYPE_STRING_INDEX,
+	SQ_TYPE_N_BUILTIN,
 };
 
+/* SqType-built-in.c - built-in types */
+extern  const  SqType      SqType_BuiltIn_[SQ_TYPE_N_BUILTIN];
+extern  const  SqType      SqType_PtrArray_;
+extern  const  SqType      SqType_StringArray_;
+extern  const  SqType      SqType_IntptrArray_;
+extern  const  SqType      SqType_InternString_;
+
 #define SQ_TYPE_BOOL       (&SqType_BuiltIn_[SQ_TYPE_BOOL_INDEX])
 #define SQ_TYPE_INT        (&SqType_BuiltIn_[SQ_TYPE_INT_INDEX])
 #define SQ_TYPE_UINT       (&SqType_BuiltIn_[SQ_TYPE_UINT_INDEX])
@@ -360,9 +370,9 @@ enum {
 		( (type)> SQ_TYPE_INTEGER_END || (type)< SQ_TYPE_INTEGER_BEG )
 
 #define SQ_TYPE_IS_ARITHMETIC(type)     \
-		( (type)<=SQ_TYPE_BUILTIN_END && (type)>=SQ_TYPE_ARITHMETIC_BEG )
+		( (type)<=SQ_TYPE_ARITHMETIC_END && (type)>=SQ_TYPE_ARITHMETIC_BEG )
 #define SQ_TYPE_NOT_ARITHMETIC(type)    \
-		( (type)> SQ_TYPE_BUILTIN_END || (type)< SQ_TYPE_ARITHMETIC_BEG )
+		( (type)> SQ_TYPE_ARITHMETIC_END || (type)< SQ_TYPE_ARITHMETIC_BEG )
 
 #define SQ_TYPE_IS_BUILTIN(type)     \
 		( (type)<=SQ_TYPE_BUILTIN_END && (type)>=SQ_TYPE_BUILTIN_BEG )
@@ -386,6 +396,11 @@ enum {
    User can use SQ_TYPE_INTPTR_ARRAY directly. */
 #define SQ_TYPE_INTPTR_ARRAY  (&SqType_IntptrArray_)
 
+/* string (char*) that is shared by SqIntern (SqType-built-in.c)
+   It is used by low-cardinality columns. Values are deduplicated by SqxcValue.intern.
+   Value assigned by user must be created by sq_intern_ref(). Don't modify or free() it. */
+#define SQ_TYPE_INTERN_STRING (&SqType_InternString_)
+
 /* macro for accessing variable of SqType */
 #define sq_type_get_ptr_array(type)    ((SqPtrArray*)&(type)->entry)
 
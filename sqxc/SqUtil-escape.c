@@ -0,0 +1,196 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#include <stdint.h>     // uintptr_t
+
+#include <SqConfig.h>
+#include <SqUtil.h>
+
+#if defined(SQ_CONFIG_ESCAPE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ESCAPE_SSE2
+#include <emmintrin.h>
+// AVX2 is detected at runtime
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ESCAPE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>     // _BitScanForward
+static int  ctz32(unsigned int bits)
+{
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return (int)index;
+}
+#else
+#define ctz32(bits)    __builtin_ctz(bits)
+#endif
+
+/*	SIMD functions read aligned blocks that may pass null-terminated.
+	Aligned block never cross page boundary, but AddressSanitizer still reports it.
+ */
+#if defined(__GNUC__)
+#define NO_SANITIZE_ADDRESS    __attribute__((no_sanitize_address))
+#else
+#define NO_SANITIZE_ADDRESS
+#endif
+
+enum {
+	ESCAPE_SQL  = 0,    // '\'' and null-terminated
+	ESCAPE_JSON = 1,    // '"', '\\', control characters, and null-terminated
+};
+
+typedef int (*SpanFunc)(const char *str, int mode);
+
+// ----------------------------------------------------------------------------
+// scalar - fallback if SIMD is not available
+
+#ifndef ESCAPE_SSE2
+
+// bit 0 = ESCAPE_SQL, bit 1 = ESCAPE_JSON
+static const unsigned char escape_flags[256] = {
+	3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	0, 0, 2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0,    // '"', '\''
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0,    // '\\'
+	// 0x60 - 0xFF are 0
+};
+
+static int  span_scalar(const char *str, int mode)
+{
+	const unsigned char *cur = (const unsigned char*)str;
+	int   flag = 1 << mode;
+
+	while ((escape_flags[*cur] & flag) == 0)
+		cur++;
+	return (int)((const char*)cur - str);
+}
+
+#endif  // ESCAPE_SSE2
+
+// ----------------------------------------------------------------------------
+// SSE2 - 16 bytes at a time
+
+#ifdef ESCAPE_SSE2
+
+NO_SANITIZE_ADDRESS
+static int  span_sse2(const char *str, int mode)
+{
+	const __m128i *cur = (const __m128i*)((uintptr_t)str & ~(uintptr_t)15);
+	unsigned int   mask = ~0u << ((uintptr_t)str & 15);    // skip bytes before 'str'
+	unsigned int   bits;
+	__m128i  quote = _mm_set1_epi8((mode == ESCAPE_SQL) ? '\'' : '"');
+	__m128i  backslash = _mm_set1_epi8('\\');
+	__m128i  control = _mm_set1_epi8(0x1F);
+	__m128i  zero = _mm_setzero_si128();
+	__m128i  data, found;
+
+	for (;;  cur++) {
+		data  = _mm_load_si128(cur);
+		found = _mm_cmpeq_epi8(data, quote);
+		if (mode == ESCAPE_JSON) {
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(data, backslash));
+			// data <= 0x1F (include null-terminated)
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(_mm_min_epu8(data, control), data));
+		}
+		else
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(data, zero));
+
+		bits = (unsigned int)_mm_movemask_epi8(found) & mask;
+		if (bits)
+			return (int)((const char*)cur + ctz32(bits) - str);
+		mask = ~0u;
+	}
+}
+
+#endif  // ESCAPE_SSE2
+
+// ----------------------------------------------------------------------------
+// AVX2 - 32 bytes at a time
+
+#ifdef ESCAPE_AVX2
+
+__attribute__((target("avx2"))) NO_SANITIZE_ADDRESS
+static int  span_avx2(const char *str, int mode)
+{
+	const __m256i *cur = (const __m256i*)((uintptr_t)str & ~(uintptr_t)31);
+	unsigned int   mask = ~0u << ((uintptr_t)str & 31);    // skip bytes before 'str'
+	unsigned int   bits;
+	__m256i  quote = _mm256_set1_epi8((mode == ESCAPE_SQL) ? '\'' : '"');
+	__m256i  backslash = _mm256_set1_epi8('\\');
+	__m256i  control = _mm256_set1_epi8(0x1F);
+	__m256i  zero = _mm256_setzero_si256();
+	__m256i  data, found;
+
+	for (;;  cur++) {
+		data  = _mm256_load_si256(cur);
+		found = _mm256_cmpeq_epi8(data, quote);
+		if (mode == ESCAPE_JSON) {
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi8(data, backslash));
+			// data <= 0x1F (include null-terminated)
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi8(_mm256_min_epu8(data, control), data));
+		}
+		else
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi8(data, zero));
+
+		bits = (unsigned int)_mm256_movemask_epi8(found) & mask;
+		if (bits)
+			return (int)((const char*)cur + ctz32(bits) - str);
+		mask = ~0u;
+	}
+}
+
+#endif  // ESCAPE_AVX2
+
+// ----------------------------------------------------------------------------
+// runtime dispatch
+
+#ifdef ESCAPE_SSE2
+
+static int  span_init(const char *str, int mode);
+
+static SpanFunc  span_func = span_init;
+
+// select function at first call. Other threads may do the same thing and get the same result.
+static int  span_init(const char *str, int mode)
+{
+#ifdef ESCAPE_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		span_func = span_avx2;
+	else
+#endif
+		span_func = span_sse2;
+	return span_func(str, mode);
+}
+
+#else
+#define span_func    span_scalar
+#endif  // ESCAPE_SSE2
+
+// ----------------------------------------------------------------------------
+
+int  sq_str_span_sql(const char *str)
+{
+	return span_func(str, ESCAPE_SQL);
+}
+
+int  sq_str_span_json(const char *str)
+{
+	return span_func(str, ESCAPE_JSON);
+}
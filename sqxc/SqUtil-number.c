@@ -0,0 +1,414 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#include <stdint.h>
+#include <string.h>     // memcpy, memmove
+
+#include <SqUtil.h>
+
+/* ----------------------------------------------------------------------------
+	integer to string
+ */
+
+static const char digits_lut[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+int  sq_uint64_to_str(char *dest, uint64_t value)
+{
+	char  temp[20];
+	char *cur = temp + sizeof(temp);
+	int   len;
+
+	// write 2 digits at a time from the end
+	while (value >= 100) {
+		cur -= 2;
+		memcpy(cur, digits_lut + (value % 100) * 2, 2);
+		value /= 100;
+	}
+	if (value >= 10) {
+		cur -= 2;
+		memcpy(cur, digits_lut + value * 2, 2);
+	}
+	else
+		*--cur = '0' + (char)value;
+
+	len = (int)(temp + sizeof(temp) - cur);
+	memcpy(dest, cur, len);
+	dest[len] = 0;
+	return len;
+}
+
+int  sq_int64_to_str(char *dest, int64_t value)
+{
+	if (value < 0) {
+		*dest = '-';
+		return sq_uint64_to_str(dest + 1, 0 - (uint64_t)value) + 1;
+	}
+	return sq_uint64_to_str(dest, (uint64_t)value);
+}
+
+/* ----------------------------------------------------------------------------
+	double to string
+
+	Grisu2 algorithm by Florian Loitsch, "Printing Floating-Point Numbers Quickly
+	and Accurately with Integers". It produces the shortest (or nearly shortest)
+	digits that can be read back to the same double.
+ */
+
+#define DP_SIGNIFICAND_SIZE   52
+#define DP_EXPONENT_BIAS      (0x3FF + DP_SIGNIFICAND_SIZE)
+#define DP_MIN_EXPONENT       (-DP_EXPONENT_BIAS)
+#define DP_EXPONENT_MASK      UINT64_C(0x7FF0000000000000)
+#define DP_SIGNIFICAND_MASK   UINT64_C(0x000FFFFFFFFFFFFF)
+#define DP_HIDDEN_BIT         UINT64_C(0x0010000000000000)
+
+// floating point number: f * 2^e
+typedef struct DiyFp {
+	uint64_t  f;
+	int       e;
+} DiyFp;
+
+static const uint64_t cached_powers_f[] = {
+	UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76),
+	UINT64_C(0xcf42894a5dce35ea), UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+	UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f), UINT64_C(0xbe5691ef416bd60c),
+	UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+	UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57),
+	UINT64_C(0xc21094364dfb5637), UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+	UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5), UINT64_C(0xb23867fb2a35b28e),
+	UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+	UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126),
+	UINT64_C(0xb5b5ada8aaff80b8), UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+	UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd), UINT64_C(0xa6dfbd9fb8e5b88f),
+	UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+	UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06),
+	UINT64_C(0xaa242499697392d3), UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+	UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c), UINT64_C(0x9c40000000000000),
+	UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+	UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068),
+	UINT64_C(0x9f4f2726179a2245), UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+	UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a), UINT64_C(0x924d692ca61be758),
+	UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+	UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d),
+	UINT64_C(0x952ab45cfa97a0b3), UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+	UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece), UINT64_C(0x88fcf317f22241e2),
+	UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+	UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410),
+	UINT64_C(0x8bab8eefb6409c1a), UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+	UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429), UINT64_C(0x80444b5e7aa7cf85),
+	UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+	UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b)
+};
+
+static const int16_t  cached_powers_e[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+	-954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+	-688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+	-422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+	-157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+	109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+	641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+	907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static const uint64_t pow10_u64[] = {
+	UINT64_C(1),                UINT64_C(10),                UINT64_C(100),
+	UINT64_C(1000),             UINT64_C(10000),             UINT64_C(100000),
+	UINT64_C(1000000),          UINT64_C(10000000),          UINT64_C(100000000),
+	UINT64_C(1000000000),       UINT64_C(10000000000),       UINT64_C(100000000000),
+	UINT64_C(1000000000000),    UINT64_C(10000000000000),    UINT64_C(100000000000000),
+	UINT64_C(1000000000000000), UINT64_C(10000000000000000), UINT64_C(100000000000000000),
+	UINT64_C(1000000000000000000), UINT64_C(10000000000000000000),
+};
+
+static inline DiyFp diyfp_sub(DiyFp a, DiyFp b)
+{
+	DiyFp  r = {a.f - b.f, a.e};
+	return r;
+}
+
+// 64 x 64 bit multiplication, keep upper 64 bits and round it.
+static inline DiyFp diyfp_mul(DiyFp a, DiyFp b)
+{
+	const uint64_t  M32 = 0xFFFFFFFF;
+	uint64_t  ac = (a.f >> 32) * (b.f >> 32);
+	uint64_t  bc = (a.f & M32) * (b.f >> 32);
+	uint64_t  ad = (a.f >> 32) * (b.f & M32);
+	uint64_t  bd = (a.f & M32) * (b.f & M32);
+	uint64_t  tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+	DiyFp     r;
+
+	tmp += (uint64_t)1 << 31;    // round
+	r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+	r.e = a.e + b.e + 64;
+	return r;
+}
+
+static inline DiyFp diyfp_normalize(DiyFp v)
+{
+	while ((v.f & DP_HIDDEN_BIT) == 0) {
+		v.f <<= 1;
+		v.e--;
+	}
+	v.f <<= 64 - DP_SIGNIFICAND_SIZE - 1;
+	v.e  -= 64 - DP_SIGNIFICAND_SIZE - 1;
+	return v;
+}
+
+// get boundaries m- and m+ of 'v'. They have the same exponent.
+static void diyfp_boundaries(DiyFp v, DiyFp *minus, DiyFp *plus)
+{
+	DiyFp  pl, mi;
+
+	pl.f = (v.f << 1) + 1;
+	pl.e = v.e - 1;
+	while ((pl.f & (DP_HIDDEN_BIT << 1)) == 0) {
+		pl.f <<= 1;
+		pl.e--;
+	}
+	pl.f <<= 64 - DP_SIGNIFICAND_SIZE - 2;
+	pl.e  -= 64 - DP_SIGNIFICAND_SIZE - 2;
+
+	if (v.f == DP_HIDDEN_BIT) {
+		mi.f = (v.f << 2) - 1;
+		mi.e = v.e - 2;
+	}
+	else {
+		mi.f = (v.f << 1) - 1;
+		mi.e = v.e - 1;
+	}
+	mi.f <<= mi.e - pl.e;
+	mi.e = pl.e;
+
+	*plus = pl;
+	*minus = mi;
+}
+
+// get cached power of 10 'c' (and 'k') that product of 'c' and 2^e is in range.
+static DiyFp cached_power(int e, int *k)
+{
+	double  dk = (-61 - e) * 0.30102999566398114 + 347;    // dk must be positive
+	int     kk = (int)dk;
+	int     index;
+	DiyFp   c;
+
+	if (dk - kk > 0.0)
+		kk++;
+	index = (kk >> 3) + 1;
+	*k = -(-348 + index * 8);    // decimal exponent
+	c.f = cached_powers_f[index];
+	c.e = cached_powers_e[index];
+	return c;
+}
+
+static void grisu_round(char *buffer, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w)
+{
+	while (rest < wp_w && delta - rest >= ten_kappa &&
+	       (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+	{
+		buffer[len - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+static int  count_decimal_digit32(uint32_t n)
+{
+	int  count = 1;
+
+	while (n >= 10) {
+		n /= 10;
+		count++;
+	}
+	return count;
+}
+
+static int  digit_gen(DiyFp W, DiyFp Mp, uint64_t delta, char *buffer, int *K)
+{
+	DiyFp     one = {(uint64_t)1 << -Mp.e, Mp.e};
+	DiyFp     wp_w = diyfp_sub(Mp, W);
+	uint32_t  p1 = (uint32_t)(Mp.f >> -one.e);
+	uint64_t  p2 = Mp.f & (one.f - 1);
+	int       kappa = count_decimal_digit32(p1);
+	int       len = 0;
+	uint32_t  d;
+
+	while (kappa > 0) {
+		d = p1 / (uint32_t)pow10_u64[kappa - 1];
+		p1 %= (uint32_t)pow10_u64[kappa - 1];
+		if (d || len)
+			buffer[len++] = '0' + (char)d;
+		kappa--;
+		if ((((uint64_t)p1) << -one.e) + p2 <= delta) {
+			*K += kappa;
+			grisu_round(buffer, len, delta, (((uint64_t)p1) << -one.e) + p2,
+			            pow10_u64[kappa] << -one.e, wp_w.f);
+			return len;
+		}
+	}
+
+	// kappa == 0
+	for (;;) {
+		p2 *= 10;
+		delta *= 10;
+		d = (uint32_t)(p2 >> -one.e);
+		if (d || len)
+			buffer[len++] = '0' + (char)d;
+		p2 &= one.f - 1;
+		kappa--;
+		if (p2 < delta) {
+			*K += kappa;
+			grisu_round(buffer, len, delta, p2, one.f,
+			            wp_w.f * ((-kappa < 20) ? pow10_u64[-kappa] : 0));
+			return len;
+		}
+	}
+}
+
+// write digits of positive 'value' to 'buffer'. value = buffer * 10^K
+static int  grisu2(double value, char *buffer, int *K)
+{
+	DiyFp     v, w_m, w_p, c_mk, W, Wp, Wm;
+	uint64_t  u64;
+	int       biased_e;
+
+	memcpy(&u64, &value, sizeof(u64));
+	biased_e = (int)((u64 & DP_EXPONENT_MASK) >> DP_SIGNIFICAND_SIZE);
+	if (biased_e != 0) {
+		v.f = (u64 & DP_SIGNIFICAND_MASK) + DP_HIDDEN_BIT;
+		v.e = biased_e - DP_EXPONENT_BIAS;
+	}
+	else {
+		v.f = u64 & DP_SIGNIFICAND_MASK;
+		v.e = DP_MIN_EXPONENT + 1;
+	}
+
+	diyfp_boundaries(v, &w_m, &w_p);
+	c_mk = cached_power(w_p.e, K);
+	W  = diyfp_mul(diyfp_normalize(v), c_mk);
+	Wp = diyfp_mul(w_p, c_mk);
+	Wm = diyfp_mul(w_m, c_mk);
+	Wm.f++;
+	Wp.f--;
+	return digit_gen(W, Wp, Wp.f - Wm.f, buffer, K);
+}
+
+static int  write_exponent(char *dest, int K)
+{
+	char *cur = dest;
+
+	if (K < 0) {
+		*cur++ = '-';
+		K = -K;
+	}
+	if (K >= 100) {
+		*cur++ = '0' + (char)(K / 100);
+		K %= 100;
+		memcpy(cur, digits_lut + K * 2, 2);
+		cur += 2;
+	}
+	else if (K >= 10) {
+		memcpy(cur, digits_lut + K * 2, 2);
+		cur += 2;
+	}
+	else
+		*cur++ = '0' + (char)K;
+	return (int)(cur - dest);
+}
+
+// format digits in 'buffer' (length = 'len', value = buffer * 10^k)
+static int  prettify(char *buffer, int len, int k)
+{
+	const int  kk = len + k;    // 10^(kk-1) <= v < 10^kk
+	int        offset;
+
+	if (0 <= k && kk <= 21) {
+		// 1234e7 -> 12340000000.0
+		memset(buffer + len, '0', k);
+		buffer[kk] = '.';
+		buffer[kk + 1] = '0';
+		return kk + 2;
+	}
+	else if (0 < kk && kk <= 21) {
+		// 1234e-2 -> 12.34
+		memmove(buffer + kk + 1, buffer + kk, len - kk);
+		buffer[kk] = '.';
+		return len + 1;
+	}
+	else if (-6 < kk && kk <= 0) {
+		// 1234e-6 -> 0.001234
+		offset = 2 - kk;
+		memmove(buffer + offset, buffer, len);
+		buffer[0] = '0';
+		buffer[1] = '.';
+		memset(buffer + 2, '0', offset - 2);
+		return len + offset;
+	}
+	else if (len == 1) {
+		// 1e30
+		buffer[1] = 'e';
+		return 2 + write_exponent(buffer + 2, kk - 1);
+	}
+	else {
+		// 1234e30 -> 1.234e33
+		memmove(buffer + 2, buffer + 1, len - 1);
+		buffer[1] = '.';
+		buffer[len + 1] = 'e';
+		return len + 2 + write_exponent(buffer + len + 2, kk - 1);
+	}
+}
+
+int  sq_double_to_str(char *dest, double value)
+{
+	char     *cur = dest;
+	uint64_t  u64;
+	int       len, K;
+
+	memcpy(&u64, &value, sizeof(u64));
+	if ((u64 & DP_EXPONENT_MASK) == DP_EXPONENT_MASK) {
+		// the same as printf()
+		if (u64 & DP_SIGNIFICAND_MASK)
+			memcpy(dest, "nan", len = 4);
+		else if (value < 0)
+			memcpy(dest, "-inf", len = 5);
+		else
+			memcpy(dest, "inf", len = 4);
+		return len - 1;
+	}
+
+	if (u64 >> 63) {
+		*cur++ = '-';
+		value = -value;
+	}
+	if (value == 0.0) {
+		memcpy(cur, "0.0", 4);
+		return (int)(cur - dest) + 3;
+	}
+
+	len = grisu2(value, cur, &K);
+	len = prettify(cur, len, K);
+	cur[len] = 0;
+	return (int)(cur - dest) + len;
+}
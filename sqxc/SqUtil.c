@@ -15,16 +15,15 @@
 #if defined(_MSC_VER)
 #define _CRT_SECURE_NO_WARNINGS
 #define strtoll		_strtoi64
-#define snprintf	_snprintf
 #endif
 
 #include <ctype.h>    // tolower(), toupper()
-#include <stdio.h>    // sscanf()
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>   // malloc()
 #include <string.h>
 
+#include <SqThread.h>    // SQ_THREAD_LOCAL
 #include <SqUtil.h>
 
 /* ----------------------------------------------------------------------------
@@ -46,102 +45,294 @@
 	HH:MM:SS.SSS
 	now                           // 
 	DDDDDDDDDD                    // Julian day number expressed as a floating point value.
+
+	ISO-8601 time zone can follow time: "Z", "+HH:MM", "+HHMM", or "+HH".
+
+	Converter doesn't call mktime() and localtime() for every time value.
+	Offset of local time is cached per day in each thread, so it doesn't wait for lock of libc.
+	Cache doesn't notice change of TZ after it is filled.
  */
 
-static int sq_tm_hms(struct tm *timeinfo, const char *timestr)
+#define SQ_TIME_OFFSET_CACHE_SIZE    64    // power of 2
+
+// days since 1970-01-01. Algorithm by Howard Hinnant.
+static int64_t days_from_civil(int64_t year, int month, int day)
+{
+	int64_t   era;
+	unsigned  yoe, doy, doe;
+
+	year -= (month <= 2);
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = (unsigned)(year - era * 400);
+	doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civil_from_days(int64_t days, int64_t *year, int *month, int *day)
 {
-	int  hour, minute, second = 0;
-	int  result;
+	int64_t   era;
+	unsigned  doe, yoe, doy, mp;
+
+	days += 719468;
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	doe = (unsigned)(days - era * 146097);
+	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	mp  = (5 * doy + 2) / 153;
+	*day   = doy - (153 * mp + 2) / 5 + 1;
+	*month = (mp < 10) ? mp + 3 : mp - 9;
+	*year  = (int64_t)yoe + era * 400 + (*month <= 2);
+}
 
-	result = sscanf(timestr, "%d:%d:%d", &hour, &minute, &second);
-	if (result < 2)
+static int64_t floor_div(int64_t value, int64_t divisor)
+{
+	return (value >= 0) ? value / divisor : (value - divisor + 1) / divisor;
+}
+
+// seconds east of UTC at 'utc_time'
+static int  local_offset(time_t utc_time)
+{
+	struct tm  tm;
+
+#if defined(_WIN32) || defined(_WIN64)
+	if (localtime_s(&tm, &utc_time) != 0)
 		return 0;
-	timeinfo->tm_hour = hour;
-	timeinfo->tm_min  = minute;
-	timeinfo->tm_sec  = second;
-	return result;
+#else
+	if (localtime_r(&utc_time, &tm) == NULL)
+		return 0;
+#endif
+	return (int)(days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * 86400 +
+	             tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec - (int64_t)utc_time);
 }
 
-static int sq_tm_ymd(struct tm *timeinfo, const char *timestr)
+static SQ_THREAD_LOCAL struct {
+	int64_t  day;
+	int      offset;
+	int      used;
+} offset_cache[SQ_TIME_OFFSET_CACHE_SIZE];
+
+static int  local_offset_cached(int64_t utc_time)
+{
+	int64_t  day = floor_div(utc_time, 86400);
+	int      index = (int)(day & (SQ_TIME_OFFSET_CACHE_SIZE - 1));
+	int      offset;
+
+	if (offset_cache[index].used && offset_cache[index].day == day)
+		return offset_cache[index].offset;
+
+	offset = local_offset((time_t)utc_time);
+	// cache it if offset doesn't change in this day
+	if (local_offset((time_t)(day * 86400)) == offset &&
+	    local_offset((time_t)(day * 86400 + 86399)) == offset)
+	{
+		offset_cache[index].day = day;
+		offset_cache[index].offset = offset;
+		offset_cache[index].used = 1;
+	}
+	return offset;
+}
+
+// convert local time to UTC. Offsets of one day before and after are candidates.
+// If local time occurs twice (offset decreased), use the earlier one like mktime().
+// If local time is skipped (offset increased), use offset before change.
+static int64_t local_to_utc(int64_t local)
+{
+	int  offset_before = local_offset_cached(local - 86400);
+	int  offset_after  = local_offset_cached(local + 86400);
+	bool before_valid, after_valid;
+
+	if (offset_before == offset_after)
+		return local - offset_before;
+	before_valid = (local_offset_cached(local - offset_before) == offset_before);
+	after_valid  = (local_offset_cached(local - offset_after)  == offset_after);
+	if (after_valid && (before_valid == false || offset_after > offset_before))
+		return local - offset_after;
+	return local - offset_before;
+}
+
+// parse unsigned decimal number. return number of digits.
+// return 0 if it has more than 9 digits because value may overflow int.
+static int  parse_digits(const char **cur, int *value)
 {
-	int  year, month, day;
+	const char *str = *cur;
+	int   result = 0;
 
-	if (sscanf(timestr, "%d-%d-%d", &year, &month, &day) != 3) {
-		if (sscanf(timestr, "%d/%d/%d", &year, &month, &day) != 3)
+	for (;  *str >= '0' && *str <= '9';  str++) {
+		if (str - *cur == 9)
 			return 0;
+		result = result * 10 + (*str - '0');
+	}
+	*value = result;
+	result = (int)(str - *cur);
+	*cur = str;
+	return result;
+}
+
+// parse HH:MM[:SS[.SSS]]
+static bool parse_hms(const char **cur, int *hour, int *minute, int *second)
+{
+	if (parse_digits(cur, hour) == 0 || **cur != ':')
+		return false;
+	(*cur)++;
+	if (parse_digits(cur, minute) == 0)
+		return false;
+	*second = 0;
+	if (**cur == ':') {
+		(*cur)++;
+		if (parse_digits(cur, second) == 0)
+			return false;
+		// skip fraction of second
+		if (**cur == '.' || **cur == ',') {
+			for ((*cur)++;  **cur >= '0' && **cur <= '9';  (*cur)++)
+				;
+		}
 	}
-	timeinfo->tm_year = year  - 1900;
-	timeinfo->tm_mon  = month - 1;
-	timeinfo->tm_mday = day;
-	return 3;
+	return (*hour <= 24 && *minute <= 59 && *second <= 60);
 }
 
-// return UTC time
-// return -1 if error
 time_t  sq_time_from_string(const char *timestr)
 {
-	struct tm  timeinfo = {0};
-	char  *cur;
-
-	cur = strpbrk(timestr, " T:n.");
-	if (cur == NULL)
-		cur = strpbrk(timestr, "-/");    // YYYY-MM-DD  or  YYYY/MM/DD
-	if (cur == NULL)
-		return -1;
-
-	switch(cur[0]) {
-	case ' ':
-	case 'T':
-		if (sq_tm_hms(&timeinfo, cur +1) == 0)
+	return sq_time_from_string_full(timestr, SQ_TIME_USE_UTC);
+}
+
+time_t  sq_time_from_string_full(const char *timestr, bool is_utc)
+{
+	const char *cur = timestr;
+	int         year = 2000, month = 1, day = 1;
+	int         hour = 0, minute = 0, second = 0;
+	int         zone_h, zone_m = 0;
+	int         n_digits;
+	char        sign, separator;
+	int64_t     result;
+
+	while (*cur == ' ')
+		cur++;
+	n_digits = parse_digits(&cur, &year);
+	if (n_digits == 0)
+		return -1;    // "now" or others
+
+	if (*cur == ':') {
+		// HH:MM  or  HH:MM:SS, date is 2000-01-01
+		cur = timestr;
+		while (*cur == ' ')
+			cur++;
+		year = 2000;
+		if (parse_hms(&cur, &hour, &minute, &second) == false)
 			return -1;
-	case '-':
-	case '/':
-		if (sq_tm_ymd(&timeinfo, timestr) == 0)
+	}
+	else if (*cur == '-' || *cur == '/') {
+		// YYYY-MM-DD  or  YYYY/MM/DD
+		separator = *cur++;
+		if (parse_digits(&cur, &month) == 0 || *cur++ != separator)
 			return -1;
-		break;
-
-	case ':':    // HH:MM  or  HH:MM:SS
-		// 2000-01-01
-		timeinfo.tm_year = 2000 - 1900;
-		timeinfo.tm_mon  = 1    - 1;
-		timeinfo.tm_mday = 1;
-		if (sq_tm_hms(&timeinfo, timestr) == 0)
+		if (parse_digits(&cur, &day) == 0)
 			return -1;
-		break;
+		if (month < 1 || month > 12 || day < 1 || day > 31)
+			return -1;
+		if (*cur == ' ' || *cur == 'T' || *cur == 't') {
+			cur++;
+			if (parse_hms(&cur, &hour, &minute, &second) == false)
+				return -1;
+		}
+	}
+	else
+		return -1;    // Julian day number
 
-	case 'n':    // now
-		return -1;
+	result = days_from_civil(year, month, day) * 86400 +
+	         hour * 3600 + minute * 60 + second;
+
+	// time zone
+	while (*cur == ' ')
+		cur++;
+	switch (*cur) {
+	case 'Z':
+	case 'z':
+		return (time_t)result;
+
+	case '+':
+	case '-':
+		sign = *cur++;
+		n_digits = parse_digits(&cur, &zone_h);
+		if (n_digits == 4) {
+			// +HHMM
+			zone_m = zone_h % 100;
+			zone_h = zone_h / 100;
+		}
+		else if (n_digits == 2) {
+			// +HH  or  +HH:MM
+			if (*cur == ':') {
+				cur++;
+				if (parse_digits(&cur, &zone_m) != 2)
+					return -1;
+			}
+		}
+		else
+			return -1;
+		if (sign == '+')
+			return (time_t)(result - zone_h * 3600 - zone_m * 60);
+		else
+			return (time_t)(result + zone_h * 3600 + zone_m * 60);
 
-	case '.':    // Julian day number
 	default:
-		return -1;
+		break;
 	}
 
-	return mktime(&timeinfo);
+	if (is_utc)
+		return (time_t)result;
+	return (time_t)local_to_utc(result);
 }
-// return NULL if error
+
 char   *sq_time_to_string(time_t timeraw)
 {
-	struct tm  *timeinfo;
-	char       *timestr;
-
-	timeinfo = localtime((time_t*) &timeraw);
-//	timeinfo = gmtime((time_t*) &timeraw);
-	if (timeinfo == NULL)
-		return NULL;
+	char  *timestr;
 
-	timestr = malloc(32);
+	timestr = malloc(SQ_TIME_STR_SIZE);
 	// output format : "2013-02-05 21:25:15"
-	snprintf(timestr, 32, "%.4d-%.2d-%.2d %.2d:%.2d:%.2d",
-	         timeinfo->tm_year + 1900,
-	         timeinfo->tm_mon  + 1,
-	         timeinfo->tm_mday,
-	         timeinfo->tm_hour,
-	         timeinfo->tm_min,
-	         timeinfo->tm_sec);
+	sq_time_to_str(timestr, timeraw, SQ_TIME_USE_UTC);
 	return timestr;
 }
 
+static inline char *write_2_digits(char *dest, int value)
+{
+	dest[0] = '0' + (char)(value / 10);
+	dest[1] = '0' + (char)(value % 10);
+	return dest + 2;
+}
+
+int     sq_time_to_str(char *dest, time_t timeraw, bool is_utc)
+{
+	char    *cur = dest;
+	int64_t  seconds = (int64_t)timeraw;
+	int64_t  days, year;
+	int      month, day;
+
+	if (is_utc == false)
+		seconds += local_offset_cached(seconds);
+	days = floor_div(seconds, 86400);
+	seconds -= days * 86400;
+	civil_from_days(days, &year, &month, &day);
+
+	if (year >= 0 && year <= 9999) {
+		cur = write_2_digits(cur, (int)(year / 100));
+		cur = write_2_digits(cur, (int)(year % 100));
+	}
+	else
+		cur += sq_int64_to_str(cur, year);
+	*cur++ = '-';
+	cur = write_2_digits(cur, month);
+	*cur++ = '-';
+	cur = write_2_digits(cur, day);
+	*cur++ = ' ';
+	cur = write_2_digits(cur, (int)(seconds / 3600));
+	*cur++ = ':';
+	cur = write_2_digits(cur, (int)(seconds / 60 % 60));
+	*cur++ = ':';
+	cur = write_2_digits(cur, (int)(seconds % 60));
+	*cur = 0;
+	return (int)(cur - dest);
+}
+
 // ----------------------------------------------------------------------------
 
 // C string to SQL string
@@ -17,6 +17,7 @@
 
 #include <time.h>        // time_t, struct tm
 #include <stdbool.h>     // bool
+#include <stdint.h>      // int64_t, uint64_t
 
 #include <SqConfig.h>    // SQ_CONFIG_NAMING_CONVENTION
 
@@ -26,13 +27,50 @@ extern "C" {
 
 /* ----------------------------------------------------------------------------
 	time_t convert from/to string
+
+	Time string without time zone is local time by default.
+	It is UTC time if SQ_CONFIG_TIME_UTC is defined.
  */
 
+#ifdef SQ_CONFIG_TIME_UTC
+#define SQ_TIME_USE_UTC     true
+#else
+#define SQ_TIME_USE_UTC     false
+#endif
+
+// size of buffer for sq_time_to_str()
+#define SQ_TIME_STR_SIZE    32
+
 // return -1 if error
 time_t  sq_time_from_string(const char *timestr);
+// If 'timestr' doesn't have time zone (e.g. "Z" or "+08:00"), it is UTC time when 'is_utc' is true.
+time_t  sq_time_from_string_full(const char *timestr, bool is_utc);
 
-// return NULL if error
+// return NULL if error. Returned string must be freed by free().
 char   *sq_time_to_string(time_t time);
+// write "YYYY-MM-DD HH:MM:SS" to 'dest' that has SQ_TIME_STR_SIZE bytes at least.
+// return length of string (not including null-terminated)
+int     sq_time_to_str(char *dest, time_t time, bool is_utc);
+
+
+/* ----------------------------------------------------------------------------
+	integer and floating point number to string (SqUtil-number.c)
+
+	They don't call printf() and allocate memory.
+	'dest' must have SQ_INT64_STR_SIZE (or SQ_DOUBLE_STR_SIZE) bytes at least.
+	return length of string (not including null-terminated)
+ */
+
+#define SQ_INT64_STR_SIZE     21
+#define SQ_DOUBLE_STR_SIZE    32
+
+int  sq_int64_to_str(char *dest, int64_t value);
+int  sq_uint64_to_str(char *dest, uint64_t value);
+
+// output the shortest (or nearly shortest) string that can be converted back to the same double.
+// e.g. 0.1, 1.0, 1e300
+// NaN and infinity are output as "nan", "inf", and "-inf".
+int  sq_double_to_str(char *dest, double value);
 
 
 /* ----------------------------------------------------------------------------
@@ -57,6 +95,19 @@ int  sq_str_c2sql(char *dest, const char *c_string);
 int  sq_str_sql2c(char *dest, char *sql_string);
 
 
+/* ----------------------------------------------------------------------------
+	find characters that need escaping (SqUtil-escape.c)
+
+	They use SSE2/AVX2 if SQ_CONFIG_ESCAPE_SIMD is enabled and CPU supports it.
+	return number of leading bytes that can be copied without escaping.
+ */
+
+// stop at '\'' or null-terminated
+int  sq_str_span_sql(const char *str);
+
+// stop at '"', '\\', control characters (0x00 - 0x1F), or null-terminated
+int  sq_str_span_json(const char *str);
+
 #ifdef SQ_CONFIG_NAMING_CONVENTION
 
 /* ----------------------------------------------------------------------------
@@ -33,11 +33,16 @@ Sqdb   *sqdb_new(const SqdbInfo *info, SqdbConfig *config)
 	init = info->init;
 	if (init) {
 		db = malloc(info->size);
+		// init() can replace 'info' (e.g. SqdbPool)
+		db->info = info;
+		// stats is NULL by default. init() of third-party Sqdb may not set it.
+		db->stats = NULL;
 		info->init(db, config);
 	}
-	else
+	else {
 		db = calloc(1, info->size);
-	db->info = info;
+		db->info = info;
+	}
 	return db;
 }
 
@@ -580,7 +585,6 @@ void sqdb_sql_create_index(Sqdb *db, SqBuffer *sql_buf, SqTable *table, SqColumn
 void sqdb_sql_write_column(Sqdb *db, SqBuffer *buffer, SqColumn *column, const char* column_name)
 {
 	const SqType *type;
-	int     len;
 	int16_t size, digits;
 
 	if (column_name == NULL)
@@ -614,8 +618,9 @@ void sqdb_sql_write_column(Sqdb *db, SqBuffer *buffer, SqColumn *column, const c
 		else
 			sq_buffer_write(buffer, "INT");
 		if (size > 0) {
-			len = snprintf(NULL, 0, "(%d)", size);
-			sprintf(sq_buffer_alloc(buffer, len), "(%d)", size);
+			sq_buffer_write_c(buffer, '(');
+			sq_buffer_write_int64(buffer, size);
+			sq_buffer_write_c(buffer, ')');
 		}
 		if (column->type == SQ_TYPE_UINT)  // || column->type == SQ_TYPE_UINTPTR
 			sq_buffer_write(buffer, " UNSIGNED");
@@ -628,8 +633,9 @@ void sqdb_sql_write_column(Sqdb *db, SqBuffer *buffer, SqColumn *column, const c
 		else
 			sq_buffer_write(buffer, "BIGINT");
 		if (size > 0) {
-			len = snprintf(NULL, 0, "(%d)", size);
-			sprintf(sq_buffer_alloc(buffer, len), "(%d)", size);
+			sq_buffer_write_c(buffer, '(');
+			sq_buffer_write_int64(buffer, size);
+			sq_buffer_write_c(buffer, ')');
 		}
 		if (column->type == SQ_TYPE_UINT64)
 			sq_buffer_write(buffer, " UNSIGNED");
@@ -643,13 +649,10 @@ void sqdb_sql_write_column(Sqdb *db, SqBuffer *buffer, SqColumn *column, const c
 		sq_buffer_write(buffer, "DOUBLE");    // FLOAT
 		if (size > 0 || digits > 0) {
 			sq_buffer_write_c(buffer, '(');
-			if (size > 0 && digits == 0) {
-				len = snprintf(NULL, 0, "%d", size);
-				sprintf(sq_buffer_alloc(buffer, len), "%d", size);
-			}
-			else {
-				len = snprintf(NULL, 0, "%d,%d", size, digits);
-				sprintf(sq_buffer_alloc(buffer, len), "%d,%d", size, digits);
+			sq_buffer_write_int64(buffer, size);
+			if (size <= 0 || digits != 0) {
+				sq_buffer_write_c(buffer, ',');
+				sq_buffer_write_int64(buffer, digits);
 			}
 			sq_buffer_write_c(buffer, ')');
 		}
@@ -657,8 +660,9 @@ void sqdb_sql_write_column(Sqdb *db, SqBuffer *buffer, SqColumn *column, const c
 
 	case SQ_TYPE_STRING_INDEX:
 		size = (size <= 0) ? SQL_STRING_LENGTH_DEFAULT : size;
-		len = snprintf(NULL, 0, "VARCHAR(%d)", size);
-		sprintf(sq_buffer_alloc(buffer, len), "VARCHAR(%d)", size);
+		sq_buffer_write_n(buffer, "VARCHAR(", 8);
+		sq_buffer_write_int64(buffer, size);
+		sq_buffer_write_c(buffer, ')');
 		break;
 	}
 
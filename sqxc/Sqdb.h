@@ -28,6 +28,8 @@
 typedef struct Sqdb             Sqdb;
 typedef struct SqdbInfo         SqdbInfo;
 typedef struct SqdbConfig       SqdbConfig;
+typedef struct SqdbStmt         SqdbStmt;    // prepared statement. derived Sqdb define it.
+typedef struct SqdbStats        SqdbStats;   // define in SqdbStats.h
 
 typedef struct Sqxc             Sqxc;        // define in Sqxc.h
 
@@ -46,7 +48,9 @@ typedef enum SqdbProduct {
 extern "C" {
 #endif
 
-/* --- macro functions --- parameter used only once in macro (except parameter 'db') */
+/* --- macro functions --- parameter used only once in macro (except parameter 'db')
+   If db->stats is not NULL, statements are measured by sqdb_stats_xxx() functions (see SqdbStats.h).
+ */
 
 // int  sqdb_open(Sqdb *db, const char *database_name);
 #define sqdb_open(db, database_name)    (db)->info->open(db, database_name)
@@ -60,7 +64,29 @@ extern "C" {
 
 // int  sqdb_exec(Sqdb *db, const char *sql, Sqxc *xc, void *reserve);
 #define sqdb_exec(db, sql, xc, reserve)    \
-		(db)->info->exec(db, sql, xc, reserve)
+		((db)->stats ? sqdb_stats_exec(db, sql, xc, reserve) : (db)->info->exec(db, sql, xc, reserve))
+
+/* --- prepared statement --- */
+
+// int  sqdb_prepare(Sqdb *db, const char *sql, SqdbStmt **stmt);
+#define sqdb_prepare(db, sql, stmt)    \
+		((db)->stats ? sqdb_stats_prepare(db, sql, stmt) : (db)->info->prepare(db, sql, stmt))
+
+// int  sqdb_stmt_bind(Sqdb *db, SqdbStmt *stmt, int index, Sqxc *src);
+#define sqdb_stmt_bind(db, stmt, index, src)    \
+		(db)->info->bind(db, stmt, index, src)
+
+// int  sqdb_stmt_step(Sqdb *db, SqdbStmt *stmt, Sqxc *xc);
+#define sqdb_stmt_step(db, stmt, xc)    \
+		((db)->stats ? sqdb_stats_stmt_step(db, stmt, xc) : (db)->info->step(db, stmt, xc))
+
+// int  sqdb_stmt_reset(Sqdb *db, SqdbStmt *stmt);
+#define sqdb_stmt_reset(db, stmt)       \
+		((db)->stats ? sqdb_stats_stmt_reset(db, stmt) : (db)->info->reset(db, stmt))
+
+// int  sqdb_stmt_finalize(Sqdb *db, SqdbStmt *stmt);
+#define sqdb_stmt_finalize(db, stmt)    \
+		((db)->stats ? sqdb_stats_stmt_finalize(db, stmt) : (db)->info->finalize(db, stmt))
 
 /* --- C Functions --- */
 
@@ -68,6 +94,14 @@ extern "C" {
 Sqdb   *sqdb_new(const SqdbInfo *info, SqdbConfig *config);
 void    sqdb_free(Sqdb *db);
 
+/* --- measure statement. They are called by above macro functions if db->stats is not NULL --- */
+
+int  sqdb_stats_exec(Sqdb *db, const char *sql, Sqxc *xc, void *reserve);
+int  sqdb_stats_prepare(Sqdb *db, const char *sql, SqdbStmt **stmt);
+int  sqdb_stats_stmt_step(Sqdb *db, SqdbStmt *stmt, Sqxc *xc);
+int  sqdb_stats_stmt_reset(Sqdb *db, SqdbStmt *stmt);
+int  sqdb_stats_stmt_finalize(Sqdb *db, SqdbStmt *stmt);
+
 /* --- execute SQL statement --- */
 
 int  sqdb_exec_create_index(Sqdb *db, SqBuffer *sql_buf, SqTable *table, SqPtrArray *arranged_columns);
@@ -119,6 +153,12 @@ struct DbMethod
 	int  close(void);
 	int  exec(const char *sql, Sqxc *xc, void *reserve);
 	int  migrate(SqSchema *schema_cur, SqSchema *schema_next);
+
+	int  prepare(const char *sql, SqdbStmt **stmt);
+	int  bind(SqdbStmt *stmt, int index, Sqxc *src);
+	int  step(SqdbStmt *stmt, Sqxc *xc = NULL);
+	int  reset(SqdbStmt *stmt);
+	int  finalize(SqdbStmt *stmt);
 };
 
 };  // namespace Sq
@@ -147,6 +187,14 @@ struct SqdbInfo
 		char         identifier[2];      // SQLite is "", MySQL is ``, SQL Server is []
 	} quote;
 
+	// Sqdb instance can be used by multiple threads at the same time (e.g. SqdbPool).
+	// SqStorage doesn't serialize access to Sqdb if this is 1.
+	unsigned int   thread_safe:1;
+
+	// prepare() reuses compiled statement of the same SQL (e.g. statement cache of SqdbSqlite).
+	// SqxcSql output '?' placeholders for this Sqdb if SQ_CONFIG_SQXC_SQL_USE_PARAM is defined.
+	unsigned int   stmt_cache:1;
+
 	// initialize derived structure of Sqdb
 	void (*init)(Sqdb *db, SqdbConfig *config);
 	// finalize derived structure of Sqdb
@@ -160,12 +208,25 @@ struct SqdbInfo
 	int  (*exec)(Sqdb *db, const char *sql, Sqxc *xc, void *reserve);
 	// migrate schema from 'schema_next' to 'schema_cur'
 	int  (*migrate)(Sqdb *db, SqSchema *schema_cur, SqSchema *schema_next);
+
+	// compile SQL statement to prepared statement 'stmt'. It can be run many times without reparsing.
+	int  (*prepare)(Sqdb *db, const char *sql, SqdbStmt **stmt);
+	// bind value of 'src' to parameter 'index' (start from 1). Value type is specified by src->type (SqxcType).
+	int  (*bind)(Sqdb *db, SqdbStmt *stmt, int index, Sqxc *src);
+	// run 'stmt'. If it produce a row, send the row to 'xc' and return SQCODE_ROW.
+	// return SQCODE_DONE if it has finished executing.
+	int  (*step)(Sqdb *db, SqdbStmt *stmt, Sqxc *xc);
+	// reset 'stmt' to its initial state and clear bindings, ready to be re-executed.
+	int  (*reset)(Sqdb *db, SqdbStmt *stmt);
+	// destroy prepared statement
+	int  (*finalize)(Sqdb *db, SqdbStmt *stmt);
 };
 
 /*
    Sqdb - It is a base structure for database product (SQLite, MySQL...etc).
 
-   TODO: Sqdb should be thread safe...
+   Sqdb is not thread safe unless SqdbInfo.thread_safe is 1 (e.g. SqdbPool).
+   SqStorage serializes access to Sqdb that is not thread safe, so SqStorage can be used by multiple threads.
 
    The correct way to derive Sqdb:  (conforming C++11 standard-layout)
    1. Use Sq::DbMethod to inherit member function(method).
@@ -176,7 +237,8 @@ struct SqdbInfo
 
 #define SQDB_MEMBERS           \
 	const SqdbInfo *info;      \
-	int             version
+	int             version;   \
+	SqdbStats      *stats
 
 #ifdef __cplusplus
 struct Sqdb : Sq::DbMethod           // <-- 1. inherit member function(method)
@@ -190,6 +252,9 @@ struct Sqdb
 
 	// schema version in SQL database
 	int             version;
+
+	// statistics of statements. It is NULL by default, set it to measure statements.
+	SqdbStats      *stats;
  */
 
 	/* Add variable and function */  // <-- 3. Add variable and non-virtual function in derived struct.
@@ -232,6 +297,22 @@ inline int  DbMethod::migrate(SqSchema *schema_cur, SqSchema *schema_next) {
 	return sqdb_migrate((Sqdb*)this, schema_cur, schema_next);
 }
 
+inline int  DbMethod::prepare(const char *sql, SqdbStmt **stmt) {
+	return sqdb_prepare((Sqdb*)this, sql, stmt);
+}
+inline int  DbMethod::bind(SqdbStmt *stmt, int index, Sqxc *src) {
+	return sqdb_stmt_bind((Sqdb*)this, stmt, index, src);
+}
+inline int  DbMethod::step(SqdbStmt *stmt, Sqxc *xc) {
+	return sqdb_stmt_step((Sqdb*)this, stmt, xc);
+}
+inline int  DbMethod::reset(SqdbStmt *stmt) {
+	return sqdb_stmt_reset((Sqdb*)this, stmt);
+}
+inline int  DbMethod::finalize(SqdbStmt *stmt) {
+	return sqdb_stmt_finalize((Sqdb*)this, stmt);
+}
+
 /* --- define C++11 standard-layout structures --- */
 
 // This one is for directly use only. You can NOT derived it.
@@ -32,6 +32,12 @@ static int  sqdb_empty_close(SqdbEmpty *sqdb);
 static int  sqdb_empty_exec(SqdbEmpty *sqdb, const char *sql, Sqxc *xc, void *reserve);
 static int  sqdb_empty_migrate(SqdbEmpty *sqdb, SqSchema *schema, SqSchema *schema_next);
 
+static int  sqdb_empty_prepare(SqdbEmpty *sqdb, const char *sql, SqdbStmt **stmt);
+static int  sqdb_empty_bind(SqdbEmpty *sqdb, SqdbStmt *stmt, int index, Sqxc *src);
+static int  sqdb_empty_step(SqdbEmpty *sqdb, SqdbStmt *stmt, Sqxc *xc);
+static int  sqdb_empty_reset(SqdbEmpty *sqdb, SqdbStmt *stmt);
+static int  sqdb_empty_finalize(SqdbEmpty *sqdb, SqdbStmt *stmt);
+
 static const SqdbInfo dbinfo = {
 	.size    = sizeof(SqdbEmpty),
 	.product = SQDB_PRODUCT_UNKNOWN,
@@ -49,6 +55,12 @@ static const SqdbInfo dbinfo = {
     .close   = (void*)sqdb_empty_close,
     .exec    = (void*)sqdb_empty_exec,
     .migrate = (void*)sqdb_empty_migrate,
+
+	.prepare  = (void*)sqdb_empty_prepare,
+	.bind     = (void*)sqdb_empty_bind,
+	.step     = (void*)sqdb_empty_step,
+	.reset    = (void*)sqdb_empty_reset,
+	.finalize = (void*)sqdb_empty_finalize,
 };
 
 const SqdbInfo *SQDB_INFO_EMPTY = &dbinfo;
@@ -58,6 +70,9 @@ const SqdbInfo *SQDB_INFO_EMPTY = &dbinfo;
 
 static void sqdb_empty_init(SqdbEmpty *sqdb, SqdbConfigEmpty *config_src)
 {
+	sqdb->version = 0;
+	sqdb->stats = NULL;
+
 	if (config_src) {
 		// setup Sqdb
 	}
@@ -126,3 +141,32 @@ static int  sqdb_empty_exec(SqdbEmpty *sqdb, const char *sql, Sqxc *xc, void *re
 
 	return SQCODE_OK;
 }
+
+static int  sqdb_empty_prepare(SqdbEmpty *sqdb, const char *sql, SqdbStmt **stmt)
+{
+	// compile SQL statement and return it in 'stmt'
+	*stmt = NULL;
+	return SQCODE_NOT_SUPPORT;
+}
+
+static int  sqdb_empty_bind(SqdbEmpty *sqdb, SqdbStmt *stmt, int index, Sqxc *src)
+{
+	// bind src->value to parameter 'index' by src->type
+	return (src->code = SQCODE_NOT_SUPPORT);
+}
+
+static int  sqdb_empty_step(SqdbEmpty *sqdb, SqdbStmt *stmt, Sqxc *xc)
+{
+	// send a row to 'xc' and return SQCODE_ROW, or return SQCODE_DONE
+	return SQCODE_DONE;
+}
+
+static int  sqdb_empty_reset(SqdbEmpty *sqdb, SqdbStmt *stmt)
+{
+	return SQCODE_OK;
+}
+
+static int  sqdb_empty_finalize(SqdbEmpty *sqdb, SqdbStmt *stmt)
+{
+	return SQCODE_OK;
+}
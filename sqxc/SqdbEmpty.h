@@ -61,6 +61,9 @@ struct SqdbEmpty
 
 	// schema version in SQL database
 	int             version;
+
+	// statistics of statements
+	SqdbStats      *stats;
  */
 
 	// ------ SqdbEmpty members ------     // <-- 3. Add variable and non-virtual function in derived struct.
@@ -20,7 +20,9 @@
 #include <stdio.h>      // snprintf
 
 #include <SqError.h>
+#include <SqUtil.h>
 #include <SqdbMysql.h>
+#include <SqdbStats.h>
 #include <SqxcValue.h>
 #include <SqxcSql.h>
 #include <Sqdb-migration.h>
@@ -29,6 +31,7 @@
 #define MYSQL_DEFAULT_PORT      3306
 #define MYSQL_DEFAULT_USER      "root"
 #define MYSQL_DEFAULT_PASSWORD  ""
+#define MYSQL_RESULT_BUFFER_SIZE    64
 
 static void sqdb_mysql_init(SqdbMysql *sqdb, SqdbConfigMysql *config);
 static void sqdb_mysql_final(SqdbMysql *sqdb);
@@ -37,6 +40,12 @@ static int  sqdb_mysql_close(SqdbMysql *sqdb);
 static int  sqdb_mysql_exec(SqdbMysql *sqdb, const char *sql, Sqxc *xc, void *reserve);
 static int  sqdb_mysql_migrate(SqdbMysql *sqdb, SqSchema *schema, SqSchema *schema_next);
 
+static int  sqdb_mysql_prepare(SqdbMysql *sqdb, const char *sql, SqdbStmt **stmt);
+static int  sqdb_mysql_bind(SqdbMysql *sqdb, SqdbStmt *stmt, int index, Sqxc *src);
+static int  sqdb_mysql_step(SqdbMysql *sqdb, SqdbStmt *stmt, Sqxc *xc);
+static int  sqdb_mysql_reset(SqdbMysql *sqdb, SqdbStmt *stmt);
+static int  sqdb_mysql_finalize(SqdbMysql *sqdb, SqdbStmt *stmt);
+
 static int  sqdb_mysql_schema_get_version(SqdbMysql *sqdb);
 static void sqdb_mysql_schema_set_version(SqdbMysql *sqdb, int version);
 
@@ -65,6 +74,12 @@ static const SqdbInfo dbinfo = {
 	.close   = (void*)sqdb_mysql_close,
 	.exec    = (void*)sqdb_mysql_exec,
 	.migrate = (void*)sqdb_mysql_migrate,
+
+	.prepare  = (void*)sqdb_mysql_prepare,
+	.bind     = (void*)sqdb_mysql_bind,
+	.step     = (void*)sqdb_mysql_step,
+	.reset    = (void*)sqdb_mysql_reset,
+	.finalize = (void*)sqdb_mysql_finalize,
 };
 
 const SqdbInfo *SQDB_INFO_MYSQL = &dbinfo;
@@ -78,6 +93,7 @@ static void sqdb_mysql_init(SqdbMysql *sqdb, SqdbConfigMysql *config_src)
 	sqdb->self = mysql_init(NULL);
 	sqdb->config = config_src;
 	sqdb->version = 0;
+	sqdb->stats = NULL;
 }
 
 static void sqdb_mysql_final(SqdbMysql *sqdb)
@@ -192,7 +208,9 @@ static int  sqdb_mysql_migrate(SqdbMysql *db, SqSchema *schema, SqSchema *schema
 atExit:
 	sq_buffer_final(&sql_buf);
 	if (rc) {
+#ifdef DEBUG
 		fprintf(stderr, "MySQL: %s\n", mysql_error(db->self));
+#endif
 		return SQCODE_EXEC_ERROR;
 	}
 	return SQCODE_OK;
@@ -205,6 +223,7 @@ static int  sqdb_mysql_exec(SqdbMysql *sqdb, const char *sql, Sqxc *xc, void *re
 	MYSQL_FIELD *field;
 	unsigned int n_fields;
 	char **names;
+	int    n_rows = 0;
 	int    rc = 0;
 
 #ifdef DEBUG
@@ -274,7 +293,9 @@ static int  sqdb_mysql_exec(SqdbMysql *sqdb, const char *sql, Sqxc *xc, void *re
 				xc = sqxc_send(xc);
 //				if (xc->code != SQCODE_OK)
 //					break;
+				n_rows++;
 			}
+			sqdb_stats_add_rows(n_rows);
 
 			// if Sqxc element prepare for multiple row
 			if (sqxc_value_current(xc) == sqxc_value_container(xc)) {
@@ -303,12 +324,290 @@ static int  sqdb_mysql_exec(SqdbMysql *sqdb, const char *sql, Sqxc *xc, void *re
 	}
 
 	if (rc) {
+#ifdef DEBUG
 		fprintf(stderr, "MySQL: %s\n", mysql_error(sqdb->self));
+#endif
 		return SQCODE_EXEC_ERROR;
 	}
 	return SQCODE_OK;
 }
 
+// ----------------------------------------------------------------------------
+// prepared statement. SqdbStmt is SqdbStmtMysql in SqdbMysql.
+
+typedef struct SqdbStmtMysql    SqdbStmtMysql;
+
+struct SqdbStmtMysql
+{
+	MYSQL_STMT    *self;
+
+	// parameters
+	MYSQL_BIND    *params;
+	union {
+		long long  int64;
+		double     double_;
+		char      *string;    // allocated string
+	}             *values;
+	unsigned long  n_params;
+
+	// result set
+	MYSQL_RES     *meta;
+	MYSQL_BIND    *results;
+	unsigned int   n_fields;
+
+	bool           executed;
+};
+
+static void sqdb_mysql_stmt_clear_params(SqdbStmtMysql *mstmt)
+{
+	for (unsigned long index = 0;  index < mstmt->n_params;  index++) {
+		if (mstmt->params[index].buffer_type == MYSQL_TYPE_STRING)
+			free(mstmt->values[index].string);
+		memset(mstmt->params + index, 0, sizeof(MYSQL_BIND));
+		mstmt->params[index].buffer_type = MYSQL_TYPE_NULL;
+	}
+}
+
+static int  sqdb_mysql_prepare(SqdbMysql *sqdb, const char *sql, SqdbStmt **stmt)
+{
+	SqdbStmtMysql *mstmt;
+	MYSQL_BIND    *field;
+
+#ifdef DEBUG
+	fprintf(stderr, "SQL prepare: %s\n", sql);
+#endif
+
+	mstmt = calloc(1, sizeof(SqdbStmtMysql));
+	mstmt->self = mysql_stmt_init(sqdb->self);
+	if (mstmt->self == NULL || mysql_stmt_prepare(mstmt->self, sql, strlen(sql)) != 0) {
+		if (mstmt->self) {
+#ifdef DEBUG
+			fprintf(stderr, "MySQL: %s\n", mysql_stmt_error(mstmt->self));
+#endif
+			mysql_stmt_close(mstmt->self);
+		}
+		free(mstmt);
+		*stmt = NULL;
+		return SQCODE_EXEC_ERROR;
+	}
+
+	// parameters
+	mstmt->n_params = mysql_stmt_param_count(mstmt->self);
+	if (mstmt->n_params > 0) {
+		mstmt->params = calloc(mstmt->n_params, sizeof(MYSQL_BIND));
+		mstmt->values = calloc(mstmt->n_params, sizeof(mstmt->values[0]));
+		sqdb_mysql_stmt_clear_params(mstmt);
+	}
+
+	// result set. MySQL copy MYSQL_BIND array, so 'is_null', 'length', and 'error'
+	// point to members of our MYSQL_BIND here.
+	mstmt->meta = mysql_stmt_result_metadata(mstmt->self);
+	if (mstmt->meta) {
+		mstmt->n_fields = mysql_num_fields(mstmt->meta);
+		mstmt->results = calloc(mstmt->n_fields, sizeof(MYSQL_BIND));
+		for (unsigned int index = 0;  index < mstmt->n_fields;  index++) {
+			field = mstmt->results + index;
+			field->buffer_type = MYSQL_TYPE_STRING;
+			field->buffer = malloc(MYSQL_RESULT_BUFFER_SIZE);
+			field->buffer_length = MYSQL_RESULT_BUFFER_SIZE;
+			field->is_null = &field->is_null_value;
+			field->length  = &field->length_value;
+			field->error   = &field->error_value;
+		}
+		mysql_stmt_bind_result(mstmt->self, mstmt->results);
+	}
+
+	*stmt = (SqdbStmt*)mstmt;
+	return SQCODE_OK;
+}
+
+static int  sqdb_mysql_bind(SqdbMysql *sqdb, SqdbStmt *stmt, int index, Sqxc *src)
+{
+	SqdbStmtMysql *mstmt = (SqdbStmtMysql*)stmt;
+	MYSQL_BIND    *param;
+
+	if (index < 1 || (unsigned long)index > mstmt->n_params)
+		return (src->code = SQCODE_ERROR);
+	index--;    // parameter index start from 1
+	param = mstmt->params + index;
+	if (param->buffer_type == MYSQL_TYPE_STRING)
+		free(mstmt->values[index].string);
+	memset(param, 0, sizeof(MYSQL_BIND));
+
+	switch (src->type) {
+	case SQXC_TYPE_BOOL:
+		mstmt->values[index].int64 = src->value.boolean;
+		goto bind_int64;
+
+	case SQXC_TYPE_INT:
+		mstmt->values[index].int64 = src->value.integer;
+		goto bind_int64;
+
+	case SQXC_TYPE_UINT:
+		mstmt->values[index].int64 = src->value.uint;
+		goto bind_int64;
+
+	case SQXC_TYPE_UINT64:
+		param->is_unsigned = 1;
+	case SQXC_TYPE_INT64:
+		mstmt->values[index].int64 = src->value.int64;
+	bind_int64:
+		param->buffer_type = MYSQL_TYPE_LONGLONG;
+		param->buffer = &mstmt->values[index].int64;
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		mstmt->values[index].double_ = src->value.double_;
+		param->buffer_type = MYSQL_TYPE_DOUBLE;
+		param->buffer = &mstmt->values[index].double_;
+		break;
+
+	case SQXC_TYPE_TIME:
+		mstmt->values[index].string = sq_time_to_string(src->value.rawtime);
+		goto bind_string;
+
+	case SQXC_TYPE_STRING:
+		if (src->value.string == NULL) {
+			param->buffer_type = MYSQL_TYPE_NULL;
+			break;
+		}
+		mstmt->values[index].string = strdup(src->value.string);
+	bind_string:
+		param->buffer_type = MYSQL_TYPE_STRING;
+		param->buffer = mstmt->values[index].string;
+		param->buffer_length = strlen(mstmt->values[index].string);
+		break;
+
+	default:
+		param->buffer_type = MYSQL_TYPE_NULL;
+		return (src->code = SQCODE_TYPE_NOT_SUPPORT);
+	}
+
+	return (src->code = SQCODE_OK);
+}
+
+static int  sqdb_mysql_step(SqdbMysql *sqdb, SqdbStmt *stmt, Sqxc *xc)
+{
+	SqdbStmtMysql *mstmt = (SqdbStmtMysql*)stmt;
+	MYSQL_BIND    *field;
+	MYSQL_FIELD   *names;
+	int            rc;
+
+	if (mstmt->executed == false) {
+		mstmt->executed = true;
+		if (mstmt->n_params > 0 && mysql_stmt_bind_param(mstmt->self, mstmt->params))
+			goto atError;
+		if (mysql_stmt_execute(mstmt->self))
+			goto atError;
+		// no result set. INSERT command: get id of the last inserted row
+		if (mstmt->meta == NULL) {
+			if (xc && xc->info == SQXC_INFO_SQL)
+				sqxc_sql_id(xc) = (int64_t)mysql_stmt_insert_id(mstmt->self);
+			return SQCODE_DONE;
+		}
+	}
+	if (mstmt->meta == NULL)
+		return SQCODE_DONE;
+
+	rc = mysql_stmt_fetch(mstmt->self);
+	if (rc == MYSQL_NO_DATA)
+		return SQCODE_DONE;
+	if (rc == 1)
+		goto atError;
+
+	// enlarge buffer and fetch column again if it has no space for null-terminated
+	for (unsigned int index = 0;  index < mstmt->n_fields;  index++) {
+		field = mstmt->results + index;
+		if (*field->is_null || *field->length < field->buffer_length)
+			continue;
+		field->buffer_length = *field->length + 1;
+		field->buffer = realloc(field->buffer, field->buffer_length);
+		mysql_stmt_fetch_column(mstmt->self, field, index, 0);
+		rc = MYSQL_DATA_TRUNCATED;
+	}
+	// buffer address has been changed
+	if (rc == MYSQL_DATA_TRUNCATED)
+		mysql_stmt_bind_result(mstmt->self, mstmt->results);
+
+	if (xc == NULL)
+		return SQCODE_ROW;
+
+	names = mysql_fetch_fields(mstmt->meta);
+
+	xc->type = SQXC_TYPE_OBJECT;
+	xc->name = NULL;
+	xc->value.pointer = NULL;
+	xc = sqxc_send(xc);
+
+	for (unsigned int index = 0;  index < mstmt->n_fields;  index++) {
+		field = mstmt->results + index;
+		xc->type = SQXC_TYPE_STRING;
+		xc->name = names[index].name;
+		if (*field->is_null)
+			xc->value.string = NULL;
+		else {
+			// buffer_length is greater than length
+			((char*)field->buffer)[*field->length] = 0;
+			xc->value.string = (char*)field->buffer;
+		}
+		xc = sqxc_send(xc);
+#ifdef DEBUG
+		switch (xc->code) {
+		case SQCODE_OK:
+			break;
+
+		case SQCODE_ENTRY_NOT_FOUND:
+			fprintf(stderr, "sqdb_mysql_step(): column '%s' not found.\n", names[index].name);
+			break;
+
+		default:
+			fprintf(stderr, "sqdb_mysql_step(): error occurred during parsing column '%s'.\n", names[index].name);
+			break;
+		}
+#endif  // DEBUG
+	}
+
+	xc->type = SQXC_TYPE_OBJECT_END;
+	xc->name = NULL;
+	xc->value.pointer = NULL;
+	xc = sqxc_send(xc);
+	return SQCODE_ROW;
+
+atError:
+#ifdef DEBUG
+	fprintf(stderr, "MySQL: %s\n", mysql_stmt_error(mstmt->self));
+#endif
+	return SQCODE_EXEC_ERROR;
+}
+
+static int  sqdb_mysql_reset(SqdbMysql *sqdb, SqdbStmt *stmt)
+{
+	SqdbStmtMysql *mstmt = (SqdbStmtMysql*)stmt;
+
+	mysql_stmt_free_result(mstmt->self);
+	mysql_stmt_reset(mstmt->self);
+	sqdb_mysql_stmt_clear_params(mstmt);
+	mstmt->executed = false;
+	return SQCODE_OK;
+}
+
+static int  sqdb_mysql_finalize(SqdbMysql *sqdb, SqdbStmt *stmt)
+{
+	SqdbStmtMysql *mstmt = (SqdbStmtMysql*)stmt;
+
+	mysql_stmt_close(mstmt->self);
+	if (mstmt->meta)
+		mysql_free_result(mstmt->meta);
+	for (unsigned int index = 0;  index < mstmt->n_fields;  index++)
+		free(mstmt->results[index].buffer);
+	free(mstmt->results);
+	sqdb_mysql_stmt_clear_params(mstmt);
+	free(mstmt->params);
+	free(mstmt->values);
+	free(mstmt);
+	return SQCODE_OK;
+}
+
 // ----------------------------------------------------------------------------
 // other static functions
 
@@ -340,12 +639,12 @@ static int  sqdb_mysql_schema_get_version(SqdbMysql *sqdb)
 
 static void sqdb_mysql_schema_set_version(SqdbMysql *sqdb, int version)
 {
-	char *buf;
-	int   len;
-
-	len = snprintf(NULL, 0, "UPDATE " SQDB_MIGRATIONS_TABLE " SET version=%d WHERE id = 0", version) + 1;
-	buf = malloc(len);
-	snprintf(buf, len, "UPDATE " SQDB_MIGRATIONS_TABLE " SET version=%d WHERE id = 0", version);
-	mysql_query(sqdb->self, buf);
-	free(buf);
+	SqBuffer  buf;
+
+	sq_buffer_init(&buf);
+	sq_buffer_write(&buf, "UPDATE " SQDB_MIGRATIONS_TABLE " SET version=");
+	sq_buffer_write_int64(&buf, version);
+	sq_buffer_write(&buf, " WHERE id = 0");
+	mysql_query(sqdb->self, buf.buf);
+	sq_buffer_final(&buf);
 }
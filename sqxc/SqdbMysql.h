@@ -69,6 +69,9 @@ struct SqdbMysql
 
 	// schema version in SQL database
 	int             version;
+
+	// statistics of statements
+	SqdbStats      *stats;
  */
 
 	// ------ SqdbMysql members ------     // <-- 3. Add variable and non-virtual function in derived struct.
@@ -0,0 +1,469 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#if defined(_MSC_VER)
+#define _CRT_SECURE_NO_WARNINGS
+#define strncasecmp strnicmp
+#endif
+
+#include <stdio.h>      // fprintf
+#include <string.h>     // strdup, strncasecmp
+
+#include <SqConfig.h>
+#include <SqError.h>
+#include <SqdbPool.h>
+
+// prepared statement of SqdbPool. It keeps connection until it is finalized.
+typedef struct PoolStmt
+{
+	SqdbPoolConn  *conn;
+	SqdbStmt      *stmt;
+} PoolStmt;
+
+static void sqdb_pool_init(SqdbPool *pool, SqdbConfigPool *config);
+static void sqdb_pool_final(SqdbPool *pool);
+static int  sqdb_pool_open(SqdbPool *pool, const char *database_name);
+static int  sqdb_pool_close(SqdbPool *pool);
+static int  sqdb_pool_exec(SqdbPool *pool, const char *sql, Sqxc *xc, void *reserve);
+static int  sqdb_pool_migrate(SqdbPool *pool, SqSchema *schema, SqSchema *schema_next);
+
+static int  sqdb_pool_prepare(SqdbPool *pool, const char *sql, PoolStmt **stmt);
+static int  sqdb_pool_bind(SqdbPool *pool, PoolStmt *stmt, int index, Sqxc *src);
+static int  sqdb_pool_step(SqdbPool *pool, PoolStmt *stmt, Sqxc *xc);
+static int  sqdb_pool_reset(SqdbPool *pool, PoolStmt *stmt);
+static int  sqdb_pool_finalize(SqdbPool *pool, PoolStmt *stmt);
+
+// SqdbPool.info_pool is copied from connection's SqdbInfo and these fields are replaced in sqdb_pool_init().
+static const SqdbInfo dbinfo = {
+	.size    = sizeof(SqdbPool),
+	.product = SQDB_PRODUCT_UNKNOWN,
+	.quote = {
+		.identifier = {'"', '"'}
+	},
+	.thread_safe = 1,
+
+	.init    = (void*)sqdb_pool_init,
+	.final   = (void*)sqdb_pool_final,
+	.open    = (void*)sqdb_pool_open,
+	.close   = (void*)sqdb_pool_close,
+	.exec    = (void*)sqdb_pool_exec,
+	.migrate = (void*)sqdb_pool_migrate,
+
+	.prepare  = (void*)sqdb_pool_prepare,
+	.bind     = (void*)sqdb_pool_bind,
+	.step     = (void*)sqdb_pool_step,
+	.reset    = (void*)sqdb_pool_reset,
+	.finalize = (void*)sqdb_pool_finalize,
+};
+
+const SqdbInfo *SQDB_INFO_POOL = &dbinfo;
+
+static SqdbPoolConn *sqdb_pool_acquire(SqdbPool *pool);
+static void          sqdb_pool_release(SqdbPool *pool, SqdbPoolConn *conn);
+
+// ----------------------------------------------------------------------------
+// SqdbInfo
+
+static void sqdb_pool_init(SqdbPool *pool, SqdbConfigPool *config)
+{
+	const SqdbInfo *info = config->info;
+
+	pool->info_conn = info;
+	pool->config_conn = config->config;
+	pool->name = NULL;
+	pool->version = 0;
+	pool->stats = NULL;
+
+	// SqdbPool has the same product, column, quote, and stmt_cache as its connections.
+	pool->info_pool = *info;
+	pool->info_pool.size        = dbinfo.size;
+	pool->info_pool.thread_safe = 1;
+	pool->info_pool.init    = dbinfo.init;
+	pool->info_pool.final   = dbinfo.final;
+	pool->info_pool.open    = dbinfo.open;
+	pool->info_pool.close   = dbinfo.close;
+	pool->info_pool.exec    = dbinfo.exec;
+	pool->info_pool.migrate = dbinfo.migrate;
+	// prepared statement is available if connection support it
+	if (info->prepare) {
+		pool->info_pool.prepare  = dbinfo.prepare;
+		pool->info_pool.bind     = dbinfo.bind;
+		pool->info_pool.step     = dbinfo.step;
+		pool->info_pool.reset    = dbinfo.reset;
+		pool->info_pool.finalize = dbinfo.finalize;
+	}
+	pool->info = &pool->info_pool;
+
+	pool->max_connections = config->max_connections;
+	if (pool->max_connections <= 0)
+		pool->max_connections = SQ_CONFIG_SQDB_POOL_MAX_DEFAULT;
+	pool->min_connections = config->min_connections;
+	if (pool->min_connections > pool->max_connections)
+		pool->min_connections = pool->max_connections;
+	pool->idle_timeout = config->idle_timeout;
+	pool->health_check = config->health_check;
+
+	pool->conns = calloc(pool->max_connections, sizeof(SqdbPoolConn));
+	pool->n_opened = 0;
+
+	sq_mutex_init(&pool->mutex, false);
+	sq_cond_init(&pool->cond);
+}
+
+static void sqdb_pool_final(SqdbPool *pool)
+{
+	sqdb_pool_close(pool);
+	free(pool->conns);
+	sq_mutex_final(&pool->mutex);
+	sq_cond_final(&pool->cond);
+}
+
+static int  sqdb_pool_conn_open(SqdbPool *pool, SqdbPoolConn *conn)
+{
+	Sqdb *db;
+	int   code;
+
+	db = sqdb_new(pool->info_conn, pool->config_conn);
+	code = sqdb_open(db, pool->name);
+	if (code != SQCODE_OK) {
+		sqdb_free(db);
+		return code;
+	}
+	conn->db = db;
+	return SQCODE_OK;
+}
+
+static void sqdb_pool_conn_close(SqdbPoolConn *conn)
+{
+	sqdb_close(conn->db);
+	sqdb_free(conn->db);
+	conn->db = NULL;
+}
+
+static int  sqdb_pool_open(SqdbPool *pool, const char *database_name)
+{
+	SqdbPoolConn *conn;
+	int   n, code = SQCODE_OK;
+
+	sq_mutex_lock(&pool->mutex);
+	free(pool->name);
+	pool->name = strdup(database_name);
+	// open 'min_connections'. open one connection at least to get schema version of database.
+	n = (pool->min_connections > 0) ? pool->min_connections : 1;
+	for (conn = pool->conns;  pool->n_opened < n && conn < pool->conns + pool->max_connections;  conn++) {
+		if (conn->db)
+			continue;
+		code = sqdb_pool_conn_open(pool, conn);
+		if (code != SQCODE_OK)
+			break;
+		conn->idle_since = time(NULL);
+		pool->n_opened++;
+	}
+	// get schema version from the first opened connection. It may not be conns[0].
+	for (conn = pool->conns;  conn < pool->conns + pool->max_connections;  conn++) {
+		if (conn->db) {
+			pool->version = conn->db->version;
+			break;
+		}
+	}
+	sq_mutex_unlock(&pool->mutex);
+	return code;
+}
+
+static int  sqdb_pool_close(SqdbPool *pool)
+{
+	SqdbPoolConn *conn;
+
+	sq_mutex_lock(&pool->mutex);
+	for (conn = pool->conns;  conn < pool->conns + pool->max_connections;  conn++) {
+		if (conn->db) {
+#ifdef DEBUG
+			if (conn->n_users > 0)
+				fprintf(stderr, "sqdb_pool_close(): connection is still in use.\n");
+#endif
+			sqdb_pool_conn_close(conn);
+		}
+		conn->n_users = 0;
+		conn->bound = false;
+	}
+	pool->n_opened = 0;
+	free(pool->name);
+	pool->name = NULL;
+	sq_mutex_unlock(&pool->mutex);
+	return SQCODE_OK;
+}
+
+#define SQL_BEGIN        1
+#define SQL_COMMIT       2
+#define SQL_ROLLBACK     3
+
+// return SQL_BEGIN, SQL_COMMIT, or SQL_ROLLBACK if 'sql' begins or ends transaction
+static int  sql_transaction(const char *sql)
+{
+	while (*sql == ' ' || *sql == '\t' || *sql == '\n')
+		sql++;
+	if (strncasecmp(sql, "BEGIN", 5) == 0 || strncasecmp(sql, "START TRANSACTION", 17) == 0)
+		return SQL_BEGIN;
+	if (strncasecmp(sql, "COMMIT", 6) == 0 || strncasecmp(sql, "END", 3) == 0)
+		return SQL_COMMIT;
+	// "ROLLBACK TO" doesn't end transaction
+	if (strncasecmp(sql, "ROLLBACK", 8) == 0) {
+		for (sql += 8;  *sql == ' ';  sql++)
+			;
+		if (strncasecmp(sql, "TO", 2) != 0)
+			return SQL_ROLLBACK;
+	}
+	return 0;
+}
+
+static int  sqdb_pool_exec(SqdbPool *pool, const char *sql, Sqxc *xc, void *reserve)
+{
+	SqdbPoolConn *conn;
+	int   code;
+
+	conn = sqdb_pool_acquire(pool);
+	if (conn == NULL)
+		return SQCODE_OPEN_FAIL;
+	code = sqdb_exec(conn->db, sql, xc, reserve);
+
+	switch (sql_transaction(sql)) {
+	case SQL_BEGIN:
+		// bind connection to this thread until transaction is ended.
+		if (code == SQCODE_OK && conn->bound == false) {
+			sq_mutex_lock(&pool->mutex);
+			conn->bound = true;
+			conn->thread = sq_thread_self();
+			conn->n_users++;
+			sq_mutex_unlock(&pool->mutex);
+		}
+		break;
+
+	case SQL_COMMIT:
+		// transaction is still active if COMMIT failed.
+		if (code != SQCODE_OK)
+			break;
+		// fall through
+	case SQL_ROLLBACK:
+		if (conn->bound) {
+			sq_mutex_lock(&pool->mutex);
+			conn->bound = false;
+			conn->n_users--;
+			sq_mutex_unlock(&pool->mutex);
+		}
+		break;
+	}
+
+	sqdb_pool_release(pool, conn);
+	return code;
+}
+
+static int  sqdb_pool_migrate(SqdbPool *pool, SqSchema *schema, SqSchema *schema_next)
+{
+	SqdbPoolConn *conn;
+	int   code;
+
+	conn = sqdb_pool_acquire(pool);
+	if (conn == NULL)
+		return SQCODE_OPEN_FAIL;
+	code = sqdb_migrate(conn->db, schema, schema_next);
+
+	// apply schema version to all connections
+	sq_mutex_lock(&pool->mutex);
+	pool->version = conn->db->version;
+	for (int index = 0;  index < pool->max_connections;  index++) {
+		if (pool->conns[index].db)
+			pool->conns[index].db->version = pool->version;
+	}
+	sq_mutex_unlock(&pool->mutex);
+
+	sqdb_pool_release(pool, conn);
+	return code;
+}
+
+// ----------------------------------------------------------------------------
+// prepared statement
+
+static int  sqdb_pool_prepare(SqdbPool *pool, const char *sql, PoolStmt **stmt)
+{
+	SqdbPoolConn *conn;
+	SqdbStmt     *conn_stmt;
+	int   code;
+
+	conn = sqdb_pool_acquire(pool);
+	if (conn == NULL)
+		return SQCODE_OPEN_FAIL;
+	code = sqdb_prepare(conn->db, sql, &conn_stmt);
+	if (code != SQCODE_OK) {
+		sqdb_pool_release(pool, conn);
+		return code;
+	}
+	// statement keeps connection until it is finalized.
+	*stmt = malloc(sizeof(PoolStmt));
+	(*stmt)->conn = conn;
+	(*stmt)->stmt = conn_stmt;
+	return SQCODE_OK;
+}
+
+static int  sqdb_pool_bind(SqdbPool *pool, PoolStmt *stmt, int index, Sqxc *src)
+{
+	return sqdb_stmt_bind(stmt->conn->db, stmt->stmt, index, src);
+}
+
+static int  sqdb_pool_step(SqdbPool *pool, PoolStmt *stmt, Sqxc *xc)
+{
+	return sqdb_stmt_step(stmt->conn->db, stmt->stmt, xc);
+}
+
+static int  sqdb_pool_reset(SqdbPool *pool, PoolStmt *stmt)
+{
+	return sqdb_stmt_reset(stmt->conn->db, stmt->stmt);
+}
+
+static int  sqdb_pool_finalize(SqdbPool *pool, PoolStmt *stmt)
+{
+	int   code;
+
+	code = sqdb_stmt_finalize(stmt->conn->db, stmt->stmt);
+	sqdb_pool_release(pool, stmt->conn);
+	free(stmt);
+	return code;
+}
+
+// ----------------------------------------------------------------------------
+// connection management
+
+Sqdb *sqdb_pool_get(SqdbPool *pool)
+{
+	SqdbPoolConn *conn;
+
+	conn = sqdb_pool_acquire(pool);
+	if (conn)
+		return conn->db;
+	return NULL;
+}
+
+void  sqdb_pool_put(SqdbPool *pool, Sqdb *db)
+{
+	for (int index = 0;  index < pool->max_connections;  index++) {
+		if (pool->conns[index].db == db) {
+			sqdb_pool_release(pool, pool->conns + index);
+			return;
+		}
+	}
+}
+
+// close connections that are idle longer than 'idle_timeout'. 'pool->mutex' must be locked.
+static void sqdb_pool_close_idle(SqdbPool *pool, time_t now)
+{
+	SqdbPoolConn *conn;
+
+	if (pool->idle_timeout <= 0)
+		return;
+	for (conn = pool->conns;  conn < pool->conns + pool->max_connections;  conn++) {
+		if (pool->n_opened <= pool->min_connections)
+			break;
+		if (conn->db && conn->n_users == 0 && now - conn->idle_since >= pool->idle_timeout) {
+			sqdb_pool_conn_close(conn);
+			pool->n_opened--;
+		}
+	}
+}
+
+static SqdbPoolConn *sqdb_pool_acquire(SqdbPool *pool)
+{
+	SqdbPoolConn *conn;
+	SqdbPoolConn *idle;
+	SqdbPoolConn *empty;
+	SqThreadId    self = sq_thread_self();
+	time_t        now;
+
+	sq_mutex_lock(&pool->mutex);
+	for (;;) {
+		// pool is not opened
+		if (pool->name == NULL) {
+			sq_mutex_unlock(&pool->mutex);
+			return NULL;
+		}
+
+		idle  = NULL;
+		empty = NULL;
+		for (conn = pool->conns;  conn < pool->conns + pool->max_connections;  conn++) {
+			// connection is bound to this thread by transaction
+			if (conn->bound && sq_thread_equal(conn->thread, self)) {
+				conn->n_users++;
+				sq_mutex_unlock(&pool->mutex);
+				return conn;
+			}
+			if (conn->n_users > 0)
+				continue;
+			// use the most recently used connection, other connections can be closed by idle timeout.
+			if (conn->db) {
+				if (idle == NULL || idle->idle_since < conn->idle_since)
+					idle = conn;
+			}
+			else if (empty == NULL)
+				empty = conn;
+		}
+
+		if (idle) {
+			conn = idle;
+			break;
+		}
+		if (empty) {
+			// reserve slot and open connection later
+			conn = empty;
+			pool->n_opened++;
+			break;
+		}
+		// all connections are in use
+		sq_cond_wait(&pool->cond, &pool->mutex);
+	}
+	conn->n_users = 1;
+	now = time(NULL);
+	sqdb_pool_close_idle(pool, now);
+	sq_mutex_unlock(&pool->mutex);
+
+	// check idle connection before use it
+	if (conn->db && pool->health_check > 0 && now - conn->idle_since >= pool->health_check) {
+		if (sqdb_exec(conn->db, "SELECT 1", NULL, NULL) != SQCODE_OK) {
+#ifdef DEBUG
+			fprintf(stderr, "sqdb_pool: health check failed. reopen connection.\n");
+#endif
+			sqdb_pool_conn_close(conn);
+		}
+	}
+
+	if (conn->db == NULL) {
+		if (sqdb_pool_conn_open(pool, conn) != SQCODE_OK) {
+			sq_mutex_lock(&pool->mutex);
+			conn->n_users = 0;
+			pool->n_opened--;
+			sq_cond_signal(&pool->cond);
+			sq_mutex_unlock(&pool->mutex);
+			return NULL;
+		}
+		conn->db->version = pool->version;
+	}
+	return conn;
+}
+
+static void sqdb_pool_release(SqdbPool *pool, SqdbPoolConn *conn)
+{
+	sq_mutex_lock(&pool->mutex);
+	if (--conn->n_users == 0) {
+		conn->idle_since = time(NULL);
+		sq_cond_signal(&pool->cond);
+	}
+	sq_mutex_unlock(&pool->mutex);
+}
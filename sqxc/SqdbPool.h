@@ -0,0 +1,173 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQDB_POOL_H
+#define SQDB_POOL_H
+
+#include <time.h>       // time_t
+
+#include <Sqdb.h>
+#include <SqThread.h>
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+typedef struct SqdbPool            SqdbPool;
+typedef struct SqdbConfigPool      SqdbConfigPool;
+typedef struct SqdbPoolConn        SqdbPoolConn;
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const SqdbInfo    *SQDB_INFO_POOL;
+
+#define sqdb_pool_new(sqdb_config)    sqdb_new(SQDB_INFO_POOL, sqdb_config)
+
+// check out a connection. It wait if all connections are in use.
+// return NULL if connection can't be opened.
+Sqdb *sqdb_pool_get(SqdbPool *pool);
+
+// check in a connection that returned by sqdb_pool_get()
+void  sqdb_pool_put(SqdbPool *pool, Sqdb *db);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+// ----------------------------------------------------------------------------
+// C/C++ common definitions: define structue
+
+/*
+    SqdbPool - Sqdb that manages multiple connections of other Sqdb product.
+
+    Sqdb
+    |
+    `--- SqdbPool
+
+    Every call of SqdbInfo functions checks out a connection and checks it in when it is done.
+    Prepared statement keeps its connection until it is finalized.
+    If thread run "BEGIN" successfully, connection is bound to the thread until "COMMIT" or "ROLLBACK".
+
+    SqdbPool.info points to SqdbPool.info_pool, it has product, quote... of connection's SqdbInfo.
+ */
+
+#ifdef __cplusplus
+struct SqdbPool : Sq::DbMethod             // <-- 1. inherit C++ member function(method)
+#else
+struct SqdbPool
+#endif
+{
+	SQDB_MEMBERS;                          // <-- 2. inherit member variable
+/*	// ------ Sqdb members ------
+	const SqdbInfo *info;
+
+	// schema version in SQL database
+	int             version;
+
+	// statistics of statements
+	SqdbStats      *stats;
+ */
+
+	// ------ SqdbPool members ------      // <-- 3. Add variable and non-virtual function in derived struct.
+	SqdbInfo        info_pool;
+	const SqdbInfo *info_conn;     // SqdbInfo of connections
+	SqdbConfig     *config_conn;   // SqdbConfig of connections
+	char           *name;          // database name
+
+	SqdbPoolConn   *conns;         // array of connections. length is 'max_connections'
+	int             n_opened;      // number of opened (or opening) connections
+	int             min_connections;
+	int             max_connections;
+	int             idle_timeout;
+	int             health_check;
+
+	SqMutex         mutex;
+	SqCond          cond;          // signaled when a connection is checked in
+};
+
+/*
+    SqdbConfigPool - SqdbPool use this configure
+
+    SqdbConfig
+    |
+    `--- SqdbConfigPool
+ */
+struct SqdbConfigPool
+{
+	SQDB_CONFIG_MEMBERS;
+/*	// ------ SqdbConfig members ------
+	unsigned int    product;
+	unsigned int    bit_field;
+ */
+
+	// ------ SqdbConfigPool members ------
+	const SqdbInfo *info;          // Sqdb product of connections. e.g. SQDB_INFO_SQLITE
+	SqdbConfig     *config;        // config of connections. It must be available until pool is freed.
+
+	int   min_connections;   // number of connections that are opened by sqdb_open() and never closed by idle timeout.
+	int   max_connections;   // 0 = default
+	int   idle_timeout;      // seconds. connection is closed if it is idle longer than this. 0 = never
+	int   health_check;      // seconds. connection is checked before use if it is idle longer than this. 0 = never
+};
+
+/*
+    SqdbPoolConn - connection in SqdbPool
+ */
+struct SqdbPoolConn
+{
+	Sqdb          *db;          // NULL if connection is not opened
+	time_t         idle_since;
+	int            n_users;     // number of calls, prepared statements, and transaction that are using this connection.
+	bool           bound;       // bound to 'thread' by transaction
+	SqThreadId     thread;
+};
+
+// ----------------------------------------------------------------------------
+// C++ definitions: define C++ data, function, method, and others.
+
+#ifdef __cplusplus
+
+namespace Sq {
+
+typedef struct SqdbConfigPool    DbConfigPool;
+
+// conforming C++11 standard-layout
+// These are for directly use only. You can NOT derived it.
+struct DbPool : SqdbPool
+{
+	DbPool(SqdbConfigPool *config) {
+		this->info = SQDB_INFO_POOL;  SQDB_INFO_POOL->init((Sqdb*)this, (SqdbConfig*)config);
+	}
+	~DbPool() {
+		this->info->final((Sqdb*)this);
+	}
+
+	Sqdb *get() {
+		return sqdb_pool_get((SqdbPool*)this);
+	}
+	void  put(Sqdb *db) {
+		sqdb_pool_put((SqdbPool*)this, db);
+	}
+};
+
+};  // namespace Sq
+
+#endif  // __cplusplus
+
+
+#endif  // SQDB_POOL_H
@@ -15,17 +15,22 @@
 #if defined(_MSC_VER)
 #define _CRT_SECURE_NO_WARNINGS
 #define snprintf	_snprintf
+#define strncasecmp  strnicmp
 #endif
 
 #include <stdio.h>      // snprintf
+#include <string.h>     // memset, strdup, strcmp
 
 #include <SqError.h>
+#include <SqUtil.h>
 #include <SqdbSqlite.h>
+#include <SqdbStats.h>
 #include <SqxcValue.h>
 #include <SqxcSql.h>
 #include <SqRelation-migration.h>
 
 #define NEW_TABLE_PREFIX_NAME          "new__table__"
+#define SQLITE_VERSION_NUMBER_3_7_14   3007014           // 3.7.14
 #define SQLITE_VERSION_NUMBER_3_20     3020000           // 3.20.0
 
 static void sqdb_sqlite_init(SqdbSqlite *sqdb, SqdbConfigSqlite *config);
@@ -35,6 +40,12 @@ static int  sqdb_sqlite_close(SqdbSqlite *sqdb);
 static int  sqdb_sqlite_exec(SqdbSqlite *sqdb, const char *sql, Sqxc *xc, void *reserve);
 static int  sqdb_sqlite_migrate(SqdbSqlite *sqdb, SqSchema *schema, SqSchema *schema_next);
 
+static int  sqdb_sqlite_prepare(SqdbSqlite *sqdb, const char *sql, SqdbStmt **stmt);
+static int  sqdb_sqlite_bind(SqdbSqlite *sqdb, SqdbStmt *stmt, int index, Sqxc *src);
+static int  sqdb_sqlite_step(SqdbSqlite *sqdb, SqdbStmt *stmt, Sqxc *xc);
+static int  sqdb_sqlite_reset(SqdbSqlite *sqdb, SqdbStmt *stmt);
+static int  sqdb_sqlite_finalize(SqdbSqlite *sqdb, SqdbStmt *stmt);
+
 static const SqdbInfo dbinfo = {
 	.size    = sizeof(SqdbSqlite),
 	.product = SQDB_PRODUCT_SQLITE,
@@ -46,6 +57,7 @@ static const SqdbInfo dbinfo = {
 	.quote = {
 		.identifier = {'"', '"'}
 	},
+	.stmt_cache = 1,
 
 	.init    = (void*)sqdb_sqlite_init,
 	.final   = (void*)sqdb_sqlite_final,
@@ -53,6 +65,12 @@ static const SqdbInfo dbinfo = {
 	.close   = (void*)sqdb_sqlite_close,
 	.exec    = (void*)sqdb_sqlite_exec,
 	.migrate = (void*)sqdb_sqlite_migrate,
+
+	.prepare  = (void*)sqdb_sqlite_prepare,
+	.bind     = (void*)sqdb_sqlite_bind,
+	.step     = (void*)sqdb_sqlite_step,
+	.reset    = (void*)sqdb_sqlite_reset,
+	.finalize = (void*)sqdb_sqlite_finalize,
 };
 
 const SqdbInfo *SQDB_INFO_SQLITE = &dbinfo;
@@ -63,25 +81,60 @@ const SqdbInfo *SQDB_INFO_SQLITE = &dbinfo;
 static void sqdb_sqlite_recreate_table(SqdbSqlite *db, SqBuffer *sql_buf, SqTable *table);
 static void sqdb_sqlite_create_indexes(SqdbSqlite *db, SqBuffer *sql_buf, SqTable *table);
 static bool sqdb_sqlite_alter_table(SqdbSqlite *db, SqBuffer *sql_buf, SqTable *table);
+static sqlite3_stmt *sqdb_sqlite_cache_prepare(SqdbSqlite *sqdb, const char *sql, bool in_use);
+static Sqxc *sqdb_sqlite_stmt_send_row(sqlite3_stmt *stmt, Sqxc *xc);
+static void  sqdb_sqlite_apply_profile(SqdbSqlite *sqdb);
+static void  sqdb_sqlite_profile_merge(SqdbSqliteProfile *profile, int preset, const SqdbSqliteProfile *src);
+
+// element of prepared statement cache (LRU)
+struct SqdbSqliteCached
+{
+	char          *sql;      // normalized SQL statement
+	unsigned int   hash;
+	sqlite3_stmt  *stmt;
+	bool           in_use;   // returned by sqdb_sqlite_prepare() and not finalized yet
+};
+
 #if DEBUG
 static int  debug_callback(void *user_data, int argc, char **argv, char **columnName);
 #endif
 
 static void sqdb_sqlite_init(SqdbSqlite *sqdb, SqdbConfigSqlite *config_src)
 {
+	int  stmt_cache_size = 0;
+
+	memset(&sqdb->profile, 0, sizeof(SqdbSqliteProfile));
 	if (config_src) {
-		sqdb->extension = strdup(config_src->extension);
-		sqdb->folder = strdup(config_src->folder);
+		sqdb->extension = (config_src->extension) ? strdup(config_src->extension) : NULL;
+		sqdb->folder = (config_src->folder) ? strdup(config_src->folder) : NULL;
+		stmt_cache_size = config_src->stmt_cache_size;
+		sqdb_sqlite_profile_merge(&sqdb->profile, config_src->preset, &config_src->profile);
 	}
 	else {
 		sqdb->extension = NULL;
 		sqdb->folder = NULL;
 	}
 	sqdb->version = 0;
+	sqdb->stats = NULL;
+	sqdb->self = NULL;
+
+	// prepared statement cache
+	sqdb->cache.entries  = NULL;
+	sqdb->cache.length   = 0;
+	sqdb->cache.capacity = 0;
+	sqdb->cache.hits     = 0;
+	sqdb->cache.misses   = 0;
+	sq_buffer_init(&sqdb->cache.key);
+	if (stmt_cache_size == 0)
+		stmt_cache_size = SQ_CONFIG_SQLITE_STMT_CACHE_SIZE_DEFAULT;
+	if (stmt_cache_size > 0)
+		sqdb_sqlite_set_stmt_cache_size(sqdb, stmt_cache_size);
 }
 
 static void sqdb_sqlite_final(SqdbSqlite *sqdb)
 {
+	sqdb_sqlite_set_stmt_cache_size(sqdb, 0);
+	sq_buffer_final(&sqdb->cache.key);
 	free(sqdb->extension);
 	free(sqdb->folder);
 }
@@ -100,26 +153,42 @@ static int  sqdb_sqlite_open(SqdbSqlite *sqdb, const char *database_name)
 	int   len;
 	int   rc;
 
-	if (ext == NULL)
-		ext = "db";
-	if (folder == NULL)
-		folder = ".";
-	len = snprintf(NULL, 0, "%s/%s.%s", folder, database_name, ext) + 1;
-	buf = malloc(len);
-	snprintf(buf, len, "%s/%s.%s", folder, database_name, ext);
-
-	rc = sqlite3_open(buf, &sqdb->self);
-	free(buf);
+	if (strcmp(database_name, ":memory:") == 0)
+		rc = sqlite3_open(database_name, &sqdb->self);
+	else {
+		if (ext == NULL)
+			ext = "db";
+		if (folder == NULL)
+			folder = ".";
+		len = snprintf(NULL, 0, "%s/%s.%s", folder, database_name, ext) + 1;
+		buf = malloc(len);
+		snprintf(buf, len, "%s/%s.%s", folder, database_name, ext);
+
+		rc = sqlite3_open(buf, &sqdb->self);
+		free(buf);
+	}
 
 	if (rc != SQLITE_OK)
 		return SQCODE_OPEN_FAIL;
+	sqdb_sqlite_apply_profile(sqdb);
 	rc = sqlite3_exec(sqdb->self, "PRAGMA user_version;", int_callback, &sqdb->version, NULL);
 	return SQCODE_OK;
 }
 
 static int  sqdb_sqlite_close(SqdbSqlite *sqdb)
 {
+	// finalize cached statements. Statements that are still in use will be finalized by sqdb_sqlite_finalize().
+	sqdb_sqlite_clear_stmt_cache(sqdb);
+	if (sqdb->profile.optimize > 0)
+		sqlite3_exec(sqdb->self, "PRAGMA optimize;", NULL, NULL, NULL);
+	// sqlite3_close() returns SQLITE_BUSY and keeps database open if there are unfinalized statements.
+	// sqlite3_close_v2() closes database after the last statement is finalized.
+#if SQLITE_VERSION_NUMBER >= SQLITE_VERSION_NUMBER_3_7_14
+	sqlite3_close_v2(sqdb->self);
+#else
 	sqlite3_close(sqdb->self);
+#endif
+	sqdb->self = NULL;
 	return SQCODE_OK;
 }
 
@@ -146,6 +215,9 @@ static int  sqdb_sqlite_migrate_sync(SqdbSqlite *sqdb, SqSchema *schema)
 	// buffer for SQL statement
 	sq_buffer_init(&sql_buf);
 
+	// cached prepared statements may refer to tables/columns that will be changed.
+	sqdb_sqlite_clear_stmt_cache(sqdb);
+
 	// trace renamed (or dropped) table/column that was referenced by others
 	sq_schema_trace_name(schema);
 
@@ -236,8 +308,8 @@ static int  sqdb_sqlite_migrate_sync(SqdbSqlite *sqdb, SqSchema *schema)
 	// update SQLite.user_version
 	sqdb->version = schema->version;
 	sql_buf.writed = 0;
-	sq_buffer_alloc(&sql_buf, snprintf(NULL, 0, "PRAGMA user_version = %d", sqdb->version));
-	sprintf(sql_buf.buf, "PRAGMA user_version = %d", sqdb->version);
+	sq_buffer_write(&sql_buf, "PRAGMA user_version = ");
+	sq_buffer_write_int64(&sql_buf, sqdb->version);
 //	sq_buffer_write_c(&sql_buf, 0);  // null-terminated
 #ifdef DEBUG
 	fprintf(stderr, "SQL: %s\n", sql_buf.buf);
@@ -332,6 +404,7 @@ static int query_callback(void *user_data, int argc, char **argv, char **columnN
 
 	// xc may be changed by sqxc_send()
 	*(Sqxc**)user_data = xc;
+	sqdb_stats_add_rows(1);
 
 	return 0;
 }
@@ -346,7 +419,7 @@ static int insert_callback(void *user_data, int argc, char **argv, char **column
 			row[index] = strtol(argv[index], NULL, 10);
 	}
 #else
-	sqxc_sql_id(xc) = strtol(argv[0], NULL, 10);
+	sqxc_sql_id(xc) = strtoll(argv[0], NULL, 10);
 #endif
 
 	return 0;
@@ -366,14 +439,102 @@ static int  debug_callback(void *user_data, int argc, char **argv, char **column
 
 static int  sqdb_sqlite_exec(SqdbSqlite *sqdb, const char *sql, Sqxc *xc, void *reserve)
 {
+	sqlite3_stmt *stmt;
+	const char   *tail;
+	bool  cached = true;
+	int   n_rows = 0;
 	int   rc;
-	char *errorMsg;
+	char *errorMsg = NULL;
 
 #ifdef DEBUG
 	fprintf(stderr, "SQL: %s\n", sql);
 #endif
 
-	if (xc == NULL) {
+	// run cached prepared statement if possible
+	stmt = sqdb_sqlite_cache_prepare(sqdb, sql, false);
+	// SELECT command always use prepared statement to get typed column values.
+	if (stmt == NULL && xc && (sql[0] == 'S' || sql[0] == 's')) {
+		cached = false;
+		rc = sqlite3_prepare_v2(sqdb->self, sql, -1, &stmt, &tail);
+		if (rc == SQLITE_OK && stmt) {
+			// use sqlite3_exec() if there are multiple statements
+			tail += strspn(tail, " \t\r\n;");
+			if (*tail) {
+				sqlite3_finalize(stmt);
+				stmt = NULL;
+			}
+		}
+		else {
+			sqlite3_finalize(stmt);
+			stmt = NULL;
+		}
+	}
+
+	if (stmt) {
+		if (xc == NULL) {
+			while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+				;
+		}
+		else {
+			switch (sql[0]) {
+			case 'S':    // SELECT
+			case 's':    // select
+#ifdef DEBUG
+				if (xc->info != SQXC_INFO_VALUE) {
+					fprintf(stderr, "sqdb_sqlite_exec(): SELECT command must use with SqxcValue.\n");
+					rc = SQLITE_MISUSE;
+					break;
+				}
+#endif
+				// if Sqxc element prepare for multiple row
+				if (sqxc_value_current(xc) == sqxc_value_container(xc)) {
+					xc->type = SQXC_TYPE_ARRAY;
+					xc->name = NULL;
+					xc->value.pointer = NULL;
+					xc = sqxc_send(xc);
+				}
+				while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+					xc = sqdb_sqlite_stmt_send_row(stmt, xc);
+					if (xc->code != SQCODE_OK) {
+						rc = SQLITE_ABORT;
+						break;
+					}
+					n_rows++;
+				}
+				sqdb_stats_add_rows(n_rows);
+				// if Sqxc element prepare for multiple row
+				if (sqxc_value_current(xc) == sqxc_value_container(xc)) {
+					xc->type = SQXC_TYPE_ARRAY_END;
+					xc->name = NULL;
+//					xc->value.pointer = NULL;
+					xc = sqxc_send(xc);
+				}
+				break;
+
+			case 'I':    // INSERT
+			case 'i':    // insert
+#ifdef DEBUG
+				if (xc->info != SQXC_INFO_SQL) {
+					fprintf(stderr, "sqdb_sqlite_exec(): INSERT command must use with SqxcSql.\n");
+					rc = SQLITE_MISUSE;
+					break;
+				}
+#endif
+			default:
+				while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+					;
+				break;
+			}
+		}
+		if (rc == SQLITE_DONE)
+			rc = SQLITE_OK;
+		// release statement, cached one will be reused next time.
+		if (cached)
+			sqlite3_reset(stmt);
+		else
+			sqlite3_finalize(stmt);
+	}
+	else if (xc == NULL) {
 #ifdef DEBUG
 		rc = sqlite3_exec(sqdb->self, sql, debug_callback, NULL, &errorMsg);
 #else
@@ -421,17 +582,377 @@ static int  sqdb_sqlite_exec(SqdbSqlite *sqdb, const char *sql, Sqxc *xc, void *
 		}
 	}
 
-	// check return value of sqlite3_exec()
+	// check return value of sqlite3_exec() or sqlite3_step()
 	if (rc != SQLITE_OK) {
 #if DEBUG
-		fprintf(stderr, "SQLite: %s\n", errorMsg);
+		fprintf(stderr, "SQLite: %s\n", (errorMsg) ? errorMsg : sqlite3_errmsg(sqdb->self));
+#endif
 		sqlite3_free(errorMsg);
+		return SQCODE_EXEC_ERROR;
+	}
+
+	// INSERT command: get id of the last inserted row
+	if (xc && xc->info == SQXC_INFO_SQL && (sql[0] == 'I' || sql[0] == 'i'))
+		sqxc_sql_id(xc) = sqlite3_last_insert_rowid(sqdb->self);
+	return SQCODE_OK;
+}
+
+// ----------------------------------------------------------------------------
+// prepared statement. SqdbStmt is sqlite3_stmt in SqdbSqlite.
+
+static int  sqdb_sqlite_prepare(SqdbSqlite *sqdb, const char *sql, SqdbStmt **stmt)
+{
+	int   rc;
+
+#ifdef DEBUG
+	fprintf(stderr, "SQL prepare: %s\n", sql);
+#endif
+
+	// use cached prepared statement if possible. It will be reset by sqdb_sqlite_finalize()
+	*stmt = (SqdbStmt*)sqdb_sqlite_cache_prepare(sqdb, sql, true);
+	if (*stmt)
+		return SQCODE_OK;
+
+#if SQLITE_VERSION_NUMBER >= SQLITE_VERSION_NUMBER_3_20
+	// statement will be retained for a long time and probably reused many times.
+	rc = sqlite3_prepare_v3(sqdb->self, sql, -1, SQLITE_PREPARE_PERSISTENT,
+	                        (sqlite3_stmt**)stmt, NULL);
+#else
+	rc = sqlite3_prepare_v2(sqdb->self, sql, -1, (sqlite3_stmt**)stmt, NULL);
+#endif
+
+	if (rc != SQLITE_OK) {
+#ifdef DEBUG
+		fprintf(stderr, "SQLite: %s\n", sqlite3_errmsg(sqdb->self));
+#endif
+		*stmt = NULL;
+		return SQCODE_EXEC_ERROR;
+	}
+	return SQCODE_OK;
+}
+
+static int  sqdb_sqlite_bind(SqdbSqlite *sqdb, SqdbStmt *stmt, int index, Sqxc *src)
+{
+	sqlite3_stmt *self = (sqlite3_stmt*)stmt;
+	char  timestr[SQ_TIME_STR_SIZE];
+	int   rc, len;
+
+	switch (src->type) {
+	case SQXC_TYPE_BOOL:
+		rc = sqlite3_bind_int(self, index, src->value.boolean);
+		break;
+
+	case SQXC_TYPE_INT:
+		rc = sqlite3_bind_int(self, index, src->value.integer);
+		break;
+
+	case SQXC_TYPE_UINT:
+		rc = sqlite3_bind_int64(self, index, src->value.uint);
+		break;
+
+	case SQXC_TYPE_INT64:
+	case SQXC_TYPE_UINT64:
+		rc = sqlite3_bind_int64(self, index, src->value.int64);
+		break;
+
+	case SQXC_TYPE_TIME:
+		// SQLite store time as string. SQLITE_TRANSIENT make SQLite copy it.
+		len = sq_time_to_str(timestr, src->value.rawtime, SQ_TIME_USE_UTC);
+		rc = sqlite3_bind_text(self, index, timestr, len, SQLITE_TRANSIENT);
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		rc = sqlite3_bind_double(self, index, src->value.double_);
+		break;
+
+	case SQXC_TYPE_STRING:
+		if (src->value.string == NULL)
+			rc = sqlite3_bind_null(self, index);
+		else
+			rc = sqlite3_bind_text(self, index, src->value.string, -1, SQLITE_TRANSIENT);
+		break;
+
+	default:
+		return (src->code = SQCODE_TYPE_NOT_SUPPORT);
+	}
+
+	if (rc != SQLITE_OK) {
+#ifdef DEBUG
+		fprintf(stderr, "SQLite: %s\n", sqlite3_errmsg(sqdb->self));
+#endif
+		return (src->code = SQCODE_EXEC_ERROR);
+	}
+	return (src->code = SQCODE_OK);
+}
+
+// send a row of 'stmt' to 'xc'
+static Sqxc *sqdb_sqlite_stmt_send_row(sqlite3_stmt *stmt, Sqxc *xc)
+{
+	int   index, count;
+
+	xc->type = SQXC_TYPE_OBJECT;
+	xc->name = NULL;
+	xc->value.pointer = NULL;
+	xc = sqxc_send(xc);
+	if (xc->code != SQCODE_OK)
+		return xc;
+
+	count = sqlite3_column_count(stmt);
+	for (index = 0;  index < count;  index++) {
+		// send native value. It can avoid converting between integer and text.
+		switch (sqlite3_column_type(stmt, index)) {
+		case SQLITE_INTEGER:
+			xc->type = SQXC_TYPE_INT64;
+			xc->value.int64 = sqlite3_column_int64(stmt, index);
+			break;
+
+		case SQLITE_FLOAT:
+			xc->type = SQXC_TYPE_DOUBLE;
+			xc->value.double_ = sqlite3_column_double(stmt, index);
+			break;
+
+		case SQLITE_NULL:
+			xc->type = SQXC_TYPE_STRING;
+			xc->value.string = NULL;
+			break;
+
+		default:    // SQLITE_TEXT, SQLITE_BLOB
+			xc->type = SQXC_TYPE_STRING;
+			xc->value.string = (char*)sqlite3_column_text(stmt, index);
+			break;
+		}
+		xc->name = sqlite3_column_name(stmt, index);
+		xc = sqxc_send(xc);
+
+#ifdef DEBUG
+		switch (xc->code) {
+		case SQCODE_OK:
+			break;
+
+		case SQCODE_ENTRY_NOT_FOUND:
+			fprintf(stderr, "sqdb_sqlite_step(): column '%s' not found.\n", sqlite3_column_name(stmt, index));
+			break;
+
+		default:
+			fprintf(stderr, "sqdb_sqlite_step(): error occurred during parsing column '%s'.\n", sqlite3_column_name(stmt, index));
+			break;
+		}
+#endif  // DEBUG
+	}
+
+	xc->type = SQXC_TYPE_OBJECT_END;
+	xc->name = NULL;
+	xc->value.pointer = NULL;
+	xc = sqxc_send(xc);
+	return xc;
+}
+
+static int  sqdb_sqlite_step(SqdbSqlite *sqdb, SqdbStmt *stmt, Sqxc *xc)
+{
+	int   rc;
+
+	rc = sqlite3_step((sqlite3_stmt*)stmt);
+	switch (rc) {
+	case SQLITE_ROW:
+		if (xc)
+			sqdb_sqlite_stmt_send_row((sqlite3_stmt*)stmt, xc);
+		return SQCODE_ROW;
+
+	case SQLITE_DONE:
+		// INSERT command: get id of the last inserted row
+		if (xc && xc->info == SQXC_INFO_SQL)
+			sqxc_sql_id(xc) = sqlite3_last_insert_rowid(sqdb->self);
+		return SQCODE_DONE;
+
+	default:
+#ifdef DEBUG
+		fprintf(stderr, "SQLite: %s\n", sqlite3_errmsg(sqdb->self));
 #endif
 		return SQCODE_EXEC_ERROR;
 	}
+}
+
+static int  sqdb_sqlite_reset(SqdbSqlite *sqdb, SqdbStmt *stmt)
+{
+	// sqlite3_reset() return error code of the most recent sqlite3_step(). It can be ignored here.
+	sqlite3_reset((sqlite3_stmt*)stmt);
+	sqlite3_clear_bindings((sqlite3_stmt*)stmt);
+	return SQCODE_OK;
+}
+
+static int  sqdb_sqlite_finalize(SqdbSqlite *sqdb, SqdbStmt *stmt)
+{
+	SqdbSqliteCached *entries = sqdb->cache.entries;
+
+	// return cached statement to cache
+	for (int index = 0;  index < sqdb->cache.length;  index++) {
+		if (entries[index].stmt == (sqlite3_stmt*)stmt && entries[index].in_use) {
+			entries[index].in_use = false;
+			sqlite3_reset((sqlite3_stmt*)stmt);
+			sqlite3_clear_bindings((sqlite3_stmt*)stmt);
+			return SQCODE_OK;
+		}
+	}
+	sqlite3_finalize((sqlite3_stmt*)stmt);
 	return SQCODE_OK;
 }
 
+// ----------------------------------------------------------------------------
+// prepared statement cache (LRU)
+
+// write normalized SQL statement to 'key' and calculate hash value of it.
+// Spaces are collapsed and trailing ';' is removed. Quoted strings and identifiers ('', "", ``, [])
+// are kept unchanged. return -1 if 'sql' has multiple statements or comments.
+static int  sqdb_sqlite_normalize(SqBuffer *key, const char *sql, unsigned int *hash)
+{
+	unsigned int  value = 2166136261u;    // FNV-1a
+	bool  space = false;
+	char  quote = 0;
+	char *dest;
+	char  ch;
+
+	key->writed = (int)strlen(sql) + 1;
+	if (key->size < key->writed)
+		sq_buffer_resize(key, key->writed);
+	dest = key->buf;
+
+	for (;  (ch = *sql);  sql++) {
+		if (quote) {
+			if (ch == quote)
+				quote = 0;
+		}
+		else if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+			// collapse spaces. leading and trailing spaces are removed.
+			space = (dest != key->buf);
+			continue;
+		}
+		else if ((ch == '-' && sql[1] == '-') || (ch == '/' && sql[1] == '*')) {
+			// comment may contain spaces or quotes. Don't cache it.
+			return -1;
+		}
+		else if (ch == ';') {
+			// remaining characters must be spaces or ';'
+			while ((ch = *++sql)) {
+				if (ch != ';' && ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
+					return -1;
+			}
+			break;
+		}
+		else if (ch == '\'' || ch == '"' || ch == '`')
+			quote = ch;
+		else if (ch == '[')
+			quote = ']';
+
+		if (space) {
+			space = false;
+			*dest++ = ' ';
+			value = (value ^ ' ') * 16777619u;
+		}
+		*dest++ = ch;
+		value = (value ^ (unsigned char)ch) * 16777619u;
+	}
+	*dest = 0;    // null-terminated
+	key->writed = (int)(dest - key->buf);
+	*hash = value;
+	return key->writed;
+}
+
+// return cached prepared statement, or prepare and cache it.
+// return NULL if cache is disabled, SQL statement is not DML, SQL has multiple statements,
+// or cached statement is in use.  Set 'in_use' to true if caller will hold statement after returning.
+static sqlite3_stmt *sqdb_sqlite_cache_prepare(SqdbSqlite *sqdb, const char *sql, bool in_use)
+{
+	SqdbSqliteCached  cached, *entries;
+	unsigned int  hash;
+	int   index, len, rc;
+
+	if (sqdb->cache.capacity == 0)
+		return NULL;
+	len = sqdb_sqlite_normalize(&sqdb->cache.key, sql, &hash);
+	if (len < 6)
+		return NULL;
+	// only cache SELECT, INSERT, UPDATE, and DELETE
+	sql = sqdb->cache.key.buf;
+	if (strncasecmp(sql, "SELECT", 6) && strncasecmp(sql, "INSERT", 6) &&
+	    strncasecmp(sql, "UPDATE", 6) && strncasecmp(sql, "DELETE", 6))
+		return NULL;
+
+	entries = sqdb->cache.entries;
+	for (index = 0;  index < sqdb->cache.length;  index++) {
+		if (entries[index].hash == hash && strcmp(entries[index].sql, sql) == 0) {
+			if (entries[index].in_use)
+				return NULL;
+			entries[index].in_use = in_use;
+			sqdb->cache.hits++;
+			// move to front (most recently used)
+			cached = entries[index];
+			memmove(entries + 1, entries, sizeof(SqdbSqliteCached) * index);
+			entries[0] = cached;
+			return cached.stmt;
+		}
+	}
+
+	sqdb->cache.misses++;
+#if SQLITE_VERSION_NUMBER >= SQLITE_VERSION_NUMBER_3_20
+	rc = sqlite3_prepare_v3(sqdb->self, sql, len, SQLITE_PREPARE_PERSISTENT, &cached.stmt, NULL);
+#else
+	rc = sqlite3_prepare_v2(sqdb->self, sql, len, &cached.stmt, NULL);
+#endif
+	// let caller use sqlite3_exec() to report error
+	if (rc != SQLITE_OK)
+		return NULL;
+
+	// remove least recently used one. statement in use will be finalized by sqdb_sqlite_finalize()
+	if (sqdb->cache.length == sqdb->cache.capacity) {
+		sqdb->cache.length--;
+		if (entries[sqdb->cache.length].in_use == false)
+			sqlite3_finalize(entries[sqdb->cache.length].stmt);
+		free(entries[sqdb->cache.length].sql);
+	}
+	memmove(entries + 1, entries, sizeof(SqdbSqliteCached) * sqdb->cache.length);
+	sqdb->cache.length++;
+	entries[0].sql  = memcpy(malloc(len + 1), sql, len + 1);
+	entries[0].hash = hash;
+	entries[0].stmt = cached.stmt;
+	entries[0].in_use = in_use;
+	return cached.stmt;
+}
+
+void  sqdb_sqlite_set_stmt_cache_size(SqdbSqlite *sqdb, int capacity)
+{
+	SqdbSqliteCached *entries = sqdb->cache.entries;
+
+	if (capacity < 0)
+		capacity = 0;
+	// remove least recently used ones
+	while (sqdb->cache.length > capacity) {
+		sqdb->cache.length--;
+		if (entries[sqdb->cache.length].in_use == false)
+			sqlite3_finalize(entries[sqdb->cache.length].stmt);
+		free(entries[sqdb->cache.length].sql);
+	}
+
+	if (capacity == 0) {
+		free(entries);
+		sqdb->cache.entries = NULL;
+	}
+	else
+		sqdb->cache.entries = realloc(entries, sizeof(SqdbSqliteCached) * capacity);
+	sqdb->cache.capacity = capacity;
+}
+
+void  sqdb_sqlite_clear_stmt_cache(SqdbSqlite *sqdb)
+{
+	SqdbSqliteCached *entries = sqdb->cache.entries;
+
+	for (int index = 0;  index < sqdb->cache.length;  index++) {
+		if (entries[index].in_use == false)
+			sqlite3_finalize(entries[index].stmt);
+		free(entries[index].sql);
+	}
+	sqdb->cache.length = 0;
+}
+
 // ----------------------------------------------------------------------------
 
 // write exist columns
@@ -577,3 +1098,125 @@ static bool sqdb_sqlite_alter_table(SqdbSqlite *db, SqBuffer *sql_buf, SqTable *
 
 	return true;
 }
+
+// ----------------------------------------------------------------------------
+// performance profile
+
+static const SqdbSqliteProfile profile_presets[] = {
+	// SQDB_SQLITE_PRESET_NONE
+	{0},
+	// SQDB_SQLITE_PRESET_DURABLE
+	{
+		.journal_mode = SQDB_SQLITE_JOURNAL_WAL,
+		.synchronous  = SQDB_SQLITE_SYNC_FULL,
+		.busy_timeout = SQ_CONFIG_SQLITE_BUSY_TIMEOUT_DEFAULT,
+		.optimize     = 1,
+	},
+	// SQDB_SQLITE_PRESET_BALANCED
+	{
+		.journal_mode = SQDB_SQLITE_JOURNAL_WAL,
+		.synchronous  = SQDB_SQLITE_SYNC_NORMAL,
+		.temp_store   = SQDB_SQLITE_TEMP_STORE_MEMORY,
+		.cache_size   = -16384,                 // 16 MiB
+		.mmap_size    = 256 * 1024 * 1024,
+		.busy_timeout = SQ_CONFIG_SQLITE_BUSY_TIMEOUT_DEFAULT,
+		.optimize     = 1,
+	},
+	// SQDB_SQLITE_PRESET_BULK_LOAD
+	{
+		.journal_mode = SQDB_SQLITE_JOURNAL_MEMORY,
+		.synchronous  = SQDB_SQLITE_SYNC_OFF,
+		.temp_store   = SQDB_SQLITE_TEMP_STORE_MEMORY,
+		.cache_size   = -65536,                 // 64 MiB
+		.mmap_size    = 256 * 1024 * 1024,
+		.busy_timeout = SQ_CONFIG_SQLITE_BUSY_TIMEOUT_DEFAULT,
+		.optimize     = 1,
+	},
+};
+
+#define N_PROFILE_PRESETS    ((int)(sizeof(profile_presets) / sizeof(profile_presets[0])))
+
+// index is value of SqdbSqliteJournal, SqdbSqliteSync, and SqdbSqliteTempStore
+static const char *journal_mode_names[] = {NULL, "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+static const char *synchronous_names[]  = {NULL, "OFF", "NORMAL", "FULL", "EXTRA"};
+static const char *temp_store_names[]   = {NULL, "FILE", "MEMORY"};
+
+bool  sqdb_sqlite_profile_preset(SqdbSqliteProfile *profile, int preset)
+{
+	if (preset < 0 || preset >= N_PROFILE_PRESETS)
+		return false;
+	*profile = profile_presets[preset];
+	return true;
+}
+
+// 'profile' = 'preset' + fields that are not 0 in 'src'
+static void  sqdb_sqlite_profile_merge(SqdbSqliteProfile *profile, int preset, const SqdbSqliteProfile *src)
+{
+	if (sqdb_sqlite_profile_preset(profile, preset) == false) {
+#ifdef DEBUG
+		fprintf(stderr, "SqdbSqlite: unknown preset %d\n", preset);
+#endif
+		memset(profile, 0, sizeof(SqdbSqliteProfile));
+	}
+
+	if (src->journal_mode)
+		profile->journal_mode = src->journal_mode;
+	if (src->synchronous)
+		profile->synchronous = src->synchronous;
+	if (src->temp_store)
+		profile->temp_store = src->temp_store;
+	if (src->page_size)
+		profile->page_size = src->page_size;
+	if (src->cache_size)
+		profile->cache_size = src->cache_size;
+	if (src->busy_timeout)
+		profile->busy_timeout = src->busy_timeout;
+	if (src->mmap_size)
+		profile->mmap_size = src->mmap_size;
+	if (src->optimize)
+		profile->optimize = src->optimize;
+}
+
+static void  sqdb_sqlite_pragma(SqdbSqlite *sqdb, const char *name, const char *value)
+{
+	char  sql[80];
+	int   rc;
+
+	snprintf(sql, sizeof(sql), "PRAGMA %s = %s;", name, value);
+	rc = sqlite3_exec(sqdb->self, sql, NULL, NULL, NULL);
+#ifdef DEBUG
+	if (rc != SQLITE_OK)
+		fprintf(stderr, "SQLite: %s\n  %s\n", sql, sqlite3_errmsg(sqdb->self));
+#endif
+	(void)rc;
+}
+
+static void  sqdb_sqlite_apply_profile(SqdbSqlite *sqdb)
+{
+	SqdbSqliteProfile *profile = &sqdb->profile;
+	char  value[24];
+
+	if (profile->busy_timeout)
+		sqlite3_busy_timeout(sqdb->self, (profile->busy_timeout > 0) ? profile->busy_timeout : 0);
+
+	// page_size must be set before database file is created and before journal_mode is WAL.
+	if (profile->page_size > 0) {
+		snprintf(value, sizeof(value), "%d", profile->page_size);
+		sqdb_sqlite_pragma(sqdb, "page_size", value);
+	}
+	if (profile->journal_mode > 0 && profile->journal_mode <= SQDB_SQLITE_JOURNAL_OFF)
+		sqdb_sqlite_pragma(sqdb, "journal_mode", journal_mode_names[profile->journal_mode]);
+	if (profile->synchronous > 0 && profile->synchronous <= SQDB_SQLITE_SYNC_EXTRA)
+		sqdb_sqlite_pragma(sqdb, "synchronous", synchronous_names[profile->synchronous]);
+	if (profile->temp_store > 0 && profile->temp_store <= SQDB_SQLITE_TEMP_STORE_MEMORY)
+		sqdb_sqlite_pragma(sqdb, "temp_store", temp_store_names[profile->temp_store]);
+	if (profile->cache_size) {
+		snprintf(value, sizeof(value), "%d", profile->cache_size);
+		sqdb_sqlite_pragma(sqdb, "cache_size", value);
+	}
+	if (profile->mmap_size) {
+		snprintf(value, sizeof(value), "%lld",
+		         (profile->mmap_size > 0) ? (long long)profile->mmap_size : 0LL);
+		sqdb_sqlite_pragma(sqdb, "mmap_size", value);
+	}
+}
@@ -24,6 +24,43 @@
 
 typedef struct SqdbSqlite          SqdbSqlite;
 typedef struct SqdbConfigSqlite    SqdbConfigSqlite;
+typedef struct SqdbSqliteCached    SqdbSqliteCached;    // define in SqdbSqlite.c
+typedef struct SqdbSqliteProfile   SqdbSqliteProfile;
+
+// named performance profile. SqdbConfigSqlite.preset
+typedef enum SqdbSqlitePreset {
+	SQDB_SQLITE_PRESET_NONE,         // SQLite default
+	SQDB_SQLITE_PRESET_DURABLE,      // WAL, synchronous FULL
+	SQDB_SQLITE_PRESET_BALANCED,     // WAL, synchronous NORMAL, larger cache, mmap
+	SQDB_SQLITE_PRESET_BULK_LOAD,    // journal in memory, synchronous OFF. data may be lost if system crash.
+} SqdbSqlitePreset;
+
+// SqdbSqliteProfile.journal_mode
+typedef enum SqdbSqliteJournal {
+	SQDB_SQLITE_JOURNAL_DEFAULT,
+	SQDB_SQLITE_JOURNAL_DELETE,
+	SQDB_SQLITE_JOURNAL_TRUNCATE,
+	SQDB_SQLITE_JOURNAL_PERSIST,
+	SQDB_SQLITE_JOURNAL_MEMORY,
+	SQDB_SQLITE_JOURNAL_WAL,
+	SQDB_SQLITE_JOURNAL_OFF,
+} SqdbSqliteJournal;
+
+// SqdbSqliteProfile.synchronous
+typedef enum SqdbSqliteSync {
+	SQDB_SQLITE_SYNC_DEFAULT,
+	SQDB_SQLITE_SYNC_OFF,
+	SQDB_SQLITE_SYNC_NORMAL,
+	SQDB_SQLITE_SYNC_FULL,
+	SQDB_SQLITE_SYNC_EXTRA,
+} SqdbSqliteSync;
+
+// SqdbSqliteProfile.temp_store
+typedef enum SqdbSqliteTempStore {
+	SQDB_SQLITE_TEMP_STORE_DEFAULT,
+	SQDB_SQLITE_TEMP_STORE_FILE,
+	SQDB_SQLITE_TEMP_STORE_MEMORY,
+} SqdbSqliteTempStore;
 
 // ----------------------------------------------------------------------------
 // C declarations: declare C data, function, and others.
@@ -36,6 +73,19 @@ extern const SqdbInfo    *SQDB_INFO_SQLITE;
 
 #define sqdb_sqlite_new(sqdb_config)    sqdb_new(SQDB_INFO_SQLITE, sqdb_config)
 
+/* --- prepared statement cache --- */
+
+// change capacity of prepared statement cache. 0 disable cache.
+void  sqdb_sqlite_set_stmt_cache_size(SqdbSqlite *sqdb, int capacity);
+
+// finalize all cached prepared statements
+void  sqdb_sqlite_clear_stmt_cache(SqdbSqlite *sqdb);
+
+/* --- performance profile --- */
+
+// set 'profile' to values of 'preset'. return false if 'preset' is unknown.
+bool  sqdb_sqlite_profile_preset(SqdbSqliteProfile *profile, int preset);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -43,6 +93,23 @@ extern const SqdbInfo    *SQDB_INFO_SQLITE;
 // ----------------------------------------------------------------------------
 // C/C++ common definitions: define structue
 
+/*
+    SqdbSqliteProfile - performance settings that are applied by sqdb_open()
+
+    0 means "not set": the value of preset (or SQLite default) is used.
+ */
+struct SqdbSqliteProfile
+{
+	int             journal_mode;   // SqdbSqliteJournal
+	int             synchronous;    // SqdbSqliteSync
+	int             temp_store;     // SqdbSqliteTempStore
+	int             page_size;      // bytes. It only applies to new database file.
+	int             cache_size;     // PRAGMA cache_size. number of pages if > 0, KiB if < 0.
+	int             busy_timeout;   // milliseconds. -1 = disabled
+	sqlite3_int64   mmap_size;      // bytes. -1 = disabled
+	int             optimize;       // run "PRAGMA optimize" on close. 1 = yes, -1 = no
+};
+
 /*
     SqdbSqlite - Sqdb for SQLite
 
@@ -69,12 +136,28 @@ struct SqdbSqlite
 
 	// schema version in SQL database
 	int             version;
+
+	// statistics of statements
+	SqdbStats      *stats;
  */
 
 	// ------ SqdbSqlite members ------    // <-- 3. Add variable and non-virtual function in derived struct.
 	sqlite3        *self;
 	char           *folder;
 	char           *extension;   // optional
+
+	// LRU cache of prepared statements. key is normalized SQL statement.
+	struct {
+		SqdbSqliteCached *entries;   // most recently used first
+		int               length;
+		int               capacity;  // 0 = disabled
+		unsigned int      hits;
+		unsigned int      misses;
+		SqBuffer          key;       // buffer for normalized SQL statement
+	} cache;
+
+	// performance settings. It is merged from SqdbConfigSqlite.preset and SqdbConfigSqlite.profile
+	SqdbSqliteProfile  profile;
 };
 
 /*
@@ -95,8 +178,14 @@ struct SqdbConfigSqlite
  */
 
 	// ------ SqdbConfigSqlite members ------
-	const char     *folder;
+	const char     *folder;      // ignored if database_name is ":memory:"
 	const char     *extension;   // optional
+
+	int             stmt_cache_size;  // capacity of prepared statement cache. 0 = default, -1 = disabled
+
+	// performance settings. Fields that are not 0 in 'profile' override values of 'preset'.
+	int                preset;   // SqdbSqlitePreset
+	SqdbSqliteProfile  profile;
 };
 
 // ----------------------------------------------------------------------------
@@ -107,6 +196,7 @@ struct SqdbConfigSqlite
 namespace Sq {
 
 typedef struct SqdbConfigSqlite    DbConfigSqlite;
+typedef struct SqdbSqliteProfile   DbSqliteProfile;
 
 // conforming C++11 standard-layout
 // These are for directly use only. You can NOT derived it.
@@ -118,6 +208,13 @@ struct DbSqlite : SqdbSqlite
 	~DbSqlite() {
 		SQDB_INFO_SQLITE->final((Sqdb*)this);
 	}
+
+	void  setStmtCacheSize(int capacity) {
+		sqdb_sqlite_set_stmt_cache_size((SqdbSqlite*)this, capacity);
+	}
+	void  clearStmtCache(void) {
+		sqdb_sqlite_clear_stmt_cache((SqdbSqlite*)this);
+	}
 };
 
 };  // namespace Sq
@@ -0,0 +1,607 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#if defined(_MSC_VER)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stddef.h>     // offsetof
+#include <stdlib.h>     // malloc, calloc, free
+#include <string.h>     // memcpy, memcmp, memchr, memset, strlen, strchr, strcmp
+#include <time.h>       // clock_gettime
+
+#include <SqConfig.h>
+#include <SqError.h>
+#include <SqdbStats.h>
+
+#define STATS_BUCKETS_DEFAULT    64
+#define FINGERPRINT_STACK_SIZE   256
+
+struct SqdbStatsNode
+{
+	SqdbStatsNode  *next;          // next node in the same bucket
+	unsigned int    hash;
+	SqdbStatsEntry  entry;
+	char            fingerprint[1];
+};
+
+// prepared statement that is not finalized
+struct SqdbStatsStmt
+{
+	SqdbStatsStmt  *next;
+	SqdbStmt       *stmt;
+	SqdbStatsNode  *node;
+	int64_t         elapsed;       // nanoseconds
+	unsigned int    rows;
+	bool            stepped;
+	bool            failed;
+};
+
+// fingerprint and hash of SQL statement. It is computed before locking 'stats->mutex'.
+typedef struct StatsKey
+{
+	char           *fingerprint;
+	int             length;
+	unsigned int    hash;
+	char            buffer[FINGERPRINT_STACK_SIZE];
+} StatsKey;
+
+// rows that were sent by exec() in this thread
+static SQ_THREAD_LOCAL unsigned int  stats_rows;
+
+// ----------------------------------------------------------------------------
+// static functions
+
+// monotonic time in nanoseconds
+static int64_t  stats_now(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	static LARGE_INTEGER  frequency;
+	LARGE_INTEGER  counter;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (int64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000 +
+	       (int64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#else
+	struct timespec  ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static void  stats_resize(SqdbStats *stats)
+{
+	SqdbStatsNode **buckets, *node, *next;
+	unsigned int    n_buckets = stats->n_buckets * 2;
+
+	buckets = calloc(n_buckets, sizeof(SqdbStatsNode*));
+	for (unsigned int index = 0;  index < stats->n_buckets;  index++) {
+		for (node = stats->buckets[index];  node;  node = next) {
+			next = node->next;
+			node->next = buckets[node->hash & (n_buckets - 1)];
+			buckets[node->hash & (n_buckets - 1)] = node;
+		}
+	}
+	free(stats->buckets);
+	stats->buckets = buckets;
+	stats->n_buckets = n_buckets;
+}
+
+static void  stats_key_init(StatsKey *key, const char *sql)
+{
+	unsigned int  hash = 2166136261u;    // FNV-1a
+	int           length;
+
+	length = (int)strlen(sql);
+	key->fingerprint = (length < FINGERPRINT_STACK_SIZE) ? key->buffer : malloc(length + 1);
+	length = sqdb_stats_fingerprint(key->fingerprint, sql);
+	for (int index = 0;  index < length;  index++)
+		hash = (hash ^ (unsigned char)key->fingerprint[index]) * 16777619u;
+	key->length = length;
+	key->hash = hash;
+}
+
+static void  stats_key_final(StatsKey *key)
+{
+	if (key->fingerprint != key->buffer)
+		free(key->fingerprint);
+}
+
+// 'stats->mutex' must be locked by caller
+static SqdbStatsNode *stats_find(SqdbStats *stats, StatsKey *key)
+{
+	SqdbStatsNode  *node, **bucket;
+
+	bucket = stats->buckets + (key->hash & (stats->n_buckets - 1));
+	for (node = *bucket;  node;  node = node->next) {
+		if (node->hash == key->hash && strcmp(node->fingerprint, key->fingerprint) == 0)
+			break;
+	}
+
+	if (node == NULL) {
+		node = calloc(1, sizeof(SqdbStatsNode) + key->length);
+		memcpy(node->fingerprint, key->fingerprint, key->length + 1);
+		node->entry.fingerprint = node->fingerprint;
+		node->hash = key->hash;
+		node->next = *bucket;
+		*bucket = node;
+		if (++stats->length > stats->n_buckets)
+			stats_resize(stats);
+	}
+	return node;
+}
+
+// 'stats->mutex' must be locked by caller
+static void  stats_add(SqdbStatsNode *node, int64_t elapsed, unsigned int rows, bool failed)
+{
+	SqdbStatsEntry *entry = &node->entry;
+	uint64_t        us = (uint64_t)elapsed / 1000;
+	int             index;
+
+	// index of histogram = number of bits in microseconds
+	for (index = 0;  us && index < SQDB_STATS_N_BUCKETS - 1;  index++)
+		us >>= 1;
+	entry->histogram[index]++;
+
+	entry->count++;
+	entry->rows += rows;
+	entry->total_ns += elapsed;
+	if (entry->max_ns < (uint64_t)elapsed)
+		entry->max_ns = elapsed;
+	if (failed)
+		entry->errors++;
+}
+
+static void  stats_log_slow(SqdbStats *stats, int64_t elapsed, unsigned int rows, const char *sql)
+{
+	FILE *slow_log = stats->slow_log;
+
+	if (slow_log && elapsed / 1000 >= stats->slow_threshold)
+		fprintf(slow_log, "SQL slow: %lld us, %u rows: %s\n", (long long)(elapsed / 1000), rows, sql);
+}
+
+// 'stats->mutex' must be locked by caller
+static SqdbStatsStmt *stats_find_stmt(SqdbStats *stats, SqdbStmt *stmt, bool unlink)
+{
+	SqdbStatsStmt **addr, *sstmt;
+
+	for (addr = &stats->stmts;  (sstmt = *addr);  addr = &sstmt->next) {
+		if (sstmt->stmt == stmt) {
+			if (unlink)
+				*addr = sstmt->next;
+			return sstmt;
+		}
+	}
+	return NULL;
+}
+
+static int  entry_compare(const void *a, const void *b)
+{
+	uint64_t  ta = (*(SqdbStatsEntry**)a)->total_ns;
+	uint64_t  tb = (*(SqdbStatsEntry**)b)->total_ns;
+
+	return (ta < tb) - (ta > tb);
+}
+
+// ----------------------------------------------------------------------------
+// SqdbStats
+
+SqdbStats *sqdb_stats_new(void)
+{
+	SqdbStats *stats;
+
+	stats = malloc(sizeof(SqdbStats));
+	sqdb_stats_init(stats);
+	return stats;
+}
+
+void  sqdb_stats_free(SqdbStats *stats)
+{
+	sqdb_stats_final(stats);
+	free(stats);
+}
+
+void  sqdb_stats_init(SqdbStats *stats)
+{
+	stats->n_buckets = STATS_BUCKETS_DEFAULT;
+	stats->buckets = calloc(stats->n_buckets, sizeof(SqdbStatsNode*));
+	stats->length = 0;
+	stats->stmts = NULL;
+	stats->slow_log = NULL;
+	stats->slow_threshold = SQ_CONFIG_SQDB_STATS_SLOW_THRESHOLD;
+	sq_mutex_init(&stats->mutex, false);
+}
+
+void  sqdb_stats_final(SqdbStats *stats)
+{
+	SqdbStatsNode *node, *next;
+	SqdbStatsStmt *sstmt, *sstmt_next;
+
+	for (unsigned int index = 0;  index < stats->n_buckets;  index++) {
+		for (node = stats->buckets[index];  node;  node = next) {
+			next = node->next;
+			free(node);
+		}
+	}
+	free(stats->buckets);
+	for (sstmt = stats->stmts;  sstmt;  sstmt = sstmt_next) {
+		sstmt_next = sstmt->next;
+		free(sstmt);
+	}
+	sq_mutex_final(&stats->mutex);
+}
+
+void  sqdb_stats_reset(SqdbStats *stats)
+{
+	SqdbStatsNode *node;
+
+	sq_mutex_lock(&stats->mutex);
+	for (unsigned int index = 0;  index < stats->n_buckets;  index++) {
+		for (node = stats->buckets[index];  node;  node = node->next) {
+			memset(&node->entry, 0, sizeof(SqdbStatsEntry));
+			node->entry.fingerprint = node->fingerprint;
+		}
+	}
+	sq_mutex_unlock(&stats->mutex);
+}
+
+SqPtrArray *sqdb_stats_snapshot(SqdbStats *stats, bool reset)
+{
+	SqPtrArray     *array;
+	SqdbStatsNode  *node;
+	SqdbStatsEntry *entry;
+	size_t          length;
+
+	sq_mutex_lock(&stats->mutex);
+	array = sq_ptr_array_new(stats->length, free);
+	for (unsigned int index = 0;  index < stats->n_buckets;  index++) {
+		for (node = stats->buckets[index];  node;  node = node->next) {
+			if (node->entry.count == 0)
+				continue;
+			length = strlen(node->fingerprint) + 1;
+			entry = malloc(sizeof(SqdbStatsEntry) + length);
+			*entry = node->entry;
+			entry->fingerprint = memcpy(entry + 1, node->fingerprint, length);
+			sq_ptr_array_append(array, entry);
+			if (reset) {
+				memset(&node->entry, 0, sizeof(SqdbStatsEntry));
+				node->entry.fingerprint = node->fingerprint;
+			}
+		}
+	}
+	sq_mutex_unlock(&stats->mutex);
+
+	sq_ptr_array_sort(array, entry_compare);
+	return array;
+}
+
+double  sqdb_stats_entry_percentile(const SqdbStatsEntry *entry, double percent)
+{
+	uint64_t  target, sum = 0;
+	double    us;
+	int       index;
+
+	if (entry->count == 0)
+		return 0;
+	target = (uint64_t)(entry->count * percent / 100.0 + 0.5);
+	if (target == 0)
+		target = 1;
+	for (index = 0;  index < SQDB_STATS_N_BUCKETS - 1;  index++) {
+		sum += entry->histogram[index];
+		if (sum >= target)
+			break;
+	}
+
+	us = (double)entry->max_ns / 1000.0;
+	if (index < SQDB_STATS_N_BUCKETS - 1 && (double)((uint64_t)1 << index) < us)
+		us = (double)((uint64_t)1 << index);
+	return us;
+}
+
+void  sqdb_stats_add_rows(int n_rows)
+{
+	stats_rows += n_rows;
+}
+
+// ----------------------------------------------------------------------------
+// fingerprint
+
+static int  fingerprint_is_word(char ch)
+{
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+	       (ch >= '0' && ch <= '9') || ch == '_' || ch == '$' || (unsigned char)ch >= 0x80;
+}
+
+// write placeholder for literal. "?, ?" become "?+"
+static int  fingerprint_placeholder(char *dest, int length)
+{
+	int  cur = length;
+
+	if (cur > 0 && dest[cur-1] == ' ')
+		cur--;
+	if (cur > 0 && dest[cur-1] == ',') {
+		cur--;
+		if (cur > 0 && dest[cur-1] == ' ')
+			cur--;
+		if (cur > 0 && dest[cur-1] == '+')
+			return cur;
+		if (cur > 0 && dest[cur-1] == '?') {
+			dest[cur] = '+';
+			return cur + 1;
+		}
+	}
+	dest[length] = '?';
+	return length + 1;
+}
+
+// ")" was written. "(?+), (?+)" become "(?+)"
+static int  fingerprint_tuple(char *dest, int length)
+{
+	int  begin, len, cur;
+
+	for (begin = length - 2;  begin >= 0;  begin--) {
+		if (dest[begin] == '(')
+			break;
+		if (strchr("?+, ", dest[begin]) == NULL)
+			return length;
+	}
+	if (begin < 0 || memchr(dest + begin, '?', length - begin) == NULL)
+		return length;
+	len = length - begin;
+
+	cur = begin;
+	if (cur > 0 && dest[cur-1] == ' ')
+		cur--;
+	if (cur == 0 || dest[cur-1] != ',')
+		return length;
+	cur--;
+	if (cur > 0 && dest[cur-1] == ' ')
+		cur--;
+	// previous tuple must not be arguments of function
+	if (cur >= len && memcmp(dest + cur - len, dest + begin, len) == 0 &&
+	    (cur == len || fingerprint_is_word(dest[cur - len - 1]) == 0))
+	{
+		return cur;
+	}
+	return length;
+}
+
+int   sqdb_stats_fingerprint(char *dest, const char *sql)
+{
+	const char *cur = sql;
+	char        close;
+	int         length = 0;
+
+	while (*cur) {
+		switch (*cur) {
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\n':
+			cur++;
+			if (length > 0 && dest[length-1] != ' ')
+				dest[length++] = ' ';
+			continue;
+
+		case '\'':
+			// string literal. '' is escaped quote.
+			for (cur++;  *cur;  cur++) {
+				if (*cur == '\'') {
+					if (cur[1] != '\'')
+						break;
+					cur++;
+				}
+				else if (*cur == '\\' && cur[1])
+					cur++;
+			}
+			if (*cur)
+				cur++;
+			length = fingerprint_placeholder(dest, length);
+			continue;
+
+		case '"':
+		case '`':
+		case '[':
+			// quoted identifier
+			close = (*cur == '[') ? ']' : *cur;
+			dest[length++] = *cur++;
+			while (*cur && *cur != close)
+				dest[length++] = *cur++;
+			if (*cur)
+				dest[length++] = *cur++;
+			continue;
+
+		case '-':
+			if (cur[1] == '-') {
+				// comment to end of line
+				while (*cur && *cur != '\n')
+					cur++;
+				continue;
+			}
+			break;
+
+		case '/':
+			if (cur[1] == '*') {
+				// comment block
+				for (cur += 2;  *cur && (cur[0] != '*' || cur[1] != '/');  cur++)
+					;
+				if (*cur)
+					cur += 2;
+				continue;
+			}
+			break;
+
+		case ')':
+			dest[length++] = *cur++;
+			length = fingerprint_tuple(dest, length);
+			continue;
+
+		default:
+			// number that is not a part of identifier
+			if (((*cur >= '0' && *cur <= '9') || (*cur == '.' && cur[1] >= '0' && cur[1] <= '9')) &&
+			    (length == 0 || fingerprint_is_word(dest[length-1]) == 0))
+			{
+				for (cur++;  fingerprint_is_word(*cur) || *cur == '.';  cur++) {
+					if ((*cur == 'e' || *cur == 'E') && (cur[1] == '+' || cur[1] == '-'))
+						cur++;
+				}
+				length = fingerprint_placeholder(dest, length);
+				continue;
+			}
+			break;
+		}
+		dest[length++] = *cur++;
+	}
+
+	if (length > 0 && dest[length-1] == ' ')
+		length--;
+	dest[length] = 0;
+	return length;
+}
+
+// ----------------------------------------------------------------------------
+// measure statement. These are called by macro functions in Sqdb.h
+
+int  sqdb_stats_exec(Sqdb *db, const char *sql, Sqxc *xc, void *reserve)
+{
+	SqdbStats    *stats = db->stats;
+	StatsKey      key;
+	unsigned int  rows = stats_rows;
+	int64_t       elapsed;
+	int           code;
+
+	elapsed = stats_now();
+	code = db->info->exec(db, sql, xc, reserve);
+	elapsed = stats_now() - elapsed;
+	rows = stats_rows - rows;
+
+	stats_key_init(&key, sql);
+	sq_mutex_lock(&stats->mutex);
+	stats_add(stats_find(stats, &key), elapsed, rows, code != SQCODE_OK);
+	sq_mutex_unlock(&stats->mutex);
+	stats_key_final(&key);
+
+	stats_log_slow(stats, elapsed, rows, sql);
+	return code;
+}
+
+int  sqdb_stats_prepare(Sqdb *db, const char *sql, SqdbStmt **stmt)
+{
+	SqdbStats     *stats = db->stats;
+	SqdbStatsStmt *sstmt = NULL, *stale = NULL;
+	StatsKey       key;
+	int64_t        elapsed;
+	int            code;
+
+	elapsed = stats_now();
+	code = db->info->prepare(db, sql, stmt);
+	elapsed = stats_now() - elapsed;
+
+	stats_key_init(&key, sql);
+	if (code == SQCODE_OK)
+		sstmt = malloc(sizeof(SqdbStatsStmt));
+	sq_mutex_lock(&stats->mutex);
+	if (code == SQCODE_OK) {
+		// If statement was finalized while stats was disabled, its SqdbStatsStmt is still in list.
+		// Sqdb returns the same address (e.g. cached statement) only after it was finalized.
+		stale = stats_find_stmt(stats, *stmt, true);
+		sstmt->stmt = *stmt;
+		sstmt->node = stats_find(stats, &key);
+		sstmt->elapsed = elapsed;
+		sstmt->rows = 0;
+		sstmt->stepped = false;
+		sstmt->failed = false;
+		sstmt->next = stats->stmts;
+		stats->stmts = sstmt;
+	}
+	else
+		stats_add(stats_find(stats, &key), elapsed, 0, true);
+	sq_mutex_unlock(&stats->mutex);
+	stats_key_final(&key);
+	free(stale);
+	return code;
+}
+
+int  sqdb_stats_stmt_step(Sqdb *db, SqdbStmt *stmt, Sqxc *xc)
+{
+	SqdbStats     *stats = db->stats;
+	SqdbStatsStmt *sstmt;
+	int64_t        elapsed;
+	int            code;
+
+	elapsed = stats_now();
+	code = db->info->step(db, stmt, xc);
+	elapsed = stats_now() - elapsed;
+
+	sq_mutex_lock(&stats->mutex);
+	sstmt = stats_find_stmt(stats, stmt, false);
+	if (sstmt) {
+		sstmt->elapsed += elapsed;
+		sstmt->stepped = true;
+		if (code == SQCODE_ROW)
+			sstmt->rows++;
+		else if (code != SQCODE_DONE && code != SQCODE_OK)
+			sstmt->failed = true;
+	}
+	sq_mutex_unlock(&stats->mutex);
+	return code;
+}
+
+int  sqdb_stats_stmt_reset(Sqdb *db, SqdbStmt *stmt)
+{
+	SqdbStats     *stats = db->stats;
+	SqdbStatsStmt *sstmt;
+	SqdbStatsStmt  sstmt_copy = {0};
+	int            code;
+
+	code = db->info->reset(db, stmt);
+
+	sq_mutex_lock(&stats->mutex);
+	sstmt = stats_find_stmt(stats, stmt, false);
+	if (sstmt && sstmt->stepped) {
+		sstmt_copy = *sstmt;
+		stats_add(sstmt->node, sstmt->elapsed, sstmt->rows, sstmt->failed);
+		sstmt->elapsed = 0;
+		sstmt->rows = 0;
+		sstmt->stepped = false;
+		sstmt->failed = false;
+	}
+	sq_mutex_unlock(&stats->mutex);
+
+	if (sstmt_copy.stepped)
+		stats_log_slow(stats, sstmt_copy.elapsed, sstmt_copy.rows, sstmt_copy.node->fingerprint);
+	return code;
+}
+
+int  sqdb_stats_stmt_finalize(Sqdb *db, SqdbStmt *stmt)
+{
+	SqdbStats     *stats = db->stats;
+	SqdbStatsStmt *sstmt;
+
+	sq_mutex_lock(&stats->mutex);
+	sstmt = stats_find_stmt(stats, stmt, true);
+	if (sstmt && sstmt->stepped)
+		stats_add(sstmt->node, sstmt->elapsed, sstmt->rows, sstmt->failed);
+	sq_mutex_unlock(&stats->mutex);
+
+	if (sstmt) {
+		if (sstmt->stepped)
+			stats_log_slow(stats, sstmt->elapsed, sstmt->rows, sstmt->node->fingerprint);
+		free(sstmt);
+	}
+	return db->info->finalize(db, stmt);
+}
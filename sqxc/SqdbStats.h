@@ -0,0 +1,156 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+/* ----------------------------------------------------------------------------
+	SqdbStats - statistics of SQL statements that run by Sqdb
+
+	Statements are grouped by fingerprint (SQL statement that literals are replaced by '?').
+	It is enabled by setting Sqdb.stats and disabled by setting Sqdb.stats to NULL.
+	If prepared statement is finalized while it is disabled, its record is dropped when Sqdb
+	prepares statement at the same address again, or when SqdbStats is freed.
+ */
+
+#ifndef SQDB_STATS_H
+#define SQDB_STATS_H
+
+#include <stdio.h>       // FILE
+#include <stdint.h>      // int64_t, uint64_t
+#include <stdbool.h>     // bool
+
+#include <SqPtrArray.h>
+#include <SqThread.h>
+#include <Sqdb.h>
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+typedef struct SqdbStatsEntry    SqdbStatsEntry;
+typedef struct SqdbStatsNode     SqdbStatsNode;    // define in SqdbStats.c
+typedef struct SqdbStatsStmt     SqdbStatsStmt;    // define in SqdbStats.c
+
+// number of buckets in latency histogram
+#define SQDB_STATS_N_BUCKETS    32
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SqdbStats *sqdb_stats_new(void);
+void       sqdb_stats_free(SqdbStats *stats);
+
+void  sqdb_stats_init(SqdbStats *stats);
+void  sqdb_stats_final(SqdbStats *stats);
+
+// clear counters of all fingerprints
+void  sqdb_stats_reset(SqdbStats *stats);
+
+// return copy of statistics. Elements are SqdbStatsEntry that sorted by total time (descending).
+// Release it by sq_ptr_array_free(). If 'reset' is true, counters are cleared after copying.
+SqPtrArray *sqdb_stats_snapshot(SqdbStats *stats, bool reset);
+
+// return latency of 'percent' percentile in microseconds. e.g. percent = 99 for p99.
+// It is upper bound of histogram bucket, but not greater than maximum latency.
+double  sqdb_stats_entry_percentile(const SqdbStatsEntry *entry, double percent);
+
+// write fingerprint of 'sql' to 'dest'. Size of 'dest' must be strlen(sql) + 1 or more.
+// String and number literals are replaced by '?', list of literals is replaced by '?+'.
+// return length of fingerprint.
+int   sqdb_stats_fingerprint(char *dest, const char *sql);
+
+// Sqdb product calls it to count rows that exec() sent to Sqxc.
+void  sqdb_stats_add_rows(int n_rows);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+// ----------------------------------------------------------------------------
+// C/C++ common definitions: define structue
+
+/*	SqdbStatsEntry - statistics of statements that have the same fingerprint.
+
+	Latency histogram has log2 buckets of microseconds:
+	histogram[0] counts latency < 1us, histogram[n] counts latency in [2^(n-1), 2^n) us.
+	The last bucket counts all latency that is greater.
+ */
+struct SqdbStatsEntry
+{
+	const char   *fingerprint;
+	uint64_t      count;         // number of executions
+	uint64_t      errors;        // number of executions that failed
+	uint64_t      rows;          // number of returned rows
+	uint64_t      total_ns;      // total time in nanoseconds
+	uint64_t      max_ns;        // maximum time in nanoseconds
+	uint64_t      histogram[SQDB_STATS_N_BUCKETS];
+};
+
+/*	SqdbStats - It is thread-safe, one SqdbStats can be used by multiple Sqdb.
+
+	Time of prepared statement is sum of sqdb_prepare() and sqdb_stmt_step() until it is reset or finalized.
+	Statements that take 'slow_threshold' microseconds or more are written to 'slow_log'.
+ */
+struct SqdbStats
+{
+	SqdbStatsNode **buckets;
+	unsigned int    n_buckets;       // power of 2
+	unsigned int    length;          // number of fingerprints
+
+	SqdbStatsStmt  *stmts;           // prepared statements that are not finalized
+	SqMutex         mutex;
+
+	// slow query log. It is disabled if 'slow_log' is NULL.
+	FILE           *slow_log;
+	int64_t         slow_threshold;  // microseconds
+};
+
+// ----------------------------------------------------------------------------
+// C++ definitions: define C++ data, function, method, and others.
+
+#ifdef __cplusplus
+
+namespace Sq {
+
+// conforming C++11 standard-layout
+// These are for directly use only. You can NOT derived it.
+typedef struct SqdbStatsEntry    DbStatsEntry;
+
+struct DbStats : SqdbStats
+{
+	DbStats() {
+		sqdb_stats_init((SqdbStats*)this);
+	}
+	~DbStats() {
+		sqdb_stats_final((SqdbStats*)this);
+	}
+
+	void  reset() {
+		sqdb_stats_reset((SqdbStats*)this);
+	}
+	SqPtrArray *snapshot(bool reset = false) {
+		return sqdb_stats_snapshot((SqdbStats*)this, reset);
+	}
+	static double  percentile(const DbStatsEntry *entry, double percent) {
+		return sqdb_stats_entry_percentile(entry, percent);
+	}
+};
+
+};  // namespace Sq
+
+#endif  // __cplusplus
+
+
+#endif  // SQDB_STATS_H
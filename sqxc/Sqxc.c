@@ -25,10 +25,82 @@
 #include <SqxcUnknown.h>
 #endif
 
+#if defined(SQ_CONFIG_SQXC_DISPATCH) && !defined(SQ_CONFIG_SQXC_UNKNOWN_SKIP)
+#define SQXC_USE_DISPATCH
+#endif
+
 #define NESTED_OUTER_ROOT    (&sqxc_nested_root)
 
 static SqxcNested sqxc_nested_root = {0};
 
+// ----------------------------------------------------------------------------
+// frozen chain (dispatch table)
+// Sqxc.dispatch[index] is the first element that may support SqxcType.
+// index = bit position of SqxcType (+ DISPATCH_N_TYPE if SqxcType has SQXC_TYPE_END)
+
+#define DISPATCH_N_TYPE    11    // number of bits in SQXC_TYPE_ALL
+#define DISPATCH_SIZE      (DISPATCH_N_TYPE * 2)
+
+void  sqxc_clear_dispatch(Sqxc *xc)
+{
+	for (;  xc;  xc = xc->peer) {
+		free(xc->dispatch);
+		xc->dispatch = NULL;
+	}
+}
+
+#ifdef SQXC_USE_DISPATCH
+
+static Sqxc **sqxc_build_dispatch(Sqxc *xc)
+{
+	Sqxc    **dispatch;
+	Sqxc     *cur;
+	unsigned int  type;
+	int       index;
+
+	dispatch = (Sqxc**)malloc(sizeof(Sqxc*) * DISPATCH_SIZE);
+	for (index = 0;  index < DISPATCH_SIZE;  index++) {
+		type = 1 << (index % DISPATCH_N_TYPE);
+		if (index >= DISPATCH_N_TYPE)
+			type |= SQXC_TYPE_END;
+		// skip elements that never support this type
+		for (cur = xc;  cur;  cur = cur->peer) {
+			if ((cur->supported_type | cur->variable_type) & type)
+				break;
+		}
+		dispatch[index] = cur;
+	}
+	xc->dispatch = dispatch;
+	return dispatch;
+}
+
+// return the first element that may support xc->type. Return 'xc' if xc->type is not a single type.
+static inline Sqxc *sqxc_dispatch(Sqxc *xc)
+{
+	unsigned int  type = xc->type;
+	unsigned int  bits = type & SQXC_TYPE_ALL;
+	Sqxc        **dispatch;
+	int           index;
+
+	if (bits == 0 || (bits & (bits - 1)) || (type & ~(SQXC_TYPE_ALL | SQXC_TYPE_END)))
+		return xc;
+#if defined(__GNUC__)
+	index = __builtin_ctz(bits);
+#else
+	for (index = 0;  (bits & 1) == 0;  index++)
+		bits >>= 1;
+#endif
+	if (type & SQXC_TYPE_END)
+		index += DISPATCH_N_TYPE;
+
+	dispatch = xc->dispatch;
+	if (dispatch == NULL)
+		dispatch = sqxc_build_dispatch(xc);
+	return dispatch[index];
+}
+
+#endif  // SQXC_USE_DISPATCH
+
 // ----------------------------------------------------------------------------
 // Sqxc functions
 
@@ -54,6 +126,7 @@ void   sqxc_final(Sqxc *xc)
 	// clear nested
 	sqxc_clear_nested(xc);
 	// free memory
+	free(xc->dispatch);
 	free(xc->buf);
 }
 
@@ -127,7 +200,10 @@ Sqxc   *sqxc_insert(Sqxc *xc, Sqxc *xc_element, int position)
 		xc_element->peer = cur;
 	// set default destination
 	xc_element->dest = xc;
-	return (prev) ? xc : xc_element;
+	// chain has been changed
+	cur = (prev) ? xc : xc_element;
+	sqxc_clear_dispatch(cur);
+	return cur;
 }
 
 Sqxc   *sqxc_steal(Sqxc *xc, Sqxc *xc_element)
@@ -135,6 +211,9 @@ Sqxc   *sqxc_steal(Sqxc *xc, Sqxc *xc_element)
 	Sqxc *cur;
 	Sqxc *prev = NULL;
 
+	// chain will be changed
+	sqxc_clear_dispatch(xc);
+
 	for (cur = xc;  cur;  cur = cur->peer) {
 		if (cur == xc_element) {
 			if (prev)
@@ -183,7 +262,18 @@ Sqxc  *sqxc_send(Sqxc *xc)
  */
 
 /*	xc->required_type = SQXC_TYPE_ALL;  */
-	for (cur = xc;  cur;  cur = cur->peer) {
+#ifdef SQXC_USE_DISPATCH
+	// skip elements that never support xc->type
+	cur = sqxc_dispatch(xc);
+	if (cur == NULL) {
+		xc->code = SQCODE_TYPE_NOT_SUPPORT;
+		return xc;
+	}
+#else
+	cur = xc;
+#endif
+
+	for (;  cur;  cur = cur->peer) {
 		if ((cur->supported_type & xc->type) == 0) {
 			xc->code = SQCODE_TYPE_NOT_SUPPORT;
 			continue;
@@ -245,6 +245,10 @@ Sqxc   *sqxc_steal(Sqxc *xc, Sqxc *xc_element);
 // Return the found Sqxc element, or NULL if it is not found
 Sqxc   *sqxc_find(Sqxc *xc, const SqxcInfo *info);
 
+// clear frozen chain (dispatch table) from 'xc' to end of chain.
+// Call it if you change Sqxc.peer directly. sqxc_insert() and sqxc_steal() call it automatically.
+void    sqxc_clear_dispatch(Sqxc *xc);
+
 //Sqxc *sqxc_nth(Sqxc *sqxc, int position);
 #define sqxc_nth(sqxc, position)    sqxc_insert(sqxc, NULL, position)
 
@@ -377,12 +381,14 @@ struct SqxcNested
 	const SqxcInfo  *info;    \
 	Sqxc            *peer;    \
 	Sqxc            *dest;    \
+	Sqxc           **dispatch;\
 	SqxcNested  *nested;          \
 	int          nested_count;    \
 	char        *buf;             \
 	int          buf_size;        \
 	int          buf_writed;      \
 	uint16_t     supported_type;    \
+	uint16_t     variable_type;     \
 /*	uint16_t     outputable_type; */\
 /*	uint16_t     required_type;   */\
 	uint16_t     code;              \
@@ -419,6 +425,7 @@ struct Sqxc
 	// Sqxc chain
 	Sqxc        *peer;     // pointer to other Sqxc elements
 	Sqxc        *dest;     // pointer to current destination in Sqxc chain
+	Sqxc       **dispatch; // frozen chain: first element that may support each SqxcType
 
 	// stack of SqxcNested
 	SqxcNested  *nested;          // current nested object/array
@@ -437,6 +444,7 @@ struct Sqxc
 	// properties
 
 	uint16_t     supported_type;  // supported SqxcType (bit field) for inputting, it can change at runtime.
+	uint16_t     variable_type;   // SqxcType (bit field) that may be added to supported_type at runtime.
 //	uint16_t     outputable_type; // supported SqxcType (bit field) for outputting, it can change at runtime.
 
 	// ------------------------------------------
@@ -0,0 +1,559 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#include <stdint.h>     // intptr_t, uintptr_t
+#include <stdlib.h>     // strtod, strtoll
+#include <string.h>     // strpbrk
+#include <limits.h>     // INT_MIN, INT_MAX
+#include <errno.h>
+
+#include <SqError.h>
+#include <SqxcJsonParser.h>
+
+// state of tokenizer
+enum {
+	JSON_ROOT,            // expect root value
+	JSON_VALUE,           // expect value
+	JSON_VALUE_OR_END,    // expect value or ']'
+	JSON_KEY,             // expect key
+	JSON_KEY_OR_END,      // expect key or '}'
+	JSON_COLON,           // expect ':'
+	JSON_COMMA,           // expect ',' or end of object/array
+	JSON_STRING,          // in string
+	JSON_ESCAPE,          // after '\' in string
+	JSON_UNICODE,         // in \uXXXX
+	JSON_NUMBER,          // in number
+	JSON_LITERAL,         // in true, false, or null
+	JSON_END,             // after root value, expect spaces only
+};
+
+#define JSON_IS_SPACE(c)    ((c) == ' ' || (c) == '\n' || (c) == '\r' || (c) == '\t')
+#define JSON_IS_NUMBER(c)   (((c) >= '0' && (c) <= '9') || (c) == '-' || (c) == '+' || (c) == '.' || (c) == 'e' || (c) == 'E')
+
+// name of value that is parsing
+static const char *sqxc_json_parser_name(SqxcJsonParser *xcjson)
+{
+	if (xcjson->nested_count == 0)
+		return (xcjson->has_root_name) ? xcjson->names : NULL;
+	if ((uintptr_t)xcjson->nested->data2 == SQXC_TYPE_ARRAY)
+		return NULL;
+	return xcjson->names + (intptr_t)xcjson->nested->data3;
+}
+
+// send data(arguments) from SqxcJsonParser(source) to SqxcValue(destination)
+static void sqxc_json_parser_send_dest(SqxcJsonParser *xcjson, int type)
+{
+	Sqxc *xcdest = xcjson->dest;
+
+	// skip unknown object or array and its children
+	if (xcjson->skip_depth)
+		return;
+	xcjson->type = type;
+	xcjson->name = sqxc_json_parser_name(xcjson);
+	xcjson->code = SQCODE_OK;
+	if (xcdest)
+		xcdest->info->send(xcdest, (Sqxc*)xcjson);
+}
+
+static void sqxc_json_parser_reset(SqxcJsonParser *xcjson)
+{
+	xcjson->state = JSON_ROOT;
+	xcjson->surrogate = 0;
+	xcjson->skip_depth = 0;
+	xcjson->buf_writed = 0;
+	xcjson->names_writed = 0;
+	sqxc_clear_nested((Sqxc*)xcjson);
+}
+
+// write code point as UTF-8
+static void sqxc_json_parser_write_utf8(SqBuffer *buf, uint32_t code)
+{
+	char *mem;
+
+	if (code < 0x80)
+		sq_buffer_write_c(buf, (char)code);
+	else if (code < 0x800) {
+		mem = sq_buffer_alloc(buf, 2);
+		mem[0] = (char)(0xC0 | (code >> 6));
+		mem[1] = (char)(0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000) {
+		mem = sq_buffer_alloc(buf, 3);
+		mem[0] = (char)(0xE0 | (code >> 12));
+		mem[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+		mem[2] = (char)(0x80 | (code & 0x3F));
+	}
+	else {
+		mem = sq_buffer_alloc(buf, 4);
+		mem[0] = (char)(0xF0 | (code >> 18));
+		mem[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+		mem[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+		mem[3] = (char)(0x80 | (code & 0x3F));
+	}
+}
+
+// write U+FFFD if high surrogate doesn't have low surrogate
+static void sqxc_json_parser_flush_surrogate(SqxcJsonParser *xcjson)
+{
+	if (xcjson->surrogate) {
+		xcjson->surrogate = 0;
+		sqxc_json_parser_write_utf8(sqxc_get_buffer(xcjson), 0xFFFD);
+	}
+}
+
+static void sqxc_json_parser_unicode(SqxcJsonParser *xcjson)
+{
+	uint32_t  code = xcjson->unicode;
+
+	if (xcjson->surrogate) {
+		if (code >= 0xDC00 && code <= 0xDFFF) {
+			code = 0x10000 + ((xcjson->surrogate - 0xD800) << 10) + (code - 0xDC00);
+			xcjson->surrogate = 0;
+			sqxc_json_parser_write_utf8(sqxc_get_buffer(xcjson), code);
+			return;
+		}
+		sqxc_json_parser_flush_surrogate(xcjson);
+	}
+
+	if (code >= 0xD800 && code <= 0xDBFF)
+		xcjson->surrogate = code;
+	else if (code >= 0xDC00 && code <= 0xDFFF)
+		sqxc_json_parser_write_utf8(sqxc_get_buffer(xcjson), 0xFFFD);
+	else
+		sqxc_json_parser_write_utf8(sqxc_get_buffer(xcjson), code);
+}
+
+static void sqxc_json_parser_value_end(SqxcJsonParser *xcjson)
+{
+	xcjson->state = (xcjson->nested_count) ? JSON_COMMA : JSON_END;
+}
+
+// return true if 'str' matches JSON number:  -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool sqxc_json_parser_is_number(const char *str)
+{
+	if (*str == '-')
+		str++;
+	if (*str == '0')
+		str++;
+	else if (*str >= '1' && *str <= '9') {
+		while (*str >= '0' && *str <= '9')
+			str++;
+	}
+	else
+		return false;
+
+	if (*str == '.') {
+		if (*++str < '0' || *str > '9')
+			return false;
+		while (*str >= '0' && *str <= '9')
+			str++;
+	}
+	if (*str == 'e' || *str == 'E') {
+		if (*++str == '+' || *str == '-')
+			str++;
+		if (*str < '0' || *str > '9')
+			return false;
+		while (*str >= '0' && *str <= '9')
+			str++;
+	}
+	return *str == 0;
+}
+
+static int  sqxc_json_parser_number(SqxcJsonParser *xcjson)
+{
+	char    *end;
+	int64_t  int64;
+
+	xcjson->buf[xcjson->buf_writed] = 0;    // NULL-termainated is not counted in length
+	// reject leading zeros, '+', and incomplete fraction or exponent that strtod() accepts.
+	if (sqxc_json_parser_is_number(xcjson->buf) == false)
+		return SQCODE_INVALID_JSON;
+	if (strpbrk(xcjson->buf, ".eE") == NULL) {
+		errno = 0;
+		int64 = strtoll(xcjson->buf, &end, 10);
+		if (errno == 0) {
+			if (end == xcjson->buf || *end != 0)
+				return SQCODE_INVALID_JSON;
+			if (int64 >= INT_MIN && int64 <= INT_MAX) {
+				xcjson->value.integer = (int)int64;
+				sqxc_json_parser_send_dest(xcjson, SQXC_TYPE_INT);
+			}
+			else {
+				xcjson->value.int64 = int64;
+				sqxc_json_parser_send_dest(xcjson, SQXC_TYPE_INT64);
+			}
+			sqxc_json_parser_value_end(xcjson);
+			return SQCODE_OK;
+		}
+		// out of range. use double
+	}
+
+	xcjson->value.double_ = strtod(xcjson->buf, &end);
+	if (end == xcjson->buf || *end != 0)
+		return SQCODE_INVALID_JSON;
+	sqxc_json_parser_send_dest(xcjson, SQXC_TYPE_DOUBLE);
+	sqxc_json_parser_value_end(xcjson);
+	return SQCODE_OK;
+}
+
+static void sqxc_json_parser_string(SqxcJsonParser *xcjson)
+{
+	SqBuffer *names = (SqBuffer*)&xcjson->names;
+
+	sqxc_json_parser_flush_surrogate(xcjson);
+	sq_buffer_alloc(sqxc_get_buffer(xcjson), 0);
+	xcjson->buf[xcjson->buf_writed] = 0;    // NULL-termainated is not counted in length
+
+	if (xcjson->is_key) {
+		// replace key of current object
+		names->writed = (int)(intptr_t)xcjson->nested->data3;
+		sq_buffer_write_n(names, xcjson->buf, xcjson->buf_writed);
+		sq_buffer_write_c(names, 0);
+		xcjson->state = JSON_COLON;
+		return;
+	}
+
+	xcjson->value.string = xcjson->buf;
+	sqxc_json_parser_send_dest(xcjson, SQXC_TYPE_STRING);
+	sqxc_json_parser_value_end(xcjson);
+}
+
+// parse beginning of value. return SQCODE_INVALID_JSON if 'c' can't start a value.
+static int  sqxc_json_parser_value(SqxcJsonParser *xcjson, char c)
+{
+	SqxcNested *nested;
+
+	xcjson->buf_writed = 0;
+	switch (c) {
+	case '"':
+		xcjson->is_key = false;
+		xcjson->state = JSON_STRING;
+		break;
+
+	case '{':
+	case '[':
+		sqxc_json_parser_send_dest(xcjson, (c == '{') ? SQXC_TYPE_OBJECT : SQXC_TYPE_ARRAY);
+		nested = sqxc_push_nested((Sqxc*)xcjson);
+		nested->data2 = (void*)(uintptr_t)((c == '{') ? SQXC_TYPE_OBJECT : SQXC_TYPE_ARRAY);
+		nested->data3 = (void*)(intptr_t)xcjson->names_writed;
+		if (xcjson->skip_depth == 0 && xcjson->code == SQCODE_ENTRY_NOT_FOUND)
+			xcjson->skip_depth = xcjson->nested_count;
+		xcjson->state = (c == '{') ? JSON_KEY_OR_END : JSON_VALUE_OR_END;
+		break;
+
+	case 't':
+		xcjson->literal = "true";
+		goto literal;
+	case 'f':
+		xcjson->literal = "false";
+		goto literal;
+	case 'n':
+		xcjson->literal = "null";
+	literal:
+		sq_buffer_write_c(sqxc_get_buffer(xcjson), c);
+		xcjson->state = JSON_LITERAL;
+		break;
+
+	default:
+		if ((c >= '0' && c <= '9') || c == '-') {
+			sq_buffer_write_c(sqxc_get_buffer(xcjson), c);
+			xcjson->state = JSON_NUMBER;
+			break;
+		}
+		return SQCODE_INVALID_JSON;
+	}
+	return SQCODE_OK;
+}
+
+// end of object or array
+static int  sqxc_json_parser_end(SqxcJsonParser *xcjson, int type)
+{
+	if ((uintptr_t)xcjson->nested->data2 != (uintptr_t)type)
+		return SQCODE_INVALID_JSON;
+	xcjson->names_writed = (int)(intptr_t)xcjson->nested->data3;
+	if (xcjson->skip_depth == xcjson->nested_count)
+		xcjson->skip_depth = -1;    // don't send end of skipped object or array
+	sqxc_pop_nested((Sqxc*)xcjson);
+	sqxc_json_parser_send_dest(xcjson, type | SQXC_TYPE_END);
+	if (xcjson->skip_depth == -1)
+		xcjson->skip_depth = 0;
+	sqxc_json_parser_value_end(xcjson);
+	return SQCODE_OK;
+}
+
+/* ----------------------------------------------------------------------------
+	SqxcInfo functions - Middleware of input chain
+
+	  (JSON string)
+	SQXC_TYPE_STRING ---> SqxcJsonParser ---> SQXC_TYPE_xxxx
+	       or
+	SQXC_TYPE_STREAM
+ */
+
+static int  sqxc_json_parser_send(SqxcJsonParser *xcjson, Sqxc *src)
+{
+	SqBuffer    *buf = sqxc_get_buffer(xcjson);
+	const char  *cur;
+	const char  *name = src->name;    // 'src' may be 'xcjson' in stream
+	int          type = src->type;
+	int          code = SQCODE_OK;
+	int          len;
+	char         c;
+
+	if (type == SQXC_TYPE_STRING)
+		sqxc_json_parser_reset(xcjson);
+	if (type == SQXC_TYPE_STREAM_END || src->value.string == NULL)
+		cur = "";
+	else
+		cur = src->value.string;
+
+	while (code == SQCODE_OK && (c = *cur) != 0) {
+		switch (xcjson->state) {
+		case JSON_ROOT:
+			if (JSON_IS_SPACE(c))
+				break;
+			// name of root value
+			xcjson->names_writed = 0;
+			xcjson->has_root_name = (name != NULL);
+			if (name) {
+				sq_buffer_write((SqBuffer*)&xcjson->names, name);
+				sq_buffer_write_c((SqBuffer*)&xcjson->names, 0);
+			}
+			code = sqxc_json_parser_value(xcjson, c);
+			break;
+
+		case JSON_VALUE_OR_END:
+			if (c == ']') {
+				code = sqxc_json_parser_end(xcjson, SQXC_TYPE_ARRAY);
+				break;
+			}
+			// Fall through
+		case JSON_VALUE:
+			if (JSON_IS_SPACE(c))
+				break;
+			code = sqxc_json_parser_value(xcjson, c);
+			break;
+
+		case JSON_KEY_OR_END:
+			if (c == '}') {
+				code = sqxc_json_parser_end(xcjson, SQXC_TYPE_OBJECT);
+				break;
+			}
+			// Fall through
+		case JSON_KEY:
+			if (JSON_IS_SPACE(c))
+				break;
+			if (c != '"') {
+				code = SQCODE_INVALID_JSON;
+				break;
+			}
+			xcjson->buf_writed = 0;
+			xcjson->is_key = true;
+			xcjson->state = JSON_STRING;
+			break;
+
+		case JSON_COLON:
+			if (c == ':')
+				xcjson->state = JSON_VALUE;
+			else if (JSON_IS_SPACE(c) == 0)
+				code = SQCODE_INVALID_JSON;
+			break;
+
+		case JSON_COMMA:
+			if (c == ',') {
+				if ((uintptr_t)xcjson->nested->data2 == SQXC_TYPE_OBJECT)
+					xcjson->state = JSON_KEY;
+				else
+					xcjson->state = JSON_VALUE;
+			}
+			else if (c == '}')
+				code = sqxc_json_parser_end(xcjson, SQXC_TYPE_OBJECT);
+			else if (c == ']')
+				code = sqxc_json_parser_end(xcjson, SQXC_TYPE_ARRAY);
+			else if (JSON_IS_SPACE(c) == 0)
+				code = SQCODE_INVALID_JSON;
+			break;
+
+		case JSON_STRING:
+			if (c == '"')
+				sqxc_json_parser_string(xcjson);
+			else if (c == '\\')
+				xcjson->state = JSON_ESCAPE;
+			else if ((unsigned char)c < 0x20)
+				code = SQCODE_INVALID_JSON;    // control characters must be escaped
+			else {
+				// copy characters that don't need unescape
+				sqxc_json_parser_flush_surrogate(xcjson);
+				for (len = 1;  (c = cur[len]) != '"' && c != '\\' && (unsigned char)c >= 0x20;  len++)
+					;
+				sq_buffer_write_n(buf, cur, len);
+				cur += len;
+				continue;
+			}
+			break;
+
+		case JSON_ESCAPE:
+			xcjson->state = JSON_STRING;
+			if (c == 'u') {
+				xcjson->unicode = 0;
+				xcjson->unicode_digits = 0;
+				xcjson->state = JSON_UNICODE;
+				break;
+			}
+			sqxc_json_parser_flush_surrogate(xcjson);
+			switch (c) {
+			case '"':
+			case '\\':
+			case '/':
+				break;
+			case 'b':
+				c = '\b';
+				break;
+			case 'f':
+				c = '\f';
+				break;
+			case 'n':
+				c = '\n';
+				break;
+			case 'r':
+				c = '\r';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			default:
+				code = SQCODE_INVALID_JSON;
+				break;
+			}
+			sq_buffer_write_c(buf, c);
+			break;
+
+		case JSON_UNICODE:
+			if (c >= '0' && c <= '9')
+				c = c - '0';
+			else if (c >= 'a' && c <= 'f')
+				c = c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')
+				c = c - 'A' + 10;
+			else {
+				code = SQCODE_INVALID_JSON;
+				break;
+			}
+			xcjson->unicode = (xcjson->unicode << 4) | c;
+			if (++xcjson->unicode_digits == 4) {
+				sqxc_json_parser_unicode(xcjson);
+				xcjson->state = JSON_STRING;
+			}
+			break;
+
+		case JSON_NUMBER:
+			if (JSON_IS_NUMBER(c)) {
+				sq_buffer_write_c(buf, c);
+				break;
+			}
+			// parse current character again in next state
+			code = sqxc_json_parser_number(xcjson);
+			continue;
+
+		case JSON_LITERAL:
+			if (c != xcjson->literal[xcjson->buf_writed]) {
+				code = SQCODE_INVALID_JSON;
+				break;
+			}
+			if (xcjson->literal[++xcjson->buf_writed] != 0)
+				break;
+			if (c == 'l') {
+				// null
+				xcjson->value.string = NULL;
+				sqxc_json_parser_send_dest(xcjson, SQXC_TYPE_STRING);
+			}
+			else {
+				xcjson->value.boolean = (c == 'e' && xcjson->buf_writed == 4);
+				sqxc_json_parser_send_dest(xcjson, SQXC_TYPE_BOOL);
+			}
+			sqxc_json_parser_value_end(xcjson);
+			break;
+
+		case JSON_END:
+			// only one root value in string or stream
+			if (JSON_IS_SPACE(c) == 0)
+				code = SQCODE_INVALID_JSON;
+			break;
+		}
+		cur++;
+	}
+
+	if (code != SQCODE_OK) {
+		sqxc_json_parser_reset(xcjson);
+		return (src->code = code);
+	}
+
+	// wait for next chunk of stream
+	if (type == SQXC_TYPE_STREAM)
+		return (src->code = SQCODE_OK);
+
+	// SQXC_TYPE_STRING or SQXC_TYPE_STREAM_END: number in root can end here.
+	if (xcjson->state == JSON_NUMBER && xcjson->nested_count == 0)
+		code = sqxc_json_parser_number(xcjson);
+	// string and stream must have root value.
+	if (code == SQCODE_OK && xcjson->state != JSON_END)
+		code = SQCODE_UNCOMPLETED_JSON;
+	// ready for next string or stream
+	sqxc_json_parser_reset(xcjson);
+	return (src->code = code);
+}
+
+static int  sqxc_json_parser_ctrl(SqxcJsonParser *xcjson, int id, void *data)
+{
+	switch(id) {
+	case SQXC_CTRL_READY:
+		sqxc_json_parser_reset(xcjson);
+		break;
+
+	case SQXC_CTRL_FINISH:
+		// clear SqxcNested if problem occurred during processing
+		sqxc_json_parser_reset(xcjson);
+		break;
+
+	default:
+		return SQCODE_NOT_SUPPORT;
+	}
+
+	return SQCODE_OK;
+}
+
+static void  sqxc_json_parser_init(SqxcJsonParser *xcjson)
+{
+//	memset(xcjson, 0, sizeof(SqxcJsonParser));
+	xcjson->supported_type = SQXC_TYPE_STRING | SQXC_TYPE_STREAM;
+}
+
+static void  sqxc_json_parser_final(SqxcJsonParser *xcjson)
+{
+	free(xcjson->names);
+}
+
+// ----------------------------------------------------------------------------
+// SqxcInfo
+
+static const SqxcInfo sqxc_json_parser =
+{
+	sizeof(SqxcJsonParser),
+	(SqInitFunc)sqxc_json_parser_init,
+	(SqFinalFunc)sqxc_json_parser_final,
+	(SqxcCtrlFunc)sqxc_json_parser_ctrl,
+	(SqxcSendFunc)sqxc_json_parser_send,
+};
+
+const SqxcInfo *SQXC_INFO_JSON_PARSER = &sqxc_json_parser;
@@ -0,0 +1,171 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQXC_JSON_PARSER_H
+#define SQXC_JSON_PARSER_H
+
+#include <stdint.h>
+#include <SqBuffer.h>
+#include <Sqxc.h>
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+typedef struct SqxcJsonParser    SqxcJsonParser;
+
+extern const SqxcInfo          *SQXC_INFO_JSON_PARSER;
+
+#define sqxc_json_parser_new()        sqxc_new(SQXC_INFO_JSON_PARSER)
+
+// ----------------------------------------------------------------------------
+// C/C++ common definitions: define structue
+
+/*
+	SqxcJsonParser - Middleware of input chain. It parses JSON text without json-c.
+
+	Sqxc
+	|
+	`--- SqxcJsonParser
+
+	*** In input chain:
+	SQXC_TYPE_STRING ---> SqxcJsonParser ---> SQXC_TYPE_xxxx
+	 (JSON string)
+	       or
+	SQXC_TYPE_STREAM
+	 (JSON text in chunks)
+
+	It sends SQXC_TYPE_xxxx to next Sqxc element as soon as each token completes.
+	SQXC_TYPE_STREAM can split JSON at any position, parser keeps its state between
+	calls of sqxc_send(). Send SQXC_TYPE_STREAM_END to finish stream.
+	Memory usage depends on nesting depth and length of token, not size of JSON.
+	If destination returns SQCODE_ENTRY_NOT_FOUND for object or array, it will be skipped.
+	String (or stream) must contain exactly one root value. Anything except spaces after it,
+	unescaped control characters in string, and numbers with leading zeros are SQCODE_INVALID_JSON.
+
+   The correct way to derive Sqxc:  (conforming C++11 standard-layout)
+   1. Use Sq::XcMethod to inherit member function(method).
+   2. Use SQXC_MEMBERS to inherit member variable.
+   3. Add variable and non-virtual function in derived struct.
+   ** This can keep std::is_standard_layout<>::value == true
+ */
+
+#ifdef __cplusplus
+struct SqxcJsonParser : Sq::XcMethod     // <-- 1. inherit C++ member function(method)
+#else
+struct SqxcJsonParser
+#endif
+{
+	SQXC_MEMBERS;                        // <-- 2. inherit member variable
+/*	// ------ Sqxc members ------
+	const SqxcInfo  *info;
+
+	// Sqxc chain
+	Sqxc        *peer;     // pointer to other Sqxc elements
+	Sqxc        *dest;     // pointer to current destination in Sqxc chain
+	Sqxc       **dispatch; // frozen chain: first element that may support each SqxcType
+
+	// stack of SqxcNested
+	SqxcNested  *nested;          // current nested object/array
+	int          nested_count;
+
+	// ------------------------------------------
+	// Buffer - common buffer for type conversion. To resize this buf:
+	// buf = realloc(buf, buf_size);
+
+//	SQ_BUFFER_MEMBERS(buf, buf_size, buf_writed);
+	char        *buf;
+	int          buf_size;
+	int          buf_writed;
+
+	// ------------------------------------------
+	// properties
+
+	uint16_t     supported_type;  // supported SqxcType (bit field) for inputting, it can change at runtime.
+	uint16_t     variable_type;   // SqxcType (bit field) that may be added to supported_type at runtime.
+//	uint16_t     outputable_type; // supported SqxcType (bit field) for outputting, it can change at runtime.
+
+	// ------------------------------------------
+	// arguments that used by SqxcInfo->send()
+
+	// output arguments
+//	uint16_t     required_type;   // required SqxcType (bit field) if 'code' == SQCODE_TYPE_NOT_MATCH
+	uint16_t     code;            // error code (SQCODE_xxxx)
+
+	// input arguments
+	uint16_t     type;            // input SqxcType
+	const char  *name;
+	union {
+		bool          boolean;
+		int           integer;
+		int           int_;
+		unsigned int  uinteger;
+		unsigned int  uint;
+		int64_t       int64;
+		int64_t       uint64;
+		time_t        rawtime;
+		double        fraction;
+		double        double_;
+		char         *string;
+		char         *stream;     // Text stream must be null-terminated string
+		void         *pointer;
+	} value;
+
+	// special input arguments
+	SqEntry     *entry;           // SqxcJsonc and SqxcSql use it to decide output. this can be NULL (optional).
+
+	// input / output arguments
+	void       **error;
+ */
+
+	// ------ SqxcJsonParser members ------   // <-- 3. Add variable and non-virtual function in derived struct.
+
+	int          state;           // state of tokenizer
+	bool         is_key;          // current string is key of object
+	bool         has_root_name;   // name of root value is not NULL
+	const char  *literal;         // "true", "false", or "null" that is parsing
+	uint32_t     unicode;         // code point of \uXXXX
+	uint32_t     surrogate;       // high surrogate that waiting for low surrogate
+	int          unicode_digits;
+	int          skip_depth;      // nested_count of object/array that destination doesn't know
+
+	// stack of names: name of root value and current key in each nested object.
+	// Sqxc.buf is used to store token that is parsing.
+	SQ_BUFFER_MEMBERS(names, names_size, names_writed);
+};
+
+// ----------------------------------------------------------------------------
+// C++ definitions: define C++ data, function, method, and others.
+
+#ifdef __cplusplus
+
+namespace Sq {
+
+// conforming C++11 standard-layout
+// These are for directly use only. You can NOT derived it.
+struct XcJsonParser : SqxcJsonParser
+{
+	XcJsonParser() {
+		sqxc_init((Sqxc*)this, SQXC_INFO_JSON_PARSER);
+	}
+	~XcJsonParser() {
+		sqxc_final((Sqxc*)this);
+	}
+};
+
+};  // namespace Sq
+
+#endif  // __cplusplus
+
+
+#endif  // SQXC_JSON_PARSER_H
@@ -0,0 +1,362 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#include <stdint.h>     // intptr_t, uintptr_t
+#include <stdlib.h>     // calloc, free
+#include <string.h>     // memcpy, memset
+#include <math.h>       // isfinite
+
+#if defined(_WIN32)
+#include <io.h>         // _write
+#define write    _write
+#else
+#include <unistd.h>     // write
+#endif
+
+#include <SqConfig.h>
+#include <SqError.h>
+#include <SqEntry.h>
+#include <SqBuffer.h>
+#include <SqUtil.h>
+#include <SqxcJsonWriter.h>
+
+struct SqxcJsonKey
+{
+	const SqEntry *entry;
+	const char    *key;       // escaped "name":
+	int            length;
+};
+
+/*	characters that must be escaped in JSON string.
+	0 = no escape, 'u' = \u00XX, 1 = null-terminated, others = \ + character
+ */
+static const char json_escape[256] = {
+	 1 , 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+	 0 ,  0 , '"',  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,
+	 0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,
+	 0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,
+	 0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 ,  0 , '\\', 0 ,  0 ,  0 ,
+	// 0x60 - 0xFF don't need escape
+};
+
+static const char hex_digits[] = "0123456789abcdef";
+
+// write JSON string with quotes
+static void sqxc_json_write_string(SqBuffer *buf, const char *str)
+{
+	char       *mem;
+	char        escape;
+	int         len;
+
+	sq_buffer_write_c(buf, '"');
+	for (;;  str++) {
+		// write characters that don't need escape
+		len = sq_str_span_json(str);
+		if (len) {
+			sq_buffer_write_n(buf, str, len);
+			str += len;
+		}
+		escape = json_escape[(unsigned char)*str];
+		if (escape == 1)
+			break;
+		if (escape == 'u') {
+			mem = sq_buffer_alloc(buf, 6);
+			memcpy(mem, "\\u00", 4);
+			mem[4] = hex_digits[(unsigned char)*str >> 4];
+			mem[5] = hex_digits[(unsigned char)*str & 0xF];
+		}
+		else {
+			mem = sq_buffer_alloc(buf, 2);
+			mem[0] = '\\';
+			mem[1] = escape;
+		}
+	}
+	sq_buffer_write_c(buf, '"');
+}
+
+// write "name": of SqEntry from cache
+static void sqxc_json_write_entry_key(SqxcJsonWriter *xcjson, SqBuffer *buf, const SqEntry *entry)
+{
+	SqxcJsonKey  *keys, *key;
+	unsigned int  index, mask;
+	int           start;
+
+	if (xcjson->keys_length >= xcjson->keys_size / 2) {
+		// grow hash table and move existing keys
+		keys = xcjson->keys;
+		index = xcjson->keys_size;
+		xcjson->keys_size = (index) ? index * 2 : SQ_CONFIG_JSON_WRITER_KEYS_DEFAULT;
+		xcjson->keys = calloc(xcjson->keys_size, sizeof(SqxcJsonKey));
+		mask = xcjson->keys_size - 1;
+		while (index--) {
+			if (keys[index].entry == NULL)
+				continue;
+			key = xcjson->keys + (((uintptr_t)keys[index].entry >> 4) & mask);
+			while (key->entry)
+				key = (key == xcjson->keys + mask) ? xcjson->keys : key + 1;
+			*key = keys[index];
+		}
+		free(keys);
+	}
+
+	mask = xcjson->keys_size - 1;
+	key = xcjson->keys + (((uintptr_t)entry >> 4) & mask);
+	for (;;) {
+		if (key->entry == entry) {
+			memcpy(sq_buffer_alloc(buf, key->length), key->key, key->length);
+			return;
+		}
+		if (key->entry == NULL)
+			break;
+		key = (key == xcjson->keys + mask) ? xcjson->keys : key + 1;
+	}
+
+	// escape name and add it to cache
+	start = buf->writed;
+	sqxc_json_write_string(buf, entry->name);
+	sq_buffer_write_c(buf, ':');
+	key->entry = entry;
+	key->length = buf->writed - start;
+	key->key = memcpy(sq_arena_alloc(&xcjson->keys_arena, key->length), buf->buf + start, key->length);
+	xcjson->keys_length++;
+}
+
+static int  sqxc_json_write_fd(void *data, const char *buffer, int length)
+{
+	return (int)write((int)(intptr_t)data, buffer, length);
+}
+
+// write all data in buffer to sink
+static int  sqxc_json_writer_flush(SqxcJsonWriter *xcjson)
+{
+	int  offset, n;
+
+	for (offset = 0;  offset < xcjson->buf_writed;  offset += n) {
+		n = xcjson->write_func(xcjson->write_data, xcjson->buf + offset, xcjson->buf_writed - offset);
+		if (n <= 0) {
+			xcjson->buf_writed = 0;
+			return SQCODE_WRITE_ERROR;
+		}
+	}
+	xcjson->buf_writed = 0;
+	return SQCODE_OK;
+}
+
+/* ----------------------------------------------------------------------------
+	SqxcInfo functions - Middleware of output chain
+
+	SQXC_TYPE_xxxx ---> SqxcJsonWriter ---> SQXC_TYPE_STRING
+	                                          (JSON string)
+ */
+
+static int  sqxc_json_writer_send(SqxcJsonWriter *xcjson, Sqxc *src)
+{
+	SqBuffer   *buf = sqxc_get_buffer(xcjson);
+	SqxcNested *nested;
+	Sqxc       *xcdest;
+
+	if (src->entry && src->entry->bit_field & SQB_HIDDEN)
+		return (src->code = SQCODE_OK);
+
+	switch (src->type) {
+	case SQXC_TYPE_OBJECT_END:
+	case SQXC_TYPE_ARRAY_END:
+		nested = xcjson->nested;
+		if (xcjson->nested_count == 0 || (uintptr_t)nested->data2 != (src->type & ~SQXC_TYPE_END))
+			return (src->code = SQCODE_TYPE_END_ERROR);
+		sqxc_pop_nested((Sqxc*)xcjson);
+		sq_buffer_write_c(buf, (src->type == SQXC_TYPE_OBJECT_END) ? '}' : ']');
+		xcjson->comma = true;
+		goto check_nested_0;
+
+	case SQXC_TYPE_STRING:
+		if (src->value.string == NULL && src->entry && src->entry->bit_field & SQB_HIDDEN_NULL)
+			return (src->code = SQCODE_OK);
+		break;
+
+	case SQXC_TYPE_BOOL:
+	case SQXC_TYPE_INT:
+	case SQXC_TYPE_UINT:
+	case SQXC_TYPE_INT64:
+	case SQXC_TYPE_UINT64:
+	case SQXC_TYPE_TIME:
+	case SQXC_TYPE_DOUBLE:
+	case SQXC_TYPE_OBJECT:
+	case SQXC_TYPE_ARRAY:
+		break;
+
+	default:
+		return (src->code = SQCODE_TYPE_NOT_SUPPORT);
+	}
+
+	// separator and key
+	if (xcjson->comma)
+		sq_buffer_write_c(buf, ',');
+	if (xcjson->nested_count == 0)
+		xcjson->root_name = src->name;
+	else if ((uintptr_t)xcjson->nested->data2 == SQXC_TYPE_OBJECT) {
+		if (src->entry && src->entry->name == src->name)
+			sqxc_json_write_entry_key(xcjson, buf, src->entry);
+		else {
+			sqxc_json_write_string(buf, (src->name) ? src->name : "");
+			sq_buffer_write_c(buf, ':');
+		}
+	}
+
+	switch (src->type) {
+	case SQXC_TYPE_BOOL:
+		if (src->value.boolean)
+			memcpy(sq_buffer_alloc(buf, 4), "true", 4);
+		else
+			memcpy(sq_buffer_alloc(buf, 5), "false", 5);
+		break;
+
+	case SQXC_TYPE_INT:
+		sq_buffer_write_int64(buf, src->value.integer);
+		break;
+
+	case SQXC_TYPE_UINT:
+		sq_buffer_write_uint64(buf, src->value.uint);
+		break;
+
+	case SQXC_TYPE_INT64:
+		sq_buffer_write_int64(buf, src->value.int64);
+		break;
+
+	case SQXC_TYPE_UINT64:
+		sq_buffer_write_uint64(buf, src->value.uint64);
+		break;
+
+	case SQXC_TYPE_TIME:
+		sq_buffer_write_int64(buf, src->value.rawtime);
+		break;
+
+	case SQXC_TYPE_DOUBLE:
+		// JSON doesn't have NaN and Infinity
+		if (isfinite(src->value.double_))
+			sq_buffer_write_double(buf, src->value.double_);
+		else
+			memcpy(sq_buffer_alloc(buf, 4), "null", 4);
+		break;
+
+	case SQXC_TYPE_STRING:
+		if (src->value.string)
+			sqxc_json_write_string(buf, src->value.string);
+		else
+			memcpy(sq_buffer_alloc(buf, 4), "null", 4);
+		break;
+
+	default:    // SQXC_TYPE_OBJECT, SQXC_TYPE_ARRAY
+		sq_buffer_write_c(buf, (src->type == SQXC_TYPE_OBJECT) ? '{' : '[');
+		nested = sqxc_push_nested((Sqxc*)xcjson);
+		nested->data2 = (void*)(uintptr_t)src->type;
+		xcjson->comma = false;
+		goto check_nested_0;
+	}
+	xcjson->comma = true;
+
+check_nested_0:
+	if (xcjson->nested_count == 0) {
+		// End of JSON
+		xcjson->comma = false;
+		if (xcjson->write_func)
+			return (src->code = sqxc_json_writer_flush(xcjson));
+		xcjson->buf[xcjson->buf_writed] = 0;    // NULL-termainated is not counted in length
+		xcdest = xcjson->dest;
+		if (xcdest) {
+			xcjson->type = SQXC_TYPE_STRING;
+			xcjson->name = xcjson->root_name;
+			xcjson->value.string = xcjson->buf;
+			xcdest->info->send(xcdest, (Sqxc*)xcjson);
+			xcjson->buf_writed = 0;
+		}
+	}
+	else if (xcjson->write_func && xcjson->buf_writed >= xcjson->flush_size)
+		return (src->code = sqxc_json_writer_flush(xcjson));
+
+	return (src->code = SQCODE_OK);
+}
+
+static int  sqxc_json_writer_ctrl(SqxcJsonWriter *xcjson, int id, void *data)
+{
+	switch(id) {
+	case SQXC_CTRL_READY:
+		xcjson->buf_writed = 0;
+		xcjson->root_name = NULL;
+		xcjson->comma = false;
+		sqxc_clear_nested((Sqxc*)xcjson);
+		// SqEntry may be freed after previous output. clear cache of keys.
+		if (xcjson->keys_length) {
+			memset(xcjson->keys, 0, sizeof(SqxcJsonKey) * xcjson->keys_size);
+			xcjson->keys_length = 0;
+			sq_arena_reset(&xcjson->keys_arena);
+		}
+		break;
+
+	case SQXC_CTRL_FINISH:
+		if (xcjson->write_func && xcjson->buf_writed > 0)
+			sqxc_json_writer_flush(xcjson);
+		// clear SqxcNested if problem occurred during processing
+		sqxc_clear_nested((Sqxc*)xcjson);
+		break;
+
+	default:
+		return SQCODE_NOT_SUPPORT;
+	}
+
+	return SQCODE_OK;
+}
+
+static void  sqxc_json_writer_init(SqxcJsonWriter *xcjson)
+{
+//	memset(xcjson, 0, sizeof(SqxcJsonWriter));
+	xcjson->supported_type = SQXC_TYPE_ALL;
+	xcjson->flush_size = SQ_CONFIG_JSON_WRITER_FLUSH_SIZE;
+	sq_arena_init(&xcjson->keys_arena, 1024);
+}
+
+static void  sqxc_json_writer_final(SqxcJsonWriter *xcjson)
+{
+	free(xcjson->keys);
+	sq_arena_final(&xcjson->keys_arena);
+}
+
+// ----------------------------------------------------------------------------
+// SqxcJsonWriter functions
+
+void  sqxc_json_writer_use_func(Sqxc *xc, SqxcJsonWriteFunc func, void *data)
+{
+	((SqxcJsonWriter*)xc)->write_func = func;
+	((SqxcJsonWriter*)xc)->write_data = data;
+}
+
+void  sqxc_json_writer_use_fd(Sqxc *xc, int fd)
+{
+	sqxc_json_writer_use_func(xc, sqxc_json_write_fd, (void*)(intptr_t)fd);
+}
+
+// ----------------------------------------------------------------------------
+// SqxcInfo
+
+static const SqxcInfo sqxc_json_writer =
+{
+	sizeof(SqxcJsonWriter),
+	(SqInitFunc)sqxc_json_writer_init,
+	(SqFinalFunc)sqxc_json_writer_final,
+	(SqxcCtrlFunc)sqxc_json_writer_ctrl,
+	(SqxcSendFunc)sqxc_json_writer_send,
+};
+
+const SqxcInfo *SQXC_INFO_JSON_WRITER = &sqxc_json_writer;
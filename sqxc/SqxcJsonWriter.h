@@ -0,0 +1,193 @@
+/*
+ *   Copyright (C) 2021 by C.H. Huang
+ *   plushuang.tw@gmail.com
+ *
+ * sqxc is licensed under Mulan PSL v2.
+ * You can use this software according to the terms and conditions of the Mulan PSL v2.
+ * You may obtain a copy of Mulan PSL v2 at:
+ *          http://license.coscl.org.cn/MulanPSL2
+ * THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+ * EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+ * MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+ * See the Mulan PSL v2 for more details.
+ */
+
+#ifndef SQXC_JSON_WRITER_H
+#define SQXC_JSON_WRITER_H
+
+#include <SqArena.h>
+#include <Sqxc.h>
+
+// ----------------------------------------------------------------------------
+// C/C++ common declarations: declare type, structue, macro, enumeration.
+
+typedef struct SqxcJsonWriter    SqxcJsonWriter;
+typedef struct SqxcJsonKey       SqxcJsonKey;    // define in SqxcJsonWriter.c
+
+// return number of written bytes, or -1 if error occurred.
+typedef int  (*SqxcJsonWriteFunc)(void *data, const char *buffer, int length);
+
+extern const SqxcInfo          *SQXC_INFO_JSON_WRITER;
+
+#define sqxc_json_writer_new()        sqxc_new(SQXC_INFO_JSON_WRITER)
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// write JSON to 'func' instead of sending it to next Sqxc element.
+// JSON is flushed to 'func' when buffer reaches 'flush_size' and at end of top level value.
+void  sqxc_json_writer_use_func(Sqxc *xc, SqxcJsonWriteFunc func, void *data);
+
+// write JSON to file descriptor 'fd'
+void  sqxc_json_writer_use_fd(Sqxc *xc, int fd);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+// ----------------------------------------------------------------------------
+// C/C++ common definitions: define structue
+
+/*
+	SqxcJsonWriter - Middleware of output chain. It writes JSON text without json-c.
+
+	Sqxc
+	|
+	`--- SqxcJsonWriter
+
+	*** In output chain:
+	SQXC_TYPE_xxxx -----> SqxcJsonWriter ---> SQXC_TYPE_STRING
+	                                            (JSON string)
+
+	JSON is written to Sqxc.buf while values arrive.
+	If no sink is specified, it is sent to next Sqxc element at end of top level value,
+	or kept in Sqxc.buf if there is no next element.
+
+   The correct way to derive Sqxc:  (conforming C++11 standard-layout)
+   1. Use Sq::XcMethod to inherit member function(method).
+   2. Use SQXC_MEMBERS to inherit member variable.
+   3. Add variable and non-virtual function in derived struct.
+   ** This can keep std::is_standard_layout<>::value == true
+ */
+
+#ifdef __cplusplus
+struct SqxcJsonWriter : Sq::XcMethod     // <-- 1. inherit C++ member function(method)
+#else
+struct SqxcJsonWriter
+#endif
+{
+	SQXC_MEMBERS;                        // <-- 2. inherit member variable
+/*	// ------ Sqxc members ------
+	const SqxcInfo  *info;
+
+	// Sqxc chain
+	Sqxc        *peer;     // pointer to other Sqxc elements
+	Sqxc        *dest;     // pointer to current destination in Sqxc chain
+	Sqxc       **dispatch; // frozen chain: first element that may support each SqxcType
+
+	// stack of SqxcNested
+	SqxcNested  *nested;          // current nested object/array
+	int          nested_count;
+
+	// ------------------------------------------
+	// Buffer - common buffer for type conversion. To resize this buf:
+	// buf = realloc(buf, buf_size);
+
+//	SQ_BUFFER_MEMBERS(buf, buf_size, buf_writed);
+	char        *buf;
+	int          buf_size;
+	int          buf_writed;
+
+	// ------------------------------------------
+	// properties
+
+	uint16_t     supported_type;  // supported SqxcType (bit field) for inputting, it can change at runtime.
+	uint16_t     variable_type;   // SqxcType (bit field) that may be added to supported_type at runtime.
+//	uint16_t     outputable_type; // supported SqxcType (bit field) for outputting, it can change at runtime.
+
+	// ------------------------------------------
+	// arguments that used by SqxcInfo->send()
+
+	// output arguments
+//	uint16_t     required_type;   // required SqxcType (bit field) if 'code' == SQCODE_TYPE_NOT_MATCH
+	uint16_t     code;            // error code (SQCODE_xxxx)
+
+	// input arguments
+	uint16_t     type;            // input SqxcType
+	const char  *name;
+	union {
+		bool          boolean;
+		int           integer;
+		int           int_;
+		unsigned int  uinteger;
+		unsigned int  uint;
+		int64_t       int64;
+		int64_t       uint64;
+		time_t        rawtime;
+		double        fraction;
+		double        double_;
+		char         *string;
+		char         *stream;     // Text stream must be null-terminated string
+		void         *pointer;
+	} value;
+
+	// special input arguments
+	SqEntry     *entry;           // SqxcJsonc and SqxcSql use it to decide output. this can be NULL (optional).
+
+	// input / output arguments
+	void       **error;
+ */
+
+	// ------ SqxcJsonWriter members ------   // <-- 3. Add variable and non-virtual function in derived struct.
+
+	const char  *root_name;       // name of top level value
+	bool         comma;           // write ',' before next value
+
+	// sink
+	SqxcJsonWriteFunc  write_func;
+	void              *write_data;
+	int                flush_size;
+
+	// cache of escaped "key": for SqEntry. It is cleared by sqxc_ready().
+	SqxcJsonKey  *keys;
+	unsigned int  keys_size;      // power of 2
+	unsigned int  keys_length;
+	SqArena       keys_arena;
+};
+
+// ----------------------------------------------------------------------------
+// C++ definitions: define C++ data, function, method, and others.
+
+#ifdef __cplusplus
+
+namespace Sq {
+
+// conforming C++11 standard-layout
+// These are for directly use only. You can NOT derived it.
+struct XcJsonWriter : SqxcJsonWriter
+{
+	XcJsonWriter() {
+		sqxc_init((Sqxc*)this, SQXC_INFO_JSON_WRITER);
+	}
+	~XcJsonWriter() {
+		sqxc_final((Sqxc*)this);
+	}
+
+	void  useFunc(SqxcJsonWriteFunc func, void *data) {
+		sqxc_json_writer_use_func((Sqxc*)this, func, data);
+	}
+	void  useFd(int fd) {
+		sqxc_json_writer_use_fd((Sqxc*)this, fd);
+	}
+};
+
+};  // namespace Sq
+
+#endif  // __cplusplus
+
+
+#endif  // SQXC_JSON_WRITER_H
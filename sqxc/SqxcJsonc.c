@@ -142,7 +142,8 @@ static int  sqxc_jsonc_ctrl_in(SqxcJsonc *xcjson, int id, void *data)
 static void  sqxc_jsonc_init_in(SqxcJsonc *xcjson)
 {
 //	memset(xcjson, 0, sizeof(SqxcJsonc));
-	xcjson->supported_type = SQXC_TYPE_ALL;
+	// parser accept JSON text only. other types (e.g. SQXC_TYPE_INT64 from database column) can't be parsed.
+	xcjson->supported_type = SQXC_TYPE_STRING | SQXC_TYPE_STREAM;
 }
 
 static void  sqxc_jsonc_final_in(SqxcJsonc *xcjson)
@@ -68,6 +68,7 @@ struct SqxcJsonc
 	// Sqxc chain
 	Sqxc        *peer;     // pointer to other Sqxc elements
 	Sqxc        *dest;     // pointer to current destination in Sqxc chain
+	Sqxc       **dispatch; // frozen chain: first element that may support each SqxcType
 
 	// stack of SqxcNested
 	SqxcNested  *nested;          // current nested object/array
@@ -86,6 +87,7 @@ struct SqxcJsonc
 	// properties
 
 	uint16_t     supported_type;  // supported SqxcType (bit field) for inputting, it can change at runtime.
+	uint16_t     variable_type;   // SqxcType (bit field) that may be added to supported_type at runtime.
 //	uint16_t     outputable_type; // supported SqxcType (bit field) for outputting, it can change at runtime.
 
 	// ------------------------------------------
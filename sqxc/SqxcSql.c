@@ -13,19 +13,9 @@
  */
 
 #if defined(_MSC_VER)
-#ifdef _WIN64
-#define __WORDSIZE 64
-#else
-#define __WORDSIZE 32
-#endif
-
 #define _CRT_SECURE_NO_WARNINGS
-#define snprintf	_snprintf
 #endif  // _MSC_VER
 
-#include <limits.h>     // __WORDSIZE
-#include <stdio.h>      // snprintf
-
 #include <SqError.h>
 #include <SqBuffer.h>
 #include <SqUtil.h>
@@ -46,6 +36,8 @@ static void sqxc_sql_use_insert_command(SqxcSql *xcsql, SqTable *table);
 static void sqxc_sql_use_update_command(SqxcSql *xcsql, SqTable *table);
 static void sqxc_sql_use_where_condition(SqxcSql *xcsql, const char *condition);
 static int  sqxc_sql_write_value(SqxcSql *xcsql, Sqxc *src, SqBuffer *buffer);
+static int  sqxc_sql_write_param(SqxcSql *xcsql, Sqxc *src, SqBuffer *buffer);
+static int  sqxc_sql_exec_param(SqxcSql *xcsql);
 
 /* ----------------------------------------------------------------------------
 	SqxcInfo functions - destination of output chain
@@ -129,25 +121,33 @@ static int  sqxc_sql_send_insert_command(SqxcSql *xcsql, Sqxc *src)
 		}
 	}
 
-	// SQL statement multiple columns
+	// SQL statement multiple columns. column names are written by first row only.
 	if (xcsql->col_count) {
-		sq_buffer_write_c(names_buf, ',');
+		if (xcsql->row_count <= 1)
+			sq_buffer_write_c(names_buf, ',');
 		sq_buffer_write_c(values_buf, ',');
 	}
 
-	// value
-	if (sqxc_sql_write_value(xcsql, src, values_buf) != SQCODE_OK) {
+	// value or '?' placeholder
+	if (xcsql->param.enable)
+		sqxc_sql_write_param(xcsql, src, values_buf);
+	else
+		sqxc_sql_write_value(xcsql, src, values_buf);
+
+	if (src->code != SQCODE_OK) {
 		if (xcsql->col_count) {
-			names_buf->writed--;     // remove ',' from names_buf
+			if (xcsql->row_count <= 1)
+				names_buf->writed--;     // remove ',' from names_buf
 			values_buf->writed--;    // remove ',' form values_buf
 		}
 	}
 	// "name"
 	else {
-		sq_buffer_write_c(names_buf, xcsql->quote[0]);
-		sq_buffer_write(names_buf, src->name);
-		sq_buffer_write_c(names_buf, xcsql->quote[1]);
-
+		if (xcsql->row_count <= 1) {
+			sq_buffer_write_c(names_buf, xcsql->quote[0]);
+			sq_buffer_write(names_buf, src->name);
+			sq_buffer_write_c(names_buf, xcsql->quote[1]);
+		}
 		xcsql->col_count++;
 	}
 
@@ -199,7 +199,7 @@ static int  sqxc_sql_send_update_command(SqxcSql *xcsql, Sqxc *src)
 		if (entry->bit_field & SQB_PRIMARY) {
 			// get primary key id if possible
 			if (SQ_TYPE_IS_INT(entry->type) && xcsql->id == -1)
-				xcsql->id = src->value.integer;
+				xcsql->id = (src->type == SQXC_TYPE_INT64 || src->type == SQXC_TYPE_UINT64) ? src->value.int64 : src->value.integer;
 			return (src->code = SQCODE_OK);
 		}
 		// Don't output column that has DEFAULT CURRENT_XXXX and value.rawtime is 0
@@ -222,7 +222,12 @@ static int  sqxc_sql_send_update_command(SqxcSql *xcsql, Sqxc *src)
 	sq_buffer_alloc(buffer, 2);
 	sq_buffer_r_at(buffer, 1) = xcsql->quote[1];
 	sq_buffer_r_at(buffer, 0) = '=';
-	if (sqxc_sql_write_value(xcsql, src, NULL) != SQCODE_OK)
+	if (xcsql->param.enable)
+		sqxc_sql_write_param(xcsql, src, buffer);
+	else
+		sqxc_sql_write_value(xcsql, src, buffer);
+
+	if (src->code != SQCODE_OK)
 		buffer->writed = len;
 	else
 		xcsql->col_count++;
@@ -241,7 +246,7 @@ static int  sqxc_sql_send(SqxcSql *xcsql, Sqxc *src)
 
 static int  sqxc_sql_ctrl(SqxcSql *xcsql, int id, void *data)
 {
-	int  code;
+	int  code, index;
 
 	switch (id) {
 	case SQXC_CTRL_READY:
@@ -260,20 +265,32 @@ static int  sqxc_sql_ctrl(SqxcSql *xcsql, int id, void *data)
 			// length of ") VALUES " is 9
 			sq_buffer_resize(buffer, buffer->writed + 9 + values->writed + 1);
 			sq_buffer_write(buffer, ") VALUES ");
+			// '?' placeholders are moved from values buffer to xcsql->buf
+			for (index = 0;  index < xcsql->param.length;  index++)
+				xcsql->param.data[index].pos += buffer->writed;
 			sq_buffer_write_n(buffer, values->buf, values->writed);
 			// reset values buffer
 			values->writed = 0;
 		}
 		// SQL statement has written in xcsql->buf
+		code = SQCODE_OK;
+		// INSERT statement without row (empty array) doesn't need to run
+		if (xcsql->mode == 1 && xcsql->row_count == 0)
+			xcsql->buf_writed = 0;
 		if (xcsql->db && xcsql->buf_writed > 0) {
-			code = sqdb_exec(xcsql->db, xcsql->buf, (Sqxc*)xcsql, NULL);
-			if (code != SQCODE_OK)
-				return (xcsql->code = SQCODE_EXEC_ERROR);
+			if (xcsql->param.length > 0)
+				code = sqxc_sql_exec_param(xcsql);
+			else
+				code = sqdb_exec(xcsql->db, xcsql->buf, (Sqxc*)xcsql, NULL);
 		}
 		// clear SqxcNested if problem occurred during processing
 		sqxc_clear_nested((Sqxc*)xcsql);
 		// reset buffer
 		xcsql->buf_writed = 0;
+		xcsql->param.length = 0;
+		xcsql->param.strings.writed = 0;
+		if (code != SQCODE_OK)
+			return (xcsql->code = SQCODE_EXEC_ERROR);
 		break;
 
 	case SQXC_SQL_USE_INSERT:
@@ -312,15 +329,25 @@ static void  sqxc_sql_init(SqxcSql *xcsql)
 	sq_buffer_init(&xcsql->values_buf);
 
 	xcsql->supported_type  = SQXC_TYPE_ALL;
+	xcsql->variable_type   = SQXC_TYPE_NESTED | SQXC_TYPE_END;
 	xcsql->outer_type = SQXC_TYPE_NONE;
 	xcsql->id = -1;
 	xcsql->quote[0] = '"';
 	xcsql->quote[1] = '"';
+
+	xcsql->param.data = NULL;
+	xcsql->param.length = 0;
+	xcsql->param.allocated = 0;
+	sq_buffer_init(&xcsql->param.strings);
+	// sqxc_sql_set_db() enable it if Sqdb caches prepared statements.
+	xcsql->param.enable = false;
 }
 
 static void  sqxc_sql_final(SqxcSql *xcsql)
 {
 	sq_buffer_final(&xcsql->values_buf);
+	sq_buffer_final(&xcsql->param.strings);
+	free(xcsql->param.data);
 }
 
 // ----------------------------------------------------------------------------
@@ -332,6 +359,8 @@ static void sqxc_sql_use_insert_command(SqxcSql *xcsql, SqTable *table)
 
 	buffer = sqxc_get_buffer(xcsql);
 	buffer->writed = 0;
+	xcsql->param.length = 0;
+	xcsql->param.strings.writed = 0;
 	// "INSERT INTO "table_name" ("column1","column2") OUTPUT Inserted.id VALUES "
 	sq_buffer_write(buffer, "INSERT INTO");
 	sq_buffer_alloc(buffer, 2);
@@ -350,6 +379,8 @@ static void sqxc_sql_use_update_command(SqxcSql *xcsql, SqTable *table)
 
 	buffer = sqxc_get_buffer(xcsql);
 	buffer->writed = 0;
+	xcsql->param.length = 0;
+	xcsql->param.strings.writed = 0;
 	// "UPDATE 'table_name' SET "
 	sq_buffer_write(buffer, "UPDATE");
 	sq_buffer_alloc(buffer, 2);
@@ -368,7 +399,6 @@ static void sqxc_sql_use_update_command(SqxcSql *xcsql, SqTable *table)
 static void sqxc_sql_use_where_condition(SqxcSql *xcsql, const char *condition)
 {
 	SqBuffer *buffer = sqxc_get_buffer(xcsql);
-	int       len;
 
 	// UPDATE (mode == 0)
 	if (xcsql->mode == 0) {
@@ -376,16 +406,23 @@ static void sqxc_sql_use_where_condition(SqxcSql *xcsql, const char *condition)
 		sq_buffer_write_n(buffer, " WHERE ", 7);
 		if (xcsql->condition)
 			sq_buffer_write(buffer, condition);
+		else if (xcsql->param.enable) {
+			// SQL statement doesn't change with id
+			sq_buffer_write_n(buffer, "id=", 3);
+			xcsql->type = SQXC_TYPE_INT64;
+			xcsql->value.int64 = xcsql->id;
+			sqxc_sql_write_param(xcsql, (Sqxc*)xcsql, buffer);
+		}
 		else {
-			len = snprintf(NULL, 0, "id=%d", xcsql->id);
-			sprintf(sq_buffer_alloc(buffer, len), "id=%d", xcsql->id);
+			sq_buffer_write_n(buffer, "id=", 3);
+			sq_buffer_write_int64(buffer, xcsql->id);
 		}
 	}
 }
 
 static int  sqxc_sql_write_value(SqxcSql *xcsql, Sqxc *src, SqBuffer *buffer)
 {
-	int   len, idx;
+	int   len;
 	char *tempstr;
 
 	if (buffer == NULL)
@@ -407,50 +444,32 @@ static int  sqxc_sql_write_value(SqxcSql *xcsql, Sqxc *src, SqBuffer *buffer)
 		break;
 
 	case SQXC_TYPE_INT:
-		len = snprintf(NULL, 0, "%d", src->value.integer);
-		sprintf(sq_buffer_alloc(buffer, len), "%d", src->value.integer);
+		sq_buffer_write_int64(buffer, src->value.integer);
 		break;
 
 	case SQXC_TYPE_UINT:
-		len = snprintf(NULL, 0, "%u", src->value.uint);
-		sprintf(sq_buffer_alloc(buffer, len), "%u", src->value.uint);
+		sq_buffer_write_uint64(buffer, src->value.uint);
 		break;
 
 	case SQXC_TYPE_INT64:
-#if defined (_MSC_VER)  // || defined (__MINGW32__) || defined (__MINGW64__)
-		len = snprintf(NULL, 0, "%I64d", src->value.int64);
-		sprintf(sq_buffer_alloc(buffer, len), "%I64d", src->value.int64);
-#elif defined(__WORDSIZE) && (__WORDSIZE == 64)
-		len = snprintf(NULL, 0, "%ld", src->value.int64);
-		sprintf(sq_buffer_alloc(buffer, len), "%ld", src->value.int64);
-#else
-		len = snprintf(NULL, 0, "%lld", (long long int)src->value.int64);
-		sprintf(sq_buffer_alloc(buffer, len), "%lld", (long long int)src->value.int64);
-#endif
+		sq_buffer_write_int64(buffer, src->value.int64);
 		break;
 
 	case SQXC_TYPE_UINT64:
-#if defined (_MSC_VER)  // || defined (__MINGW32__) || defined (__MINGW64__)
-		len = snprintf(NULL, 0, "%I64u", src->value.uint64);
-		sprintf(sq_buffer_alloc(buffer, len), "%I64u", src->value.uint64);
-#elif defined(__WORDSIZE) && (__WORDSIZE == 64)
-		len = snprintf(NULL, 0, "%lu", src->value.uint64);
-		sprintf(sq_buffer_alloc(buffer, len), "%lu", src->value.uint64);
-#else
-		len = snprintf(NULL, 0, "%llu", (long long unsigned int)src->value.uint64);
-		sprintf(sq_buffer_alloc(buffer, len), "%llu", (long long unsigned int)src->value.uint64);
-#endif
+		sq_buffer_write_uint64(buffer, src->value.uint64);
 		break;
 
 	case SQXC_TYPE_TIME:
-		tempstr = sq_time_to_string(src->value.rawtime);
-		sq_buffer_write(buffer, tempstr);
-		free(tempstr);
+		// allocate enough space, then give back unused part.
+		tempstr = sq_buffer_alloc(buffer, SQ_TIME_STR_SIZE + 2);
+		len = sq_time_to_str(tempstr + 1, src->value.rawtime, SQ_TIME_USE_UTC);
+		tempstr[0] = '\'';
+		tempstr[len + 1] = '\'';
+		buffer->writed -= SQ_TIME_STR_SIZE - len;
 		break;
 
 	case SQXC_TYPE_DOUBLE:
-		len = snprintf(NULL, 0, "%lf", src->value.double_);
-		sprintf(sq_buffer_alloc(buffer, len), "%lf", src->value.double_);
+		sq_buffer_write_double(buffer, src->value.double_);
 		break;
 
 	case SQXC_TYPE_STRING:
@@ -459,21 +478,18 @@ static int  sqxc_sql_write_value(SqxcSql *xcsql, Sqxc *src, SqBuffer *buffer)
 			break;
 		}
 		// handle SQL string apostrophe (single quotes)
-		for (len = 0, idx = 0;  src->value.string[idx];  idx++, len++) {
-			// double up on the single quotes
-			if (src->value.string[idx] == '\'')
-				len++;
-		}
-		idx = buffer->writed;
-		sq_buffer_alloc(buffer, len +2);    // + '\'' x 2
-		buffer->buf[idx++] = '\'';
-		buffer->buf[idx +len] = '\'';
-		for (len = idx, idx = 0;  src->value.string[idx];  idx++, len++) {
+		sq_buffer_write_c(buffer, '\'');
+		for (tempstr = src->value.string;  ;  tempstr++) {
+			// copy characters before single quote
+			len = sq_str_span_sql(tempstr);
+			sq_buffer_write_n(buffer, tempstr, len);
+			tempstr += len;
+			if (*tempstr == 0)
+				break;
 			// double up on the single quotes
-			if (src->value.string[idx] == '\'')
-				buffer->buf[len++] = '\'';
-			buffer->buf[len] = src->value.string[idx];
+			memcpy(sq_buffer_alloc(buffer, 2), "\'\'", 2);
 		}
+		sq_buffer_write_c(buffer, '\'');
 		break;
 
 	default:
@@ -483,6 +499,114 @@ static int  sqxc_sql_write_value(SqxcSql *xcsql, Sqxc *src, SqBuffer *buffer)
 	return (src->code = SQCODE_OK);
 }
 
+// ----------------------------------------------------------------------------
+// parameterized mode
+
+// write '?' placeholder to 'buffer' and append value of 'src' to parameter list.
+static int  sqxc_sql_write_param(SqxcSql *xcsql, Sqxc *src, SqBuffer *buffer)
+{
+	SqxcSqlParam *param;
+	int   len;
+
+	switch (src->type) {
+	case SQXC_TYPE_BOOL:
+	case SQXC_TYPE_INT:
+	case SQXC_TYPE_UINT:
+	case SQXC_TYPE_INT64:
+	case SQXC_TYPE_UINT64:
+	case SQXC_TYPE_TIME:
+	case SQXC_TYPE_DOUBLE:
+	case SQXC_TYPE_STRING:
+		break;
+
+	default:
+		return (src->code = SQCODE_TYPE_NOT_SUPPORT);
+	}
+
+	if (xcsql->param.length == xcsql->param.allocated) {
+		xcsql->param.allocated = (xcsql->param.allocated) ? xcsql->param.allocated * 2 : 16;
+		xcsql->param.data = realloc(xcsql->param.data, sizeof(SqxcSqlParam) * xcsql->param.allocated);
+	}
+	param = xcsql->param.data + xcsql->param.length++;
+	param->type = src->type;
+	param->pos  = buffer->writed;
+
+	if (src->type != SQXC_TYPE_STRING)
+		memcpy(&param->value, &src->value, sizeof(param->value));
+	else if (src->value.string == NULL)
+		param->value.offset = -1;
+	else {
+		// copy string without escaping. It will be passed to Sqdb as it is.
+		len = (int)strlen(src->value.string) + 1;
+		param->value.offset = xcsql->param.strings.writed;
+		memcpy(sq_buffer_alloc(&xcsql->param.strings, len), src->value.string, len);
+	}
+
+	sq_buffer_write_c(buffer, '?');
+	return (src->code = SQCODE_OK);
+}
+
+// load value of 'param' into input arguments of 'xcsql'
+static void sqxc_sql_load_param(SqxcSql *xcsql, SqxcSqlParam *param)
+{
+	xcsql->type = param->type;
+	xcsql->name = NULL;
+	if (param->type != SQXC_TYPE_STRING)
+		memcpy(&xcsql->value, &param->value, sizeof(param->value));
+	else if (param->value.offset == -1)
+		xcsql->value.string = NULL;
+	else
+		xcsql->value.string = xcsql->param.strings.buf + param->value.offset;
+}
+
+// run SQL statement in xcsql->buf with bound parameters
+static int  sqxc_sql_exec_param(SqxcSql *xcsql)
+{
+	Sqdb         *db = xcsql->db;
+	SqdbStmt     *stmt = NULL;
+	SqxcSqlParam *param;
+	SqBuffer     *buffer;
+	int   index, pos, code;
+
+	if (db->info->prepare)
+		code = sqdb_prepare(db, xcsql->buf, &stmt);
+	else
+		code = SQCODE_NOT_SUPPORT;
+
+	// Sqdb can't prepare statement (or too many parameters). write values to SQL statement and run it.
+	if (code != SQCODE_OK) {
+		buffer = &xcsql->values_buf;
+		buffer->writed = 0;
+		for (pos = 0, index = 0;  index < xcsql->param.length;  index++) {
+			param = xcsql->param.data + index;
+			sq_buffer_write_n(buffer, xcsql->buf + pos, param->pos - pos);
+			pos = param->pos + 1;
+			sqxc_sql_load_param(xcsql, param);
+			sqxc_sql_write_value(xcsql, (Sqxc*)xcsql, buffer);
+		}
+		// remaining part of SQL statement (including null-terminated)
+		sq_buffer_write_n(buffer, xcsql->buf + pos, xcsql->buf_writed - pos);
+		code = sqdb_exec(db, buffer->buf, (Sqxc*)xcsql, NULL);
+		buffer->writed = 0;
+		return code;
+	}
+
+	for (index = 0;  index < xcsql->param.length;  index++) {
+		sqxc_sql_load_param(xcsql, xcsql->param.data + index);
+		code = sqdb_stmt_bind(db, stmt, index + 1, (Sqxc*)xcsql);
+		if (code != SQCODE_OK)
+			break;
+	}
+	// INSERT and UPDATE doesn't return row. SqxcSql is used to get inserted id.
+	if (code == SQCODE_OK) {
+		code = sqdb_stmt_step(db, stmt, (Sqxc*)xcsql);
+		if (code == SQCODE_DONE)
+			code = SQCODE_OK;
+	}
+	sqdb_stmt_finalize(db, stmt);
+	return code;
+}
+
 // ----------------------------------------------------------------------------
 // SqxcInfo
 
@@ -23,6 +23,7 @@
 // C/C++ common declarations: declare type, structue, macro, enumeration.
 
 typedef struct SqxcSql        SqxcSql;
+typedef struct SqxcSqlParam   SqxcSqlParam;
 
 extern const SqxcInfo        *SQXC_INFO_SQL;
 
@@ -35,11 +36,40 @@ extern const SqxcInfo        *SQXC_INFO_SQL;
 		{	((SqxcSql*)xcsql)->db = sqdb;    \
 			((SqxcSql*)xcsql)->quote[0] = (sqdb)->info->quote.identifier[0];   \
 			((SqxcSql*)xcsql)->quote[1] = (sqdb)->info->quote.identifier[1];   \
+			((SqxcSql*)xcsql)->param.enable = SQXC_SQL_USE_PARAM && (sqdb)->info->stmt_cache;  \
 		}
 
+#ifdef SQ_CONFIG_SQXC_SQL_USE_PARAM
+#define SQXC_SQL_USE_PARAM    1
+#else
+#define SQXC_SQL_USE_PARAM    0
+#endif
+
+// output '?' placeholders and bind values to prepared statement.
+// sqxc_sql_set_db() enable it if SQ_CONFIG_SQXC_SQL_USE_PARAM is defined and Sqdb caches prepared statements.
+#define sqxc_sql_use_param(xcsql, boolean)   ((SqxcSql*)xcsql)->param.enable = (boolean)
+
 // ----------------------------------------------------------------------------
 // C/C++ common definitions: define structue
 
+/*	SqxcSqlParam - value of '?' placeholder in SQL statement.
+ */
+struct SqxcSqlParam
+{
+	uint16_t     type;        // SQXC_TYPE_BOOL, SQXC_TYPE_INT, ..., SQXC_TYPE_STRING
+	int          pos;         // position of '?' in SQL statement
+	union {
+		bool          boolean;
+		int           integer;
+		unsigned int  uint;
+		int64_t       int64;
+		uint64_t      uint64;
+		time_t        rawtime;
+		double        double_;
+		int           offset;     // offset of string in SqxcSql.param.strings, -1 if string is NULL
+	} value;
+};
+
 /*
 	SqxcSql - Sqxc data convert to SQL statement. (destination of output chain)
 
@@ -74,6 +104,7 @@ struct SqxcSql
 	// Sqxc chain
 	Sqxc        *peer;     // pointer to other Sqxc elements
 	Sqxc        *dest;     // pointer to current destination in Sqxc chain
+	Sqxc       **dispatch; // frozen chain: first element that may support each SqxcType
 
 	// stack of SqxcNested
 	SqxcNested  *nested;          // current nested object/array
@@ -92,6 +123,7 @@ struct SqxcSql
 	// properties
 
 	uint16_t     supported_type;  // supported SqxcType (bit field) for inputting, it can change at runtime.
+	uint16_t     variable_type;   // SqxcType (bit field) that may be added to supported_type at runtime.
 //	uint16_t     outputable_type; // supported SqxcType (bit field) for outputting, it can change at runtime.
 
 	// ------------------------------------------
@@ -135,7 +167,7 @@ struct SqxcSql
 
 	// controlled variable
 	unsigned int mode;        // 1 == INSERT, 0 == UPDATE
-	int          id;          // inserted id; update id if 'condition' == NULL
+	int64_t      id;          // inserted id; update id if 'condition' == NULL
 	char        *condition;   // WHERE condition if mode == 0 (UPDATE)
 
 	// runtime variable
@@ -145,6 +177,15 @@ struct SqxcSql
 	int          buf_reuse;   // used by INSERT and UPDATE
 
 	SqBuffer     values_buf;  // used by INSERT INTO VALUES
+
+	// parameterized mode: SQL statement use '?' placeholders and values are bound by Sqdb.
+	struct {
+		SqxcSqlParam *data;
+		int           length;
+		int           allocated;
+		SqBuffer      strings;    // copy of string values. (values of Sqxc may be released before binding)
+		bool          enable;
+	} param;
 };
 
 // ----------------------------------------------------------------------------
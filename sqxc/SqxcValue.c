@@ -12,6 +12,8 @@
  * See the Mulan PSL v2 for more details.
  */
 
+#include <stdlib.h>
+
 #include <SqError.h>
 #include <SqxcValue.h>
 
@@ -56,8 +58,10 @@ static int  sqxc_value_ctrl(SqxcValue *xcvalue, int id, void *data)
 			xcvalue->current = xcvalue->container;
 		else
 			xcvalue->current = xcvalue->element;
-		xcvalue->instance = sq_type_init_instance(xcvalue->current,
-		                                         &xcvalue->instance, true);
+		xcvalue->instance = sq_type_init_instance_arena(xcvalue->current,
+		                                         &xcvalue->instance, true, xcvalue->arena);
+		// new result set
+		xcvalue->columns.length = 0;
 		break;
 
 	case SQXC_CTRL_FINISH:
@@ -82,11 +86,44 @@ static void  sqxc_value_init(SqxcValue *xcvalue)
 
 static void  sqxc_value_final(SqxcValue *xcvalue)
 {
+	free(xcvalue->columns.data);
 //	if (xcvalue->instance)
 //		sq_type_final_instance(xcvalue->current, &xcvalue->instance, true);
 //	sqxc_final(xcvalue);
 }
 
+// ----------------------------------------------------------------------------
+// column index -> SqEntry cache
+
+SqEntry  *sqxc_value_find_column(SqxcValue *xcvalue, const char *name)
+{
+	SqxcValueColumn *column;
+	SqEntry        **addr;
+	int    index;
+
+	index = xcvalue->columns.index++;
+	if (index < xcvalue->columns.length) {
+		column = xcvalue->columns.data + index;
+		// compare with name of cached SqEntry instead of address of 'name'.
+		// data source may reuse (or free) buffer of column name.
+		if (column->entry && sq_entry_cmp_str__name(name, &column->entry) == 0)
+			return column->entry;
+	}
+	else {
+		if (index >= xcvalue->columns.allocated) {
+			xcvalue->columns.allocated = (index + 1) * 2;
+			xcvalue->columns.data = realloc(xcvalue->columns.data,
+					sizeof(SqxcValueColumn) * xcvalue->columns.allocated);
+		}
+		column = xcvalue->columns.data + index;
+		xcvalue->columns.length = index + 1;
+	}
+
+	addr = (SqEntry**)sq_type_find_entry(xcvalue->element, name, NULL);
+	column->entry = (addr) ? *addr : NULL;
+	return column->entry;
+}
+
 // ----------------------------------------------------------------------------
 // SqxcInfo
 
@@ -17,11 +17,14 @@
 
 #include <Sqxc.h>
 #include <SqEntry.h>
+#include <SqArena.h>
+#include <SqIntern.h>
 
 // ----------------------------------------------------------------------------
 // C/C++ common declarations: declare type, structue, macro, enumeration.
 
 typedef struct SqxcValue        SqxcValue;
+typedef struct SqxcValueColumn  SqxcValueColumn;
 
 extern const SqxcInfo          *SQXC_INFO_VALUE;
 
@@ -35,6 +38,31 @@ extern const SqxcInfo          *SQXC_INFO_VALUE;
 #define sqxc_value_current(xcvalue)       ((SqxcValue*)xcvalue)->current
 #define sqxc_value_element(xcvalue)       ((SqxcValue*)xcvalue)->element
 #define sqxc_value_container(xcvalue)     ((SqxcValue*)xcvalue)->container
+// memory
+#define sqxc_value_arena(xcvalue)         ((SqxcValue*)xcvalue)->arena
+#define sqxc_value_intern(xcvalue)        ((SqxcValue*)xcvalue)->intern
+
+// reset column index -> SqEntry cache. SQXC_CTRL_READY also reset it.
+#define sqxc_value_reset_columns(xcvalue)   (((SqxcValue*)xcvalue)->columns.length = 0)
+
+// ----------------------------------------------------------------------------
+// C declarations: declare C data, function, and others.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*	find SqEntry of current column in object of 'element' type.
+	It return pointer to SqEntry, or NULL if column name not found.
+	Result is cached by column index. Cached SqEntry is used only if its name matches 'name',
+	so data source can reuse or free buffer of column name between rows.
+	sq_type_find_entry() is called when cache missed or column name is unknown.
+ */
+SqEntry  *sqxc_value_find_column(SqxcValue *xcvalue, const char *name);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
 
 // ----------------------------------------------------------------------------
 // C/C++ common definitions: define structue
@@ -73,6 +101,7 @@ struct SqxcValue
 	// Sqxc chain
 	Sqxc        *peer;     // pointer to other Sqxc elements
 	Sqxc        *dest;     // pointer to current destination in Sqxc chain
+	Sqxc       **dispatch; // frozen chain: first element that may support each SqxcType
 
 	// stack of SqxcNested
 	SqxcNested  *nested;          // current nested object/array
@@ -91,6 +120,7 @@ struct SqxcValue
 	// properties
 
 	uint16_t     supported_type;  // supported SqxcType (bit field) for inputting, it can change at runtime.
+	uint16_t     variable_type;   // SqxcType (bit field) that may be added to supported_type at runtime.
 //	uint16_t     outputable_type; // supported SqxcType (bit field) for outputting, it can change at runtime.
 
 	// ------------------------------------------
@@ -134,6 +164,30 @@ struct SqxcValue
 	const SqType *current;    // type of instance
 	const SqType *element;    // type of table (or entry)
 	const SqType *container;  // type of array (or list)
+
+	// If 'arena' is not NULL, built-in types allocate instances, strings, and arrays from it.
+	// Result must be released by sq_arena_free() instead of sq_type_final_instance().
+	SqArena     *arena;
+
+	// SQ_TYPE_INTERN_STRING get shared strings from 'intern'. It can be NULL.
+	SqIntern    *intern;
+
+	// column index -> SqEntry cache for object of 'element' type.
+	// Data source (Sqdb) usually send columns in the same order for every row,
+	// so column can be found by comparing name with cached SqEntry at the same index.
+	struct {
+		SqxcValueColumn *data;
+		int   length;
+		int   allocated;
+		int   index;          // index of current column in object
+	} columns;
+};
+
+/*	SqxcValueColumn - cached result of sq_type_find_entry() for column 'index'
+ */
+struct SqxcValueColumn
+{
+	SqEntry     *entry;       // NULL if column name is unknown
 };
 
 // ----------------------------------------------------------------------------
@@ -18,19 +18,25 @@
 
 #include <SqPtrArray.h>
 #include <SqBuffer.h>
+#include <SqArena.h>
+#include <SqIntern.h>
 
 #include <SqType.h>
 #include <SqEntry.h>
 
 #include <SqUtil.h>
+#include <SqThread.h>
 #include <SqTable.h>
 #include <SqSchema.h>
 #include <SqStorage.h>
+#include <SqStorage-async.h>
 #include <SqQuery.h>
 #include <SqJoint.h>
 
 // ------------------------------------
 #include <Sqdb.h>
+#include <SqdbPool.h>
+#include <SqdbStats.h>
 
 #ifdef SQ_CONFIG_HAVE_SQLITE
 #include <SqdbSqlite.h>
@@ -45,6 +51,8 @@
 
 #include <SqxcSql.h>
 #include <SqxcValue.h>
+#include <SqxcJsonParser.h>
+#include <SqxcJsonWriter.h>
 
 #ifdef SQ_CONFIG_HAVE_JSONC
 #include <SqxcJsonc.h>
@@ -52,3 +60,4 @@
 
 // ------------------------------------
 #include <SqType-stl-cpp.h>    // Sq::TypeStl<StlContainer>
+#include <SqType-static-cpp.h> // Sq::StaticType<Struct, Fields> (C++17)
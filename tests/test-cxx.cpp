@@ -12,9 +12,12 @@
  * See the Mulan PSL v2 for more details.
  */
 
+#include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include <type_traits>  // is_standard_layout<>
 #include <iostream>     // cout
+#include <string>
 
 #include <SqSchema.h>
 #include <SqSchema-macro.h>
@@ -23,8 +26,13 @@
 #include <SqQuery-macro.h>
 
 #include <SqdbEmpty.h>
+#include <SqdbSqlite.h>
 #include <SqxcEmpty.h>
 #include <SqStorage.h>
+#include <SqxcJsonParser.h>
+#include <SqxcJsonWriter.h>
+#include <SqxcValue.h>
+#include <SqType-static-cpp.h>
 
 using namespace std;
 
@@ -185,6 +193,51 @@ void test_storage()
 	storage->get<Company>(1);
 }
 
+#ifdef SQ_CONFIG_HAVE_SQLITE
+// findByType() must not return cached result after migration changed schema version
+void test_storage_find_by_type()
+{
+	Sq::DbSqlite *db = new Sq::DbSqlite();
+	Sq::Storage  *storage = new Sq::Storage(db);
+	Sq::Schema   *schemaVer1;
+	Sq::Schema   *schemaVer2;
+	Sq::Table    *table;
+	Sq::Table    *tableCompany;
+
+	assert(storage->open(":memory:") == SQCODE_OK);
+
+	schemaVer1 = new Sq::Schema("Ver1");
+	schemaVer1->version = 1;
+	table = schemaVer1->create<Company>("companies");
+	table->integer("id", &Company::id)->primary();
+	table->string("name", &Company::name);
+
+	schemaVer2 = new Sq::Schema("Ver2");
+	schemaVer2->version = 2;
+	table = schemaVer2->create<User>("users");
+	table->integer("id", &User::id)->primary();
+	table->string("name", &User::name);
+
+	storage->migrate(schemaVer1);
+	storage->migrate(NULL);
+	tableCompany = storage->findByType<Company>();
+	assert(tableCompany != NULL && strcmp(tableCompany->name, "companies") == 0);
+	assert(storage->findByType<User>() == NULL);
+
+	storage->migrate(schemaVer2);
+	storage->migrate(NULL);
+	table = storage->findByType<User>();
+	assert(table != NULL && strcmp(table->name, "users") == 0);
+	assert(storage->findByType<Company>() == sq_storage_find_by_type(storage, typeid(Company).name()));
+
+	delete schemaVer1;
+	delete schemaVer2;
+	storage->close();
+	delete storage;
+	delete db;
+}
+#endif  // SQ_CONFIG_HAVE_SQLITE
+
 // ----------------------------------------------------------------------------
 void test_type()
 {
@@ -223,6 +276,108 @@ void test_type()
 
 	type->unref();
 }
+
+// ----------------------------------------------------------------------------
+// Sq::StaticType (C++17)
+
+#if __cplusplus >= 201703L
+
+struct Member
+{
+	int           id;
+	std::string   name;
+	char         *note;
+	bool          active;
+	int64_t       points;
+	double        ratio;
+	int          *score;     // SQB_POINTER
+	double       *weight;    // SQB_POINTER, NULL
+};
+
+static constexpr auto memberFields = Sq::fields(
+	Sq::field("id",     &Member::id,     SQB_PRIMARY),
+	Sq::field("name",   &Member::name),
+	Sq::field("note",   &Member::note),
+	Sq::field("active", &Member::active),
+	Sq::field("points", &Member::points),
+	Sq::field("ratio",  &Member::ratio),
+	Sq::field("score",  &Member::score,  SQ_TYPE_INT,    SQB_POINTER),
+	Sq::field("weight", &Member::weight, SQ_TYPE_DOUBLE, SQB_POINTER)
+);
+
+static int  append_json(void *data, const char *buffer, int length)
+{
+	((std::string*)data)->append(buffer, length);
+	return length;
+}
+
+void test_static_type()
+{
+	const SqType *type = Sq::StaticType<Member, memberFields>::type();
+	std::string   json;
+	Sqxc         *xc;
+	Sqxc         *xcjson;
+	Member       *member;
+	Member        src;
+	int           score = 95;
+
+	// entries are sorted by name
+	assert(type->n_entry == 8);
+	for (int index = 1;  index < type->n_entry;  index++)
+		assert(strcmp(type->entry[index-1]->name, type->entry[index]->name) < 0);
+
+	src.id = 3;
+	src.name = "Alice";
+	src.note = (char*)"a \"quoted\" note";
+	src.active = true;
+	src.points = 5000000000;
+	src.ratio = 0.25;
+	src.score = &score;
+	src.weight = NULL;
+
+	// write instance to JSON
+	xc = sqxc_new(SQXC_INFO_JSON_WRITER);
+	sqxc_json_writer_use_func(xc, append_json, &json);
+	sqxc_ready(xc, NULL);
+	xc->name = NULL;
+	assert(type->write(&src, type, xc)->code == SQCODE_OK);
+	sqxc_finish(xc, NULL);
+	sqxc_free(xc);
+	cout << json << endl;
+	assert(json.find("\"score\":95") != std::string::npos);
+	assert(json.find("\"weight\":null") != std::string::npos);
+
+	// parse JSON to new instance
+	xc = sqxc_new_chain(SQXC_INFO_VALUE, SQXC_INFO_JSON_PARSER, NULL);
+	xcjson = sqxc_find(xc, SQXC_INFO_JSON_PARSER);
+	sqxc_value_type(xc) = type;
+	sqxc_value_container(xc) = NULL;
+	sqxc_ready(xc, NULL);
+	xcjson->type = SQXC_TYPE_STRING;
+	xcjson->name = NULL;
+	xcjson->value.string = (char*)json.c_str();
+	assert(xcjson->info->send(xcjson, xcjson) == SQCODE_OK);
+	sqxc_finish(xc, NULL);
+	member = (Member*)sqxc_value_instance(xc);
+	sqxc_free_chain(xc);
+
+	assert(member->id == 3);
+	assert(member->name == "Alice");
+	assert(strcmp(member->note, src.note) == 0);
+	assert(member->active == true);
+	assert(member->points == 5000000000);
+	assert(member->ratio == 0.25);
+	assert(member->score != NULL && *member->score == 95);
+	assert(member->weight == NULL);
+
+	free(member->note);
+	free(member->score);
+	member->~Member();
+	free(member);
+}
+
+#endif  // __cplusplus >= 201703L
+
 // ----------------------------------------------------------------------------
 
 int main(void)
@@ -231,6 +386,12 @@ int main(void)
 	test_query();
 	test_sqxc();
 	test_storage();
+#ifdef SQ_CONFIG_HAVE_SQLITE
+	test_storage_find_by_type();
+#endif
 	test_type();
+#if __cplusplus >= 201703L
+	test_static_type();
+#endif
 	return EXIT_SUCCESS;
 }
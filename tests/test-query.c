@@ -13,7 +13,9 @@
  */
 
 
+#include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <SqQuery-macro.h>
 
@@ -120,11 +122,82 @@ void test_query_macro()
 	sq_query_free(query);
 }
 
+void test_query_reuse()
+{
+	SqQuery  *query;
+	SqBuffer  buf;
+	char     *sql;
+	char      table[16] = "Company";
+	char      long_value[300];
+	void     *node_chunk, *arena_chunk;
+	int       node_count;
+
+	query = sq_query_new(NULL);
+	sq_query_from(query, table);
+	sq_query_where(query, "id", ">", "5");
+	sq_query_order_by(query, "id", NULL);
+	// write SQL to tail of buffer
+	sq_buffer_init(&buf);
+	sq_buffer_write(&buf, "EXPLAIN ");
+	sql = sq_query_write_sql(query, &buf);
+	assert(sql == buf.buf + 8);
+	assert(strcmp(buf.buf, "EXPLAIN SELECT * FROM Company WHERE id > 5 ORDER BY id") == 0);
+	assert(buf.writed == (int)strlen(buf.buf));
+
+	// names are copied by default
+	strcpy(table, "city");
+	sql = sq_query_to_sql(query);
+	assert(strcmp(sql, "SELECT * FROM Company WHERE id > 5 ORDER BY id") == 0);
+	free(sql);
+
+	// nodes and strings are reused after sq_query_clear()
+	node_chunk = query->node_chunk;
+	node_count = query->node_count;
+	arena_chunk = query->arena.chunk;
+	for (int count = 0;  count < 3;  count++) {
+		sq_query_clear(query);
+		sq_query_from(query, table);
+		sq_query_where(query, "id", ">", "5");
+		sq_query_order_by(query, "id", NULL);
+		buf.writed = 0;
+		sql = sq_query_write_sql(query, &buf);
+		assert(strcmp(sql, "SELECT * FROM city WHERE id > 5 ORDER BY id") == 0);
+		assert(query->node_chunk == node_chunk);
+		assert(query->node_count == node_count);
+		assert(query->arena.chunk == arena_chunk);
+	}
+
+	// printf format that is longer than stack buffer
+	sq_query_clear(query);
+	memset(long_value, 'a', sizeof(long_value) - 1);
+	long_value[sizeof(long_value) - 1] = 0;
+	sq_query_from(query, "city");
+	sq_query_where(query, "name = '%s'", long_value);
+	buf.writed = 0;
+	sql = sq_query_write_sql(query, &buf);
+	assert(strncmp(sql, "SELECT * FROM city WHERE name = 'aaa", 36) == 0);
+	assert(strlen(sql) == 33 + strlen(long_value) + 1);
+
+	// static names are referenced instead of copied
+	sq_query_clear(query);
+	sq_query_static_names(query, true);
+	sq_query_from(query, table);
+	sq_query_select(query, "id", "name", NULL);
+	strcpy(table, "Company");
+	buf.writed = 0;
+	sql = sq_query_write_sql(query, &buf);
+	assert(strcmp(sql, "SELECT id, name FROM Company") == 0);
+
+	sq_buffer_final(&buf);
+	sq_query_free(query);
+}
+
 void test_query()
 {
 	test_query_c1();
 	test_query_c2();
 	test_query_macro();
+	test_query_reuse();
 }
 
 // ----------------------------------------------------------------------------
@@ -12,14 +12,18 @@
  * See the Mulan PSL v2 for more details.
  */
 
+#include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
+#include <SqError.h>
 #include <SqPtrArray.h>
 #include <SqSchema-macro.h>
 #include <SqJoint.h>
 #include <SqxcSql.h>
 #include <SqxcValue.h>
 #include <SqxcEmpty.h>
+#include <SqxcJsonParser.h>
 #ifdef SQ_CONFIG_HAVE_JSONC
 #include <SqxcJsonc.h>
 #endif
@@ -137,6 +141,66 @@ void test_sqxc_joint_input()
 	sq_table_free(table);
 }
 
+// data source reuses buffer of column name and changes order of columns
+void test_sqxc_value_columns()
+{
+	static const char *names[2][2] = {{"id", "email"}, {"email", "id"}};
+	SqPtrArray *array;
+	User       *user;
+	Sqxc       *xc;
+	char        name[16];
+	char        email[16];
+	int         row, col;
+
+	xc = sqxc_new(SQXC_INFO_VALUE);
+	sqxc_value_type(xc) = &UserType;
+	sqxc_value_container(xc) = SQ_TYPE_PTR_ARRAY;
+	sqxc_ready(xc, NULL);
+
+	xc->name = NULL;
+	xc->type = SQXC_TYPE_ARRAY;
+	sqxc_send(xc);
+	for (row = 0;  row < 3;  row++) {
+		xc->name = NULL;
+		xc->type = SQXC_TYPE_OBJECT;
+		sqxc_send(xc);
+		for (col = 0;  col < 2;  col++) {
+			strcpy(name, names[row & 1][col]);
+			xc->name = name;
+			if (strcmp(name, "id") == 0) {
+				xc->type = SQXC_TYPE_INT;
+				xc->value.integer = row + 1;
+			}
+			else {
+				snprintf(email, sizeof(email), "user%d@", row + 1);
+				xc->type = SQXC_TYPE_STRING;
+				xc->value.string = email;
+			}
+			sqxc_send(xc);
+			assert(xc->code == SQCODE_OK);
+		}
+		xc->name = NULL;
+		xc->type = SQXC_TYPE_OBJECT_END;
+		sqxc_send(xc);
+	}
+	xc->name = NULL;
+	xc->type = SQXC_TYPE_ARRAY_END;
+	sqxc_send(xc);
+	sqxc_finish(xc, NULL);
+
+	array = sqxc_value_instance(xc);
+	assert(array->length == 3);
+	for (row = 0;  row < 3;  row++) {
+		user = array->data[row];
+		snprintf(email, sizeof(email), "user%d@", row + 1);
+		assert(user->id == row + 1);
+		assert(strcmp(user->email, email) == 0);
+		sq_type_final_instance(&UserType, &user, true);
+	}
+	sq_ptr_array_free(array);
+	sqxc_free(xc);
+}
+
 #ifdef SQ_CONFIG_HAVE_JSONC
 
 const char *json_array_string =
@@ -311,6 +375,201 @@ void test_sqxc_sql_output(bool use_update)
 
 #endif  // SQ_CONFIG_HAVE_JSONC
 
+// ----------------------------------------------------------------------------
+// SqxcJsonParser
+
+const char *json_user_string =
+"{"
+	"\"id\": 12, \"name\": \"Joe \\u00e9\\ud83d\\ude00\","
+	"\"email\": \"a\\\"b\\\\c\","
+	"\"unknown\": {\"x\": [1, {\"y\": null}]},"
+	"\"strs\": [\"first\", \"second\"],"
+	"\"ints\": [-1, 2147483647]"
+"} ";
+
+// send 'json' to parser as one string (chunk_size == 0) or as stream in chunks of 'chunk_size' bytes.
+int  test_json_parser_send(Sqxc *xcjson, const char *json, int chunk_size)
+{
+	char  chunk[8];
+	int   length = (int)strlen(json);
+
+	if (chunk_size == 0) {
+		xcjson->type = SQXC_TYPE_STRING;
+		xcjson->name = NULL;
+		xcjson->value.string = (char*)json;
+		return xcjson->info->send(xcjson, xcjson);
+	}
+
+	for (int offset = 0;  offset < length;  offset += chunk_size) {
+		memset(chunk, 0, sizeof(chunk));
+		strncpy(chunk, json + offset, chunk_size);
+		xcjson->type = SQXC_TYPE_STREAM;
+		xcjson->name = NULL;
+		xcjson->value.string = chunk;
+		if (xcjson->info->send(xcjson, xcjson) != SQCODE_OK)
+			return xcjson->code;
+	}
+	xcjson->type = SQXC_TYPE_STREAM_END;
+	xcjson->value.string = NULL;
+	return xcjson->info->send(xcjson, xcjson);
+}
+
+User *test_json_parser_user(int chunk_size)
+{
+	Sqxc *xcvalue;
+	Sqxc *xcjson;
+	User *user;
+
+	xcvalue = sqxc_new_chain(SQXC_INFO_VALUE, SQXC_INFO_JSON_PARSER, NULL);
+	xcjson = sqxc_find(xcvalue, SQXC_INFO_JSON_PARSER);
+	sqxc_value_type(xcvalue) = &UserType;
+	sqxc_value_container(xcvalue) = NULL;
+
+	sqxc_ready(xcvalue, NULL);
+	assert(test_json_parser_send(xcjson, json_user_string, chunk_size) == SQCODE_OK);
+	sqxc_finish(xcvalue, NULL);
+
+	user = (User*)sqxc_value_instance(xcvalue);
+	sqxc_free_chain(xcvalue);
+	return user;
+}
+
+void test_json_parser()
+{
+	Sqxc *xcjson;
+	User *user, *user_chunked;
+
+	// whole string and 1-byte chunks produce the same instance
+	user = test_json_parser_user(0);
+	user_chunked = test_json_parser_user(1);
+	print_user(user);
+	assert(user->id == 12 && user_chunked->id == 12);
+	assert(strcmp(user->name, "Joe \xC3\xA9\xF0\x9F\x98\x80") == 0);
+	assert(strcmp(user->name, user_chunked->name) == 0);
+	assert(strcmp(user->email, "a\"b\\c") == 0);
+	assert(strcmp(user->email, user_chunked->email) == 0);
+	assert(user->strs.length == 2 && user_chunked->strs.length == 2);
+	assert(strcmp(user_chunked->strs.data[1], "second") == 0);
+	assert(user->ints.length == 2 && (int)user_chunked->ints.data[1] == 2147483647);
+
+	// valid and invalid JSON without destination
+	xcjson = sqxc_new(SQXC_INFO_JSON_PARSER);
+	for (int chunk_size = 0;  chunk_size <= 3;  chunk_size++) {
+		assert(test_json_parser_send(xcjson, " [1, -0.5e+3, 0, true, null] ", chunk_size) == SQCODE_OK);
+		assert(test_json_parser_send(xcjson, "\"\\t\"", chunk_size) == SQCODE_OK);
+		assert(test_json_parser_send(xcjson, "12", chunk_size) == SQCODE_OK);
+		// only one root value
+		assert(test_json_parser_send(xcjson, "{}{}", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "1 2", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "[] x", chunk_size) == SQCODE_INVALID_JSON);
+		// numbers
+		assert(test_json_parser_send(xcjson, "01", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "[+1]", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "[1.]", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "[1e]", chunk_size) == SQCODE_INVALID_JSON);
+		// strings
+		assert(test_json_parser_send(xcjson, "\"a\tb\"", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "\"\\x\"", chunk_size) == SQCODE_INVALID_JSON);
+		// structure
+		assert(test_json_parser_send(xcjson, "[1,]", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "{\"a\" 1}", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "[1}", chunk_size) == SQCODE_INVALID_JSON);
+		assert(test_json_parser_send(xcjson, "[1", chunk_size) == SQCODE_UNCOMPLETED_JSON);
+		assert(test_json_parser_send(xcjson, "tru", chunk_size) == SQCODE_UNCOMPLETED_JSON);
+		// no root value
+		assert(test_json_parser_send(xcjson, "", chunk_size) == SQCODE_UNCOMPLETED_JSON);
+		assert(test_json_parser_send(xcjson, "  ", chunk_size) == SQCODE_UNCOMPLETED_JSON);
+	}
+	sqxc_free(xcjson);
+}
+
+// ----------------------------------------------------------------------------
+// frozen chain (dispatch table)
+
+static Sqxc *dispatch_received;
+
+static int  dispatch_test_send(Sqxc *xc, Sqxc *src)
+{
+	dispatch_received = xc;
+	return SQCODE_OK;
+}
+
+static const SqxcInfo dispatch_test_info = {
+	.size  = sizeof(Sqxc),
+	.send  = dispatch_test_send,
+};
+
+static Sqxc *dispatch_test_new(unsigned int supported_type)
+{
+	Sqxc *xc = sqxc_new(&dispatch_test_info);
+
+	xc->supported_type = supported_type;
+	return xc;
+}
+
+static Sqxc *dispatch_test_send_type(Sqxc *xc, SqxcType type)
+{
+	dispatch_received = NULL;
+	xc->type = type;
+	xc->name = NULL;
+	xc->value.string = "value";
+	sqxc_send(xc);
+	return dispatch_received;
+}
+
+void test_sqxc_dispatch()
+{
+	Sqxc *src, *xc_int, *xc_str, *xc_str2;
+
+	src     = dispatch_test_new(0);
+	xc_int  = dispatch_test_new(SQXC_TYPE_INT);
+	xc_str  = dispatch_test_new(SQXC_TYPE_STRING | SQXC_TYPE_ARRAY);
+	xc_str2 = dispatch_test_new(SQXC_TYPE_STRING);
+
+	// src -> xc_int -> xc_str
+	sqxc_insert(src, xc_int, -1);
+	sqxc_insert(src, xc_str, -1);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_STRING) == xc_str);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_INT) == xc_int);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_ARRAY) == xc_str);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_DOUBLE) == NULL);
+	assert(src->code == SQCODE_TYPE_NOT_SUPPORT);
+#ifdef SQ_CONFIG_SQXC_DISPATCH
+	assert(src->dispatch != NULL);
+#endif
+
+	// src -> xc_str2 -> xc_int -> xc_str
+	sqxc_insert(src, xc_str2, 1);
+	assert(src->dispatch == NULL);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_STRING) == xc_str2);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_INT) == xc_int);
+
+	// src -> xc_int -> xc_str
+	sqxc_steal(src, xc_str2);
+	assert(src->dispatch == NULL && xc_str2->dispatch == NULL);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_STRING) == xc_str);
+
+	// change Sqxc.peer directly: src -> xc_int
+	xc_int->peer = NULL;
+	sqxc_clear_dispatch(src);
+	assert(src->dispatch == NULL && xc_int->dispatch == NULL);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_STRING) == NULL);
+	assert(src->code == SQCODE_TYPE_NOT_SUPPORT);
+
+	// supported_type that is changed at runtime must be in variable_type
+	// src -> xc_int -> xc_str
+	xc_int->variable_type = SQXC_TYPE_STRING;
+	sqxc_insert(src, xc_str, -1);
+	assert(dispatch_test_send_type(src, SQXC_TYPE_STRING) == xc_str);
+	xc_int->supported_type |= SQXC_TYPE_STRING;
+	assert(dispatch_test_send_type(src, SQXC_TYPE_STRING) == xc_int);
+	xc_int->supported_type &= ~SQXC_TYPE_STRING;
+	assert(dispatch_test_send_type(src, SQXC_TYPE_STRING) == xc_str);
+
+	sqxc_free(xc_str2);
+	sqxc_free_chain(src);
+}
+
 // ----------------------------------------------------------------------------
 
 int  main(void)
@@ -331,12 +590,15 @@ int  main(void)
 	sq_ptr_array_append(&user->ints, (void*)(intptr_t)1);
 
 	test_sqxc_joint_input();
+	test_sqxc_value_columns();
 #ifdef SQ_CONFIG_HAVE_JSONC
 	test_sqxc_jsonc_input();
 	test_sqxc_jsonc_input_user();
 	test_sqxc_jsonc_output(user);
 	test_sqxc_sql_output(true);
 #endif  // SQ_CONFIG_HAVE_JSONC
+	test_json_parser();
+	test_sqxc_dispatch();
 
 //	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
 	return EXIT_SUCCESS;
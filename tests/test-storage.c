@@ -13,7 +13,9 @@
  */
 
 
+#include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <SqConfig.h>
 #ifdef SQ_CONFIG_HAVE_SQLITE
@@ -22,10 +24,14 @@
 
 #include <SqError.h>
 #include <SqPtrArray.h>
+#include <SqQuery.h>
 #include <SqTable.h>
 #include <SqSchema-macro.h>
 #include <SqStorage.h>
+#include <SqStorage-async.h>
 #include <SqdbSqlite.h>
+#include <SqdbPool.h>
+#include <SqdbStats.h>
 #include <SqxcSql.h>
 #include <SqxcValue.h>
 
@@ -103,6 +109,796 @@ static int callback(void *user_data, int argc, char **argv, char **columnName)
 	return 0;
 }
 
+// ----------------------------------------------------------------------------
+// Worker - table in SQLite in-memory database
+
+typedef struct Worker    Worker;
+
+struct Worker
+{
+	int    id;
+	char  *name;
+	double salary;
+	time_t hired;
+};
+
+void worker_free(Worker *worker)
+{
+	free(worker->name);
+	free(worker);
+}
+
+SqStorage *create_worker_storage(void)
+{
+	SqStorage  *storage;
+	SqSchema   *schema;
+
+	storage = sq_storage_new(sqdb_new(SQDB_INFO_SQLITE, NULL));
+	assert(sq_storage_open(storage, ":memory:") == SQCODE_OK);
+
+	schema = sq_schema_new("Ver1");
+	schema->version = 1;
+	SQ_SCHEMA_CREATE(schema, "workers", Worker, {
+		SQT_INTEGER("id", Worker, id);  SQC_PRIMARY();  SQC_INCREMENT();
+		SQT_STRING("name", Worker, name, -1);
+		SQT_DOUBLE("salary", Worker, salary);
+		SQT_TIMESTAMP("hired", Worker, hired);
+	});
+	assert(sq_storage_migrate(storage, schema) == SQCODE_OK);
+	assert(sq_storage_migrate(storage, NULL) == SQCODE_OK);
+	sq_schema_free(schema);
+	return storage;
+}
+
+void free_worker_storage(SqStorage *storage)
+{
+	Sqdb  *db = storage->db;
+
+	sq_storage_close(storage);
+	sq_storage_free(storage);
+	sqdb_free(db);
+}
+
+// fill 'array' with 'n' workers. id is 0 if 'first_id' is 0.
+void make_workers(SqPtrArray *array, int n, int first_id)
+{
+	Worker *worker;
+	char    name[32];
+	int     index;
+
+	for (index = 0;  index < n;  index++) {
+		worker = malloc(sizeof(Worker));
+		worker->id = (first_id) ? first_id + index : 0;
+		snprintf(name, sizeof(name), "worker %d", index);
+		worker->name = strdup(name);
+		worker->salary = 1000.0 + index / 3.0;
+		worker->hired = 1036941839 + index;
+		sq_ptr_array_append(array, worker);
+	}
+}
+
+void free_workers(SqPtrArray *array)
+{
+	sq_ptr_array_foreach(array, element) {
+		worker_free((Worker*)element);
+	}
+	sq_ptr_array_free(array);
+}
+
+// ----------------------------------------------------------------------------
+// sq_storage_insert_all()
+
+void test_insert_all(SqStorage *storage)
+{
+	SqPtrArray *array;
+	Worker     *worker;
+	int         index;
+
+	// more rows than one INSERT statement can bind
+	array = sq_ptr_array_new(0, NULL);
+	make_workers(array, 1000, 0);
+	assert(sq_storage_insert_all(storage, "workers", NULL, array, NULL) == 1000);
+	// ids of AUTOINCREMENT primary key are written back
+	for (index = 0;  index < array->length;  index++)
+		assert(((Worker*)array->data[index])->id == index + 1);
+	free_workers(array);
+
+	worker = sq_storage_get(storage, "workers", NULL, 1000);
+	assert(worker != NULL);
+	assert(strcmp(worker->name, "worker 999") == 0);
+	assert(worker->salary == 1000.0 + 999 / 3.0);
+	assert(worker->hired == 1036941839 + 999);
+	worker_free(worker);
+
+	// preset ids are kept
+	array = sq_ptr_array_new(0, NULL);
+	make_workers(array, 3, 2001);
+	assert(sq_storage_insert_all(storage, "workers", NULL, array, NULL) == 3);
+	assert(((Worker*)array->data[2])->id == 2003);
+	free_workers(array);
+
+	worker = sq_storage_get(storage, "workers", NULL, 2002);
+	assert(worker != NULL && strcmp(worker->name, "worker 1") == 0);
+	worker_free(worker);
+
+	// empty container
+	array = sq_ptr_array_new(0, NULL);
+	assert(sq_storage_insert_all(storage, "workers", NULL, array, NULL) == 0);
+	sq_ptr_array_free(array);
+
+	// unknown table
+	array = sq_ptr_array_new(0, NULL);
+	assert(sq_storage_insert_all(storage, "no_such_table", NULL, array, NULL) == -1);
+	sq_ptr_array_free(array);
+}
+
+// ----------------------------------------------------------------------------
+// SqStorageCursor
+
+void test_cursor(SqStorage *storage)
+{
+	SqStorageCursor *cursor;
+	Worker          *worker;
+	Worker          *first;
+	int              count;
+
+	// reuse instance
+	cursor = sq_storage_cursor_open(storage, "workers", NULL, NULL, "WHERE id <= 10 ORDER BY id");
+	assert(cursor != NULL);
+	sq_storage_cursor_reuse(cursor, true);
+	first = NULL;
+	for (count = 0;  (worker = sq_storage_cursor_next(cursor)) != NULL;  count++) {
+		if (first == NULL)
+			first = worker;
+		assert(worker == first);
+		assert(worker->id == count + 1);
+		assert(worker->salary == 1000.0 + count / 3.0);
+		assert(worker->hired == 1036941839 + count);
+	}
+	assert(count == 10);
+	assert(cursor->code == SQCODE_OK);
+	// no more row
+	assert(sq_storage_cursor_next(cursor) == NULL);
+	sq_storage_cursor_close(cursor);
+
+	// caller frees instances (default)
+	cursor = sq_storage_cursor_open(storage, "workers", NULL, NULL, "WHERE id > 2000 ORDER BY id");
+	assert(cursor != NULL);
+	first = sq_storage_cursor_next(cursor);
+	assert(first != NULL && first->id == 2001);
+	worker = sq_storage_cursor_next(cursor);
+	assert(worker != NULL && worker != first && worker->id == 2002);
+	assert(strcmp(first->name, "worker 0") == 0);
+	worker_free(first);
+	worker_free(worker);
+	sq_storage_cursor_close(cursor);
+
+	// no row
+	cursor = sq_storage_cursor_open(storage, "workers", NULL, NULL, "WHERE id < 0");
+	assert(cursor != NULL);
+	assert(sq_storage_cursor_next(cursor) == NULL);
+	assert(cursor->code == SQCODE_OK);
+	sq_storage_cursor_close(cursor);
+
+	// SQL error
+	cursor = sq_storage_cursor_open(storage, "workers", NULL, NULL, "WHERE no_such_column = 1");
+	assert(cursor == NULL);
+}
+
+// ----------------------------------------------------------------------------
+// sq_storage_get_all_arena()
+
+void test_get_all_arena(SqStorage *storage)
+{
+	SqArena     arena;
+	SqPtrArray *array;
+	Worker     *worker;
+
+	sq_arena_init(&arena, 0);
+	// result is larger than one chunk
+	array = sq_storage_get_all_arena(storage, "workers", NULL, NULL, NULL, "WHERE id <= 1000 ORDER BY id", &arena);
+	assert(array != NULL && array->length == 1000);
+	worker = array->data[999];
+	assert(worker->id == 1000 && strcmp(worker->name, "worker 999") == 0);
+	assert(worker->salary == 1000.0 + 999 / 3.0);
+	assert(worker->hired == 1036941839 + 999);
+
+	// result is released by sq_arena_reset() and arena is reused
+	sq_arena_reset(&arena);
+	array = sq_storage_get_all_arena(storage, "workers", NULL, NULL, NULL, "WHERE id > 2000 ORDER BY id", &arena);
+	assert(array != NULL && array->length == 3);
+	worker = array->data[2];
+	assert(worker->id == 2003 && strcmp(worker->name, "worker 2") == 0);
+	sq_arena_final(&arena);
+
+	// SqStorage doesn't keep arena
+	array = sq_storage_get_all_full(storage, "workers", NULL, NULL, NULL, "WHERE id <= 3");
+	assert(array != NULL && array->length == 3);
+	free_workers(array);
+}
+
+// ----------------------------------------------------------------------------
+// SqCompiledQuery
+
+void test_compiled_query(SqStorage *storage)
+{
+	SqCompiledQuery *compiled;
+	SqQuery         *query;
+	SqPtrArray      *array;
+	Worker          *worker;
+	int              index;
+
+	// positional and named parameters
+	query = sq_query_new(NULL);
+	sq_query_from(query, "workers");
+	sq_query_where(query, "id", "<", "?");
+	sq_query_where(query, "name", "<>", ":name");
+	compiled = sq_storage_compile(storage, query, NULL, NULL);
+	sq_query_free(query);
+	assert(compiled != NULL);
+
+	index = sq_compiled_query_index(compiled, ":name");
+	assert(index == 2);
+	assert(sq_compiled_query_index(compiled, "name") == index);
+	assert(sq_compiled_query_index(compiled, "no_such_name") == 0);
+
+	// run many times with different values
+	sq_compiled_query_bind_int(compiled, 1, 6);
+	sq_compiled_query_bind_string(compiled, index, "worker 2");
+	array = sq_compiled_query_exec(compiled);
+	assert(array != NULL && array->length == 4);
+	worker = array->data[3];
+	assert(worker->id == 5 && worker->salary == 1000.0 + 4 / 3.0);
+	free_workers(array);
+
+	// bound string is kept for next execution
+	sq_compiled_query_bind_int(compiled, 1, 3);
+	array = sq_compiled_query_exec(compiled);
+	assert(array != NULL && array->length == 2);
+	free_workers(array);
+
+	// parameter that is bound to NULL
+	sq_compiled_query_bind_null(compiled, index);
+	array = sq_compiled_query_exec(compiled);
+	assert(array == NULL || array->length == 0);
+	if (array)
+		sq_ptr_array_free(array);
+
+	// out of range
+	assert(sq_compiled_query_bind_int(compiled, 3, 0) != SQCODE_OK);
+	assert(sq_compiled_query_bind_int(compiled, 0, 0) != SQCODE_OK);
+	sq_compiled_query_free(compiled);
+
+	// bool parameter
+	query = sq_query_new(NULL);
+	sq_query_from(query, "workers");
+	sq_query_where(query, "id", "<", "?");
+	sq_query_where(query, "id & 1", "=", "?");
+	compiled = sq_storage_compile(storage, query, NULL, NULL);
+	sq_query_free(query);
+	assert(compiled != NULL);
+
+	sq_compiled_query_bind_int(compiled, 1, 6);
+	sq_compiled_query_bind_bool(compiled, 2, true);
+	array = sq_compiled_query_exec(compiled);
+	assert(array != NULL && array->length == 3);
+	free_workers(array);
+
+	sq_compiled_query_bind_bool(compiled, 2, false);
+	array = sq_compiled_query_exec(compiled);
+	assert(array != NULL && array->length == 2);
+	free_workers(array);
+	sq_compiled_query_free(compiled);
+}
+
+// ----------------------------------------------------------------------------
+// SqStorageAsync
+
+typedef struct AsyncOrder    AsyncOrder;
+
+struct AsyncOrder
+{
+	int  ids[4];
+	int  n_ids;
+};
+
+static void async_record_id(SqStorageJob *job, void *data)
+{
+	AsyncOrder *order = data;
+
+	order->ids[order->n_ids++] = job->id;
+}
+
+static void async_count(SqStorageJob *job, void *data)
+{
+	sq_atomic_add_fetch((unsigned int*)data, 1);
+}
+
+static int  async_job_state(SqStorageJob *job)
+{
+	int  state;
+
+	sq_mutex_lock(&job->async->mutex);
+	state = job->state;
+	sq_mutex_unlock(&job->async->mutex);
+	return state;
+}
+
+void test_async(SqStorage *storage)
+{
+	SqStorageAsync *async;
+	SqStorageJob   *jobs[4], *job;
+	SqPtrArray     *array;
+	Worker         *worker, new_worker = {0, (char*)"async worker", 500.0, 1036941839};
+	AsyncOrder      order = {{0}, 0};
+	unsigned int    n_called = 0;
+	int             id;
+
+	// run jobs in worker threads
+	async = sq_storage_async_new(storage, 2, 0);
+	job = sq_storage_async_insert(async, "workers", NULL, &new_worker, 0, async_count, &n_called);
+	assert(sq_storage_job_wait(job) == SQ_STORAGE_JOB_DONE);
+	id = job->code;
+	assert(id > 0);
+	sq_storage_job_unref(job);
+
+	job = sq_storage_async_get(async, "workers", NULL, id, 0, async_count, &n_called);
+	assert(sq_storage_job_wait(job) == SQ_STORAGE_JOB_DONE);
+	worker = job->result;
+	assert(worker != NULL && strcmp(worker->name, "async worker") == 0);
+	worker_free(worker);
+	sq_storage_job_unref(job);
+
+	job = sq_storage_async_get_all(async, "workers", NULL, NULL, "WHERE id <= 10", 0, async_count, &n_called);
+	assert(sq_storage_job_wait(job) == SQ_STORAGE_JOB_DONE);
+	array = job->result;
+	assert(array != NULL && array->length == 10);
+	free_workers(array);
+	sq_storage_job_unref(job);
+
+	job = sq_storage_async_remove(async, "workers", NULL, id, 0, NULL, NULL);
+	assert(sq_storage_job_wait(job) == SQ_STORAGE_JOB_DONE);
+	sq_storage_job_unref(job);
+	// callbacks have been called after worker threads exit
+	sq_storage_async_free(async);
+	assert(n_called == 3);
+	array = sq_storage_get_all_full(storage, "workers", NULL, NULL, NULL, "WHERE name = 'async worker'");
+	assert(array == NULL || array->length == 0);
+	if (array)
+		sq_ptr_array_free(array);
+
+	// priority and cancel. worker thread is blocked by holding lock of database.
+	async = sq_storage_async_new(storage, 1, 0);
+	sq_storage_lock_db(storage);
+	jobs[0] = sq_storage_async_get(async, "workers", NULL, 1, 0, async_record_id, &order);
+	while (async_job_state(jobs[0]) != SQ_STORAGE_JOB_RUNNING)
+		;
+	jobs[1] = sq_storage_async_get(async, "workers", NULL, 2, 0, async_record_id, &order);
+	jobs[2] = sq_storage_async_get(async, "workers", NULL, 3, 5, async_record_id, &order);
+	jobs[3] = sq_storage_async_get(async, "workers", NULL, 4, 0, async_record_id, &order);
+	assert(sq_storage_job_cancel(jobs[0]) == false);
+	assert(sq_storage_job_cancel(jobs[3]) == true);
+	assert(sq_storage_job_wait(jobs[3]) == SQ_STORAGE_JOB_CANCELED);
+	sq_storage_unlock_db(storage);
+	for (int index = 0;  index < 4;  index++) {
+		if (sq_storage_job_wait(jobs[index]) == SQ_STORAGE_JOB_DONE)
+			worker_free(jobs[index]->result);
+		sq_storage_job_unref(jobs[index]);
+	}
+	sq_storage_async_free(async);
+	// higher priority runs first. callback of canceled job is not called.
+	assert(order.n_ids == 3);
+	assert(order.ids[0] == 1 && order.ids[1] == 3 && order.ids[2] == 2);
+
+	// callbacks are called by sq_storage_async_dispatch() in calling thread
+	n_called = 0;
+	async = sq_storage_async_new(storage, 1, SQ_STORAGE_ASYNC_DISPATCH);
+#if defined(__linux__)
+	assert(sq_storage_async_fd(async) != -1);
+#endif
+	job = sq_storage_async_get(async, "workers", NULL, 1, 0, async_count, &n_called);
+	assert(sq_storage_job_wait(job) == SQ_STORAGE_JOB_DONE);
+	assert(n_called == 0);
+	assert(sq_storage_async_dispatch(async) == 1);
+	assert(n_called == 1);
+	worker_free(job->result);
+	sq_storage_job_unref(job);
+	sq_storage_async_free(async);
+}
+
+// ----------------------------------------------------------------------------
+// SqdbStats
+
+static SqdbStatsEntry *find_stats_entry(SqPtrArray *array, const char *fingerprint)
+{
+	SqdbStatsEntry *entry;
+
+	for (int index = 0;  index < array->length;  index++) {
+		entry = array->data[index];
+		if (strcmp(entry->fingerprint, fingerprint) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+void test_stats(SqStorage *storage)
+{
+	SqdbStats      *stats;
+	SqdbStatsEntry *entry, entry_local = {0};
+	SqdbStmt       *stmt;
+	SqPtrArray     *array;
+	char            buf[128];
+	FILE           *slow_log;
+	int             code;
+
+	// fingerprint
+	sqdb_stats_fingerprint(buf, "SELECT * FROM t WHERE id = 5 AND name = 'it''s'");
+	assert(strcmp(buf, "SELECT * FROM t WHERE id = ? AND name = ?") == 0);
+	sqdb_stats_fingerprint(buf, "SELECT  *\n FROM t WHERE id IN (1, 2, 3) AND col2 > 1.5");
+	assert(strcmp(buf, "SELECT * FROM t WHERE id IN (?+) AND col2 > ?") == 0);
+
+	stats = sqdb_stats_new();
+	storage->db->stats = stats;
+
+	// statements that have the same fingerprint share the same entry
+	array = sq_storage_get_all_full(storage, "workers", NULL, NULL, NULL, "WHERE id <= 3");
+	free_workers(array);
+	array = sq_storage_get_all_full(storage, "workers", NULL, NULL, NULL, "WHERE id <= 5");
+	free_workers(array);
+	// failed statement
+	code = sqdb_exec(storage->db, "SELECT * FROM no_such_table WHERE id = 1", NULL, NULL);
+	assert(code != SQCODE_OK);
+	// prepared statement is counted once when it is finalized
+	code = sqdb_prepare(storage->db, "SELECT * FROM workers WHERE id < 4", &stmt);
+	assert(code == SQCODE_OK);
+	while (sqdb_stmt_step(storage->db, stmt, NULL) == SQCODE_ROW)
+		;
+	sqdb_stmt_finalize(storage->db, stmt);
+
+	array = sqdb_stats_snapshot(stats, false);
+	entry = find_stats_entry(array, "SELECT * FROM \"workers\" WHERE id <= ?");
+	assert(entry != NULL);
+	assert(entry->count == 2 && entry->rows == 8 && entry->errors == 0);
+	assert(entry->max_ns > 0 && entry->total_ns >= entry->max_ns);
+	entry = find_stats_entry(array, "SELECT * FROM no_such_table WHERE id = ?");
+	assert(entry != NULL && entry->count == 1 && entry->errors == 1);
+	entry = find_stats_entry(array, "SELECT * FROM workers WHERE id < ?");
+	assert(entry != NULL && entry->count == 1 && entry->rows == 3 && entry->errors == 0);
+	// sorted by total time
+	for (int index = 1;  index < array->length;  index++) {
+		assert(((SqdbStatsEntry*)array->data[index-1])->total_ns >=
+		       ((SqdbStatsEntry*)array->data[index])->total_ns);
+	}
+	sq_ptr_array_free(array);
+
+	// counters are cleared after copying
+	array = sqdb_stats_snapshot(stats, true);
+	assert(array->length > 0);
+	sq_ptr_array_free(array);
+	array = sqdb_stats_snapshot(stats, false);
+	assert(array->length == 0);
+	sq_ptr_array_free(array);
+
+	// slow query log
+	slow_log = tmpfile();
+	stats->slow_log = slow_log;
+	stats->slow_threshold = 0;
+	sqdb_exec(storage->db, "SELECT * FROM workers WHERE id = 1", NULL, NULL);
+	stats->slow_log = NULL;
+	rewind(slow_log);
+	assert(fgets(buf, sizeof(buf), slow_log) != NULL);
+	assert(strncmp(buf, "SQL slow: ", 10) == 0);
+	assert(strstr(buf, "SELECT * FROM workers WHERE id = 1") != NULL);
+	fclose(slow_log);
+
+	// disabled
+	storage->db->stats = NULL;
+	sqdb_stats_reset(stats);
+	sqdb_exec(storage->db, "SELECT * FROM workers WHERE id = 1", NULL, NULL);
+	array = sqdb_stats_snapshot(stats, false);
+	assert(array->length == 0);
+	sq_ptr_array_free(array);
+	sqdb_stats_free(stats);
+
+	// percentile: upper bound of histogram bucket, but not greater than maximum latency
+	entry_local.count = 4;
+	entry_local.histogram[0] = 2;     // < 1us
+	entry_local.histogram[3] = 2;     // [4, 8) us
+	entry_local.max_ns = 6000;
+	assert(sqdb_stats_entry_percentile(&entry_local, 50) == 1.0);
+	assert(sqdb_stats_entry_percentile(&entry_local, 99) == 6.0);
+	entry_local.count = 0;
+	assert(sqdb_stats_entry_percentile(&entry_local, 99) == 0);
+}
+
+// ----------------------------------------------------------------------------
+// SqStorage is used by multiple threads
+
+typedef struct StorageThread    StorageThread;
+
+struct StorageThread
+{
+	SqStorage *storage;
+	int        index;
+	int        code;
+	int        n_rows;
+};
+
+static void storage_thread_run(void *data)
+{
+	StorageThread *st = data;
+	SqStorage     *storage = st->storage;
+	SqPtrArray    *array;
+	Worker         worker, *result;
+	char           name[32], where[64];
+	int            ids[20];
+
+	snprintf(name, sizeof(name), "thread %d", st->index);
+	snprintf(where, sizeof(where), "WHERE name = '%s'", name);
+	worker.name = name;
+	worker.hired = 1036941839;
+	for (int count = 0;  count < 20;  count++) {
+		worker.id = 0;
+		worker.salary = count;
+		ids[count] = sq_storage_insert(storage, "workers", NULL, &worker);
+		assert(ids[count] > 0);
+		result = sq_storage_get(storage, "workers", NULL, ids[count]);
+		assert(result != NULL && strcmp(result->name, name) == 0);
+		assert(sq_storage_find_by_type(storage, "Worker") == sq_storage_find(storage, "workers"));
+		worker_free(result);
+	}
+	array = sq_storage_get_all_full(storage, "workers", NULL, NULL, NULL, where);
+	assert(array != NULL && array->length == 20);
+	free_workers(array);
+	for (int count = 0;  count < 20;  count++)
+		sq_storage_remove(storage, "workers", NULL, ids[count]);
+	array = sq_storage_get_all_full(storage, "workers", NULL, NULL, NULL, where);
+	assert(array == NULL || array->length == 0);
+	if (array)
+		sq_ptr_array_free(array);
+}
+
+static void storage_thread_commit(void *data)
+{
+	StorageThread *st = data;
+	SqPtrArray    *array;
+
+	// this thread didn't begin transaction. It waits until transaction of main thread ends.
+	st->code = sq_storage_commit(st->storage);
+	array = sq_storage_get_all_full(st->storage, "workers", NULL, NULL, NULL, "WHERE name = 'in transaction'");
+	st->n_rows = (array) ? array->length : 0;
+	if (array)
+		free_workers(array);
+}
+
+void test_storage_threads(SqStorage *storage)
+{
+	StorageThread  st[4];
+	SqThread       threads[4];
+	Worker         worker = {0, "in transaction", 0.0, 1036941839};
+	int            id;
+
+	for (int index = 0;  index < 4;  index++) {
+		st[index] = (StorageThread) {storage, index, 0, 0};
+		assert(sq_thread_create(threads + index, storage_thread_run, st + index));
+	}
+	for (int index = 0;  index < 4;  index++)
+		sq_thread_join(threads[index]);
+	// Sqxc chains were checked out by threads and returned to pools
+	assert(storage->xc_input_pool.length >= 1 && storage->xc_input_pool.length <= 4);
+	assert(storage->xc_output_pool.length >= 1 && storage->xc_output_pool.length <= 4);
+
+	// transaction is bound to thread that began it
+	assert(sq_storage_begin(storage) == SQCODE_OK);
+	assert(sq_thread_create(threads, storage_thread_commit, st));
+	id = sq_storage_insert(storage, "workers", NULL, &worker);
+	assert(id > 0);
+	assert(sq_storage_commit(storage) == SQCODE_OK);
+	sq_thread_join(threads[0]);
+	assert(st[0].code == SQCODE_ERROR);
+	assert(st[0].n_rows == 1);
+	// no transaction
+	assert(sq_storage_rollback(storage) == SQCODE_ERROR);
+	sq_storage_remove(storage, "workers", NULL, id);
+}
+
+void test_worker_storage(void)
+{
+	SqStorage  *storage;
+
+	storage = create_worker_storage();
+	test_insert_all(storage);
+	test_cursor(storage);
+	test_get_all_arena(storage);
+	test_compiled_query(storage);
+	test_async(storage);
+	test_stats(storage);
+	test_storage_threads(storage);
+	free_worker_storage(storage);
+}
+
+// ----------------------------------------------------------------------------
+// SqdbPool
+
+void test_pool(void)
+{
+	SqdbConfigSqlite  config_sqlite = {
+		.folder = ".",
+		.extension = "db",
+		.preset = SQDB_SQLITE_PRESET_BALANCED,
+	};
+	SqdbConfigPool    config_pool = {
+		.info = SQDB_INFO_SQLITE,
+		.config = (SqdbConfig*)&config_sqlite,
+		.min_connections = 1,
+		.max_connections = 2,
+	};
+	SqdbPool   *pool;
+	SqStorage  *storage;
+	SqSchema   *schema;
+	Sqdb       *db1, *db2;
+
+	remove("test-pool.db");
+	pool = (SqdbPool*)sqdb_pool_new((SqdbConfig*)&config_pool);
+	// pool is not opened
+	assert(sqdb_pool_get(pool) == NULL);
+	assert(sqdb_open((Sqdb*)pool, "test-pool") == SQCODE_OK);
+	assert(pool->n_opened == 1);
+	assert(pool->version == 0);
+
+	// check out all connections
+	db1 = sqdb_pool_get(pool);
+	db2 = sqdb_pool_get(pool);
+	assert(db1 != NULL && db2 != NULL && db1 != db2);
+	assert(pool->n_opened == 2);
+	sqdb_pool_put(pool, db2);
+	// checked in connection is reused
+	assert(sqdb_pool_get(pool) == db2);
+	sqdb_pool_put(pool, db2);
+	sqdb_pool_put(pool, db1);
+
+	// transaction binds connection to calling thread until COMMIT
+	assert(sqdb_exec((Sqdb*)pool, "BEGIN", NULL, NULL) == SQCODE_OK);
+	assert(pool->conns[0].bound != pool->conns[1].bound);
+	assert(sqdb_exec((Sqdb*)pool, "CREATE TABLE t1 (id INTEGER)", NULL, NULL) == SQCODE_OK);
+	assert(sqdb_exec((Sqdb*)pool, "COMMIT", NULL, NULL) == SQCODE_OK);
+	assert(pool->conns[0].bound == false && pool->conns[1].bound == false);
+	assert(pool->conns[0].n_users == 0 && pool->conns[1].n_users == 0);
+
+	// migrate through SqStorage. schema version is applied to all connections.
+	storage = sq_storage_new((Sqdb*)pool);
+	schema = sq_schema_new("Ver1");
+	schema->version = 1;
+	SQ_SCHEMA_CREATE(schema, "workers", Worker, {
+		SQT_INTEGER("id", Worker, id);  SQC_PRIMARY();  SQC_INCREMENT();
+		SQT_STRING("name", Worker, name, -1);
+		SQT_DOUBLE("salary", Worker, salary);
+		SQT_TIMESTAMP("hired", Worker, hired);
+	});
+	assert(sq_storage_migrate(storage, schema) == SQCODE_OK);
+	assert(sq_storage_migrate(storage, NULL) == SQCODE_OK);
+	sq_schema_free(schema);
+	assert(pool->version == 1);
+	assert(pool->conns[0].db->version == 1 && pool->conns[1].db->version == 1);
+
+	// reopen. schema version is taken from database.
+	assert(sq_storage_close(storage) == SQCODE_OK);
+	assert(pool->n_opened == 0 && pool->conns[0].db == NULL);
+	assert(sq_storage_open(storage, "test-pool") == SQCODE_OK);
+	assert(pool->version == 1);
+
+	sq_storage_close(storage);
+	sq_storage_free(storage);
+	sqdb_free((Sqdb*)pool);
+	remove("test-pool.db");
+}
+
+// ----------------------------------------------------------------------------
+// SqdbPool + SQ_TYPE_INTERN_STRING in multiple threads
+
+typedef struct Staff    Staff;
+
+struct Staff
+{
+	int    id;
+	char  *dept;
+};
+
+static const char *staff_depts[4] = {"sales", "support", "finance", "research"};
+
+static void free_staffs(SqPtrArray *array)
+{
+	Staff *staff;
+
+	for (int index = 0;  index < array->length;  index++) {
+		staff = array->data[index];
+		sq_intern_unref(staff->dept);
+		free(staff);
+	}
+	sq_ptr_array_free(array);
+}
+
+static void check_staffs(SqPtrArray *array)
+{
+	Staff *staff;
+
+	assert(array != NULL && array->length == 100);
+	for (int index = 0;  index < array->length;  index++) {
+		staff = array->data[index];
+		assert(strcmp(staff->dept, staff_depts[(staff->id - 1) % 4]) == 0);
+		// values of the same column are shared
+		if (index >= 4)
+			assert(staff->dept == ((Staff*)array->data[index - 4])->dept);
+	}
+}
+
+static void pool_intern_run(void *data)
+{
+	SqStorage  *storage = data;
+	SqPtrArray *array;
+
+	// strings are referenced and released by all threads at the same time
+	for (int count = 0;  count < 20;  count++) {
+		array = sq_storage_get_all_full(storage, "staffs", NULL, NULL, NULL, "ORDER BY id");
+		check_staffs(array);
+		free_staffs(array);
+	}
+}
+
+void test_pool_intern(void)
+{
+	SqdbConfigSqlite  config_sqlite = {
+		.folder = ".",
+		.extension = "db",
+		.preset = SQDB_SQLITE_PRESET_BALANCED,
+	};
+	SqdbConfigPool    config_pool = {
+		.info = SQDB_INFO_SQLITE,
+		.config = (SqdbConfig*)&config_sqlite,
+		.min_connections = 1,
+		.max_connections = 4,
+	};
+	SqThread    threads[4];
+	SqdbPool   *pool;
+	SqStorage  *storage;
+	SqPtrArray *array;
+	char        sql[128];
+
+	remove("test-pool.db");
+	pool = (SqdbPool*)sqdb_pool_new((SqdbConfig*)&config_pool);
+	storage = sq_storage_new((Sqdb*)pool);
+	assert(sq_storage_open(storage, "test-pool") == SQCODE_OK);
+	SQ_SCHEMA_CREATE(storage->schema, "staffs", Staff, {
+		SQT_INTEGER("id", Staff, id);  SQC_PRIMARY();
+		SQT_CUSTOM("dept", Staff, dept, SQ_TYPE_INTERN_STRING, 32);
+	});
+	assert(sqdb_exec((Sqdb*)pool, "CREATE TABLE staffs (id INTEGER PRIMARY KEY, dept VARCHAR(32))", NULL, NULL) == SQCODE_OK);
+	assert(sqdb_exec((Sqdb*)pool, "BEGIN", NULL, NULL) == SQCODE_OK);
+	for (int id = 1;  id <= 100;  id++) {
+		snprintf(sql, sizeof(sql), "INSERT INTO staffs VALUES (%d, '%s')", id, staff_depts[(id - 1) % 4]);
+		assert(sqdb_exec((Sqdb*)pool, sql, NULL, NULL) == SQCODE_OK);
+	}
+	assert(sqdb_exec((Sqdb*)pool, "COMMIT", NULL, NULL) == SQCODE_OK);
+
+	for (int index = 0;  index < 4;  index++)
+		assert(sq_thread_create(threads + index, pool_intern_run, storage));
+	// this result is alive while other threads release the same strings
+	array = sq_storage_get_all_full(storage, "staffs", NULL, NULL, NULL, "ORDER BY id");
+	for (int index = 0;  index < 4;  index++)
+		sq_thread_join(threads[index]);
+	check_staffs(array);
+
+	sq_storage_close(storage);
+	// interned strings are still valid after SqStorage is freed
+	sq_storage_free(storage);
+	check_staffs(array);
+	free_staffs(array);
+	sqdb_free((Sqdb*)pool);
+	remove("test-pool.db");
+}
+
+// ----------------------------------------------------------------------------
+
 int main (int argc, char *argv[])
 {
 	sqlite3 *db;
@@ -115,6 +911,10 @@ int main (int argc, char *argv[])
 	SqPtrArray *array;
 	Company    *company;
 
+	test_worker_storage();
+	test_pool();
+	test_pool_intern();
+
 	/* Open database */
 	rc = sqlite3_open("test.db", &db);
 
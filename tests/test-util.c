@@ -12,10 +12,18 @@
  * See the Mulan PSL v2 for more details.
  */
 
+#include <assert.h>
+#include <math.h>       // isnan(), isinf(), signbit()
+#include <inttypes.h>   // PRId64, PRIu64
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 #include <SqUtil.h>
+#include <SqIntern.h>
+#include <SqThread.h>
 
 
 void test_name_convention()
@@ -81,12 +89,337 @@ void test_time_string()
 	str  = sq_time_to_string(time);
 	if (str)
 		puts(str);
+	free(str);
+}
+
+// sq_time_from_string_full() and sq_time_to_str()
+void test_time_codec()
+{
+	char       buf[SQ_TIME_STR_SIZE];
+	char       expect[SQ_TIME_STR_SIZE];
+	struct tm *tm;
+	time_t     time;
+	int64_t    seconds;
+
+	// formats
+	assert(sq_time_from_string_full("2002-11-10T15:23:59", true) == 1036941839);
+	assert(sq_time_from_string_full("2002-11-10 15:23:59Z", false) == 1036941839);
+	assert(sq_time_from_string_full("2002/11/10 15:23:59.123", true) == 1036941839);
+	assert(sq_time_from_string_full("2002-11-10 23:23:59+08:00", false) == 1036941839);
+	assert(sq_time_from_string_full("2002-11-10T10:23:59-0500", false) == 1036941839);
+	assert(sq_time_from_string_full("2002-11-10", true) == 1036886400);
+	assert(sq_time_from_string_full("2000-02-29 00:00:00", true) == 951782400);
+	assert(sq_time_from_string_full("15:23:59", true) == 946740239);
+	// errors
+	assert(sq_time_from_string_full("", true) == -1);
+	assert(sq_time_from_string_full("now", true) == -1);
+	assert(sq_time_from_string_full("2002-13-10", true) == -1);
+	assert(sq_time_from_string_full("2002-11-10 25:00", true) == -1);
+	assert(sq_time_from_string_full("2002-11-10 15:23:59+8", true) == -1);
+	// numbers that overflow int
+	assert(sq_time_from_string_full("2002-11-10 15:4294967296:00", true) == -1);
+	assert(sq_time_from_string_full("99999999999999999999-01-01", true) == -1);
+
+	// compare with gmtime() and localtime() from 1900 to 2100
+	for (seconds = -2208988800;  seconds < 4102444800;  seconds += 9999991) {
+		time = (time_t)seconds;
+		assert(sq_time_to_str(buf, time, true) == 19);
+		tm = gmtime(&time);
+		strftime(expect, sizeof(expect), "%Y-%m-%d %H:%M:%S", tm);
+		assert(strcmp(buf, expect) == 0);
+		assert(sq_time_from_string_full(buf, true) == time);
+
+		sq_time_to_str(buf, time, false);
+		tm = localtime(&time);
+		strftime(expect, sizeof(expect), "%Y-%m-%d %H:%M:%S", tm);
+		assert(strcmp(buf, expect) == 0);
+	}
+}
+
+// sq_int64_to_str(), sq_uint64_to_str(), and sq_double_to_str()
+void test_number_string()
+{
+	static const int64_t  int64s[] = {
+		0, 1, -1, 9, 10, -10, 99, 100, 12345678, -87654321,
+		INT32_MAX, INT32_MIN, (int64_t)INT32_MAX + 1,
+		INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1,
+	};
+	static const uint64_t uint64s[] = {
+		0, 1, 10, UINT32_MAX, (uint64_t)UINT32_MAX + 1, UINT64_MAX - 1, UINT64_MAX,
+	};
+	static const double   doubles[] = {
+		0.1, 0.3, 1.0, -2.5, 100.0, 123456789.0, 1e21, 1e-7, 1e300, 1e-300,
+		5e-324, 2.2250738585072014e-308, 1.7976931348623157e308, 1.0 / 3.0,
+	};
+	char      buf[SQ_DOUBLE_STR_SIZE];
+	char      expect[SQ_DOUBLE_STR_SIZE];
+	uint64_t  bits = 88172645463325252u;
+	double    value;
+	int       index;
+	int       len;
+
+	for (index = 0;  index < (int)(sizeof(int64s) / sizeof(int64s[0]));  index++) {
+		len = sq_int64_to_str(buf, int64s[index]);
+		snprintf(expect, sizeof(expect), "%" PRId64, int64s[index]);
+		assert(strcmp(buf, expect) == 0 && len == (int)strlen(expect));
+	}
+	for (index = 0;  index < (int)(sizeof(uint64s) / sizeof(uint64s[0]));  index++) {
+		len = sq_uint64_to_str(buf, uint64s[index]);
+		snprintf(expect, sizeof(expect), "%" PRIu64, uint64s[index]);
+		assert(strcmp(buf, expect) == 0 && len == (int)strlen(expect));
+	}
+
+	// shortest form
+	sq_double_to_str(buf, 0.1);
+	assert(strcmp(buf, "0.1") == 0);
+	sq_double_to_str(buf, 1.0);
+	assert(strcmp(buf, "1.0") == 0);
+	sq_double_to_str(buf, 1e300);
+	assert(strcmp(buf, "1e300") == 0);
+	sq_double_to_str(buf, -0.0);
+	assert(strcmp(buf, "-0.0") == 0);
+	sq_double_to_str(buf, NAN);
+	assert(strcmp(buf, "nan") == 0);
+	sq_double_to_str(buf, -INFINITY);
+	assert(strcmp(buf, "-inf") == 0);
+
+	// round-trip
+	for (index = 0;  index < (int)(sizeof(doubles) / sizeof(doubles[0]));  index++) {
+		len = sq_double_to_str(buf, doubles[index]);
+		assert(len == (int)strlen(buf) && len < SQ_DOUBLE_STR_SIZE);
+		assert(strtod(buf, NULL) == doubles[index]);
+	}
+	// round-trip of random bit patterns (xorshift64)
+	for (index = 0;  index < 100000;  index++) {
+		bits ^= bits << 13;
+		bits ^= bits >> 7;
+		bits ^= bits << 17;
+		memcpy(&value, &bits, sizeof(value));
+		if (isnan(value) || isinf(value))
+			continue;
+		len = sq_double_to_str(buf, value);
+		assert(len == (int)strlen(buf) && len < SQ_DOUBLE_STR_SIZE);
+		assert(strtod(buf, NULL) == value);
+		assert(signbit(strtod(buf, NULL)) == signbit(value));
+	}
+}
+
+// reference of sq_str_span_sql() and sq_str_span_json()
+static int  span_reference(const char *str, bool json)
+{
+	const unsigned char *cur = (const unsigned char*)str;
+
+	for (;  *cur;  cur++) {
+		if (json && (*cur == '"' || *cur == '\\' || *cur < 0x20))
+			break;
+		if (json == false && *cur == '\'')
+			break;
+	}
+	return (int)((const char*)cur - str);
+}
+
+// compare SIMD result with reference at every alignment and across 16/32-byte boundaries
+void test_str_span()
+{
+	// the first 7 characters need no escaping in SQL and JSON
+	static const char  normal[] = {'a', ' ', '/', 0x7F, (char)0x80, (char)0xE4, (char)0xFF, '\'', '"', '\\'};
+	static const char  special[] = {'\'', '"', '\\', 0x01, 0x1F, '\n', 0};
+	char  *memory;
+	char  *base;
+	char  *str;
+	int    offset, length, pos, index;
+
+	memory = malloc(256 + 64);
+	// 64-byte aligned
+	base = memory + (64 - ((uintptr_t)memory & 63)) % 64;
+
+	for (offset = 0;  offset < 64;  offset++) {
+		str = base + offset;
+		for (length = 0;  length < 160;  length++) {
+			// characters before 'str' in the same block must be ignored
+			memset(base, '"', offset);
+			if (offset > 0)
+				base[offset - 1] = 0;
+			// string that need no escaping
+			for (index = 0;  index < length;  index++)
+				str[index] = normal[(index + offset) % 7];
+			str[length] = 0;
+			assert(sq_str_span_sql(str) == length);
+			assert(sq_str_span_json(str) == length);
+
+			// put special character at every position
+			for (pos = 0;  pos < length;  pos++) {
+				for (index = 0;  index < (int)sizeof(special);  index++) {
+					char  saved = str[pos];
+					str[pos] = special[index];
+					assert(sq_str_span_sql(str) == span_reference(str, false));
+					assert(sq_str_span_json(str) == span_reference(str, true));
+					str[pos] = saved;
+				}
+			}
+			// all characters
+			for (index = 0;  index < length;  index++)
+				str[index] = normal[(index + offset) % (int)sizeof(normal)];
+			assert(sq_str_span_sql(str) == span_reference(str, false));
+			assert(sq_str_span_json(str) == span_reference(str, true));
+		}
+	}
+	free(memory);
+}
+
+// ----------------------------------------------------------------------------
+// SqIntern
+
+typedef struct InternThread    InternThread;
+
+struct InternThread
+{
+	SqIntern  *intern;
+	char      *strings[4];
+
+	// threads wait on 'cond' until 'freed' is true
+	SqMutex   *mutex;
+	SqCond    *cond;
+	int       *n_ready;
+	bool      *freed;
+};
+
+static const char *intern_values[4] = {"active", "inactive", "pending", "banned"};
+
+static void intern_thread_run(void *data)
+{
+	InternThread *it = data;
+	char         *str;
+
+	for (int count = 0;  count < 2000;  count++) {
+		str = sq_intern_ref(it->intern, intern_values[count % 4]);
+		assert(strcmp(str, intern_values[count % 4]) == 0);
+		sq_intern_unref(str);
+	}
+	for (int index = 0;  index < 4;  index++)
+		it->strings[index] = sq_intern_ref(it->intern, intern_values[index]);
+
+	// release strings after SqIntern is freed by main thread
+	sq_mutex_lock(it->mutex);
+	*it->n_ready += 1;
+	sq_cond_broadcast(it->cond);
+	while (*it->freed == false)
+		sq_cond_wait(it->cond, it->mutex);
+	sq_mutex_unlock(it->mutex);
+
+	for (int index = 0;  index < 4;  index++) {
+		assert(strcmp(it->strings[index], intern_values[index]) == 0);
+		sq_intern_unref(it->strings[index]);
+	}
+}
+
+void test_intern_thread()
+{
+	InternThread  its[4];
+	SqThread      threads[4];
+	SqIntern     *intern;
+	SqMutex       mutex;
+	SqCond        cond;
+	int           n_ready = 0;
+	bool          freed = false;
+
+	sq_mutex_init(&mutex, false);
+	sq_cond_init(&cond);
+	intern = sq_intern_new(NULL);
+	for (int index = 0;  index < 4;  index++) {
+		its[index] = (InternThread) {intern, {NULL}, &mutex, &cond, &n_ready, &freed};
+		assert(sq_thread_create(threads + index, intern_thread_run, its + index));
+	}
+
+	sq_mutex_lock(&mutex);
+	while (n_ready < 4)
+		sq_cond_wait(&cond, &mutex);
+	// strings are shared by all threads
+	for (int index = 1;  index < 4;  index++)
+		assert(its[index].strings[0] == its[0].strings[0]);
+	// strings are still in use. They are released by threads after SqIntern is freed.
+	sq_intern_free(intern);
+	freed = true;
+	sq_cond_broadcast(&cond);
+	sq_mutex_unlock(&mutex);
+
+	for (int index = 0;  index < 4;  index++)
+		sq_thread_join(threads[index]);
+	sq_cond_final(&cond);
+	sq_mutex_final(&mutex);
+}
+
+void test_intern()
+{
+	SqIntern  intern;
+	SqArena   arena;
+	char     *str1, *str2, *str3;
+	char      buf[16];
+
+	// shared strings
+	sq_intern_init(&intern, NULL);
+	str1 = sq_intern_ref(&intern, "active");
+	str2 = sq_intern_ref(&intern, "active");
+	str3 = sq_intern_ref(&intern, "inactive");
+	assert(str1 == str2);
+	assert(str1 != str3 && strcmp(str3, "inactive") == 0);
+	sq_intern_unref(str1);
+	assert(strcmp(str2, "active") == 0);
+	// removed string is added again
+	sq_intern_unref(str2);
+	str1 = sq_intern_ref(&intern, "active");
+	assert(strcmp(str1, "active") == 0);
+	// more strings than hash buckets
+	for (int index = 0;  index < 1000;  index++) {
+		snprintf(buf, sizeof(buf), "value %d", index % 500);
+		str2 = sq_intern_ref(&intern, buf);
+		assert(strcmp(str2, buf) == 0);
+		if (index >= 500)
+			assert(str2 == sq_intern_ref(&intern, buf));
+	}
+	for (int index = 0;  index < 500;  index++) {
+		snprintf(buf, sizeof(buf), "value %d", index);
+		str2 = sq_intern_ref(&intern, buf);
+		// release references of above loop and this one
+		for (int count = 0;  count < 4;  count++)
+			sq_intern_unref(str2);
+	}
+	// strings that are still in use are valid after sq_intern_final()
+	sq_intern_final(&intern);
+	assert(strcmp(str1, "active") == 0 && strcmp(str3, "inactive") == 0);
+	sq_intern_unref(str1);
+	sq_intern_unref(str3);
+
+	// unshared strings
+	str1 = sq_intern_ref(NULL, "active");
+	str2 = sq_intern_ref(NULL, "active");
+	assert(str1 != str2 && strcmp(str1, str2) == 0);
+	sq_intern_unref(str1);
+	sq_intern_unref(str2);
+	sq_intern_unref(NULL);
+
+	// strings allocated from arena are not reference counted
+	sq_arena_init(&arena, 0);
+	sq_intern_init(&intern, &arena);
+	str1 = sq_intern_ref(&intern, "active");
+	assert(str1 == sq_intern_ref(&intern, "active"));
+	sq_intern_unref(str1);
+	sq_intern_final(&intern);
+	assert(strcmp(str1, "active") == 0);
+	sq_intern_unref(str1);
+	sq_arena_final(&arena);
+
+	test_intern_thread();
 }
 
 void test_util()
 {
 	test_name_convention();
     test_time_string();
+	test_time_codec();
+	test_number_string();
+	test_str_span();
+	test_intern();
 }
 
 // ----------------------------------------------------------------------------